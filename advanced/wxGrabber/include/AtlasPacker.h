@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+
+// Packs many sprites into a single atlas bitmap with a skyline bottom-left packer.
+// Sprites can be trimmed to their non-mask content first (mask color as in
+// CompiledSprite: index 0, magenta, or zero alpha), padded, and rotated by 90
+// degrees when that fits better. All sprites must share one color depth.
+class AtlasPacker {
+public:
+    struct Options {
+        int padding = 1;            // Empty pixels between sprites and around the border
+        bool trim = true;           // Crop mask colored borders before packing
+        bool powerOfTwo = false;    // Round the atlas size up to powers of two
+        bool allowRotation = false; // Sprites may be stored rotated 90 degrees clockwise
+        int maxSize = 4096;         // Largest allowed atlas width/height
+    };
+
+    struct Input {
+        std::string name;
+        const BitmapData* bitmap;
+    };
+
+    // Where a sprite ended up, in the order the inputs were given
+    struct Placement {
+        std::string name;
+        int x = 0;              // Position in the atlas
+        int y = 0;
+        int width = 0;          // Size in the atlas, after trimming and rotation
+        int height = 0;
+        int trimX = 0;          // Offset of the trimmed content in the source bitmap
+        int trimY = 0;
+        int sourceWidth = 0;    // Untrimmed source size
+        int sourceHeight = 0;
+        bool rotated = false;
+    };
+
+    struct Result {
+        BitmapData atlas;
+        std::vector<Placement> placements;
+    };
+
+    static bool pack(const std::vector<Input>& inputs, const Options& options, Result& result);
+
+    // C header with the atlas size and one row per sprite, prefix names the macros and the table
+    static std::string generateHeader(const Result& result, const std::string& prefix);
+
+    // Coordinates table for a DATA object: little-endian int32 count, then per sprite
+    // x, y, width, height, trimX, trimY, sourceWidth, sourceHeight, rotated (int32 each)
+    static std::vector<uint8_t> serializeTable(const Result& result);
+};
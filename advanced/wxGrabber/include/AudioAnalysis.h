@@ -0,0 +1,126 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "AudioData.h"
+
+// Min/max peaks of a sound at several resolutions. Level 0 holds one peak per
+// BaseBucketFrames frames for each channel and every further level merges
+// LevelFactor buckets of the one below, so any zoom is drawn from the coarsest
+// level that still has a bucket per pixel column.
+class WaveformPyramid {
+public:
+    struct Peak {
+        int16_t min = 0;
+        int16_t max = 0;
+    };
+
+    static constexpr int64_t BaseBucketFrames = 32;
+    static constexpr int64_t LevelFactor = 4;
+
+    // Build from interleaved 16-bit samples, may be called repeatedly with consecutive chunks
+    void begin(int channels);
+    void add(const int16_t* samples, size_t frameCount);
+    void finish();
+
+    // Min and max of one channel for each of columns equal slices of [startFrame, endFrame)
+    void query(int channel, int64_t startFrame, int64_t endFrame, int columns, std::vector<Peak>& out) const;
+
+    int getChannels() const { return channels; }
+    size_t getLevelCount() const { return levels.size(); }
+    size_t memoryBytes() const;
+
+private:
+    int channels = 0;
+    std::vector<std::vector<Peak>> levels;  // Per level, bucket-major then channel
+    std::vector<Peak> pending;              // Bucket being filled
+    int64_t pendingFrames = 0;
+};
+
+// Results of decoding an audio object once
+struct AudioAnalysis {
+    struct ChannelStats {
+        float peak = 0.0f;  // Largest absolute sample, 1.0 is full scale
+        float rms = 0.0f;
+    };
+
+    int sampleRate = 0;
+    int channels = 0;
+    int64_t totalFrames = 0;
+    int durationMs = 0;  // From the decoded frame count, exact where headers are not
+    std::vector<ChannelStats> stats;
+    WaveformPyramid waveform;
+    // Decoded interleaved samples, absent when the sound is too long to keep
+    std::shared_ptr<const std::vector<int16_t>> pcm;
+
+    // Waveform peaks as WaveformPyramid::query, from the PCM when zoomed in past the pyramid resolution
+    void peaks(int channel, int64_t startFrame, int64_t endFrame, int columns, std::vector<WaveformPyramid::Peak>& out) const;
+    size_t memoryBytes() const;
+};
+
+// Size-bounded LRU cache of AudioAnalysis keyed by a hash of the audio content,
+// so identical sounds share an entry and edits invalidate implicitly. Analysis
+// runs on a worker thread; callers poll find() until the result is ready.
+class AudioAnalysisCache {
+public:
+    static constexpr size_t DefaultBudgetBytes = 128 * 1024 * 1024;
+
+    explicit AudioAnalysisCache(size_t budgetBytes = DefaultBudgetBytes);
+    ~AudioAnalysisCache();
+
+    // True for the types that can be decoded to PCM (OGG, SAMP, and MIDI through MidiSynth)
+    static bool canAnalyze(const AudioData& audio);
+    static uint64_t makeKey(const AudioData& audio);
+
+    // Finished analysis, nullptr while pending, failed or never requested
+    std::shared_ptr<const AudioAnalysis> find(uint64_t key);
+    bool hasFailed(uint64_t key) const;
+    // Queue analysis ahead of earlier requests unless it is cached or already queued
+    void request(uint64_t key, const AudioData& audio);
+
+    // Decode and analyze on the calling thread, the PCM is kept if it fits in maxPcmBytes
+    static std::shared_ptr<AudioAnalysis> analyze(const AudioData& audio, size_t maxPcmBytes);
+
+    void clear();
+    void setBudget(size_t budgetBytes);
+    size_t getMemoryUsage() const;
+    size_t getEntryCount() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const AudioAnalysis> analysis;
+        size_t bytes;
+        std::list<uint64_t>::iterator orderIt;
+    };
+
+    // Snapshot taken on the UI thread so the worker never touches live objects
+    struct Job {
+        uint64_t key;
+        AudioData audio;
+    };
+
+    void insertLocked(uint64_t key, std::shared_ptr<const AudioAnalysis> analysis);
+    void evictLocked();
+    void workerLoop();
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::list<uint64_t> order;  // Most recently used first
+    std::unordered_set<uint64_t> failed;
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+
+    std::deque<Job> jobs;
+    uint64_t activeKey = 0;
+    bool working = false;
+    bool stopWorker = false;
+    std::condition_variable jobsAvailable;
+    std::thread worker;
+};
@@ -3,12 +3,17 @@
 #include "AVControlInterface.h"
 #include <wx/image.h>
 #include "AudioData.h"
+#include "AudioStream.h"
+#include "AudioAnalysis.h"
 #include <memory>
 #include <wx/sound.h>
 #include "DataParser.h"
 
 // AudioPlaybackControl: Manages audio playback (play, pause, stop, seek) for AudioData objects. Not a UI panel.
 // Use SetAudioData to assign audio, PlayPause/Stop to control playback, and SetCurrentPositionMs to seek.
+// OGG, SAMP and MIDI (rendered by MidiSynth) objects are streamed to the sound card where a streaming sink exists, other
+// audio and other platforms play through wxSound. Once the analysis cache holds the
+// decoded samples of the sound, playback uses those instead of decoding again.
 class AudioPlaybackControl : public AVControlInterface {
 public:
     AudioPlaybackControl(std::function<void(int, int)> updateCallback);
@@ -17,9 +22,18 @@ public:
     void Stop() override;      // Stop playback and reset
     void SetCurrentPositionMs(int currentPositionMs) override; // Seek to position (ms)
     bool IsAudioLoaded() const; // Returns true if audio is loaded
+    int GetPlaybackPositionMs() const; // Position being played, -1 when not playing
+    void SetAnalysisCache(AudioAnalysisCache* cache) { m_analysisCache = cache; }
 private:
+    void CreatePlayer();  // Stream from cached samples when available, else from the object data
+    std::shared_ptr<const AudioAnalysis> FindCachedPcm() const;  // Analysis of the sound if it kept the samples
+
     std::shared_ptr<DataParser::DataObject> m_audioObject = nullptr;
     std::unique_ptr<wxSound> m_sound;
+    std::unique_ptr<AudioStreamPlayer> m_player;
     int m_startPositionMs = 0;
+    AudioAnalysisCache* m_analysisCache = nullptr;
+    uint64_t m_analysisKey = 0;
+    bool m_playsCachedPcm = false;
 };
 #endif // AUDIOPLAYBACKCONTROL_H
\ No newline at end of file
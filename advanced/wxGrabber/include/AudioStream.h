@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioData.h"
+
+// Interleaved 16-bit PCM read a chunk at a time from an audio object
+class PcmSource {
+public:
+    virtual ~PcmSource() = default;
+
+    int getSampleRate() const { return sampleRate; }
+    int getChannels() const { return channels; }
+    int64_t getTotalFrames() const { return totalFrames; }
+
+    virtual bool seek(int64_t frame) = 0;
+    // Returns the frames read, 0 at the end
+    virtual size_t read(int16_t* samples, size_t frameCount) = 0;
+
+    // Source for an OGG or SAMP object, or MIDI rendered by MidiSynth;
+    // nullptr for other types or broken data
+    static std::unique_ptr<PcmSource> create(const AudioData& audio);
+    // Source over samples decoded earlier, shared rather than copied
+    static std::unique_ptr<PcmSource> create(std::shared_ptr<const std::vector<int16_t>> samples, int sampleRate, int channels);
+
+protected:
+    int sampleRate = 0;
+    int channels = 0;
+    int64_t totalFrames = 0;
+};
+
+// Fixed size sample queue between one writer thread and one reader thread
+class AudioRingBuffer {
+public:
+    explicit AudioRingBuffer(size_t capacity);
+
+    size_t write(const int16_t* samples, size_t count);  // Returns how many fitted
+    size_t read(int16_t* samples, size_t count);         // Returns how many were queued
+    size_t available() const;
+    size_t space() const { return buffer.size() - available(); }
+    void clear();  // Only while neither side is running
+
+private:
+    std::vector<int16_t> buffer;
+    std::atomic<size_t> readCount{0};   // Samples read and written so far, the
+    std::atomic<size_t> writeCount{0};  // positions are these modulo the capacity
+};
+
+// Where decoded audio goes
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+
+    virtual bool open(int sampleRate, int channels) = 0;
+    // Queue frames for output, blocks while the output queue is full
+    virtual bool write(const int16_t* samples, size_t frameCount) = 0;
+    // Wait until everything written has been played
+    virtual void drain() {}
+    // Drop queued audio and release the output
+    virtual void close() = 0;
+
+    // Sound card output, nullptr where streaming output is not available
+    static std::unique_ptr<AudioSink> createDevice();
+};
+
+// Discards audio, at playback speed when realtime so timing matches a device
+class NullAudioSink : public AudioSink {
+public:
+    explicit NullAudioSink(bool realtime = false) : realtime(realtime) {}
+    bool open(int sampleRate, int channels) override;
+    bool write(const int16_t* samples, size_t frameCount) override;
+    void close() override {}
+    int64_t getFramesWritten() const { return framesWritten; }
+
+private:
+    bool realtime;
+    int sampleRate = 0;
+    std::atomic<int64_t> framesWritten{0};
+};
+
+// Writes what it is given to a WAV file, for headless tests
+class WavFileAudioSink : public AudioSink {
+public:
+    explicit WavFileAudioSink(const std::string& path) : path(path) {}
+    ~WavFileAudioSink() override { close(); }
+    bool open(int sampleRate, int channels) override;
+    bool write(const int16_t* samples, size_t frameCount) override;
+    void close() override;  // Completes the header
+
+private:
+    std::string path;
+    std::ofstream file;
+    int sampleRate = 0;
+    int channels = 0;
+    uint32_t dataBytes = 0;
+};
+
+// Plays a PcmSource through a sink from any position. A decoder thread fills a
+// ring buffer a chunk at a time and an output thread feeds the sink from it, so
+// memory does not grow with the length of the sound and a seek only restarts
+// both threads at the new position.
+class AudioStreamPlayer {
+public:
+    static constexpr int DefaultBufferMs = 500;
+
+    AudioStreamPlayer(std::unique_ptr<PcmSource> source, std::unique_ptr<AudioSink> sink, int bufferMs = DefaultBufferMs);
+    ~AudioStreamPlayer();
+
+    // Start, or seek while playing
+    bool play(int positionMs);
+    void stop();
+    // False once the end of the sound has been played
+    bool isPlaying() const { return running && !finished; }
+    // Position of the last frame handed to the sink
+    int getPositionMs() const;
+
+private:
+    static constexpr size_t ChunkFrames = 2048;
+
+    void decodeLoop();
+    void outputLoop();
+
+    std::unique_ptr<PcmSource> source;
+    std::unique_ptr<AudioSink> sink;
+    AudioRingBuffer ring;
+    std::thread decoder;
+    std::thread output;
+    std::atomic<bool> running{false};
+    std::atomic<bool> endOfStream{false};
+    std::atomic<bool> finished{true};
+    std::atomic<int64_t> outputFrames{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "AudioData.h"
+
+// Conversions applied to many OGG and SAMP objects at once. Every sound is
+// decoded to PCM, remixed, resampled and optionally normalized, then stored as
+// SAMP at the requested depth. Sources are never modified: every job produces
+// a new AudioData so the caller can keep the old one for undo.
+class BatchAudioConvert {
+public:
+    static constexpr int MaxSampleRate = 65535;  // SAMP stores the rate in 16 bits
+
+    struct Params {
+        int sampleRate = 0;         // 0 keeps the source rate
+        int channels = 0;           // 0 keeps the source layout, 1 mixes down, 2 duplicates mono
+        int bitsPerSample = 16;     // 8 or 16, 8-bit output is dithered
+        bool normalize = false;
+        float normalizePeakDb = -1.0f;  // Peak level normalize scales to
+    };
+
+    struct Job {
+        const AudioData* source = nullptr;
+        AudioData result;
+        bool done = false;
+        size_t sourceBytes = 0;     // Serialized sizes, as stored in the datafile
+        size_t resultBytes = 0;
+    };
+
+    // Convert one sound, false when it cannot be decoded or the parameters are unsupported
+    static bool apply(const AudioData& source, const Params& params, AudioData& result);
+
+    // Run all jobs across threadCount workers (0 uses all cores), returns how many succeeded
+    static int run(std::vector<Job>& jobs, const Params& params, unsigned threadCount = 0);
+
+    // Band-limited (windowed sinc) rate conversion of one channel
+    static std::vector<float> resample(const std::vector<float>& samples, int fromRate, int toRate);
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+
+// Pixel operations applied to many bitmaps at once, directly on their native
+// depth buffers. Mask pixels (index 0, magenta, zero alpha) are kept as mask by
+// the color operations. Sources are never modified: every job produces a new
+// bitmap so the caller can keep the old one for undo.
+class BatchTransform {
+public:
+    static constexpr int MaxSide = 0xFFFF;              // Datafiles store bitmap sizes in 16 bits
+    static constexpr int64_t MaxPixels = 64 * 1024 * 1024;
+    enum class Operation {
+        RemapPalette,       // 8-bit: move indices onto targetPalette, other depths: snap colors to it
+        FlipHorizontal,
+        FlipVertical,
+        Rotate90,           // Clockwise
+        Rotate180,
+        Rotate270,
+        Scale,              // Nearest neighbour, whole multiples of 100% just repeat pixels
+        ReplaceColor        // fromColor becomes toColor, or the mask color
+    };
+
+    struct Params {
+        Operation operation = Operation::FlipHorizontal;
+        std::vector<uint8_t> palette;       // Palette the 8-bit bitmaps currently use
+        std::vector<uint8_t> targetPalette; // RemapPalette only
+        int scalePercent = 200;             // Scale only
+        uint32_t fromColor = 0;             // ReplaceColor, as 0xRRGGBB
+        uint32_t toColor = 0;
+        bool toMask = false;                // ReplaceColor writes the mask color instead of toColor
+    };
+
+    struct Job {
+        const BitmapData* source = nullptr;
+        BitmapData result;
+        bool done = false;
+    };
+
+    // Size of source scaled by percent, false when a side or the pixel count is over the limits
+    static bool scaledSize(const BitmapData& source, int percent, int& width, int& height);
+
+    // Transform one bitmap, false when the depth or parameters are unsupported or memory runs out
+    static bool apply(const BitmapData& source, const Params& params, BitmapData& result);
+
+    // Run all jobs across threadCount workers (0 uses all cores), returns how many succeeded
+    static int run(std::vector<Job>& jobs, const Params& params, unsigned threadCount = 0);
+};
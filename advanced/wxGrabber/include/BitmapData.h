@@ -76,6 +76,10 @@ public:
     // import BitmapData from a file
     bool importFromFile(const std::string& filepath, std::vector<uint8_t>* currentPalette = nullptr, bool useDithering = false, bool preserveTransparency = false);
 
+    // Import through the native PCX/BMP/TGA/PNG codecs, same result as importFromFile.
+    // Returns false without touching this bitmap if the file needs the wxImage path.
+    bool importWithCodec(const std::string& filepath, std::vector<uint8_t>* currentPalette, bool useDithering, bool preserveTransparency);
+
     // Get a descriptive caption for preview display
     wxString getPreviewCaption() const;
 
@@ -88,6 +92,9 @@ public:
     // Returns true if cropping was performed, false if no cropping was needed
     bool autoCrop(int& xCrop, int& yCrop);
 
+    // Most common raw pixel value (getBytesPerPixel() bytes), the background for autoCrop
+    bool findDominantColor(uint8_t* color) const;
+
     static bool ReadPCXFile(const wxString& filename, wxImage& image);
     
     // Generate an optimal palette for the bitmap
@@ -122,6 +129,10 @@ public:
     // Split image into smaller images using grid cell size
     static std::vector<GridCell> gridBySize(const wxImage& image, int cellWidth, int cellHeight);
 
+    // Cell rectangles only, in the same order as gridByColor/gridBySize, without copying any pixels
+    static std::vector<wxRect> findGridCellsByColor(const wxImage& image, const wxColour& gridColor);
+    static std::vector<wxRect> findGridCellsBySize(const wxImage& image, int cellWidth, int cellHeight);
+
     // Calculate how well a palette represents an image's colors
     // Returns a value between 0 and 1, where:
     // 1 means the palette is a perfect match (all colors in the image are in the palette)
@@ -168,4 +179,11 @@ public:
     // Returns wxRect of the found region, or the whole image if not found.
     static wxRect findCharacterRegion(const std::shared_ptr<wxImage>& image, int x, int y);
 
+    // Fast 64-bit hash of the pixel content (type, format, size, data and alpha)
+    // Used as a version stamp by caches, equal content gives equal hashes
+    uint64_t contentHash() const;
+
+    // Same hash over an arbitrary buffer, e.g. a palette
+    static uint64_t hashBytes(const uint8_t* bytes, size_t size, uint64_t seed = 0);
+
 };
\ No newline at end of file
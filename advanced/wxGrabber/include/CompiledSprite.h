@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+#include "CommonTypes.h"
+
+// Memory surface the sprite blitters draw into, same pixel layout as BitmapData::data
+struct SpriteSurface {
+    int width = 0;
+    int height = 0;
+    int bytesPerPixel = 0;
+    std::vector<uint8_t> pixels;
+
+    SpriteSurface() = default;
+    SpriteSurface(int width, int height, int bytesPerPixel);
+    void clear(uint8_t value = 0);
+};
+
+// Allegro mask color test: palette index 0 for 8-bit, magenta for 15/16/24/32-bit,
+// zero alpha for -32 bit RGBA
+bool isSpriteMaskPixel(const uint8_t* pixel, int bits);
+
+// Opaque-span tables of a sprite, the same row layout Allegro generates its compiled
+// sprite code from: for each row the runs of non-mask pixels with their packed pixel data.
+// Drawing is a memcpy per span, transparent pixels are never looked at.
+class CompiledSprite {
+public:
+    struct Span {
+        uint16_t x;         // First pixel of the run within the row
+        uint16_t length;    // Pixels in the run
+        uint32_t offset;    // Byte offset of the run's pixels in the pixel table
+    };
+
+    bool build(const BitmapData& bitmap);
+    // Draw with the sprite's top left corner at (x, y), clipped to the surface
+    void draw(SpriteSurface& surface, int x, int y) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getSpanCount() const { return spans.size(); }
+    size_t getOpaquePixelCount() const;
+    // Size of the span and pixel tables
+    size_t getMemoryUsage() const;
+
+private:
+    int width = 0;
+    int height = 0;
+    int bytesPerPixel = 0;
+    std::vector<uint32_t> rowStart;   // Index of the first span of each row, height + 1 entries
+    std::vector<Span> spans;
+    std::vector<uint8_t> pixels;
+};
+
+// RLE sprite in Allegro's layout: per row signed counts, positive for a run of
+// pixels that follow, negative for a skip, ended by a zero
+class RleSprite {
+public:
+    bool build(const BitmapData& bitmap);
+    void draw(SpriteSurface& surface, int x, int y) const;
+    size_t getMemoryUsage() const;
+
+private:
+    int width = 0;
+    int height = 0;
+    int bytesPerPixel = 0;
+    std::vector<int32_t> counts;
+    std::vector<uint8_t> pixels;
+};
+
+// Plain bitmap drawn with a per pixel mask test, like Allegro's draw_sprite
+void drawMaskedSprite(SpriteSurface& surface, const BitmapData& bitmap, int x, int y);
+
+// Times the three ways a sprite can be stored in a datafile drawing the same bitmap
+struct SpriteBlitBenchmark {
+    struct Result {
+        double compiledNs = 0;      // Average time per blit
+        double rleNs = 0;
+        double maskedNs = 0;
+        size_t compiledBytes = 0;   // Memory for the drawable form
+        size_t rleBytes = 0;
+        size_t maskedBytes = 0;
+        double opaqueRatio = 0;     // Share of non-mask pixels
+        bool compiledSupported = true;  // Compiled sprites cannot hold RGBA
+        bool outputsMatch = true;   // All blitters produced the same pixels
+        ObjectType recommended = ObjectType::DAT_BITMAP;
+    };
+
+    // Each blitter runs for at least minMillis after a warm-up
+    static bool run(const BitmapData& bitmap, Result& result, int minMillis = 30);
+};
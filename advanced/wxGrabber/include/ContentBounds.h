@@ -0,0 +1,31 @@
+#pragma once
+#include <wx/gdicmn.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Row scanners for raw pixel buffers of 1 to 4 bytes per pixel. "Content" is any
+// pixel that differs from a background value; rows are compared eight bytes at a
+// time with early exit on the first difference. compareMask (bytesPerPixel bytes,
+// nullptr compares everything) selects the bits that take part, e.g. only alpha.
+namespace ContentBounds {
+    // Index of the first/last pixel in [beginX, endX) of a row that differs from the background, or -1
+    int firstMismatch(const uint8_t* row, int beginX, int endX, int bytesPerPixel,
+                      const uint8_t* background, const uint8_t* compareMask = nullptr);
+    int lastMismatch(const uint8_t* row, int beginX, int endX, int bytesPerPixel,
+                     const uint8_t* background, const uint8_t* compareMask = nullptr);
+
+    // Bounding box of the content. Returns false if every pixel matches the background.
+    bool find(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+              const uint8_t* background, const uint8_t* compareMask, wxRect& bounds);
+
+    // True if every pixel equals the first one
+    bool isUniform(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+                   const uint8_t* compareMask = nullptr);
+
+    // Rows/columns made up entirely of the background value, e.g. grid separator lines
+    std::vector<int> findUniformRows(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+                                     const uint8_t* background, const uint8_t* compareMask = nullptr);
+    std::vector<int> findUniformColumns(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+                                        const uint8_t* background, const uint8_t* compareMask = nullptr);
+}
@@ -116,7 +116,9 @@ public:
         }
 
         // Update object data from ORIG property file path if it exists
-        bool update(std::string &ErrorMessage, bool ForceUpdate = false, std::vector<uint8_t>* currentPalette = nullptr, bool useDithering = false);
+        // previousData, when given, receives the replaced payload (moved, not copied)
+        bool update(std::string &ErrorMessage, bool ForceUpdate = false, std::vector<uint8_t>* currentPalette = nullptr, bool useDithering = false,
+                    DataVariant* previousData = nullptr);
 
         // Equality operator to compare two DataObjects
         bool operator==(const DataObject& other) const;
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "DataParser.h"
+
+// Finds identical and nearly identical images among bitmap objects.
+// Exact matches share a hash of depth, size and pixel data. Near matches have
+// perceptual (difference) hashes within a Hamming distance; candidates are found
+// through hash bands so only images sharing a band are compared.
+class DuplicateFinder {
+public:
+    struct Options {
+        bool nearMatches = true;
+        int maxDistance = 4;        // Largest Hamming distance between near matches, at most 7
+        unsigned threadCount = 0;   // 0 uses all cores
+    };
+
+    struct Group {
+        std::vector<std::shared_ptr<DataParser::DataObject>> objects;  // In datafile order, the first is kept on merge
+        bool exact = true;          // All members are pixel identical
+        int maxDistance = 0;        // Largest hash distance to the first member
+    };
+
+    static std::vector<Group> find(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
+                                   const std::vector<uint8_t>& palette, const Options& options);
+
+    // 64-bit difference hash of the image scaled to 9x8 luminance samples
+    static uint64_t perceptualHash(const BitmapData& bitmap, const std::vector<uint8_t>& palette, int* meanLuma = nullptr);
+    // Hash of depth, size and pixel data, independent of the object type
+    static uint64_t pixelHash(const BitmapData& bitmap);
+    static int hammingDistance(uint64_t a, uint64_t b);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+#include "VideoData.h"
+
+// Builds FLI and FLC animations from bitmaps or image files. All frames share
+// one palette: the given palette when every source is an 8-bit bitmap, else the
+// exact colors when the whole sequence has at most 256 of them, else a median
+// cut over the colors of every frame. Each frame is stored as the smallest of a
+// BRUN, a delta (DELTA_FLC for FLC, the byte oriented LC chunk for FLI) and a
+// COPY chunk, or without a pixel chunk when it repeats the frame before.
+// Loading is sequential, conversion, quantization and encoding run on all cores.
+// The finished animation is decoded again and compared with the encoded frames.
+class FlicEncoder {
+public:
+    enum class Format { FLI, FLC };
+
+    struct Input {
+        const BitmapData* bitmap = nullptr;
+        std::string filepath;       // Read when bitmap is null, locale encoded as wxString::ToStdString() gives it
+    };
+
+    struct Params {
+        Format format = Format::FLC;
+        int frameDelayMs = 70;          // FLI stores 1/70 s jiffies, so the delay is rounded to those
+        std::vector<uint8_t> palette;   // Palette the 8-bit bitmaps use
+        unsigned threadCount = 0;       // 0 uses all cores
+    };
+
+    struct Result {
+        VideoData video;
+        int colors = 0;                 // Palette entries used
+        bool exactColors = false;       // Every source color is in the palette
+        int brunFrames = 0;
+        int deltaFrames = 0;
+        int copyFrames = 0;
+        int unchangedFrames = 0;
+    };
+
+    // False when a source cannot be read or the frames differ in size
+    static bool encode(const std::vector<Input>& inputs, const Params& params, Result& result);
+
+    // Chunk bodies, appended to out, for the frame (and the frame before for the deltas).
+    // The delta encoders return false when the change cannot be expressed in their chunk.
+    static void encodeBrun(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out);
+    static bool encodeDeltaFlc(const uint8_t* pixels, const uint8_t* previous, int width, int height, std::vector<uint8_t>& out);
+    static bool encodeDeltaFli(const uint8_t* pixels, const uint8_t* previous, int width, int height, std::vector<uint8_t>& out);
+};
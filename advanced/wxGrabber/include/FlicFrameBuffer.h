@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <wx/image.h>
+
+// The screen a FLIC draws on: one palette index per pixel and a 256 entry
+// colormap, kept between frames because delta chunks only touch what changed.
+// Chunk decoders mark the rows they write; expandDirty() then converts only
+// those rows (all rows after a colormap change) into a persistent RGB copy,
+// so a frame that moves a sprite costs a few rows rather than a full screen.
+class FlicFrameBuffer {
+public:
+    // Black screen and black colormap, everything dirty
+    void resize(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    uint8_t* row(int y) { return pixels.data() + static_cast<size_t>(y) * width; }
+    const std::vector<uint8_t>& getPixels() const { return pixels; }
+    const std::vector<uint8_t>& getColormap() const { return colormap; }
+
+    void markRows(int first, int count);
+    void markAll() { markRows(0, height); }
+    void setColor(int index, uint8_t r, uint8_t g, uint8_t b);
+    // Replace the whole state, for resuming at a keyframe or checkpoint
+    void setColormap(const std::vector<uint8_t>& newColormap);
+    void restore(const std::vector<uint8_t>& newPixels, const std::vector<uint8_t>& newColormap);
+
+    // Bring the RGB copy up to date, returns how many rows were converted
+    int expandDirty();
+    const std::vector<uint8_t>& getRgb() const { return rgb; }
+    // Image of the RGB copy, call expandDirty() first
+    wxImage toImage() const;
+
+    // Palette index to packed RGB, four pixels per step
+    static void expandRow(const uint8_t* indices, size_t count, const uint32_t* lut, uint8_t* out);
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> colormap = std::vector<uint8_t>(256 * 3, 0);
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> dirtyRows;     // Non-zero for rows the RGB copy does not match
+    int dirtyCount = 0;
+    bool colormapChanged = true;
+    std::array<uint32_t, 256> lut = {};  // Colormap as little-endian R, G, B, 0
+};
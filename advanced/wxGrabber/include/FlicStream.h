@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <map>
+#include <vector>
+#include <wx/image.h>
+#include "VideoData.h"
+
+// Random access to the frames of a FLIC without decoding the whole clip.
+// Opening only walks the frame headers. A frame is decoded forward from the
+// closest of: the frame decoded last, the nearest keyframe (BRUN, COPY or
+// BLACK) and the nearest checkpoint, an 8-bit copy of the framebuffer taken
+// every CheckpointInterval frames while decoding, which bounds seeks in clips
+// with a single keyframe. The last few frames handed out are kept in a ring so
+// repaints and short steps back do not decode again.
+// The VideoData must outlive the stream.
+class FlicStream {
+public:
+    static constexpr size_t RingFrames = 8;
+    static constexpr int CheckpointInterval = 32;
+    static constexpr size_t MaxCheckpointBytes = 32 * 1024 * 1024;
+
+    explicit FlicStream(const VideoData& video);
+
+    int getFrameCount() const { return static_cast<int>(index.size()); }
+    // Image of a frame, invalid when the index is out of range or the data is broken
+    wxImage getFrame(int frame);
+    size_t getMemoryUsage() const;
+
+private:
+    struct Checkpoint {
+        std::vector<uint8_t> pixels;
+        std::vector<uint8_t> colormap;
+    };
+    struct CachedFrame {
+        int frame = -1;
+        wxImage image;
+    };
+
+    bool decodeTo(int frame);
+
+    const VideoData& video;
+    std::vector<VideoData::FrameEntry> index;
+    std::vector<int> keyframes;
+    std::map<int, Checkpoint> checkpoints;  // State after the frame
+    size_t checkpointBytes = 0;
+    FlicFrameBuffer frameBuffer;
+    int decodedFrame = -1;                  // Frame the framebuffer holds, -1 for none
+    std::array<CachedFrame, RingFrames> ring;
+    size_t ringNext = 0;
+};
+
+// Decode throughput of a FLIC: the framebuffer path used for playback against
+// converting every pixel of every frame through wxImage::SetRGB
+struct FlicDecodeBenchmark {
+    struct Result {
+        int frames = 0;
+        int width = 0;
+        int height = 0;
+        double decodeUs = 0;        // Average per frame, chunks into the 8-bit framebuffer
+        double expandUs = 0;        // Average per frame, dirty rows to RGB
+        double fullConvertUs = 0;   // Average per frame, every pixel through SetRGB
+        double dirtyRowShare = 0;   // Rows converted over rows shown
+        double framesPerSecond = 0; // Decode plus expand
+        bool outputsMatch = true;   // Incremental RGB equals a full conversion of every frame
+    };
+
+    // Plays the whole clip repeatedly for at least minMillis
+    static bool run(const VideoData& video, Result& result, int minMillis = 30);
+};
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <memory>
 #include <wx/string.h>
 #include <wx/font.h>
 #include <wx/image.h>
@@ -21,6 +22,26 @@ public:
         std::vector<uint8_t> data;
         
     };
+    // Every glyph of a range rendered once into one RGB + alpha sheet, packed
+    // shelf by shelf, so previews copy rectangles instead of decoding glyphs.
+    // Empty pixels are black with zero alpha, like a fresh preview image.
+    struct GlyphAtlas {
+        struct Rect {
+            int x = 0;
+            int y = 0;
+            int width = 0;
+            int height = 0;
+        };
+        uint64_t hash = 0;              // Range::contentHash() the sheet was built from
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> rgb;       // width * height * 3
+        std::vector<uint8_t> alpha;     // width * height
+        std::vector<Rect> rects;        // One per glyph, empty for glyphs without pixels
+
+        // Copy a glyph into the image (which must have alpha) with its top left at x, y
+        void blit(size_t glyphIndex, wxImage& img, int x, int y) const;
+    };
     struct Range {
         int8_t mono;
         uint32_t start;
@@ -30,7 +51,15 @@ public:
         
         // Helper method for rendering glyph pixels
         void renderGlyphPixels(const Glyph& glyph, wxImage& img, int offsetX, int offsetY, int fontSize) const;
+        void renderGlyphPixels(const Glyph& glyph, unsigned char* rgb, unsigned char* alpha, int imgWidth, int imgHeight, int offsetX, int offsetY) const;
         int getBitDepth() const;
+        // Hash of the color format, code points and glyph pixels, chained from seed
+        uint64_t contentHash(uint64_t seed = 0) const;
+        // The atlas of the current glyphs, rebuilt only when contentHash() changed
+        std::shared_ptr<const GlyphAtlas> getAtlas() const;
+
+    private:
+        mutable std::shared_ptr<const GlyphAtlas> atlas;
     };
     struct ScriptRange {
         ScriptRange(wxString filename, uint32_t start, uint32_t end) : filename(filename), start(start), end(end) {};
@@ -60,6 +89,7 @@ public:
     static wxString formatUnicodeRange(uint32_t start, uint32_t end);
     static wxString getColorDepthStringFromMono(int8_t mono);
     static wxBitmap createGlyphDisplayBitmap(const Range& range, uint32_t glyphIndex, int targetSize = 16);
+    static wxBitmap createGlyphDisplayBitmap(const GlyphAtlas& atlas, uint32_t glyphIndex, int targetSize = 16);
 
     // Import/Export functions
     static Range ImportBitmapAsRange(const wxString& filename, uint32_t baseCharacter, int8_t colorFormat);
@@ -42,6 +42,7 @@ public:
     
 private:
     const FontData::Range* m_range;
+    std::shared_ptr<const FontData::GlyphAtlas> m_atlas;  // Glyph column is drawn from this
 };
 
 // Dialog for entering base character when importing a range
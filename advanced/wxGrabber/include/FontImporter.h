@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <wx/image.h>
+#include "FontData.h"
+
+// Builds multi-range Unicode fonts from any mix of grid sheets (separator lines
+// as ExportRangeAsBitmap writes them, or fixed size cells), BDF fonts and GRX
+// fonts. Every glyph gets the code its source gives it (first code of the sheet
+// plus the cell index, the BDF ENCODING, the GRX character code), optionally
+// translated by a mapping file, and the glyphs are then split into contiguous
+// ranges. Cell extraction, BDF bitmap decoding and trimming run on all cores.
+class FontImporter {
+public:
+    enum class SourceType { Auto, GridSheet, Bdf, Grx };
+
+    struct Source {
+        std::string filepath;
+        SourceType type = SourceType::Auto;   // Auto goes by extension: .bdf, .fnt (GRX), else an image
+        std::string mappingFile;              // Optional, see readMappingFile
+        // Grid sheets only
+        uint32_t firstCode = 0x20;            // Code of the top left cell
+        bool followPrevious = false;          // Start after the last code of the previous grid sheet instead
+        int8_t colorFormat = 1;               // Glyph mono value: 1, 0 (8-bit indexed), 24 or -32
+        int cellWidth = 0;                    // Fixed cells when both are set, separator lines otherwise
+        int cellHeight = 0;
+    };
+
+    struct Options {
+        bool trim = false;          // Crop blank columns left and right of each glyph (not blank glyphs)
+        int spacing = 1;            // Blank columns added right of trimmed glyphs
+        uint32_t maxGapFill = 0;    // Join ranges at most this many code points apart, the gap gets empty glyphs
+        unsigned threadCount = 0;   // 0 uses all cores
+    };
+
+    struct BlockCoverage {
+        std::string name;
+        uint32_t start = 0;
+        uint32_t end = 0;           // Inclusive, 0 start and end for code points outside the known blocks
+        int glyphs = 0;             // Code points of the block the font has a glyph for
+    };
+
+    struct Result {
+        FontData font;
+        int glyphs = 0;             // Distinct code points imported
+        int duplicates = 0;         // Glyphs dropped because an earlier source had the code point
+        std::vector<BlockCoverage> coverage;
+    };
+
+    // False when a source cannot be read or nothing was imported
+    static bool import(const std::vector<Source>& sources, const Options& options, Result& result);
+
+    // Blocks with at least one glyph in code point order, empty glyphs do not count
+    static std::vector<BlockCoverage> computeCoverage(const FontData& font);
+    static std::string formatCoverage(const std::vector<BlockCoverage>& coverage);
+
+    // Type of a path by its extension, what Auto resolves to
+    static SourceType detectType(const std::string& path);
+
+    // One "source code" pair per line, "#" starts a comment, so the unicode.org
+    // MAPPINGS tables load as they are. "first-last code" maps a run of source
+    // codes. Numbers are hex with 0x or U+, else decimal. Unlisted codes stay.
+    static bool readMappingFile(const std::string& path, std::map<uint32_t, uint32_t>& mapping);
+
+    // Glyphs of a BDF font as mono glyphs, each placed in a cell as tall as the
+    // font ascent plus descent and as wide as its advance
+    static bool parseBdf(const std::string& text, std::vector<std::pair<uint32_t, FontData::Glyph>>& glyphs,
+                         unsigned threadCount = 0);
+
+    // Convert image cells into glyphs of the color format, in cell order. Separator
+    // and transparent colored pixels become transparent.
+    static void extractCells(const wxImage& image, const std::vector<wxRect>& cells, int8_t colorFormat,
+                             const uint8_t separatorRGB[3], const uint8_t transparentRGB[3],
+                             std::vector<FontData::Glyph>& glyphs, unsigned threadCount = 0);
+
+    // Crop blank columns from both sides and add spacing, blank glyphs are left alone
+    static void trimGlyph(FontData::Glyph& glyph, int8_t mono, int spacing);
+};
@@ -47,6 +47,7 @@ public:
     int GetGriddleType() const { return m_griddleType; }
     uint32_t GetGriddleColor() const { return m_griddleColor; }
     const std::string& GetPassword() const { return m_password; }
+    int GetUndoMemory() const { return m_undoMemory; }
 
     // Setters
     void SetXGrid(int value) { m_xGrid = value; }
@@ -66,6 +67,7 @@ public:
     void SetGriddleType(int value) { m_griddleType = value; }
     void SetGriddleColor(uint32_t value) { m_griddleColor = value; }
     void SetPassword(const std::string& value) { m_password = value; }
+    void SetUndoMemory(int value) { m_undoMemory = value; }
 
     // Shell association lookup
     std::string GetShellCommandForType(const std::string& type) const;
@@ -94,6 +96,7 @@ private:
     std::string m_name;     // NAME - Datafile name
     CompressionMode m_pack; // PACK - Compression mode (0=None, 1=Individual, 2=Global)
     std::string m_password; // PASSWORD - Password for encryption
+    int m_undoMemory;       // Undo history limit in megabytes
 
     // Shell associations
     std::unordered_map<std::string, std::string> m_shellAssociations;
@@ -0,0 +1,43 @@
+#pragma once
+#include <wx/image.h>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+#include "CommonTypes.h"
+
+// Converts the cells of a grid-split image into bitmap objects on a pool of worker threads.
+// Cell boundaries come from BitmapData::findGridCellsByColor/BySize; each worker then crops,
+// converts to the target depth and optionally auto-crops its cells independently.
+class GridGrabber {
+public:
+    struct Options {
+        ObjectType typeID = ObjectType::DAT_BITMAP;
+        int bits = 24;
+        bool skipEmpties = false;
+        bool autoCrop = false;
+        bool useDithering = false;
+        bool preserveTransparency = false;
+    };
+
+    struct Cell {
+        wxRect rect;            // Position of the cell in the source image
+        BitmapData bitmap;
+        int cropX = 0;
+        int cropY = 0;
+        bool cropped = false;
+        bool keep = false;      // False for skipped empties and failed conversions
+    };
+
+    // Called on the calling thread with the number of finished cells; return false to cancel
+    using ProgressCallback = std::function<bool(size_t done, size_t total)>;
+
+    // Process all cells, results are in the same order as rects.
+    // Returns false if the progress callback cancelled the grab.
+    static bool processCells(const wxImage& image, const std::vector<wxRect>& rects, const Options& options,
+                             const std::vector<uint8_t>& palette, std::vector<Cell>& cells,
+                             const ProgressCallback& progress = nullptr, unsigned threadCount = 0);
+
+private:
+    static void processCell(const wxImage& image, const Options& options, std::vector<uint8_t>& palette, Cell& cell);
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "BitmapData.h"
+
+// Native readers/writers for PCX, BMP, TGA and PNG that stream one scanline at a
+// time straight into/out of BitmapData at the file's own depth, without going
+// through wxImage. Paletted files stay 8-bit and keep their palette.
+// Variants that are not handled here (interlaced PNG, RLE BMP, 16-bit TGA, ...)
+// make readFile return false so callers can fall back to wxImage::LoadFile.
+class ImageCodec {
+public:
+    enum class Format { Unknown, PCX, BMP, TGA, PNG };
+
+    struct DecodedImage {
+        BitmapData bitmap;              // bits is 8, 24 or -32
+        std::vector<uint8_t> palette;   // 256 RGB entries (768 bytes) for 8-bit images
+        bool paletteHasAlpha = false;   // Indexed PNG with transparent tRNS entries
+    };
+
+    static Format formatFromPath(const std::string& path);
+
+    static bool readFile(const std::string& path, DecodedImage& image);
+
+    // Write an 8, 24, 32 or -32 bit bitmap; 8-bit images are written with the given palette.
+    // PCX has no alpha, -32 bitmaps are written as 24-bit there.
+    static bool writeFile(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette);
+
+private:
+    static bool readPCX(const std::string& path, DecodedImage& image);
+    static bool readBMP(const std::string& path, DecodedImage& image);
+    static bool readTGA(const std::string& path, DecodedImage& image);
+    static bool readPNG(const std::string& path, DecodedImage& image);
+
+    static bool writePCX(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette);
+    static bool writeBMP(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette);
+    static bool writeTGA(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette);
+    static bool writePNG(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette);
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <wx/scrolwin.h>
+#include <wx/image.h>
+#include <wx/bitmap.h>
+#include <unordered_map>
+#include <list>
+#include <vector>
+
+// Scrollable image preview that only renders the visible part of the zoomed image.
+// The converted image is kept once at its native size (plus half-size mip levels for
+// zoom-out); the viewport is drawn from nearest-neighbor scaled tiles kept in a small
+// LRU cache sized to the window, so memory does not grow with the zoom factor.
+class ImagePreviewCanvas : public wxScrolledCanvas {
+public:
+    ImagePreviewCanvas(wxWindow* parent, wxWindowID id = wxID_ANY);
+
+    void SetImage(const wxImage& image, bool addBorder = false);
+    void SetZoom(double zoomLevel);
+    void ClearImage();
+
+    double GetZoom() const { return m_zoom; }
+    bool HasImage() const { return !m_mipLevels.empty(); }
+
+    // Size in pixels of the square screen tiles the viewport is rendered with
+    static constexpr int TileSize = 256;
+    // Space between the panel edge and the image, matches the old sizer border
+    static constexpr int Margin = 5;
+
+private:
+    void OnPaint(wxPaintEvent& event);
+    void OnSize(wxSizeEvent& event);
+
+    void UpdateVirtualSize();
+    void InvalidateTiles();
+    void UpdateTileCapacity();
+    int SelectMipLevel();
+    const wxBitmap& GetTile(int tileX, int tileY);
+    wxImage RenderTile(int tileX, int tileY);
+
+    std::vector<wxImage> m_mipLevels;  // [0] is the unscaled image, each next level is half size
+    bool m_addBorder = false;
+    double m_zoom = 1.0;
+    int m_scaledWidth = 0;
+    int m_scaledHeight = 0;
+
+    // Tile cache for the current image and zoom, keyed by packed tile coordinates
+    std::unordered_map<uint64_t, std::pair<wxBitmap, std::list<uint64_t>::iterator>> m_tiles;
+    std::list<uint64_t> m_tileOrder;  // Most recently used first
+    size_t m_tileCapacity = 16;
+
+    wxDECLARE_EVENT_TABLE();
+};
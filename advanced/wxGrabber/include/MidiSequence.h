@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AudioData.h"
+
+// Parsed form of a MIDI object: the channel messages of all tracks merged into
+// one list in playback order, each with its time through the tempo map, so a
+// position is found by binary search. Controller state is checkpointed every
+// CheckpointInterval events, which keeps seeking to any time O(log n) plus a
+// short replay. Also summarizes what each track and channel contains.
+class MidiSequence {
+public:
+    static constexpr size_t CheckpointInterval = 256;
+    static constexpr int PercussionChannel = 9;
+
+    struct Event {
+        int64_t timeUs = 0;     // From the start of the sequence
+        uint32_t tick = 0;
+        uint8_t track = 0;
+        uint8_t status = 0;     // Channel message status byte, channel in the low nibble
+        uint8_t data1 = 0;
+        uint8_t data2 = 0;
+
+        int channel() const { return status & 0x0F; }
+        int command() const { return status & 0xF0; }
+        bool isNoteOn() const { return command() == 0x90 && data2 > 0; }
+        bool isNoteOff() const { return command() == 0x80 || (command() == 0x90 && data2 == 0); }
+    };
+
+    struct TrackInfo {
+        std::string name;
+        size_t eventCount = 0;      // Channel messages only
+        size_t noteCount = 0;
+        uint16_t channelMask = 0;   // Bit per channel the track sends to
+    };
+
+    struct ChannelInfo {
+        size_t noteCount = 0;
+        int firstProgram = -1;      // -1 when no program change is sent
+        uint8_t lowestNote = 127;
+        uint8_t highestNote = 0;
+        uint32_t trackMask = 0;     // Bit per track that sends to the channel
+    };
+
+    // Controller and note state a synthesizer needs to start mid-sequence
+    struct ChannelState {
+        uint8_t program = 0;
+        uint8_t volume = 100;
+        uint8_t expression = 127;
+        uint8_t pan = 64;
+        bool sustain = false;
+        int16_t pitchBend = 0;      // -8192..8191
+        uint8_t bendRange = 2;      // Semitones, set through RPN 0
+        uint8_t rpnMsb = 127;       // Selected RPN, 127/127 is none
+        uint8_t rpnLsb = 127;
+        std::bitset<128> notes;     // Keys held down
+    };
+    using ChannelStates = std::array<ChannelState, 16>;
+
+    // Parse the tracks of a DAT_MIDI object, false when they are not valid MIDI
+    bool parse(const AudioData& audio);
+
+    const std::vector<Event>& getEvents() const { return events; }
+    const std::vector<TrackInfo>& getTracks() const { return tracks; }
+    const std::array<ChannelInfo, 16>& getChannels() const { return channels; }
+    int64_t getDurationUs() const { return durationUs; }
+    int getDurationMs() const { return static_cast<int>(durationUs / 1000); }
+
+    // Index of the first event at or after timeUs, events.size() past the end
+    size_t findEvent(int64_t timeUs) const;
+    int64_t tickToUs(uint32_t tick) const;
+
+    // Controller state of all channels after the events before eventIndex
+    ChannelStates stateBefore(size_t eventIndex) const;
+    // Update the controller state for one event
+    static void applyEvent(const Event& event, ChannelStates& states);
+
+private:
+    struct TempoChange {
+        uint32_t tick;
+        int64_t timeUs;                 // Time at tick
+        uint32_t microsPerQuarter;
+    };
+
+    bool parseTrack(const std::vector<uint8_t>& data, uint8_t track, uint32_t& endTick,
+                    std::vector<std::pair<uint32_t, uint32_t>>& tempos);
+
+    std::vector<Event> events;
+    std::vector<TempoChange> tempoMap;  // Ascending ticks, first entry at tick 0
+    std::vector<ChannelStates> checkpoints;  // State before events[i * CheckpointInterval]
+    std::vector<TrackInfo> tracks;
+    std::array<ChannelInfo, 16> channels;
+    uint16_t ticksPerQuarter = 96;
+    double smpteUsPerTick = 0.0;        // Set for SMPTE divisions, the tempo map is unused then
+    int64_t durationUs = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "MidiSequence.h"
+
+// Small built-in synthesizer so MIDI objects can be previewed, seeked and
+// drawn as a waveform without a system MIDI device. Every General MIDI family
+// maps to one band-limited oscillator and envelope, and the percussion channel
+// to a handful of noise and pitch-swept drums. It aims at recognizable, not at
+// faithful, playback. Output is interleaved 16-bit stereo.
+class MidiSynth {
+public:
+    static constexpr int MaxVoices = 48;
+
+    explicit MidiSynth(int sampleRate);
+
+    // Silence all voices and take over controller state, restarting held notes
+    void reset(const MidiSequence::ChannelStates& states);
+    void handle(const MidiSequence::Event& event);
+    void render(int16_t* samples, size_t frameCount);
+
+private:
+    enum class Wave { Sine, Triangle, Square, Saw, Noise };
+
+    struct Patch {
+        Wave wave;
+        float attack;       // Seconds
+        float decay;        // Seconds to fall by 60 dB towards the sustain level
+        float sustain;      // 0 for plucked sounds that die away while held
+        float release;
+    };
+
+    struct Voice {
+        bool active = false;
+        bool released = false;
+        bool sustained = false;     // Note off arrived while the pedal was down
+        bool drum = false;
+        uint8_t channel = 0;
+        uint8_t note = 0;
+        uint32_t age = 0;           // Start order, the oldest voice is stolen first
+        Wave wave = Wave::Sine;
+        float gain = 0.0f;          // Velocity
+        double phase = 0.0;
+        double increment = 0.0;     // Cycles per sample before pitch bend
+        float level = 0.0f;
+        float attackStep = 0.0f;
+        float decayFactor = 1.0f;
+        float sustainLevel = 0.0f;
+        float releaseFactor = 1.0f;
+        bool attacking = true;
+        // Drums
+        float sweepFactor = 1.0f;   // Applied to the increment every sample
+        float noiseMix = 0.0f;
+        float highPass = 0.0f;      // One-pole filter state for cymbals
+        bool bright = false;
+    };
+
+    static const Patch& patchFor(uint8_t program);
+
+    void noteOn(uint8_t channel, uint8_t note, uint8_t velocity);
+    void noteOff(uint8_t channel, uint8_t note);
+    void releaseSustained(uint8_t channel);
+    Voice& allocateVoice();
+    void startDrum(Voice& voice, uint8_t note);
+    float nextNoise();
+
+    int sampleRate;
+    std::array<Voice, MaxVoices> voices;
+    MidiSequence::ChannelStates states;
+    std::vector<float> mix;
+    uint32_t nextAge = 0;
+    uint32_t noiseState = 0x12345678u;
+};
@@ -5,6 +5,9 @@
 #include <functional>
 #include "DataParser.h"
 
+// The find, replace, insert and move functions look objects up through an index
+// of the last tree they searched, which they keep current for their own changes
+// and rebuild when the tree was changed some other way. Use from the UI thread.
 namespace ObjectTraversalUtils {
     // Find and remove object from a vector, returns true if found and removed
     bool FindAndRemoveObject(std::vector<std::shared_ptr<DataParser::DataObject>>& objects, 
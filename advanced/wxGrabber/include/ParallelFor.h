@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run fn(i) for every i below count across the workers, like BatchTransform::run.
+// Indices are handed out one at a time, so uneven work balances itself. 0 threads
+// uses all cores, a single thread runs fn inline.
+template <typename Fn>
+void parallelFor(size_t count, unsigned threadCount, Fn fn) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, count));
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Media time for fixed-rate playback, measured on a monotonic clock from the
+// moment playback started rather than accumulated tick by tick, so timer
+// jitter and slow frames never add up to drift. The frame to show is the one
+// whose period contains the current position; frames whose period passed
+// before they could be shown are skipped and counted as dropped.
+// A master clock, such as the position of a sound playing alongside, can be
+// followed: small differences are slewed out, large ones are jumped to.
+class PlaybackClock {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int64_t ResyncThresholdUs = 100000;
+    static constexpr int SlewDivisor = 16;  // Share of the master error removed per update
+
+    struct Stats {
+        int framesShown = 0;
+        int framesDropped = 0;   // Passed over because a later frame was already due
+        int lateFrames = 0;      // Shown more than a frame period after they were due
+        int64_t maxLateUs = 0;
+        int resyncs = 0;         // Jumps to the master clock
+    };
+
+    void setFrameDuration(int64_t frameDurationUs);
+    int64_t getFrameDurationUs() const { return frameDurationUs; }
+    // Position of the master in microseconds, negative while it is not playing
+    void setMaster(std::function<int64_t()> newMaster) { master = std::move(newMaster); }
+
+    void start(int64_t positionUs);
+    void pause();
+    void seek(int64_t positionUs);
+    bool isRunning() const { return running; }
+
+    // Media position now, following the master when it plays
+    int64_t update();
+    int64_t getPositionUs() const { return positionUs; }  // As of the last update
+    int frameAt(int64_t mediaUs) const { return static_cast<int>(mediaUs / frameDurationUs); }
+    int64_t frameStartUs(int frame) const { return frame * frameDurationUs; }
+    // Wall time until the frame is due, 0 once it is
+    int64_t getUsUntil(int frame) const;
+
+    // Count a frame once it is ready to be put on screen
+    void frameShown(int frame);
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = Stats(); }
+
+private:
+    int64_t localPositionUs(Clock::time_point now) const;
+    void rebase(int64_t mediaUs, Clock::time_point now);
+
+    int64_t frameDurationUs = 1000000 / 70;
+    std::function<int64_t()> master;
+    bool running = false;
+    Clock::time_point originTime;   // Wall time at originUs
+    int64_t originUs = 0;
+    int64_t positionUs = 0;
+    int lastShownFrame = -1;        // -1 after a start or seek, nothing to skip from
+    Stats stats;
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <wx/image.h>
+#include <memory>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "DataParser.h"
+
+// LRU cache of bitmap objects converted to wxImage for the preview panel.
+// Entries are keyed by object UID, a content hash of the bitmap data (so edits
+// invalidate implicitly), the palette hash (8-bit images only) and the
+// transparency flag. The cache is bounded by a memory budget in bytes.
+// Neighbouring objects can be converted ahead of time on a worker thread.
+class PreviewImageCache {
+public:
+    struct Key {
+        uint32_t uid;
+        uint64_t dataHash;
+        uint64_t paletteHash;
+        bool preserveTransparency;
+
+        bool operator==(const Key& other) const {
+            return uid == other.uid && dataHash == other.dataHash &&
+                   paletteHash == other.paletteHash && preserveTransparency == other.preserveTransparency;
+        }
+    };
+
+    static constexpr size_t DefaultBudgetBytes = 64 * 1024 * 1024;
+
+    explicit PreviewImageCache(size_t budgetBytes = DefaultBudgetBytes);
+    ~PreviewImageCache();
+
+    // Return the converted image for a bitmap object, converting it on a miss.
+    // Returns nullptr if the object is not a bitmap or the conversion fails.
+    std::shared_ptr<const wxImage> get(const DataParser::DataObject& obj, const std::vector<uint8_t>& palette,
+                                       bool preserveTransparency = false);
+
+    // Queue background conversion of the given objects, replacing any pending requests
+    void prefetch(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
+                  const std::vector<uint8_t>& palette, bool preserveTransparency = false);
+
+    void clear();
+    void setBudget(size_t budgetBytes);
+    size_t getMemoryUsage() const;
+    size_t getEntryCount() const;
+
+    static Key makeKey(const DataParser::DataObject& obj, uint64_t paletteHash, bool preserveTransparency);
+    static uint64_t hashPalette(const std::vector<uint8_t>& palette);
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.dataHash ^ (key.paletteHash * 31) ^
+                                       (static_cast<uint64_t>(key.uid) << 1) ^ key.preserveTransparency);
+        }
+    };
+
+    struct Entry {
+        std::shared_ptr<const wxImage> image;
+        size_t bytes;
+        std::list<Key>::iterator orderIt;
+    };
+
+    // Snapshot taken on the UI thread so the worker never touches live objects
+    struct PrefetchJob {
+        Key key;
+        BitmapData bitmap;
+    };
+
+    static std::shared_ptr<const wxImage> convert(const BitmapData& bitmap, std::vector<uint8_t>& palette,
+                                                  bool preserveTransparency);
+    static size_t imageBytes(const wxImage& image);
+
+    std::shared_ptr<const wxImage> lookupLocked(const Key& key);
+    void insertLocked(const Key& key, std::shared_ptr<const wxImage> image);
+    void evictLocked();
+    void workerLoop();
+
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    std::list<Key> order;  // Most recently used first
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+
+    std::deque<PrefetchJob> jobs;
+    std::vector<uint8_t> jobPalette;
+    bool jobTransparency = false;
+    bool stopWorker = false;
+    std::condition_variable jobsAvailable;
+    std::thread worker;
+};
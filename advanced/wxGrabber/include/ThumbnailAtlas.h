@@ -0,0 +1,121 @@
+#pragma once
+#include <wx/image.h>
+#include <wx/colour.h>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <list>
+#include <variant>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "DataParser.h"
+
+// Fixed-cell texture atlas holding small RGB thumbnails of datafile objects.
+// Thumbnails live in square pages of CellsPerRow x CellsPerRow cells; when all
+// pages are full the least recently used cell is reused. Each thumbnail carries
+// a stamp of the content it was rendered from, lookups with a different stamp miss.
+// Thread safe.
+class ThumbnailAtlas {
+public:
+    static constexpr int ThumbSize = 64;
+    static constexpr int CellsPerRow = 16;
+    static constexpr int PageSize = ThumbSize * CellsPerRow;
+
+    // Location of a stored thumbnail, width/height are the used part of the cell
+    struct Slot {
+        int page = 0;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    explicit ThumbnailAtlas(size_t maxPages = 8);
+
+    // Store a thumbnail of at most ThumbSize x ThumbSize pixels (alpha is ignored)
+    void store(uint32_t uid, uint64_t stamp, const wxImage& thumbnail);
+    bool find(uint32_t uid, uint64_t stamp, Slot& slot);
+    bool contains(uint32_t uid, uint64_t stamp) const;
+    void clear();
+
+    size_t getPageCount() const;
+    // Incremented every time a page's pixels change
+    uint64_t getPageVersion(size_t page) const;
+    // Copy of a whole page as an RGB image
+    wxImage getPageImage(size_t page) const;
+
+private:
+    struct Page {
+        std::vector<uint8_t> rgb;
+        uint64_t version = 0;
+    };
+
+    struct CellEntry {
+        Slot slot;
+        uint64_t stamp;
+        std::list<uint32_t>::iterator orderIt;
+    };
+
+    Slot allocateCellLocked();
+
+    mutable std::mutex mutex;
+    size_t maxPages;
+    std::vector<Page> pages;
+    size_t nextCell = 0;               // Next never-used cell index across all pages
+    std::unordered_map<uint32_t, CellEntry> cells;
+    std::list<uint32_t> order;         // Most recently used first
+};
+
+// Pool of worker threads rendering thumbnails into a ThumbnailAtlas.
+// Objects are copied when requested, so workers never read objects the UI thread may edit.
+class ThumbnailGenerator {
+public:
+    explicit ThumbnailGenerator(ThumbnailAtlas& atlas, unsigned threadCount = 0);
+    ~ThumbnailGenerator();
+
+    // Replace pending requests with the given objects, first object is rendered first
+    void request(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects, const std::vector<uint8_t>& palette);
+    // UIDs whose thumbnails were stored since the last call
+    std::vector<uint32_t> takeCompleted();
+    // Drop pending requests, e.g. before the atlas is cleared
+    void cancelPending();
+
+    // True for object types a thumbnail can be rendered for
+    static bool canRender(const DataParser::DataObject& obj);
+
+    // Content stamp a thumbnail is checked against. Bitmaps and fonts are hashed
+    // fully, FLIC data is sampled since only its first frame is shown.
+    static uint64_t stampFor(const DataParser::DataObject& obj, uint64_t paletteHash);
+
+    // Fit an image into a ThumbSize square, compositing alpha onto the background
+    static wxImage makeThumbnail(const wxImage& image, const wxColour& background);
+
+    static const wxColour BackgroundColour;
+
+private:
+    using Snapshot = std::variant<BitmapData, FontData, VideoData>;
+
+    struct Job {
+        uint32_t uid;
+        uint64_t stamp;
+        Snapshot snapshot;
+        std::shared_ptr<const std::vector<uint8_t>> palette;
+    };
+
+    static wxImage renderSnapshot(const Job& job);
+    void workerLoop();
+
+    ThumbnailAtlas& atlas;
+    std::mutex mutex;
+    std::condition_variable jobsAvailable;
+    std::deque<Job> jobs;
+    std::unordered_set<uint32_t> inFlight;
+    std::unordered_map<uint32_t, uint64_t> failed;  // Stamp that could not be rendered, not retried
+    std::vector<uint32_t> completed;
+    bool stopWorkers = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <wx/scrolwin.h>
+#include <wx/bitmap.h>
+#include <wx/timer.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "DataParser.h"
+#include "ThumbnailAtlas.h"
+
+// Virtual grid of object thumbnails. Only the visible cells are painted; missing
+// thumbnails are requested from a background ThumbnailGenerator and show a type
+// placeholder until a timer picks up the finished ones, so the UI never waits.
+class ThumbnailGridView : public wxScrolledCanvas {
+public:
+    // Called with the clicked object, activated is true for a double-click
+    using SelectCallback = std::function<void(std::shared_ptr<DataParser::DataObject>, bool activated)>;
+
+    ThumbnailGridView(wxWindow* parent, SelectCallback selectCallback);
+    ~ThumbnailGridView();
+
+    // Objects shown in the grid, in display order
+    void SetObjects(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects);
+    void SetPalette(const std::vector<uint8_t>& palette);
+    void SetSelection(const std::shared_ptr<DataParser::DataObject>& obj);
+    // Forget every thumbnail, e.g. after loading another datafile
+    void ClearThumbnails();
+
+    static constexpr int CellWidth = ThumbnailAtlas::ThumbSize + 16;
+    static constexpr int CellHeight = ThumbnailAtlas::ThumbSize + 24;
+    static constexpr int PollIntervalMs = 100;
+
+private:
+    struct Item {
+        std::shared_ptr<DataParser::DataObject> object;
+        uint64_t stamp = 0;
+        bool stampValid = false;
+    };
+
+    void OnPaint(wxPaintEvent& event);
+    void OnSize(wxSizeEvent& event);
+    void OnMouse(wxMouseEvent& event);
+    void OnPollTimer(wxTimerEvent& event);
+
+    int GetColumns() const;
+    void UpdateVirtualSize();
+    int HitTest(const wxPoint& position) const;
+    uint64_t GetStamp(Item& item);
+    const wxBitmap& GetPageBitmap(size_t page);
+    void RequestVisible(const std::vector<std::shared_ptr<DataParser::DataObject>>& missing);
+
+    ThumbnailAtlas m_atlas;
+    ThumbnailGenerator m_generator;  // Declared after the atlas so its workers stop first
+    SelectCallback m_selectCallback;
+    std::vector<Item> m_items;
+    std::vector<uint8_t> m_palette;
+    uint64_t m_paletteHash = 0;
+    int m_selected = -1;
+    std::vector<std::pair<wxBitmap, uint64_t>> m_pageBitmaps;  // Uploaded page and its atlas version
+    wxTimer m_pollTimer;
+
+    wxDECLARE_EVENT_TABLE();
+};
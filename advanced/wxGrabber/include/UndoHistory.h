@@ -0,0 +1,80 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataParser.h"
+
+// Undo/redo stack for the object tree.
+// Every record keeps the tree structure as lists of object pointers, so a delete,
+// move or sort is undone by putting the old lists back without copying any
+// payload; removed objects stay alive through those pointers. Objects whose
+// contents a command edits in place are saved whole before the change. Undo
+// swaps the saved state with the current one, so the same record then serves
+// as the redo step. Oldest records are dropped when the saved state exceeds the
+// memory budget.
+class UndoHistory {
+public:
+    using ObjectList = std::vector<std::shared_ptr<DataParser::DataObject>>;
+
+    static constexpr size_t DefaultBudgetBytes = 256 * 1024 * 1024;
+
+    explicit UndoHistory(size_t budgetBytes = DefaultBudgetBytes);
+
+    // Save the state before a change: the structure under root, and the full
+    // contents of the objects in changed. Clears the redo steps.
+    void record(const std::string& description, ObjectList& root, const ObjectList& changed = {});
+
+    // Same as record, for a change already made to the objects in previous, which
+    // hold their former contents (usually moved out of them rather than copied)
+    using SavedContents = std::vector<std::pair<std::shared_ptr<DataParser::DataObject>, DataParser::DataObject>>;
+    void recordPrevious(const std::string& description, ObjectList& root, SavedContents previous);
+    // Former state of obj for recordPrevious: its current properties with the given payload
+    static DataParser::DataObject withData(const DataParser::DataObject& obj, DataParser::DataVariant data);
+
+    // Cheaper record for edits that only touch properties (and so the name), payloads are not saved
+    void recordProperties(const std::string& description, ObjectList& root, const ObjectList& changed);
+
+    // Forget the last record, for a change that did not happen after all
+    void discardLast();
+
+    bool undo(ObjectList& root);
+    bool redo(ObjectList& root);
+
+    bool canUndo() const { return !undoSteps.empty(); }
+    bool canRedo() const { return !redoSteps.empty(); }
+    std::string undoDescription() const;
+    std::string redoDescription() const;
+
+    void clear();
+    void setBudget(size_t budgetBytes);
+    size_t getMemoryUsage() const { return usedBytes; }
+
+    // Approximate memory held by an object's own contents, nested objects count as pointers
+    static size_t payloadBytes(const DataParser::DataObject& obj);
+
+private:
+    struct Properties {
+        DataParser::PropertyMap values;
+        std::vector<uint32_t> order;
+        std::string name;
+    };
+
+    struct Step {
+        std::string description;
+        ObjectList root;
+        std::vector<std::pair<std::shared_ptr<DataParser::DataObject>, ObjectList>> children;
+        SavedContents contents;
+        std::vector<std::pair<std::shared_ptr<DataParser::DataObject>, Properties>> properties;
+        size_t bytes = 0;
+    };
+
+    static void swapState(Step& step, ObjectList& root);
+    void push(Step step, ObjectList& root);
+    void evict();
+
+    std::deque<Step> undoSteps;   // Oldest first
+    std::vector<Step> redoSteps;  // Next redo last
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+};
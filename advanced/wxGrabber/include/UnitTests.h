@@ -12,6 +12,14 @@ public:
     static bool LZSSFileDecompressTest(const std::string& compressedFilename, const std::string& etalonFilename);
     static bool LZSSFileDecompressTest();
     static bool LZSSTests();
+    // Hand-built BRUN, DELTA_FLC, LC, BLACK and COPY chunks, including truncated ones
+    static bool FlicDecoderTests();
+    // FLI and FLC encodes of synthetic 8-bit and RGB frames, decoded again
+    static bool FlicEncoderTests();
+    // PCX, BMP, TGA and PNG written and read back at every depth ImageCodec writes
+    static bool ImageCodecTests();
+    // BDF parsing (ENCODING -1 n, negative BBX offsets) and mapping files (ranges, lines without a target)
+    static bool FontImporterTests();
 
 private:
     struct TestCase {
@@ -6,6 +6,7 @@
 #include <wx/string.h>
 #include <wx/statbmp.h>
 #include "CommonTypes.h"
+#include "FlicFrameBuffer.h"
 
 class VideoData {
 public:
@@ -19,6 +20,7 @@ public:
     int frameRate = 0;       // Frames per second
     int frameDelay = 0;      // Frame delay in milliseconds
     int durationMs = 0;      // Duration in milliseconds
+    int64_t frameDurationUs = 0; // Exact frame period from the header speed, 0 when unknown
     int offsetFrame1 = 0;    // Offset of frame 1
     int offsetFrame2 = 0;    // Offset of frame 2
     std::vector<uint8_t> data; // Raw FLIC animation data
@@ -39,6 +41,9 @@ public:
     // Get video duration in milliseconds
     int getDurationMs() const;
 
+    // Time each frame is shown, from frameRate when the header speed is unknown
+    int64_t getFrameDurationUs() const;
+
     // Compare video data with the content of a file
     bool compareWithFile(const std::string& filepath) const;
 
@@ -58,6 +63,20 @@ public:
     // Get a descriptive caption for preview display
     wxString getPreviewCaption() const;
 
+    // Where a frame is stored, found by walking the frame headers once
+    struct FrameEntry {
+        size_t offset = 0;              // Frame header
+        uint16_t chunks = 0;
+        bool keyframe = false;          // Replaces every pixel (BRUN, COPY or BLACK)
+        std::vector<uint8_t> palette;   // Keyframes only: the colormap before the frame
+    };
+
+    // Locate every frame without decoding pixels. Colormap chunks are applied
+    // along the way so decoding can start at any keyframe.
+    std::vector<FrameEntry> buildFrameIndex() const;
+    // Apply the chunks of one frame to the framebuffer, resized to the video first if needed
+    bool decodeFrame(const FrameEntry& entry, FlicFrameBuffer& frame) const;
+
     // Get a vector of frames as wxImages
     std::vector<wxImage> getFrameArray(int32_t requestedFrameCount = -1) const;
 
@@ -67,5 +86,6 @@ public:
     }
 
 private:
-    size_t readChunk(size_t offset, std::vector<uint8_t>& outPixels, std::vector<uint8_t>& colormap) const;
+    // Decode the chunk at offset into the framebuffer, returns the chunk size (0 past the end)
+    size_t readChunk(size_t offset, FlicFrameBuffer& frame) const;
 }; 
\ No newline at end of file
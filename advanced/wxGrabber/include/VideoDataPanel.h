@@ -3,6 +3,8 @@
 #include <wx/image.h>
 #include <wx/bitmap.h>
 #include "VideoData.h"
+#include "FlicStream.h"
+#include "PlaybackClock.h"
 #include "AVControlInterface.h"
 #include "DataParser.h"
 
@@ -19,18 +21,25 @@ public:
     void Stop() override;
     void SetCurrentPositionMs(int currentPositionMs) override;
     void OnTimer();
+    // Follow the position of a sound instead of the wall clock while it reports one (>= 0)
+    void SetSyncSource(std::function<int()> positionMs);
+    const PlaybackClock::Stats& GetPlaybackStats() const { return m_clock.getStats(); }
 
 protected:
     void OnPaint(wxPaintEvent& event);
     void RenderFrame(wxDC& dc);
     void UpdatePreview();
+    void ShowFrame(int frame);
+    void ScheduleNextFrame();
+    void LogPlaybackStats() const;
 
     std::shared_ptr<DataParser::DataObject> m_videoObject = nullptr;
     wxImage m_currentFrame;
-    int m_frameRate = 0;
     uint64_t m_currentFrameIndex = 0;
-    class VideoDataPanelTimer* m_timer = nullptr;
-    std::vector<wxImage> m_frames;
+    class VideoDataPanelTimer* m_timer = nullptr;  // One shot, set for the next frame due
+    PlaybackClock m_clock;
+    int64_t m_lastReportUs = 0;                    // Position last sent to the update callback
+    std::unique_ptr<FlicStream> m_stream;  // Decodes frames as they are shown
 
     wxDECLARE_EVENT_TABLE();
 }; 
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <wx/window.h>
+#include <wx/timer.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "AudioAnalysis.h"
+#include "DataParser.h"
+
+// Waveform of an audio object with a playhead and its peak/RMS levels. Peaks come
+// from the AudioAnalysisCache pyramid, so drawing costs the same at any zoom;
+// while the analysis is running a timer polls for it. The mouse wheel zooms
+// around the pointer, Shift+wheel scrolls and a click seeks.
+class WaveformView : public wxWindow {
+public:
+    using SeekCallback = std::function<void(int positionMs)>;
+
+    WaveformView(wxWindow* parent, AudioAnalysisCache& cache, SeekCallback seekCallback);
+    ~WaveformView();
+
+    // Object to show, nullptr or a type without PCM clears the view
+    void SetAudio(const std::shared_ptr<DataParser::DataObject>& obj);
+    void SetPositionMs(int positionMs);
+
+    static constexpr int PollIntervalMs = 100;
+
+private:
+    void OnPaint(wxPaintEvent& event);
+    void OnMouseWheel(wxMouseEvent& event);
+    void OnLeftDown(wxMouseEvent& event);
+    void OnPollTimer(wxTimerEvent& event);
+
+    int64_t FrameAt(int x) const;
+    int XAt(int64_t frame) const;
+    int64_t ViewFrames() const;
+    void ClampView();
+
+    AudioAnalysisCache& m_cache;
+    SeekCallback m_seekCallback;
+    uint64_t m_key = 0;
+    bool m_hasAudio = false;
+    std::shared_ptr<const AudioAnalysis> m_analysis;
+    int64_t m_viewStart = 0;
+    int64_t m_viewFrames = 0;  // Frames across the width, 0 shows the whole sound
+    int m_positionMs = 0;
+    std::vector<WaveformPyramid::Peak> m_peaks;
+    wxTimer m_pollTimer;
+
+    wxDECLARE_EVENT_TABLE();
+};
@@ -9,6 +9,24 @@
 #include <sstream>
 #include <ctime>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Compile-time minimum log level (0 = Error ... 4 = Debug).
+// Statements above this level are removed by the LOG_* macros entirely.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 4
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(fmtIndex, argIndex) __attribute__((format(printf, fmtIndex, argIndex)))
+#else
+#define LOG_PRINTF_FORMAT(fmtIndex, argIndex)
+#endif
 
 class Logger {
 public:
@@ -24,35 +42,71 @@ public:
     bool init(const std::string& filename = "log.txt");
     void setLevel(Level level);
 
+    // Cheap runtime check, used by the LOG_* macros before arguments are evaluated
+    bool isEnabled(Level level) const {
+        return static_cast<int>(level) <= currentLevel.load(std::memory_order_relaxed);
+    }
+
     template<typename T>
     void log(Level level, const T& message) {
-        if (level <= currentLevel) {
-            auto now = std::chrono::system_clock::now();
-            auto time = std::chrono::system_clock::to_time_t(now);
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now.time_since_epoch()) % 1000;
-
-            std::tm timeinfo;
-#ifdef _WIN32
-            localtime_s(&timeinfo, &time);
-#else
-            localtime_r(&time, &timeinfo);
-#endif
+        if (isEnabled(level)) {
+            std::ostringstream ss;
+            ss << message;
+            enqueue(level, ss.str());
+        }
+    }
 
-            std::stringstream ss;
-            ss << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S")
-               << '.' << std::setfill('0') << std::setw(3) << ms.count()
-               << " [" << getLevelString(level) << "] "
-               << message << std::endl;
-
-            std::lock_guard<std::mutex> lock(logMutex);
-            if (logFile.is_open()) {
-                logFile << ss.str();
-                logFile.flush();
-            }
+    void log(Level level, const std::string& message) {
+        if (isEnabled(level)) {
+            enqueue(level, message);
         }
     }
 
+    void log(Level level, const char* message) {
+        if (isEnabled(level)) {
+            enqueue(level, message);
+        }
+    }
+
+    // printf-style formatting, only called once the level is known to be enabled
+    void logf(Level level, const char* format, ...) LOG_PRINTF_FORMAT(3, 4);
+
+    // Block until every queued line has been written and flushed
+    void flush();
+    // Drain the queue and stop the writer thread
+    void shutdown();
+
+    // Completed timing span, names must be string literals
+    struct ProfileSpan {
+        const char* name;
+        uint64_t startUs;       // Microseconds since profiling was enabled
+        uint64_t durationUs;
+        uint32_t threadId;
+        uint32_t depth;         // Nesting level within the thread
+    };
+
+    // Counter sample, value is the running total after the update
+    struct ProfileCounter {
+        const char* name;
+        uint64_t timeUs;
+        int64_t value;
+        uint32_t threadId;
+    };
+
+    // Profile mode: enabling clears previously recorded spans and counters
+    void setProfiling(bool enabled);
+    bool isProfiling() const {
+        return profiling.load(std::memory_order_relaxed);
+    }
+    uint64_t profileTimeUs() const;
+    void recordSpan(const char* name, uint64_t startUs, uint64_t durationUs, uint32_t depth);
+    void addCounter(const char* name, int64_t delta);
+
+    // Dump recorded data as Chrome trace-event JSON (chrome://tracing, Perfetto)
+    bool writeChromeTrace(const std::string& filename) const;
+    // Per-span totals sorted by total time, plus final counter values
+    std::string getProfileSummary() const;
+
     // Custom stream buffer for redirecting cout/cerr
     class LogBuf : public std::streambuf {
     public:
@@ -83,18 +137,66 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
+    // Queued line, timestamp is formatted by the writer thread
+    struct Entry {
+        std::chrono::system_clock::time_point time;
+        Level level;
+        std::string message;
+    };
+
+    // Capacity of the ring buffer between producers and the writer thread
+    static constexpr size_t QueueCapacity = 4096;
+
     const char* getLevelString(Level level) const;
+    void enqueue(Level level, std::string message);
+    void writerLoop();
+    void writeEntry(const Entry& entry);
 
     std::ofstream logFile;
-    Level currentLevel;
+    std::atomic<int> currentLevel;
     LogStream errorStream_;
     LogStream infoStream_;
-    mutable std::mutex logMutex;  // Mutex for thread-safe logging
+    mutable std::mutex logMutex;  // Guards logFile and the ring buffer
+
+    std::vector<Entry> queue;     // Ring buffer storage
+    size_t queueHead = 0;         // Next entry to write
+    size_t queueCount = 0;        // Number of queued entries
+    bool writerBusy = false;      // Writer thread holds a batch outside the lock
+    bool stopWriter = false;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueDrained;
+    std::thread writerThread;
+
+    // Upper bound on stored spans so a forgotten profile run can't exhaust memory
+    static constexpr size_t MaxProfileSpans = 1 << 20;
+
+    std::atomic<bool> profiling;
+    std::chrono::steady_clock::time_point profileStart;
+    mutable std::mutex profileMutex;  // Guards the profile buffers below
+    std::vector<ProfileSpan> profileSpans;
+    std::vector<ProfileCounter> profileCounters;
+    std::unordered_map<std::string, int64_t> counterTotals;
+    size_t droppedSpans = 0;
+};
+
+// RAII timing span, recorded only while profile mode is on
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name);
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    const char* name;
+    uint64_t startUs = 0;
+    uint32_t depth = 0;
+    bool active = false;
 };
 
 // Global functions for easy access
 bool initLog(const std::string& filename = "log.txt");
 void setLogLevel(Logger::Level level);
+void flushLog();
 
 template<typename T>
 void logError(const T& message) {
@@ -123,4 +225,30 @@ void logDebug(const T& message) {
 
 void redirectStdStreams();
 
-#endif // LOG_H 
\ No newline at end of file
+// Lazily formatted log statements: the format arguments are only evaluated when
+// the level passes both the compile-time and the runtime filter.
+#define LOG_AT_LEVEL(levelValue, level, ...) \
+    do { \
+        if ((levelValue) <= LOG_MIN_LEVEL && Logger::getInstance().isEnabled(level)) { \
+            Logger::getInstance().logf(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(...)   LOG_AT_LEVEL(0, Logger::Level::Error, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT_LEVEL(1, Logger::Level::Warning, __VA_ARGS__)
+#define LOG_INFO(...)    LOG_AT_LEVEL(2, Logger::Level::Info, __VA_ARGS__)
+#define LOG_VERBOSE(...) LOG_AT_LEVEL(3, Logger::Level::Verbose, __VA_ARGS__)
+#define LOG_DEBUG(...)   LOG_AT_LEVEL(4, Logger::Level::Debug, __VA_ARGS__)
+
+// Profiling helpers, cheap no-ops unless profile mode is on
+#define LOG_CONCAT_INNER(a, b) a##b
+#define LOG_CONCAT(a, b) LOG_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer LOG_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_COUNTER(name, delta) \
+    do { \
+        if (Logger::getInstance().isProfiling()) { \
+            Logger::getInstance().addCounter(name, delta); \
+        } \
+    } while (0)
+
+#endif // LOG_H
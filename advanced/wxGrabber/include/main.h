@@ -20,10 +20,12 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <unordered_map>
 #include <cstring>
 #include <string>
 #include <cmath>
 #include "../include/DataParser.h"
+#include "../include/UndoHistory.h"
 #include "../include/UnitTests.h"
 #include "GrabberInfo.h"
 #include <wx/filename.h>
@@ -34,6 +36,10 @@
 #include <wx/propgrid/advprops.h>
 #include "VideoDataPanel.h"
 #include "AudioPlaybackControl.h"
+#include "WaveformView.h"
+#include "ImagePreviewCanvas.h"
+#include "PreviewImageCache.h"
+#include "ThumbnailGridView.h"
 
 // Custom streambuf that writes to both file and original stream
 class TeeStreamBuf : public std::streambuf {
@@ -136,6 +142,7 @@ private:
     void OnPasswordChange(wxCommandEvent& event);
     void OnIndexObjects(wxCommandEvent& event);
     void RefreshTreeDisplay();
+    void RefreshTreeItem(const std::shared_ptr<DataParser::DataObject>& obj);
     void UpdateImageDisplay(const wxImage& image, double zoomLevel, bool addBorder = false);
     void OnNotImplemented(wxCommandEvent& event);
     void OnClose(wxCloseEvent& event);
@@ -145,8 +152,16 @@ private:
     // Audio/video playback
     void OnPlayPauseAV(wxCommandEvent& event);
     void UpdatePreviewControls(std::shared_ptr<DataParser::DataObject> obj);
+    void PrefetchNeighborPreviews(const wxTreeItemId& item);
+    void RefreshThumbnailView();
+    void OnThumbnailSelected(std::shared_ptr<DataParser::DataObject> obj, bool activated);
+    wxTreeItemId FindTreeItem(const std::shared_ptr<DataParser::DataObject>& obj) const;
+    wxTreeItemId ClearTree();
+    void SyncTreeChildren(const wxTreeItemId& parent, const std::vector<std::shared_ptr<DataParser::DataObject>>& objects, int& index, std::unordered_map<uint32_t, bool>& expanded);
+    void ForgetTreeItems(const wxTreeItemId& item, std::unordered_map<uint32_t, bool>& expanded);
+    wxString TreeItemText(const DataParser::DataObject& obj, int index) const;
     void StopAVPlayback();
-    void ResetAVPlayback();
+    void ResetAVPlayback(bool keepSound = false);    // keepSound leaves a playing sound running
 
     bool HasUnsavedChanges() const;
     void ResetToDefaults();
@@ -154,11 +169,14 @@ private:
     bool IsModified() const { return m_isModified; }
 
     wxTreeCtrl* m_tree;
+    std::unordered_map<uint32_t, wxTreeItemId> m_treeItems;  // Object ui_id to its item, kept by RefreshTreeDisplay
+    int m_treeIndexWidth = 1;  // Digits of the index prefix when indices are shown
     wxListCtrl* m_details;
     wxStaticText* m_infoText;        // General info/preview text
     wxStaticText* m_paletteInfoText; // Specific text for palette preview
-    wxStaticBitmap* m_imagePreview;
-    wxScrolledWindow* m_imagePreviewPanel;
+    ImagePreviewCanvas* m_imagePreviewPanel;
+    PreviewImageCache m_previewCache;  // Converted bitmap previews, see UpdatePreviewControls
+    ThumbnailGridView* m_thumbnailView;  // Shown instead of m_tree in thumbnail view
     wxSlider* m_zoomSlider;
     wxStaticText* m_zoomLabel;
     std::vector<std::shared_ptr<DataParser::DataObject>> m_objects;
@@ -187,8 +205,10 @@ private:
     wxSlider* m_audioPositionSlider;
     wxButton* m_playButton;
     wxPanel* m_audioPanel;
+    WaveformView* m_waveformView;  // Shown above m_audioPanel for OGG and SAMP objects
 
     // Audio playback members
+    AudioAnalysisCache m_audioCache;  // Decoded samples and waveforms, shared by m_waveformView and m_audioControl
     std::unique_ptr<AudioPlaybackControl> m_audioControl;
 
     // Icon management
@@ -206,6 +226,9 @@ private:
     wxString m_loadedBitmapPath;
     std::vector<uint8_t> m_currentPalette;
     std::vector<uint8_t> m_currentAlphaChannel;  // Store the loaded alpha channel
+
+    // Undo/redo steps for the object tree
+    UndoHistory m_history;
     
     // Drag and drop support
     wxTreeItemId m_draggedItem;
@@ -258,6 +281,17 @@ private:
     void OnRenameObject(wxCommandEvent& event);
     void OnSetProperty(wxCommandEvent& event);
     void OnAutocrop(wxCommandEvent& event);
+    void OnSpriteBenchmark(wxCommandEvent& event);
+    void OnFlicBenchmark(wxCommandEvent& event);
+    void OnCreateFlic(wxCommandEvent& event);
+    void OnImportUnicodeFont(wxCommandEvent& event);
+    void OnBuildAtlas(wxCommandEvent& event);
+    void OnFindDuplicates(wxCommandEvent& event);
+    void OnBatchTransform(wxCommandEvent& event);
+    void OnBatchAudio(wxCommandEvent& event);
+    void OnUndo(wxCommandEvent& event);
+    void OnRedo(wxCommandEvent& event);
+    void SetSortOption(bool sort);
     void OnBoxGrab(wxCommandEvent& event);
     void OnUngrab(wxCommandEvent& event);
     void OnViewAlpha(wxCommandEvent& event);
@@ -272,8 +306,8 @@ private:
     void OnDepth24(wxCommandEvent& event);
     void OnDepth32(wxCommandEvent& event);
 
-    // Helper to add a new object to the root or to the selected datafile's nested objects
-    void addObjectToCurrentOrRoot(std::shared_ptr<DataParser::DataObject> obj);
+    // Helper to add a new object to the root or to the selected datafile's nested objects, as one undo step
+    void addObjectToCurrentOrRoot(std::shared_ptr<DataParser::DataObject> obj, const std::string& undoDescription = "New Object");
 
     // Video preview and playback
     VideoDataPanel* m_videoPanel;
@@ -322,6 +356,8 @@ private:
     
     void OnDitherImages(wxCommandEvent& event);
     void OnPreserveTransparency(wxCommandEvent& event);
+    void OnProfileMode(wxCommandEvent& event);
+    void OnThumbnailView(wxCommandEvent& event);
 
     void OnTreeItemMenu(wxTreeEvent& event);
 
@@ -378,6 +414,16 @@ enum
     ID_RENAME,
     ID_SET_PROPERTY,
     ID_AUTOCROP,
+    ID_SPRITE_BENCHMARK,
+    ID_FLIC_BENCHMARK,
+    ID_CREATE_FLIC,
+    ID_IMPORT_UNICODE_FONT,
+    ID_BUILD_ATLAS,
+    ID_FIND_DUPLICATES,
+    ID_DUPLICATES_MERGE,
+    ID_DUPLICATES_REPLACE,
+    ID_BATCH_TRANSFORM,
+    ID_BATCH_AUDIO,
     ID_BOX_GRAB,
     ID_UNGRAB,
     ID_VIEW_ALPHA,
@@ -412,6 +458,8 @@ enum
     ID_STORE_RELATIVE,
     ID_DITHER_IMAGES,
     ID_PRESERVE_TRANSPARENCY,
+    ID_PROFILE_MODE,
+    ID_THUMBNAIL_VIEW,
     ID_HELP_SYSTEM,
     ID_HELP_WORMS,
     ID_TREE_CTRL,
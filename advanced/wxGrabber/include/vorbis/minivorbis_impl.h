@@ -1,6 +1,8 @@
 #ifndef MINIVORBIS_IMPL_H
 #define MINIVORBIS_IMPL_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +20,18 @@ int convert_vorbis_to_pcm_from_memory(const unsigned char* data, size_t size, ch
 int create_wav_in_memory(const char* pcm_data, int pcm_size, int sample_rate, int channels, 
                         unsigned char** wav_data, int* wav_size);
 
+/* Incremental decoding of an Ogg Vorbis stream held in memory.
+   The data must stay valid until the stream is closed. */
+typedef struct VorbisStream VorbisStream;
+
+VorbisStream* vorbis_stream_open(const unsigned char* data, size_t size, VorbisInfo* res_info);
+/* Seek to a sample frame, returns 0 on success */
+int vorbis_stream_seek(VorbisStream* stream, long long frame);
+/* Decode up to max_bytes of 16-bit little endian interleaved PCM,
+   returns the bytes written, 0 at the end of the stream or -1 on error */
+int vorbis_stream_read(VorbisStream* stream, char* pcm_data, int max_bytes);
+void vorbis_stream_close(VorbisStream* stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,4 +26,31 @@ private:
     ~VorbisWrapper() = delete;
 };
 
+// Decodes an Ogg Vorbis buffer a chunk at a time, memory use does not depend on
+// the stream length. The decoder keeps its own copy of the compressed data.
+class VorbisDecoder {
+public:
+    VorbisDecoder() = default;
+    ~VorbisDecoder();
+    VorbisDecoder(const VorbisDecoder&) = delete;
+    VorbisDecoder& operator=(const VorbisDecoder&) = delete;
+
+    bool open(const std::vector<uint8_t>& oggBuffer);
+    void close();
+    bool isOpen() const { return m_stream != nullptr; }
+
+    const VorbisInfo& getInfo() const { return m_info; }
+    int64_t getTotalFrames() const;
+
+    // Seek to a sample frame without decoding what comes before it
+    bool seek(int64_t frame);
+    // Decode up to frameCount interleaved 16-bit frames, returns the frames read, 0 at the end
+    size_t read(int16_t* samples, size_t frameCount);
+
+private:
+    std::vector<uint8_t> m_data;
+    VorbisStream* m_stream = nullptr;
+    VorbisInfo m_info = {};
+};
+
 #endif // VORBIS_WRAPPER_H 
\ No newline at end of file
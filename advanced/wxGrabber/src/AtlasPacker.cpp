@@ -0,0 +1,404 @@
+#include "../include/AtlasPacker.h"
+#include "../include/log.h"
+#include "../include/ContentBounds.h"
+#include "../include/CommonTypes.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <set>
+
+namespace {
+    // Skyline bottom-left bin packer: the top edge of the packed area is kept as a list
+    // of horizontal segments and each rectangle goes where its bottom ends up lowest
+    class SkylinePacker {
+    public:
+        SkylinePacker(int width, int maxHeight) : binWidth(width), maxHeight(maxHeight) {
+            nodes.push_back(Node{0, 0, width});
+        }
+
+        bool insert(int width, int height, bool allowRotation, int& outX, int& outY, bool& rotated) {
+            int bestBottom = maxHeight + 1;
+            int bestNodeWidth = 0;
+            size_t bestIndex = 0;
+            bool found = false;
+            for (int orientation = 0; orientation < (allowRotation && width != height ? 2 : 1); orientation++) {
+                int w = orientation ? height : width;
+                int h = orientation ? width : height;
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    int y = fit(i, w, h);
+                    if (y < 0) {
+                        continue;
+                    }
+                    int bottom = y + h;
+                    if (bottom < bestBottom || (bottom == bestBottom && nodes[i].width < bestNodeWidth)) {
+                        bestBottom = bottom;
+                        bestNodeWidth = nodes[i].width;
+                        bestIndex = i;
+                        outX = nodes[i].x;
+                        outY = y;
+                        rotated = orientation == 1;
+                        found = true;
+                    }
+                }
+            }
+            if (!found) {
+                return false;
+            }
+            addLevel(bestIndex, outX, outY, rotated ? height : width, rotated ? width : height);
+            usedHeight = std::max(usedHeight, bestBottom);
+            return true;
+        }
+
+        int getUsedHeight() const { return usedHeight; }
+
+    private:
+        struct Node {
+            int x, y, width;
+        };
+
+        // Lowest y a w x h rectangle can sit at with its left edge on node index, -1 if it does not fit
+        int fit(size_t index, int w, int h) const {
+            int x = nodes[index].x;
+            if (x + w > binWidth) {
+                return -1;
+            }
+            int y = nodes[index].y;
+            int widthLeft = w;
+            for (size_t i = index; widthLeft > 0; i++) {
+                y = std::max(y, nodes[i].y);
+                if (y + h > maxHeight) {
+                    return -1;
+                }
+                widthLeft -= nodes[i].width;
+            }
+            return y;
+        }
+
+        void addLevel(size_t index, int x, int y, int w, int h) {
+            nodes.insert(nodes.begin() + index, Node{x, y + h, w});
+            // Cut the segments now covered by the new one
+            for (size_t i = index + 1; i < nodes.size();) {
+                const Node& previous = nodes[i - 1];
+                int overlap = previous.x + previous.width - nodes[i].x;
+                if (overlap <= 0) {
+                    break;
+                }
+                nodes[i].x += overlap;
+                nodes[i].width -= overlap;
+                if (nodes[i].width > 0) {
+                    break;
+                }
+                nodes.erase(nodes.begin() + i);
+            }
+            // Merge neighbours at the same height
+            size_t first = index > 0 ? index - 1 : 0;
+            for (size_t i = first; i + 1 < nodes.size() && i <= index + 1;) {
+                if (nodes[i].y == nodes[i + 1].y) {
+                    nodes[i].width += nodes[i + 1].width;
+                    nodes.erase(nodes.begin() + i + 1);
+                } else {
+                    i++;
+                }
+            }
+        }
+
+        int binWidth;
+        int maxHeight;
+        int usedHeight = 0;
+        std::vector<Node> nodes;
+    };
+
+    struct Item {
+        size_t index;       // Into inputs/placements
+        int width;          // Trimmed size plus padding
+        int height;
+    };
+
+    int nextPowerOfTwo(int value) {
+        int result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Mask color of a depth as raw pixel bytes, with the bytes that take part in the comparison
+    void maskPixel(int bits, uint8_t* pixel, uint8_t* compareMask) {
+        std::memset(pixel, 0, 4);
+        std::memset(compareMask, 0xFF, 4);
+        switch (bits) {
+            case 15:
+                pixel[0] = TRANSPARENT_COLOR_15 & 0xFF;
+                pixel[1] = TRANSPARENT_COLOR_15 >> 8;
+                compareMask[0] = 0xDF;  // Bit 5 is unused in 15-bit pixels
+                break;
+            case 16:
+                pixel[0] = TRANSPARENT_COLOR_16 & 0xFF;
+                pixel[1] = TRANSPARENT_COLOR_16 >> 8;
+                break;
+            case 24:
+            case 32:
+                pixel[0] = red(TRANSPARENT_COLOR);
+                pixel[1] = green(TRANSPARENT_COLOR);
+                pixel[2] = blue(TRANSPARENT_COLOR);
+                break;
+            case -32:
+                compareMask[0] = compareMask[1] = compareMask[2] = 0;  // Only zero alpha counts
+                break;
+        }
+    }
+
+    struct Layout {
+        int width = 0;
+        int height = 0;
+        std::vector<int> x, y;
+        std::vector<bool> rotated;
+    };
+
+    bool tryLayout(const std::vector<Item>& items, size_t placementCount, int atlasWidth,
+                   const AtlasPacker::Options& options, Layout& layout) {
+        int padding = std::max(0, options.padding);
+        SkylinePacker packer(atlasWidth - padding, options.maxSize - padding);
+        layout.x.assign(placementCount, 0);
+        layout.y.assign(placementCount, 0);
+        layout.rotated.assign(placementCount, false);
+        for (const Item& item : items) {
+            int x, y;
+            bool rotated;
+            if (!packer.insert(item.width, item.height, options.allowRotation, x, y, rotated)) {
+                return false;
+            }
+            layout.x[item.index] = x + padding;
+            layout.y[item.index] = y + padding;
+            layout.rotated[item.index] = rotated;
+        }
+        layout.width = atlasWidth;
+        layout.height = std::max(1, packer.getUsedHeight() + padding);
+        if (options.powerOfTwo) {
+            layout.height = nextPowerOfTwo(layout.height);
+        }
+        return layout.height <= options.maxSize;
+    }
+}
+
+bool AtlasPacker::pack(const std::vector<Input>& inputs, const Options& options, Result& result) {
+    PROFILE_SCOPE("AtlasPacker::pack");
+    if (inputs.empty()) {
+        logError("Atlas packer: no sprites to pack");
+        return false;
+    }
+    int bits = inputs.front().bitmap->bits;
+    for (const Input& input : inputs) {
+        const BitmapData& bitmap = *input.bitmap;
+        if (bitmap.bits != bits) {
+            logError("Atlas packer: all sprites must have the same color depth, " + input.name + " is " +
+                     std::to_string(bitmap.bits) + " bit instead of " + std::to_string(bits));
+            return false;
+        }
+        if (bitmap.getBytesPerPixel() == 0 || bitmap.width <= 0 || bitmap.height <= 0 ||
+            bitmap.data.size() < static_cast<size_t>(bitmap.width) * bitmap.height * bitmap.getBytesPerPixel()) {
+            logError("Atlas packer: invalid bitmap " + input.name);
+            return false;
+        }
+    }
+
+    uint8_t background[4], compareMask[4];
+    maskPixel(bits, background, compareMask);
+    int bytesPerPixel = inputs.front().bitmap->getBytesPerPixel();
+    int padding = std::max(0, options.padding);
+
+    // Trimmed content rectangle of every sprite; fully transparent sprites get an empty one
+    result.placements.assign(inputs.size(), Placement());
+    std::vector<Item> items;
+    items.reserve(inputs.size());
+    int minAtlasWidth = 1;
+    uint64_t totalArea = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const BitmapData& bitmap = *inputs[i].bitmap;
+        Placement& placement = result.placements[i];
+        placement.name = inputs[i].name;
+        placement.sourceWidth = bitmap.width;
+        placement.sourceHeight = bitmap.height;
+        wxRect bounds(0, 0, bitmap.width, bitmap.height);
+        if (options.trim &&
+            !ContentBounds::find(bitmap.data.data(), bitmap.width, bitmap.height,
+                                 static_cast<size_t>(bitmap.width) * bytesPerPixel, bytesPerPixel,
+                                 background, compareMask, bounds)) {
+            continue;
+        }
+        placement.trimX = bounds.x;
+        placement.trimY = bounds.y;
+        placement.width = bounds.width;
+        placement.height = bounds.height;
+
+        Item item{i, bounds.width + padding, bounds.height + padding};
+        int narrowest = options.allowRotation ? std::min(item.width, item.height) : item.width;
+        minAtlasWidth = std::max(minAtlasWidth, narrowest + padding);
+        totalArea += static_cast<uint64_t>(item.width) * item.height;
+        items.push_back(item);
+    }
+    if (minAtlasWidth > options.maxSize) {
+        logError("Atlas packer: a sprite is larger than the maximum atlas size");
+        return false;
+    }
+
+    // Tallest first packs best for a skyline
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.height != b.height ? a.height > b.height : a.width > b.width;
+    });
+
+    // Try a few atlas widths around the square root of the total area and keep the smallest result
+    std::vector<int> widths;
+    if (options.powerOfTwo) {
+        for (int width = nextPowerOfTwo(minAtlasWidth); width <= options.maxSize; width <<= 1) {
+            widths.push_back(width);
+        }
+    } else {
+        double side = std::sqrt(static_cast<double>(totalArea)) + padding;
+        for (double factor : {1.0, 1.1, 1.25, 1.5, 2.0}) {
+            widths.push_back(std::min(options.maxSize, std::max(minAtlasWidth, static_cast<int>(std::ceil(side * factor)))));
+        }
+        widths.erase(std::unique(widths.begin(), widths.end()), widths.end());
+    }
+
+    Layout best;
+    bool found = false;
+    for (int width : widths) {
+        Layout layout;
+        if (!tryLayout(items, inputs.size(), width, options, layout)) {
+            continue;
+        }
+        uint64_t area = static_cast<uint64_t>(layout.width) * layout.height;
+        uint64_t bestArea = static_cast<uint64_t>(best.width) * best.height;
+        if (!found || area < bestArea ||
+            (area == bestArea && std::max(layout.width, layout.height) < std::max(best.width, best.height))) {
+            best = std::move(layout);
+            found = true;
+        }
+    }
+    if (!found) {
+        logError("Atlas packer: sprites do not fit into " + std::to_string(options.maxSize) + "x" +
+                 std::to_string(options.maxSize));
+        return false;
+    }
+
+    // Fill the atlas with the mask color and copy the sprites in
+    BitmapData& atlas = result.atlas;
+    atlas.typeID = ObjectType::DAT_BITMAP;
+    atlas.bits = bits;
+    atlas.width = best.width;
+    atlas.height = best.height;
+    atlas.alpha.clear();
+    atlas.data.resize(static_cast<size_t>(atlas.width) * atlas.height * bytesPerPixel);
+    for (size_t i = 0; i < atlas.data.size(); i += bytesPerPixel) {
+        std::memcpy(atlas.data.data() + i, background, bytesPerPixel);
+    }
+
+    size_t atlasStride = static_cast<size_t>(atlas.width) * bytesPerPixel;
+    for (const Item& item : items) {
+        Placement& placement = result.placements[item.index];
+        const BitmapData& bitmap = *inputs[item.index].bitmap;
+        size_t srcStride = static_cast<size_t>(bitmap.width) * bytesPerPixel;
+        const uint8_t* src = bitmap.data.data() + placement.trimY * srcStride + placement.trimX * bytesPerPixel;
+        placement.x = best.x[item.index];
+        placement.y = best.y[item.index];
+        placement.rotated = best.rotated[item.index];
+        uint8_t* dst = atlas.data.data() + placement.y * atlasStride + placement.x * bytesPerPixel;
+        if (!placement.rotated) {
+            for (int row = 0; row < placement.height; row++) {
+                std::memcpy(dst + row * atlasStride, src + row * srcStride, static_cast<size_t>(placement.width) * bytesPerPixel);
+            }
+            continue;
+        }
+        // Rotated 90 degrees clockwise: atlas pixel (dx, dy) is source pixel (dy, height - 1 - dx)
+        int srcHeight = placement.height;
+        std::swap(placement.width, placement.height);
+        for (int dy = 0; dy < placement.height; dy++) {
+            for (int dx = 0; dx < placement.width; dx++) {
+                std::memcpy(dst + dy * atlasStride + dx * bytesPerPixel,
+                            src + (srcHeight - 1 - dx) * srcStride + dy * bytesPerPixel, bytesPerPixel);
+            }
+        }
+    }
+    atlas.updateAlphaChannel();
+
+    LOG_INFO("Packed %zu sprites into a %dx%d atlas", items.size(), atlas.width, atlas.height);
+    return true;
+}
+
+std::string AtlasPacker::generateHeader(const Result& result, const std::string& prefix) {
+    auto sanitize = [](std::string text) {
+        for (char& c : text) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '_') {
+                c = '_';
+            }
+        }
+        return text;
+    };
+    std::string name = sanitize(prefix);
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0]))) {
+        name.insert(0, "_");
+    }
+    std::ostringstream out;
+    out << "/* Sprite atlas coordinates, produced by " << GrabberName << " v" << GrabberVersion << " */\n";
+    out << "/* Do not hand edit! */\n\n";
+    out << "#define " << name << "_WIDTH " << result.atlas.width << "\n";
+    out << "#define " << name << "_HEIGHT " << result.atlas.height << "\n";
+    out << "#define " << name << "_COUNT " << result.placements.size() << "\n\n";
+
+    // Sprite names that sanitize to the same text, or to one of the names above, get a numeric suffix
+    std::set<std::string> used = {"WIDTH", "HEIGHT", "COUNT", "rects"};
+    for (size_t i = 0; i < result.placements.size(); i++) {
+        std::string base = sanitize(result.placements[i].name);
+        std::string macro = base;
+        for (int suffix = 2; !used.insert(macro).second; suffix++) {
+            macro = base + "_" + std::to_string(suffix);
+        }
+        out << "#define " << name << "_" << macro << " " << i << "\n";
+    }
+
+    out << "\n/* x, y, width, height, trim x, trim y, source width, source height, rotated */\n";
+    out << "static const int " << name << "_rects[" << std::max<size_t>(1, result.placements.size()) << "][9] = {\n";
+    for (const Placement& p : result.placements) {
+        // A "*/" in the name would end the comment early
+        std::string comment = p.name;
+        for (size_t pos = comment.find("*/"); pos != std::string::npos; pos = comment.find("*/", pos + 2)) {
+            comment.replace(pos, 2, "* /");
+        }
+        out << "    { " << std::setw(4) << p.x << ", " << std::setw(4) << p.y << ", "
+            << std::setw(4) << p.width << ", " << std::setw(4) << p.height << ", "
+            << std::setw(4) << p.trimX << ", " << std::setw(4) << p.trimY << ", "
+            << std::setw(4) << p.sourceWidth << ", " << std::setw(4) << p.sourceHeight << ", "
+            << (p.rotated ? 1 : 0) << " },  /* " << comment << " */\n";
+    }
+    out << "};\n";
+    return out.str();
+}
+
+std::vector<uint8_t> AtlasPacker::serializeTable(const Result& result) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(4 + result.placements.size() * 9 * 4);
+    auto put = [&buffer](int32_t value) {
+        uint32_t v = static_cast<uint32_t>(value);
+        buffer.push_back(v & 0xFF);
+        buffer.push_back((v >> 8) & 0xFF);
+        buffer.push_back((v >> 16) & 0xFF);
+        buffer.push_back((v >> 24) & 0xFF);
+    };
+    put(static_cast<int32_t>(result.placements.size()));
+    for (const Placement& p : result.placements) {
+        put(p.x);
+        put(p.y);
+        put(p.width);
+        put(p.height);
+        put(p.trimX);
+        put(p.trimY);
+        put(p.sourceWidth);
+        put(p.sourceHeight);
+        put(p.rotated ? 1 : 0);
+    }
+    return buffer;
+}
@@ -0,0 +1,336 @@
+#include "../include/AudioAnalysis.h"
+#include "../include/AudioStream.h"
+#include "../include/BitmapData.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void WaveformPyramid::begin(int channels) {
+    this->channels = channels;
+    levels.assign(1, std::vector<Peak>());
+    pending.assign(channels, Peak{std::numeric_limits<int16_t>::max(), std::numeric_limits<int16_t>::min()});
+    pendingFrames = 0;
+}
+
+void WaveformPyramid::add(const int16_t* samples, size_t frameCount) {
+    std::vector<Peak>& base = levels[0];
+    for (size_t frame = 0; frame < frameCount; frame++) {
+        for (int ch = 0; ch < channels; ch++) {
+            int16_t sample = *samples++;
+            pending[ch].min = std::min(pending[ch].min, sample);
+            pending[ch].max = std::max(pending[ch].max, sample);
+        }
+        if (++pendingFrames == BaseBucketFrames) {
+            base.insert(base.end(), pending.begin(), pending.end());
+            std::fill(pending.begin(), pending.end(), Peak{std::numeric_limits<int16_t>::max(), std::numeric_limits<int16_t>::min()});
+            pendingFrames = 0;
+        }
+    }
+}
+
+void WaveformPyramid::finish() {
+    if (levels.empty()) {
+        return;
+    }
+    if (pendingFrames > 0) {
+        levels[0].insert(levels[0].end(), pending.begin(), pending.end());
+    }
+    pending.clear();
+    pendingFrames = 0;
+
+    // Merge until a level has a single bucket
+    while (levels.back().size() > static_cast<size_t>(channels)) {
+        const std::vector<Peak>& below = levels.back();
+        size_t belowBuckets = below.size() / channels;
+        size_t buckets = (belowBuckets + LevelFactor - 1) / LevelFactor;
+        std::vector<Peak> level(buckets * channels);
+        for (size_t bucket = 0; bucket < buckets; bucket++) {
+            size_t first = bucket * LevelFactor;
+            size_t last = std::min(first + LevelFactor, belowBuckets);
+            for (int ch = 0; ch < channels; ch++) {
+                Peak peak = below[first * channels + ch];
+                for (size_t i = first + 1; i < last; i++) {
+                    peak.min = std::min(peak.min, below[i * channels + ch].min);
+                    peak.max = std::max(peak.max, below[i * channels + ch].max);
+                }
+                level[bucket * channels + ch] = peak;
+            }
+        }
+        levels.push_back(std::move(level));
+    }
+}
+
+void WaveformPyramid::query(int channel, int64_t startFrame, int64_t endFrame, int columns, std::vector<Peak>& out) const {
+    out.assign(std::max(columns, 0), Peak());
+    if (levels.empty() || columns <= 0 || endFrame <= startFrame || channel < 0 || channel >= channels) {
+        return;
+    }
+
+    double framesPerColumn = static_cast<double>(endFrame - startFrame) / columns;
+    size_t level = 0;
+    int64_t bucketFrames = BaseBucketFrames;
+    while (level + 1 < levels.size() && bucketFrames * LevelFactor <= framesPerColumn) {
+        level++;
+        bucketFrames *= LevelFactor;
+    }
+
+    const std::vector<Peak>& peaks = levels[level];
+    int64_t bucketCount = static_cast<int64_t>(peaks.size() / channels);
+    for (int column = 0; column < columns; column++) {
+        int64_t first = std::max<int64_t>(0, startFrame + static_cast<int64_t>(column * framesPerColumn));
+        int64_t last = startFrame + static_cast<int64_t>((column + 1) * framesPerColumn);
+        int64_t firstBucket = first / bucketFrames;
+        int64_t lastBucket = std::min(bucketCount, std::max(firstBucket + 1, (last + bucketFrames - 1) / bucketFrames));
+        if (firstBucket >= lastBucket) {
+            continue;  // Past the end, left silent
+        }
+        Peak peak = peaks[firstBucket * channels + channel];
+        for (int64_t bucket = firstBucket + 1; bucket < lastBucket; bucket++) {
+            peak.min = std::min(peak.min, peaks[bucket * channels + channel].min);
+            peak.max = std::max(peak.max, peaks[bucket * channels + channel].max);
+        }
+        out[column] = peak;
+    }
+}
+
+size_t WaveformPyramid::memoryBytes() const {
+    size_t bytes = 0;
+    for (const auto& level : levels) {
+        bytes += level.size() * sizeof(Peak);
+    }
+    return bytes;
+}
+
+void AudioAnalysis::peaks(int channel, int64_t startFrame, int64_t endFrame, int columns,
+                          std::vector<WaveformPyramid::Peak>& out) const {
+    double framesPerColumn = columns > 0 ? static_cast<double>(endFrame - startFrame) / columns : 0.0;
+    if (!pcm || framesPerColumn >= WaveformPyramid::BaseBucketFrames || channel < 0 || channel >= channels) {
+        waveform.query(channel, startFrame, endFrame, columns, out);
+        return;
+    }
+    out.assign(std::max(columns, 0), WaveformPyramid::Peak());
+    for (int column = 0; column < columns; column++) {
+        int64_t first = std::max<int64_t>(0, startFrame + static_cast<int64_t>(column * framesPerColumn));
+        int64_t last = std::min(totalFrames, std::max(first + 1, startFrame + static_cast<int64_t>((column + 1) * framesPerColumn)));
+        if (first >= last) {
+            continue;
+        }
+        int16_t sample = (*pcm)[first * channels + channel];
+        WaveformPyramid::Peak peak{sample, sample};
+        for (int64_t frame = first + 1; frame < last; frame++) {
+            sample = (*pcm)[frame * channels + channel];
+            peak.min = std::min(peak.min, sample);
+            peak.max = std::max(peak.max, sample);
+        }
+        out[column] = peak;
+    }
+}
+
+size_t AudioAnalysis::memoryBytes() const {
+    return sizeof(AudioAnalysis) + stats.size() * sizeof(ChannelStats) + waveform.memoryBytes() +
+           (pcm ? pcm->size() * sizeof(int16_t) : 0);
+}
+
+AudioAnalysisCache::AudioAnalysisCache(size_t budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+    worker = std::thread(&AudioAnalysisCache::workerLoop, this);
+}
+
+AudioAnalysisCache::~AudioAnalysisCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopWorker = true;
+        jobs.clear();
+    }
+    jobsAvailable.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool AudioAnalysisCache::canAnalyze(const AudioData& audio) {
+    return audio.typeID == ObjectType::DAT_OGG || audio.typeID == ObjectType::DAT_SAMP || audio.typeID == ObjectType::DAT_MIDI;
+}
+
+uint64_t AudioAnalysisCache::makeKey(const AudioData& audio) {
+    int32_t header[5] = {static_cast<int32_t>(audio.typeID), audio.sampleRate, audio.channels, audio.bitsPerSample, audio.midiDivisions};
+    uint64_t hash = BitmapData::hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+    for (const AudioData::MidiTrack& track : audio.midiTracks) {
+        uint32_t size = static_cast<uint32_t>(track.data.size());
+        hash = BitmapData::hashBytes(reinterpret_cast<const uint8_t*>(&size), sizeof(size), hash);
+        hash = BitmapData::hashBytes(track.data.data(), track.data.size(), hash);
+    }
+    return BitmapData::hashBytes(audio.data.data(), audio.data.size(), hash);
+}
+
+std::shared_ptr<AudioAnalysis> AudioAnalysisCache::analyze(const AudioData& audio, size_t maxPcmBytes) {
+    PROFILE_SCOPE("AudioAnalysisCache::analyze");
+    std::unique_ptr<PcmSource> source = canAnalyze(audio) ? PcmSource::create(audio) : nullptr;
+    if (!source) {
+        return nullptr;
+    }
+
+    auto result = std::make_shared<AudioAnalysis>();
+    result->sampleRate = source->getSampleRate();
+    result->channels = source->getChannels();
+    int channels = result->channels;
+
+    std::shared_ptr<std::vector<int16_t>> pcm;
+    size_t expectedSamples = static_cast<size_t>(std::max<int64_t>(source->getTotalFrames(), 0)) * channels;
+    if (expectedSamples * sizeof(int16_t) <= maxPcmBytes) {
+        pcm = std::make_shared<std::vector<int16_t>>();
+        pcm->reserve(expectedSamples);
+    }
+
+    constexpr size_t ChunkFrames = 4096;
+    std::vector<int16_t> chunk(ChunkFrames * channels);
+    std::vector<double> sumSquares(channels, 0.0);
+    std::vector<int> peaks(channels, 0);
+    int64_t frames = 0;
+    result->waveform.begin(channels);
+    while (size_t read = source->read(chunk.data(), ChunkFrames)) {
+        const int16_t* samples = chunk.data();
+        for (size_t i = 0; i < read; i++) {
+            for (int ch = 0; ch < channels; ch++) {
+                int sample = *samples++;
+                sumSquares[ch] += static_cast<double>(sample) * sample;
+                peaks[ch] = std::max(peaks[ch], std::abs(sample));
+            }
+        }
+        result->waveform.add(chunk.data(), read);
+        if (pcm) {
+            if ((pcm->size() + read * channels) * sizeof(int16_t) > maxPcmBytes) {
+                pcm.reset();  // The header undercounted, too long to keep after all
+            } else {
+                pcm->insert(pcm->end(), chunk.begin(), chunk.begin() + read * channels);
+            }
+        }
+        frames += read;
+    }
+    result->waveform.finish();
+
+    result->totalFrames = frames;
+    result->durationMs = static_cast<int>(frames * 1000 / result->sampleRate);
+    result->stats.resize(channels);
+    for (int ch = 0; ch < channels; ch++) {
+        result->stats[ch].peak = peaks[ch] / 32768.0f;
+        result->stats[ch].rms = frames > 0 ? static_cast<float>(std::sqrt(sumSquares[ch] / frames) / 32768.0) : 0.0f;
+    }
+    if (pcm) {
+        pcm->shrink_to_fit();
+        result->pcm = std::move(pcm);
+    }
+    return result;
+}
+
+std::shared_ptr<const AudioAnalysis> AudioAnalysisCache::find(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    order.splice(order.begin(), order, it->second.orderIt);
+    return it->second.analysis;
+}
+
+bool AudioAnalysisCache::hasFailed(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed.count(key) != 0;
+}
+
+void AudioAnalysisCache::request(uint64_t key, const AudioData& audio) {
+    if (!canAnalyze(audio)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.count(key) || failed.count(key) || (working && activeKey == key)) {
+            return;
+        }
+        jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [key](const Job& job) { return job.key == key; }), jobs.end());
+        // The latest selection is analyzed first
+        jobs.push_front(Job{key, audio});
+    }
+    jobsAvailable.notify_one();
+}
+
+void AudioAnalysisCache::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobsAvailable.wait(lock, [this] { return stopWorker || !jobs.empty(); });
+        if (stopWorker) {
+            break;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        activeKey = job.key;
+        working = true;
+        // A decoded sound may use at most half the budget so it cannot push out everything else
+        size_t maxPcmBytes = budgetBytes / 2;
+        lock.unlock();
+
+        std::shared_ptr<AudioAnalysis> analysis = analyze(job.audio, maxPcmBytes);
+
+        lock.lock();
+        working = false;
+        if (analysis) {
+            insertLocked(job.key, std::move(analysis));
+        } else {
+            logWarning("Could not decode audio for analysis");
+            failed.insert(job.key);
+        }
+    }
+}
+
+void AudioAnalysisCache::insertLocked(uint64_t key, std::shared_ptr<const AudioAnalysis> analysis) {
+    auto existing = entries.find(key);
+    if (existing != entries.end()) {
+        usedBytes -= existing->second.bytes;
+        order.erase(existing->second.orderIt);
+        entries.erase(existing);
+    }
+
+    size_t bytes = analysis->memoryBytes();
+    order.push_front(key);
+    entries[key] = Entry{std::move(analysis), bytes, order.begin()};
+    usedBytes += bytes;
+    evictLocked();
+}
+
+void AudioAnalysisCache::evictLocked() {
+    // Keep at least the most recent entry even if it alone exceeds the budget
+    while (usedBytes > budgetBytes && order.size() > 1) {
+        auto it = entries.find(order.back());
+        usedBytes -= it->second.bytes;
+        entries.erase(it);
+        order.pop_back();
+    }
+}
+
+void AudioAnalysisCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.clear();
+    entries.clear();
+    order.clear();
+    failed.clear();
+    usedBytes = 0;
+}
+
+void AudioAnalysisCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budgetBytes = budgetBytes;
+    evictLocked();
+}
+
+size_t AudioAnalysisCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+size_t AudioAnalysisCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -1,6 +1,9 @@
 #include "../include/AudioData.h"
+#include "../include/AudioStream.h"
+#include "../include/MidiSequence.h"
 #include "../include/vorbis/vorbis_wrapper.h"
 #include "../include/log.h"
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 
@@ -20,33 +23,66 @@ std::vector<uint8_t> AudioData::getWavData(int position_ms) const {
         return std::vector<uint8_t>();
     }
 
+    // The format of the PCM below, MIDI is rendered in a format of its own
+    int rate = sampleRate;
+    int channelCount = channels;
+    int bits = bitsPerSample;
     std::vector<uint8_t> pcmData;
     if (typeID == ObjectType::DAT_OGG) {
-        // Convert ogg data to pcm data
-        if (!VorbisWrapper::ConvertOggToPCM(data, pcmData)) {
-            logError("Failed to convert ogg data to pcm data");
+        // Seek to the position and decode only from there on
+        VorbisDecoder decoder;
+        if (!decoder.open(data)) {
+            logError("Failed to open ogg data");
             return std::vector<uint8_t>();
         }
+        int64_t startFrame = static_cast<int64_t>(position_ms) * decoder.getInfo().sample_rate / 1000;
+        int64_t frameCount = decoder.getTotalFrames() - startFrame;
+        if (frameCount <= 0 || !decoder.seek(startFrame)) {
+            logError("Position " + std::to_string(position_ms) + " ms is past the end of the ogg data");
+            return std::vector<uint8_t>();
+        }
+        size_t frameBytes = static_cast<size_t>(decoder.getInfo().channels) * sizeof(int16_t);
+        pcmData.resize(static_cast<size_t>(frameCount) * frameBytes);
+        size_t frames = decoder.read(reinterpret_cast<int16_t*>(pcmData.data()), static_cast<size_t>(frameCount));
+        pcmData.resize(frames * frameBytes);
+        position_ms = 0;
     } else if (typeID == ObjectType::DAT_SAMP) {
         // For DAT_SAMP, data is already PCM
         pcmData = data;
     } else if (typeID == ObjectType::DAT_MIDI) {
-        // MIDI cannot be converted to WAV directly here
-        logWarning("getWavData: DAT_MIDI to WAV conversion is not supported");
-        return std::vector<uint8_t>();
+        // Rendered by the built-in synthesizer from the position on
+        std::unique_ptr<PcmSource> source = PcmSource::create(*this);
+        if (!source) {
+            logError("getWavData: MIDI data could not be parsed");
+            return std::vector<uint8_t>();
+        }
+        int64_t startFrame = static_cast<int64_t>(position_ms) * source->getSampleRate() / 1000;
+        int64_t frameCount = source->getTotalFrames() - startFrame;
+        if (frameCount <= 0 || !source->seek(startFrame)) {
+            logError("Position " + std::to_string(position_ms) + " ms is past the end of the MIDI data");
+            return std::vector<uint8_t>();
+        }
+        size_t frameBytes = static_cast<size_t>(source->getChannels()) * sizeof(int16_t);
+        pcmData.resize(static_cast<size_t>(frameCount) * frameBytes);
+        size_t frames = source->read(reinterpret_cast<int16_t*>(pcmData.data()), static_cast<size_t>(frameCount));
+        pcmData.resize(frames * frameBytes);
+        rate = source->getSampleRate();
+        channelCount = source->getChannels();
+        bits = 16;
+        position_ms = 0;
     } else {
         logError("Unsupported audio type for getWavData: " + std::to_string(static_cast<int>(typeID)));
         return std::vector<uint8_t>();
     }
 
     // Calculate offset in PCM data based on position
-    uint64_t bytesPerSample = bitsPerSample / 8;
-    uint64_t bytesPerSecond = sampleRate * channels * bytesPerSample;
+    uint64_t bytesPerSample = bits / 8;
+    uint64_t bytesPerSecond = rate * channelCount * bytesPerSample;
     uint64_t offsetBytes = (static_cast<uint64_t>(position_ms) * bytesPerSecond) / 1000;
     
     // Ensure offset is aligned with sample boundaries
     // round up to the nearest channel * bytesPerSample
-    offsetBytes = (offsetBytes + (channels * bytesPerSample) - 1) & ~(channels * bytesPerSample - 1);
+    offsetBytes = (offsetBytes + (channelCount * bytesPerSample) - 1) & ~(channelCount * bytesPerSample - 1);
     
     // Ensure we don't exceed the buffer
     if (offsetBytes >= pcmData.size()) {
@@ -60,11 +96,11 @@ std::vector<uint8_t> AudioData::getWavData(int position_ms) const {
     // Create WAV header
     wavHeader header;
     header.chunkSize = sizeof(wavHeader) + remainingPcmSize - 8;
-    header.numChannels = channels;
-    header.sampleRate = sampleRate;
-    header.byteRate = sampleRate * channels * bitsPerSample / 8;
-    header.blockAlign = channels * bitsPerSample / 8;
-    header.bitsPerSample = bitsPerSample;
+    header.numChannels = channelCount;
+    header.sampleRate = rate;
+    header.byteRate = rate * channelCount * bits / 8;
+    header.blockAlign = channelCount * bits / 8;
+    header.bitsPerSample = bits;
     header.subchunk2Size = remainingPcmSize;
 
     // Create output buffer
@@ -515,122 +551,55 @@ void AudioData::calculateMIDIDuration() {
     if (typeID != ObjectType::DAT_MIDI || midiDivisions == 0) {
         return;
     }
+    // Same tempo map the player uses, so SMPTE divisions are timed as well
+    MidiSequence sequence;
+    durationMs = sequence.parse(*this) ? sequence.getDurationMs() : 0;
+}
 
-    // Only support ticks per quarter note (not SMPTE) for now
-    if (midiDivisions & 0x8000) {
-        logDebug("SMPTE timing not supported in this implementation.");
-        durationMs = 0;
-        return;
-    }
-    uint16_t ticksPerQuarter = midiDivisions & 0x7FFF;
-
-    struct TempoEvent {
-        uint32_t tick;
-        uint32_t tempo; // in microseconds per quarter note
-    };
-
-    std::vector<TempoEvent> tempoChanges = { {0, 500000} }; // Default tempo
-    uint32_t maxTick = 0;
-
-    // Gather all tempo changes and max tick across all tracks
-    for (size_t track = 0; track < midiTracks.size(); ++track) {
-        const auto& data = midiTracks[track].data;
-        if (data.empty()) continue;
-        size_t pos = 0;
-        uint32_t tick = 0;
-        uint8_t runningStatus = 0;
-        while (pos < data.size()) {
-            // Read delta time (variable length)
-            uint32_t delta = 0;
-            uint8_t byte;
-            do {
-                if (pos >= data.size()) break;
-                byte = data[pos++];
-                delta = (delta << 7) | (byte & 0x7F);
-            } while (byte & 0x80);
-            tick += delta;
-
-            if (pos >= data.size()) break;
-            uint8_t statusByte = data[pos];
-            if (statusByte < 0x80) {
-                statusByte = runningStatus;
-            } else {
-                statusByte = data[pos++];
-                runningStatus = statusByte;
-            }
-
-            if (statusByte == 0xFF) {
-                if (pos + 1 >= data.size()) break;
-                uint8_t metaType = data[pos++];
-                // Read variable length for meta event
-                uint32_t length = 0;
-                do {
-                    if (pos >= data.size()) break;
-                    byte = data[pos++];
-                    length = (length << 7) | (byte & 0x7F);
-                } while (byte & 0x80);
-                if (metaType == 0x51 && length == 3 && pos + 2 < data.size()) {
-                    uint32_t tempo = (data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2];
-                    tempoChanges.push_back({tick, tempo});
-                }
-                pos += length;
-            } else if ((statusByte & 0xF0) == 0xF0) {
-                // SysEx event
-                uint32_t length = 0;
-                do {
-                    if (pos >= data.size()) break;
-                    byte = data[pos++];
-                    length = (length << 7) | (byte & 0x7F);
-                } while (byte & 0x80);
-                pos += length;
-            } else {
-                int dataLen = ((statusByte & 0xF0) == 0xC0 || (statusByte & 0xF0) == 0xD0) ? 1 : 2;
-                pos += dataLen;
-            }
-        }
-        if (tick > maxTick) maxTick = tick;
+wxString AudioData::getPreviewCaption() const {
+    wxString durationStr = wxString::Format("%d ms", durationMs);
+    if (durationMs >= 60000) {
+        durationStr = wxString::Format("%d:%02d min", durationMs / 60000, (durationMs % 60000) / 1000);
     }
-
-    // Sort tempo changes by tick (just in case)
-    std::sort(tempoChanges.begin(), tempoChanges.end(), [](const TempoEvent& a, const TempoEvent& b) {
-        return a.tick < b.tick;
-    });
-
-    // Calculate total duration in ms
-    double totalMs = 0.0;
-    uint32_t prevTick = 0;
-    uint32_t currentTempo = 500000; // default tempo
-    for (size_t i = 0; i < tempoChanges.size(); ++i) {
-        uint32_t nextTick = (i + 1 < tempoChanges.size()) ? tempoChanges[i + 1].tick : maxTick;
-        if (nextTick > maxTick) nextTick = maxTick;
-        uint32_t deltaTicks = nextTick - prevTick;
-        double currentTempoMs = static_cast<double>(currentTempo) / 1000.0;
-        double segmentMs = (static_cast<double>(deltaTicks) * currentTempoMs) / static_cast<double>(ticksPerQuarter);
-        totalMs += segmentMs;
-        currentTempo = tempoChanges[i].tempo;
-        prevTick = nextTick;
+    else if (durationMs >= 1000) {
+        durationStr = wxString::Format("%.2f s", durationMs / 1000.0);
     }
-    durationMs = static_cast<uint32_t>(totalMs);
-}
 
-wxString AudioData::getPreviewCaption() const {
     wxString typeStr;
     if (typeID == ObjectType::DAT_OGG) {
         typeStr = "OGG Vorbis";
     } else if (typeID == ObjectType::DAT_SAMP) {
         typeStr = "PCM Sample";
     } else if (typeID == ObjectType::DAT_MIDI) {
-        return wxString::Format("MIDI: %d divisions, %d tracks", midiDivisions, (int)midiTracks.size());
+        MidiSequence sequence;
+        if (!sequence.parse(*this)) {
+            return wxString::Format("MIDI: %d divisions, %d tracks", midiDivisions, (int)midiTracks.size());
+        }
+        int usedTracks = 0;
+        size_t notes = 0;
+        for (const auto& track : sequence.getTracks()) {
+            usedTracks += track.eventCount > 0 ? 1 : 0;
+            notes += track.noteCount;
+        }
+        wxString channelList;
+        for (int ch = 0; ch < 16; ch++) {
+            const MidiSequence::ChannelInfo& channel = sequence.getChannels()[ch];
+            if (channel.noteCount == 0) {
+                continue;
+            }
+            channelList += channelList.empty() ? "" : ", ";
+            if (ch == MidiSequence::PercussionChannel) {
+                channelList += wxString::Format("%d drums", ch + 1);
+            } else {
+                channelList += wxString::Format("%d program %d", ch + 1, std::max(channel.firstProgram, 0) + 1);
+            }
+        }
+        return wxString::Format("MIDI: %d divisions, %d of %d tracks used, %zu notes, duration: %s\nChannels: %s",
+            midiDivisions, usedTracks, (int)midiTracks.size(), notes, durationStr,
+            channelList.empty() ? wxString("none") : channelList);
     } else {
         typeStr = "Audio";
     }
-    wxString durationStr = wxString::Format("%d ms", durationMs);
-    if (durationMs >= 60000) {
-        durationStr = wxString::Format("%d:%02d min", durationMs / 60000, (durationMs % 60000) / 1000);
-    }
-    else if (durationMs >= 1000) {
-        durationStr = wxString::Format("%.2f s", durationMs / 1000.0);
-    }
     return wxString::Format("%s: %d Hz, %d ch, %d bit, duration: %s", 
         typeStr, sampleRate, channels, bitsPerSample, durationStr);
 }
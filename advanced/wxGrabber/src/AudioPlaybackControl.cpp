@@ -1,5 +1,29 @@
 #include "../include/AudioPlaybackControl.h"
 #include <wx/msgdlg.h>
+#include <algorithm>
+
+namespace {
+    // WAV file of the decoded samples from a position on, for wxSound
+    std::vector<uint8_t> MakeWav(const AudioAnalysis& analysis, int positionMs) {
+        int64_t startFrame = std::clamp<int64_t>(static_cast<int64_t>(positionMs) * analysis.sampleRate / 1000, 0, analysis.totalFrames);
+        const int16_t* samples = analysis.pcm->data() + startFrame * analysis.channels;
+        uint32_t dataSize = static_cast<uint32_t>((analysis.totalFrames - startFrame) * analysis.channels * sizeof(int16_t));
+
+        wavHeader header;
+        header.numChannels = static_cast<uint16_t>(analysis.channels);
+        header.sampleRate = analysis.sampleRate;
+        header.bitsPerSample = 16;
+        header.blockAlign = static_cast<uint16_t>(analysis.channels * 2);
+        header.byteRate = analysis.sampleRate * header.blockAlign;
+        header.subchunk2Size = dataSize;
+        header.chunkSize = sizeof(wavHeader) - 8 + dataSize;
+
+        std::vector<uint8_t> wav(sizeof(wavHeader) + dataSize);
+        std::memcpy(wav.data(), &header, sizeof(wavHeader));
+        std::memcpy(wav.data() + sizeof(wavHeader), samples, dataSize);
+        return wav;
+    }
+}
 
 AudioPlaybackControl::AudioPlaybackControl(std::function<void(int, int)> updateCallback)
 {
@@ -7,20 +31,70 @@ AudioPlaybackControl::AudioPlaybackControl(std::function<void(int, int)> updateC
 }
 
 void AudioPlaybackControl::SetAudioData(std::shared_ptr<DataParser::DataObject> audioObject) {
+    m_player.reset();
+    m_playsCachedPcm = false;
     m_audioObject = audioObject;
     if (m_audioObject) {
-        SetTotalDurationMs(m_audioObject->getAudio().getDurationMs());
+        const AudioData& audio = m_audioObject->getAudio();
+        SetTotalDurationMs(audio.getDurationMs());
+        if (m_analysisCache && AudioAnalysisCache::canAnalyze(audio)) {
+            m_analysisKey = AudioAnalysisCache::makeKey(audio);
+            m_analysisCache->request(m_analysisKey, audio);
+        }
+        CreatePlayer();
     } else {
         SetTotalDurationMs(0);
     }
 }
 
+std::shared_ptr<const AudioAnalysis> AudioPlaybackControl::FindCachedPcm() const {
+    if (!m_analysisCache || !AudioAnalysisCache::canAnalyze(m_audioObject->getAudio())) {
+        return nullptr;
+    }
+    std::shared_ptr<const AudioAnalysis> analysis = m_analysisCache->find(m_analysisKey);
+    return analysis && analysis->pcm ? analysis : nullptr;
+}
+
+void AudioPlaybackControl::CreatePlayer() {
+    std::unique_ptr<AudioSink> sink = AudioSink::createDevice();
+    if (!sink) {
+        return;
+    }
+    std::unique_ptr<PcmSource> source;
+    if (auto analysis = FindCachedPcm()) {
+        source = PcmSource::create(analysis->pcm, analysis->sampleRate, analysis->channels);
+        m_playsCachedPcm = source != nullptr;
+    }
+    if (!source) {
+        source = PcmSource::create(m_audioObject->getAudio());
+    }
+    if (source) {
+        m_player = std::make_unique<AudioStreamPlayer>(std::move(source), std::move(sink));
+    }
+}
+
 void AudioPlaybackControl::PlayPause() {
     if (!m_audioObject) return;
     AVControlInterface::PlayPause();
     if (m_isPlaying) {
+        if (!m_playsCachedPcm && FindCachedPcm()) {
+            // Analysis finished since the sound was selected, stop decoding it
+            m_player.reset();
+            CreatePlayer();
+        }
+        if (m_player) {
+            if (!m_player->play(m_currentPositionMs)) {
+                wxMessageBox("Failed to play sound", "Error", wxOK | wxICON_ERROR);
+            }
+            return;
+        }
         int startPosition = m_currentPositionMs;
-        std::vector<uint8_t> wavData = m_audioObject->getAudio().getWavData(startPosition);
+        std::vector<uint8_t> wavData;
+        if (auto analysis = FindCachedPcm()) {
+            wavData = MakeWav(*analysis, startPosition);
+        } else {
+            wavData = m_audioObject->getAudio().getWavData(startPosition);
+        }
         if (wavData.empty()) {
             wxMessageBox("Failed to create WAV data", "Error", wxOK | wxICON_ERROR);
             return;
@@ -35,19 +109,24 @@ void AudioPlaybackControl::PlayPause() {
             return;
         }
     } else {
+        if (m_player) m_player->stop();
         if (m_sound) m_sound->Stop();
     }
 }
 
 void AudioPlaybackControl::Stop() {
     AVControlInterface::Stop();
+    if (m_player) m_player->stop();
     if (m_sound) m_sound->Stop();
 }
 
 void AudioPlaybackControl::SetCurrentPositionMs(int currentPositionMs) {
     AVControlInterface::SetCurrentPositionMs(currentPositionMs);
     if (!m_audioObject) return;
-    if (m_isPlaying) {
+    if (m_isPlaying && m_player) {
+        // Only the decoder position changes, playback continues from there
+        m_player->play(m_currentPositionMs);
+    } else if (m_isPlaying) {
         Stop();
         PlayPause();
     }
@@ -55,4 +134,16 @@ void AudioPlaybackControl::SetCurrentPositionMs(int currentPositionMs) {
 
 bool AudioPlaybackControl::IsAudioLoaded() const {
     return m_audioObject != nullptr;
-} 
\ No newline at end of file
+}
+
+int AudioPlaybackControl::GetPlaybackPositionMs() const {
+    if (!m_isPlaying) {
+        return -1;
+    }
+    if (m_player) {
+        return m_player->isPlaying() ? m_player->getPositionMs() : -1;
+    }
+    // wxSound does not report a position, extrapolate the interface clock
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_lastUpdateTime);
+    return m_currentPositionMs + static_cast<int>(elapsed.count());
+}
\ No newline at end of file
@@ -0,0 +1,478 @@
+#include "../include/AudioStream.h"
+#include "../include/MidiSynth.h"
+#include "../include/vorbis/vorbis_wrapper.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <mmsystem.h>
+    #pragma comment(lib, "winmm.lib")
+#endif
+
+namespace {
+    class OggSource : public PcmSource {
+    public:
+        bool open(const AudioData& audio) {
+            if (!decoder.open(audio.data)) {
+                return false;
+            }
+            sampleRate = decoder.getInfo().sample_rate;
+            channels = decoder.getInfo().channels;
+            totalFrames = decoder.getTotalFrames();
+            return sampleRate > 0;
+        }
+        bool seek(int64_t frame) override { return decoder.seek(frame); }
+        size_t read(int16_t* samples, size_t frameCount) override { return decoder.read(samples, frameCount); }
+
+    private:
+        VorbisDecoder decoder;
+    };
+
+    // SAMP data is already PCM, 8-bit samples are widened
+    class SampleSource : public PcmSource {
+    public:
+        bool open(const AudioData& audio) {
+            if (audio.bitsPerSample != 8 && audio.bitsPerSample != 16) {
+                return false;
+            }
+            data = audio.data;
+            sampleRate = audio.sampleRate;
+            channels = audio.channels;
+            bytesPerSample = audio.bitsPerSample / 8;
+            totalFrames = static_cast<int64_t>(data.size() / (bytesPerSample * channels));
+            return sampleRate > 0 && channels > 0;
+        }
+        bool seek(int64_t frame) override {
+            position = std::clamp<int64_t>(frame, 0, totalFrames);
+            return true;
+        }
+        size_t read(int16_t* samples, size_t frameCount) override {
+            size_t frames = static_cast<size_t>(std::min<int64_t>(frameCount, totalFrames - position));
+            size_t count = frames * channels;
+            const uint8_t* in = data.data() + position * channels * bytesPerSample;
+            if (bytesPerSample == 1) {
+                for (size_t i = 0; i < count; i++) {
+                    samples[i] = static_cast<int16_t>((in[i] - 128) * 256);
+                }
+            } else {
+                std::memcpy(samples, in, count * sizeof(int16_t));
+            }
+            position += frames;
+            return frames;
+        }
+
+    private:
+        std::vector<uint8_t> data;
+        int bytesPerSample = 2;
+        int64_t position = 0;
+    };
+
+    // Samples decoded earlier, shared with whoever decoded them
+    class MemorySource : public PcmSource {
+    public:
+        MemorySource(std::shared_ptr<const std::vector<int16_t>> samples, int sampleRate, int channels)
+            : samples(std::move(samples)) {
+            this->sampleRate = sampleRate;
+            this->channels = channels;
+            totalFrames = static_cast<int64_t>(this->samples->size() / channels);
+        }
+        bool seek(int64_t frame) override {
+            position = std::clamp<int64_t>(frame, 0, totalFrames);
+            return true;
+        }
+        size_t read(int16_t* out, size_t frameCount) override {
+            size_t frames = static_cast<size_t>(std::min<int64_t>(frameCount, totalFrames - position));
+            std::memcpy(out, samples->data() + position * channels, frames * channels * sizeof(int16_t));
+            position += frames;
+            return frames;
+        }
+
+    private:
+        std::shared_ptr<const std::vector<int16_t>> samples;
+        int64_t position = 0;
+    };
+
+    // MIDI rendered by the built-in synthesizer as it is read. A seek restores
+    // the controller state from the sequence checkpoints instead of rendering
+    // everything before the new position.
+    class MidiSource : public PcmSource {
+    public:
+        static constexpr int RenderRate = 44100;
+        static constexpr int TailMs = 1000;  // Lets the last notes ring out
+
+        MidiSource() : synth(RenderRate) {}
+
+        bool open(const AudioData& audio) {
+            if (!sequence.parse(audio)) {
+                return false;
+            }
+            sampleRate = RenderRate;
+            channels = 2;
+            totalFrames = (sequence.getDurationUs() + TailMs * 1000) * RenderRate / 1000000;
+            return seek(0);
+        }
+        bool seek(int64_t frame) override {
+            position = std::clamp<int64_t>(frame, 0, totalFrames);
+            // Events before the first sample are applied, the rest are played
+            int64_t timeUs = (position * 1000000 + RenderRate - 1) / RenderRate;
+            nextEvent = sequence.findEvent(timeUs);
+            synth.reset(sequence.stateBefore(nextEvent));
+            return true;
+        }
+        size_t read(int16_t* samples, size_t frameCount) override {
+            const std::vector<MidiSequence::Event>& events = sequence.getEvents();
+            size_t produced = 0;
+            while (produced < frameCount && position < totalFrames) {
+                int64_t untilEvent = totalFrames - position;
+                for (; nextEvent < events.size(); nextEvent++) {
+                    int64_t eventFrame = events[nextEvent].timeUs * RenderRate / 1000000;
+                    if (eventFrame > position) {
+                        untilEvent = std::min(untilEvent, eventFrame - position);
+                        break;
+                    }
+                    synth.handle(events[nextEvent]);
+                }
+                size_t frames = static_cast<size_t>(std::min<int64_t>(untilEvent, frameCount - produced));
+                synth.render(samples + produced * 2, frames);
+                produced += frames;
+                position += frames;
+            }
+            return produced;
+        }
+
+    private:
+        MidiSequence sequence;
+        MidiSynth synth;
+        size_t nextEvent = 0;
+        int64_t position = 0;
+    };
+
+#if defined(_WIN32)
+    // waveOut with a few short blocks queued, so output starts within one block
+    class WaveOutSink : public AudioSink {
+    public:
+        ~WaveOutSink() override { close(); }
+
+        bool open(int sampleRate, int channels) override {
+            close();
+            WAVEFORMATEX format = {};
+            format.wFormatTag = WAVE_FORMAT_PCM;
+            format.nChannels = static_cast<WORD>(channels);
+            format.nSamplesPerSec = sampleRate;
+            format.wBitsPerSample = 16;
+            format.nBlockAlign = static_cast<WORD>(channels * 2);
+            format.nAvgBytesPerSec = sampleRate * format.nBlockAlign;
+            event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            if (!event || waveOutOpen(&device, WAVE_MAPPER, &format, reinterpret_cast<DWORD_PTR>(event), 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+                logError("Failed to open the audio device");
+                device = nullptr;
+                close();
+                return false;
+            }
+            this->channels = channels;
+            blockFrames = std::max(1, sampleRate * BlockMs / 1000);
+            for (int i = 0; i < BlockCount; i++) {
+                blocks[i].resize(blockFrames * channels);
+                headers[i] = WAVEHDR();
+            }
+            next = 0;
+            return true;
+        }
+
+        bool write(const int16_t* samples, size_t frameCount) override {
+            while (frameCount > 0) {
+                WAVEHDR& header = headers[next];
+                while (!isFree(header)) {
+                    WaitForSingleObject(event, 100);
+                }
+                if (header.dwFlags & WHDR_PREPARED) {
+                    waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+                }
+                size_t frames = std::min(frameCount, blockFrames);
+                std::memcpy(blocks[next].data(), samples, frames * channels * sizeof(int16_t));
+                header = WAVEHDR();
+                header.lpData = reinterpret_cast<LPSTR>(blocks[next].data());
+                header.dwBufferLength = static_cast<DWORD>(frames * channels * sizeof(int16_t));
+                if (waveOutPrepareHeader(device, &header, sizeof(WAVEHDR)) != MMSYSERR_NOERROR ||
+                    waveOutWrite(device, &header, sizeof(WAVEHDR)) != MMSYSERR_NOERROR) {
+                    logError("Failed to queue audio for the device");
+                    return false;
+                }
+                next = (next + 1) % BlockCount;
+                samples += frames * channels;
+                frameCount -= frames;
+            }
+            return true;
+        }
+
+        void drain() override {
+            for (auto& header : headers) {
+                while (!isFree(header)) {
+                    WaitForSingleObject(event, 100);
+                }
+            }
+        }
+
+        void close() override {
+            if (device) {
+                waveOutReset(device);
+                for (auto& header : headers) {
+                    if (header.dwFlags & WHDR_PREPARED) {
+                        waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+                    }
+                    header = WAVEHDR();
+                }
+                waveOutClose(device);
+                device = nullptr;
+            }
+            if (event) {
+                CloseHandle(event);
+                event = nullptr;
+            }
+        }
+
+    private:
+        static constexpr int BlockCount = 4;
+        static constexpr int BlockMs = 40;
+
+        static bool isFree(const WAVEHDR& header) {
+            return !(header.dwFlags & WHDR_PREPARED) || (header.dwFlags & WHDR_DONE);
+        }
+
+        HWAVEOUT device = nullptr;
+        HANDLE event = nullptr;
+        WAVEHDR headers[BlockCount] = {};
+        std::vector<int16_t> blocks[BlockCount];
+        size_t blockFrames = 0;
+        int channels = 0;
+        int next = 0;
+    };
+#endif
+}
+
+std::unique_ptr<PcmSource> PcmSource::create(const AudioData& audio) {
+    if (audio.typeID == ObjectType::DAT_OGG) {
+        auto source = std::make_unique<OggSource>();
+        if (source->open(audio)) {
+            return source;
+        }
+    } else if (audio.typeID == ObjectType::DAT_SAMP) {
+        auto source = std::make_unique<SampleSource>();
+        if (source->open(audio)) {
+            return source;
+        }
+    } else if (audio.typeID == ObjectType::DAT_MIDI) {
+        auto source = std::make_unique<MidiSource>();
+        if (source->open(audio)) {
+            return source;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<PcmSource> PcmSource::create(std::shared_ptr<const std::vector<int16_t>> samples, int sampleRate, int channels) {
+    if (!samples || sampleRate <= 0 || channels <= 0) {
+        return nullptr;
+    }
+    return std::make_unique<MemorySource>(std::move(samples), sampleRate, channels);
+}
+
+AudioRingBuffer::AudioRingBuffer(size_t capacity)
+    : buffer(std::max<size_t>(capacity, 1)) {
+}
+
+size_t AudioRingBuffer::available() const {
+    return writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_acquire);
+}
+
+size_t AudioRingBuffer::write(const int16_t* samples, size_t count) {
+    size_t written = writeCount.load(std::memory_order_relaxed);
+    count = std::min(count, buffer.size() - (written - readCount.load(std::memory_order_acquire)));
+    size_t start = written % buffer.size();
+    size_t first = std::min(count, buffer.size() - start);
+    std::memcpy(buffer.data() + start, samples, first * sizeof(int16_t));
+    std::memcpy(buffer.data(), samples + first, (count - first) * sizeof(int16_t));
+    writeCount.store(written + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::read(int16_t* samples, size_t count) {
+    size_t readSoFar = readCount.load(std::memory_order_relaxed);
+    count = std::min(count, writeCount.load(std::memory_order_acquire) - readSoFar);
+    size_t start = readSoFar % buffer.size();
+    size_t first = std::min(count, buffer.size() - start);
+    std::memcpy(samples, buffer.data() + start, first * sizeof(int16_t));
+    std::memcpy(samples + first, buffer.data(), (count - first) * sizeof(int16_t));
+    readCount.store(readSoFar + count, std::memory_order_release);
+    return count;
+}
+
+void AudioRingBuffer::clear() {
+    readCount = 0;
+    writeCount = 0;
+}
+
+std::unique_ptr<AudioSink> AudioSink::createDevice() {
+#if defined(_WIN32)
+    return std::make_unique<WaveOutSink>();
+#else
+    return nullptr;
+#endif
+}
+
+bool NullAudioSink::open(int sampleRate, int channels) {
+    this->sampleRate = sampleRate;
+    framesWritten = 0;
+    return sampleRate > 0 && channels > 0;
+}
+
+bool NullAudioSink::write(const int16_t* samples, size_t frameCount) {
+    framesWritten += frameCount;
+    if (realtime) {
+        std::this_thread::sleep_for(std::chrono::microseconds(frameCount * 1000000 / sampleRate));
+    }
+    return true;
+}
+
+bool WavFileAudioSink::open(int sampleRate, int channels) {
+    close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        logError("Failed to open " + path + " for writing");
+        return false;
+    }
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+    dataBytes = 0;
+    wavHeader header;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));  // Completed by close
+    return file.good();
+}
+
+bool WavFileAudioSink::write(const int16_t* samples, size_t frameCount) {
+    size_t bytes = frameCount * channels * sizeof(int16_t);
+    file.write(reinterpret_cast<const char*>(samples), bytes);
+    dataBytes += static_cast<uint32_t>(bytes);
+    return file.good();
+}
+
+void WavFileAudioSink::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    wavHeader header;
+    header.chunkSize = sizeof(wavHeader) + dataBytes - 8;
+    header.numChannels = static_cast<uint16_t>(channels);
+    header.sampleRate = sampleRate;
+    header.byteRate = sampleRate * channels * 2;
+    header.blockAlign = static_cast<uint16_t>(channels * 2);
+    header.bitsPerSample = 16;
+    header.subchunk2Size = dataBytes;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+}
+
+AudioStreamPlayer::AudioStreamPlayer(std::unique_ptr<PcmSource> source, std::unique_ptr<AudioSink> sink, int bufferMs)
+    : source(std::move(source)),
+      sink(std::move(sink)),
+      ring(this->source ? std::max<size_t>(ChunkFrames * 2, static_cast<size_t>(this->source->getSampleRate()) * bufferMs / 1000) * this->source->getChannels() : 1) {
+}
+
+AudioStreamPlayer::~AudioStreamPlayer() {
+    stop();
+}
+
+bool AudioStreamPlayer::play(int positionMs) {
+    stop();
+    if (!source || !sink) {
+        return false;
+    }
+    int64_t frame = std::clamp<int64_t>(static_cast<int64_t>(positionMs) * source->getSampleRate() / 1000, 0, source->getTotalFrames());
+    if (!source->seek(frame)) {
+        logError("Failed to seek audio to " + std::to_string(positionMs) + " ms");
+        return false;
+    }
+    if (!sink->open(source->getSampleRate(), source->getChannels())) {
+        return false;
+    }
+    outputFrames = frame;
+    endOfStream = false;
+    finished = false;
+    running = true;
+    decoder = std::thread(&AudioStreamPlayer::decodeLoop, this);
+    output = std::thread(&AudioStreamPlayer::outputLoop, this);
+    return true;
+}
+
+void AudioStreamPlayer::stop() {
+    running = false;
+    wake.notify_all();
+    if (decoder.joinable()) {
+        decoder.join();
+    }
+    if (output.joinable()) {
+        output.join();
+    }
+    if (sink) {
+        sink->close();
+    }
+    ring.clear();
+}
+
+int AudioStreamPlayer::getPositionMs() const {
+    return source ? static_cast<int>(outputFrames * 1000 / source->getSampleRate()) : 0;
+}
+
+void AudioStreamPlayer::decodeLoop() {
+    PROFILE_SCOPE("AudioStreamPlayer::decodeLoop");
+    size_t channels = source->getChannels();
+    std::vector<int16_t> chunk(ChunkFrames * channels);
+    while (running) {
+        if (ring.space() < chunk.size()) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+        size_t frames = source->read(chunk.data(), ChunkFrames);
+        if (frames == 0) {
+            endOfStream = true;
+            wake.notify_all();
+            return;
+        }
+        ring.write(chunk.data(), frames * channels);
+        wake.notify_all();
+    }
+}
+
+void AudioStreamPlayer::outputLoop() {
+    size_t channels = source->getChannels();
+    std::vector<int16_t> chunk(ChunkFrames * channels);
+    while (running) {
+        // Check before reading so nothing the decoder wrote last is left behind
+        bool ended = endOfStream;
+        size_t count = ring.read(chunk.data(), chunk.size());
+        if (count == 0) {
+            if (ended) {
+                sink->drain();
+                finished = true;
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+        wake.notify_all();
+        if (!sink->write(chunk.data(), count / channels)) {
+            finished = true;
+            return;
+        }
+        outputFrames += count / channels;
+    }
+}
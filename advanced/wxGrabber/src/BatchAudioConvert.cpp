@@ -0,0 +1,249 @@
+#include "../include/BatchAudioConvert.h"
+#include "../include/AudioStream.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
+namespace {
+    constexpr double Pi = 3.14159265358979323846;
+    constexpr int KernelZeros = 16;         // Zero crossings of the sinc on each side
+    constexpr int KernelResolution = 512;   // Table entries per zero crossing
+
+    // Blackman windowed sinc for 0 <= x <= KernelZeros
+    const std::vector<float>& kernelTable() {
+        static const std::vector<float> table = [] {
+            std::vector<float> values(KernelZeros * KernelResolution + 2, 0.0f);
+            for (int i = 0; i < KernelZeros * KernelResolution; i++) {
+                double x = static_cast<double>(i) / KernelResolution;
+                double sinc = i == 0 ? 1.0 : std::sin(Pi * x) / (Pi * x);
+                double w = x / KernelZeros;
+                values[i] = static_cast<float>(sinc * (0.42 + 0.5 * std::cos(Pi * w) + 0.08 * std::cos(2.0 * Pi * w)));
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    float kernel(const std::vector<float>& table, double x) {
+        double position = std::fabs(x) * KernelResolution;
+        size_t index = static_cast<size_t>(position);
+        if (index >= static_cast<size_t>(KernelZeros * KernelResolution)) {
+            return 0.0f;
+        }
+        float fraction = static_cast<float>(position - index);
+        return table[index] + (table[index + 1] - table[index]) * fraction;
+    }
+
+    // Triangular dither noise in [-1, 1), xorshift so every job is reproducible
+    struct Dither {
+        uint32_t state = 0x9E3779B9u;
+        float uniform() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        }
+        float next() { return uniform() - uniform(); }
+    };
+}
+
+std::vector<float> BatchAudioConvert::resample(const std::vector<float>& samples, int fromRate, int toRate) {
+    if (fromRate == toRate || fromRate <= 0 || toRate <= 0 || samples.empty()) {
+        return samples;
+    }
+    PROFILE_SCOPE("BatchAudioConvert::resample");
+    const std::vector<float>& table = kernelTable();
+    // Output sample n sits at input position n * down / up
+    int64_t divisor = std::gcd(fromRate, toRate);
+    int64_t up = toRate / divisor;
+    int64_t down = fromRate / divisor;
+    // Low-pass below the lower of the two Nyquist frequencies, with a little room for the transition band
+    double cutoff = std::min(1.0, static_cast<double>(toRate) / fromRate) * 0.95;
+    int64_t half = static_cast<int64_t>(std::ceil(KernelZeros / cutoff));
+    int64_t taps = half * 2;
+    int64_t inCount = static_cast<int64_t>(samples.size());
+    size_t outCount = static_cast<size_t>((inCount * up + down - 1) / down);
+
+    // Common rate pairs have few phases, their normalized filters are computed once
+    constexpr int64_t MaxPhases = 1024;
+    std::vector<float> phases;
+    if (up <= MaxPhases) {
+        phases.resize(up * taps);
+        for (int64_t phase = 0; phase < up; phase++) {
+            float* filter = &phases[phase * taps];
+            double fraction = static_cast<double>(phase) / up;
+            double weights = 0.0;
+            for (int64_t j = 0; j < taps; j++) {
+                filter[j] = kernel(table, (fraction - (j - half + 1)) * cutoff);
+                weights += filter[j];
+            }
+            for (int64_t j = 0; j < taps; j++) {
+                filter[j] = static_cast<float>(filter[j] / weights);
+            }
+        }
+    }
+
+    std::vector<float> out(outCount);
+    for (size_t n = 0; n < outCount; n++) {
+        int64_t position = static_cast<int64_t>(n) * down;
+        int64_t centre = position / up;
+        int64_t first = centre - half + 1;
+        if (!phases.empty() && first >= 0 && centre + half < inCount) {
+            const float* in = &samples[first];
+            const float* filter = &phases[(position % up) * taps];
+            float sum = 0.0f;
+            for (int64_t j = 0; j < taps; j++) {
+                sum += in[j] * filter[j];
+            }
+            out[n] = sum;
+            continue;
+        }
+        // Near the ends, or for rate pairs with too many phases
+        double t = static_cast<double>(position) / up;
+        double sum = 0.0;
+        double weights = 0.0;
+        for (int64_t k = std::max<int64_t>(0, first); k <= std::min(inCount - 1, centre + half); k++) {
+            float weight = kernel(table, (t - k) * cutoff);
+            sum += samples[k] * weight;
+            weights += weight;
+        }
+        // Dividing by the weights keeps unity gain, also where the kernel is cut off at the ends
+        out[n] = weights > 1e-6 ? static_cast<float>(sum / weights) : 0.0f;
+    }
+    return out;
+}
+
+bool BatchAudioConvert::apply(const AudioData& source, const Params& params, AudioData& result) {
+    if (params.bitsPerSample != 8 && params.bitsPerSample != 16) {
+        logError("Batch audio: output must be 8 or 16 bit");
+        return false;
+    }
+    if (params.channels < 0 || params.channels > 2 || params.sampleRate < 0 || params.sampleRate > MaxSampleRate) {
+        logError("Batch audio: unsupported channel count or sample rate");
+        return false;
+    }
+    std::unique_ptr<PcmSource> pcm = PcmSource::create(source);
+    if (!pcm) {
+        logError("Batch audio: only OGG and SAMP objects can be converted");
+        return false;
+    }
+    int inChannels = pcm->getChannels();
+    int inRate = pcm->getSampleRate();
+    int outChannels = params.channels > 0 ? params.channels : inChannels;
+    int outRate = params.sampleRate > 0 ? params.sampleRate : inRate;
+    if (inChannels < 1 || inChannels > 2) {
+        logError("Batch audio: " + std::to_string(inChannels) + " channels cannot be stored as SAMP");
+        return false;
+    }
+    if (outRate > MaxSampleRate) {
+        logError("Batch audio: " + std::to_string(outRate) + " Hz is above the SAMP limit, choose a lower sample rate");
+        return false;
+    }
+
+    // Decode to one float plane per channel
+    std::vector<std::vector<float>> planes(inChannels);
+    for (auto& plane : planes) {
+        plane.reserve(static_cast<size_t>(std::max<int64_t>(pcm->getTotalFrames(), 0)));
+    }
+    constexpr size_t ChunkFrames = 4096;
+    std::vector<int16_t> chunk(ChunkFrames * inChannels);
+    while (size_t frames = pcm->read(chunk.data(), ChunkFrames)) {
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < inChannels; ch++) {
+                planes[ch].push_back(chunk[i * inChannels + ch] / 32768.0f);
+            }
+        }
+    }
+
+    if (outChannels == 1 && inChannels == 2) {
+        for (size_t i = 0; i < planes[0].size(); i++) {
+            planes[0][i] = (planes[0][i] + planes[1][i]) * 0.5f;
+        }
+        planes.pop_back();
+    } else if (outChannels == 2 && inChannels == 1) {
+        planes.push_back(planes[0]);
+    }
+
+    for (auto& plane : planes) {
+        plane = resample(plane, inRate, outRate);
+    }
+
+    float gain = 1.0f;
+    if (params.normalize) {
+        float peak = 0.0f;
+        for (const auto& plane : planes) {
+            for (float sample : plane) {
+                peak = std::max(peak, std::fabs(sample));
+            }
+        }
+        if (peak > 0.0f) {
+            gain = std::pow(10.0f, params.normalizePeakDb / 20.0f) / peak;
+        }
+    }
+
+    size_t frames = planes[0].size();
+    result = AudioData();
+    result.typeID = ObjectType::DAT_SAMP;
+    result.sampleRate = outRate;
+    result.channels = outChannels;
+    result.bitsPerSample = params.bitsPerSample;
+    result.data.resize(frames * outChannels * (params.bitsPerSample / 8));
+    uint8_t* out = result.data.data();
+    if (params.bitsPerSample == 8) {
+        Dither dither;
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < outChannels; ch++) {
+                float value = std::round(planes[ch][i] * gain * 128.0f + dither.next());
+                *out++ = static_cast<uint8_t>(std::clamp(value, -128.0f, 127.0f) + 128.0f);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < outChannels; ch++) {
+                int16_t value = static_cast<int16_t>(std::clamp(std::round(planes[ch][i] * gain * 32768.0f), -32768.0f, 32767.0f));
+                *out++ = static_cast<uint8_t>(value & 0xFF);
+                *out++ = static_cast<uint8_t>((value >> 8) & 0xFF);
+            }
+        }
+    }
+    result.pcmDataSize = static_cast<int>(result.data.size());
+    result.durationMs = static_cast<int>(frames * 1000 / outRate);
+    return !result.data.empty();
+}
+
+int BatchAudioConvert::run(std::vector<Job>& jobs, const Params& params, unsigned threadCount) {
+    PROFILE_SCOPE("BatchAudioConvert::run");
+    if (jobs.empty()) {
+        return 0;
+    }
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, jobs.size()));
+
+    std::atomic<size_t> nextJob{0};
+    std::atomic<int> succeeded{0};
+    auto worker = [&]() {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            Job& job = jobs[i];
+            job.done = job.source && apply(*job.source, params, job.result);
+            if (job.done) {
+                job.sourceBytes = job.source->serialize().size();
+                job.resultBytes = job.result.serialize().size();
+                succeeded++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    LOG_INFO("Batch audio: %d of %zu sounds converted", succeeded.load(), jobs.size());
+    return succeeded.load();
+}
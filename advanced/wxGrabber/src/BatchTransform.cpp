@@ -0,0 +1,333 @@
+#include "../include/BatchTransform.h"
+#include "../include/CompiledSprite.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    bool validBitmap(const BitmapData& bitmap) {
+        int bytesPerPixel = bitmap.getBytesPerPixel();
+        return !bitmap.isPalette() && bytesPerPixel > 0 && bitmap.width > 0 && bitmap.height > 0 &&
+               bitmap.data.size() >= static_cast<size_t>(bitmap.width) * bitmap.height * bytesPerPixel;
+    }
+
+    bool hasPixelAlpha(const BitmapData& bitmap) {
+        return bitmap.alpha.size() == static_cast<size_t>(bitmap.width) * bitmap.height;
+    }
+
+    // Native pixel to 0xRRGGBB, not used for 8-bit
+    uint32_t decodePixel(const uint8_t* pixel, int bits) {
+        if (bits == 15 || bits == 16) {
+            int value = pixel[0] | (pixel[1] << 8);
+            int g = bits == 15 ? ((value >> 6) & 0x1F) << 3 : ((value >> 5) & 0x3F) << 2;
+            return (((value >> 11) & 0x1F) << 3 << 16) | (g << 8) | ((value & 0x1F) << 3);
+        }
+        return (pixel[0] << 16) | (pixel[1] << 8) | pixel[2];
+    }
+
+    // 0xRRGGBB to a native pixel, alpha of -32 pixels is left alone
+    void encodePixel(uint8_t* pixel, int bits, uint32_t rgb) {
+        int r = (rgb >> 16) & 0xFF, g = (rgb >> 8) & 0xFF, b = rgb & 0xFF;
+        if (bits == 15 || bits == 16) {
+            // Same packing as loadFromWxImage: RRRRRGGGGG1BBBBB and RRRRRGGGGGGBBBBB
+            int value = bits == 15 ? ((r >> 3) << 11) | ((g >> 3) << 6) | (1 << 5) | (b >> 3)
+                                   : ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            pixel[0] = value & 0xFF;
+            pixel[1] = value >> 8;
+            return;
+        }
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+    }
+
+    void writeMaskPixel(uint8_t* pixel, int bits) {
+        switch (bits) {
+            case 8:
+                pixel[0] = TRANSPARENT_COLOR_INDEX;
+                break;
+            case 15:
+                pixel[0] = TRANSPARENT_COLOR_15 & 0xFF;
+                pixel[1] = TRANSPARENT_COLOR_15 >> 8;
+                break;
+            case 16:
+                pixel[0] = TRANSPARENT_COLOR_16 & 0xFF;
+                pixel[1] = TRANSPARENT_COLOR_16 >> 8;
+                break;
+            case -32:
+                pixel[3] = 0;
+                break;
+            default:
+                encodePixel(pixel, bits, TRANSPARENT_COLOR);
+                break;
+        }
+    }
+
+    // Closest palette entry, index 0 is the mask and never chosen
+    int nearestIndex(const std::vector<uint8_t>& palette, uint32_t rgb) {
+        int r = (rgb >> 16) & 0xFF, g = (rgb >> 8) & 0xFF, b = rgb & 0xFF;
+        int best = 1;
+        int bestDistance = INT32_MAX;
+        for (int i = 1; i < 256; i++) {
+            int dr = palette[i * 3] - r, dg = palette[i * 3 + 1] - g, db = palette[i * 3 + 2] - b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+                if (distance == 0) {
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    uint32_t paletteColor(const std::vector<uint8_t>& palette, int index) {
+        return (palette[index * 3] << 16) | (palette[index * 3 + 1] << 8) | palette[index * 3 + 2];
+    }
+
+    // Copy everything except the pixels, which the caller fills in
+    void prepareResult(const BitmapData& source, int width, int height, BitmapData& result) {
+        result.bits = source.bits;
+        result.typeID = source.typeID;
+        result.width = width;
+        result.height = height;
+        result.data.assign(static_cast<size_t>(width) * height * source.getBytesPerPixel(), 0);
+        result.alpha.clear();
+        if (hasPixelAlpha(source)) {
+            result.alpha.assign(static_cast<size_t>(width) * height, 0);
+        }
+    }
+
+    // Move pixels: destination (dx, dy) takes source pixel map(dx, dy)
+    template<typename Map>
+    void remapPixels(const BitmapData& source, BitmapData& result, Map map) {
+        int bytesPerPixel = source.getBytesPerPixel();
+        bool alpha = !result.alpha.empty();
+        for (int dy = 0; dy < result.height; dy++) {
+            uint8_t* out = result.data.data() + static_cast<size_t>(dy) * result.width * bytesPerPixel;
+            for (int dx = 0; dx < result.width; dx++) {
+                size_t index = map(dx, dy);
+                std::memcpy(out + dx * bytesPerPixel, source.data.data() + index * bytesPerPixel, bytesPerPixel);
+                if (alpha) {
+                    result.alpha[static_cast<size_t>(dy) * result.width + dx] = source.alpha[index];
+                }
+            }
+        }
+    }
+
+    bool scale(const BitmapData& source, int percent, BitmapData& result) {
+        int width = 0, height = 0;
+        if (!BatchTransform::scaledSize(source, percent, width, height)) {
+            logError("Scaling a " + std::to_string(source.width) + "x" + std::to_string(source.height) +
+                     " bitmap by " + std::to_string(percent) + "% is over the size limit");
+            return false;
+        }
+        prepareResult(source, width, height, result);
+        int bytesPerPixel = source.getBytesPerPixel();
+        std::vector<int> sourceX(width);
+        for (int x = 0; x < width; x++) {
+            sourceX[x] = static_cast<int>(static_cast<int64_t>(x) * source.width / width);
+        }
+        size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+        int previousY = -1;
+        for (int y = 0; y < height; y++) {
+            int sy = static_cast<int>(static_cast<int64_t>(y) * source.height / height);
+            uint8_t* out = result.data.data() + y * rowBytes;
+            uint8_t* outAlpha = result.alpha.empty() ? nullptr : result.alpha.data() + static_cast<size_t>(y) * width;
+            if (sy == previousY) {
+                // Enlarged rows repeat the one above
+                std::memcpy(out, out - rowBytes, rowBytes);
+                if (outAlpha) {
+                    std::memcpy(outAlpha, outAlpha - width, width);
+                }
+                continue;
+            }
+            const uint8_t* in = source.data.data() + static_cast<size_t>(sy) * source.width * bytesPerPixel;
+            for (int x = 0; x < width; x++) {
+                std::memcpy(out + x * bytesPerPixel, in + sourceX[x] * bytesPerPixel, bytesPerPixel);
+            }
+            if (outAlpha) {
+                const uint8_t* inAlpha = source.alpha.data() + static_cast<size_t>(sy) * source.width;
+                for (int x = 0; x < width; x++) {
+                    outAlpha[x] = inAlpha[sourceX[x]];
+                }
+            }
+            previousY = sy;
+        }
+        return true;
+    }
+
+    bool remapPalette(const BitmapData& source, const BatchTransform::Params& params, BitmapData& result) {
+        if (params.targetPalette.size() < 768 || (source.bits == 8 && params.palette.size() < 768)) {
+            logError("Palette remap needs a source and a target palette");
+            return false;
+        }
+        result = source;
+        int bytesPerPixel = source.getBytesPerPixel();
+        size_t count = static_cast<size_t>(source.width) * source.height;
+        if (source.bits == 8) {
+            uint8_t lut[256];
+            lut[0] = 0;
+            for (int i = 1; i < 256; i++) {
+                lut[i] = static_cast<uint8_t>(nearestIndex(params.targetPalette, paletteColor(params.palette, i)));
+            }
+            for (size_t i = 0; i < count; i++) {
+                result.data[i] = lut[result.data[i]];
+            }
+            return true;
+        }
+        // Sprites use few distinct colors, so cache each lookup
+        std::unordered_map<uint32_t, uint32_t> cache;
+        for (size_t i = 0; i < count; i++) {
+            uint8_t* pixel = result.data.data() + i * bytesPerPixel;
+            if (isSpriteMaskPixel(pixel, source.bits)) {
+                continue;
+            }
+            uint32_t rgb = decodePixel(pixel, source.bits);
+            auto it = cache.find(rgb);
+            if (it == cache.end()) {
+                it = cache.emplace(rgb, paletteColor(params.targetPalette, nearestIndex(params.targetPalette, rgb))).first;
+            }
+            encodePixel(pixel, source.bits, it->second);
+        }
+        return true;
+    }
+
+    bool replaceColor(const BitmapData& source, const BatchTransform::Params& params, BitmapData& result) {
+        result = source;
+        int bytesPerPixel = source.getBytesPerPixel();
+        size_t count = static_cast<size_t>(source.width) * source.height;
+        if (source.bits == 8) {
+            if (params.palette.size() < 768) {
+                logError("Color replacement in 8-bit bitmaps needs a palette");
+                return false;
+            }
+            // Every index showing fromColor is replaced, the mask index included
+            uint8_t lut[256];
+            int target = params.toMask ? TRANSPARENT_COLOR_INDEX : nearestIndex(params.palette, params.toColor & 0xFFFFFF);
+            for (int i = 0; i < 256; i++) {
+                lut[i] = paletteColor(params.palette, i) == (params.fromColor & 0xFFFFFF) ? static_cast<uint8_t>(target) : static_cast<uint8_t>(i);
+            }
+            for (size_t i = 0; i < count; i++) {
+                result.data[i] = lut[result.data[i]];
+            }
+            return true;
+        }
+        // Compare in the bitmap's own precision so 15/16-bit colors match their rounded value
+        uint8_t from[4] = {0, 0, 0, 0};
+        encodePixel(from, source.bits, params.fromColor & 0xFFFFFF);
+        uint32_t fromRGB = decodePixel(from, source.bits);
+        for (size_t i = 0; i < count; i++) {
+            uint8_t* pixel = result.data.data() + i * bytesPerPixel;
+            if (decodePixel(pixel, source.bits) != fromRGB || (source.bits == -32 && pixel[3] == 0)) {
+                continue;
+            }
+            if (params.toMask) {
+                writeMaskPixel(pixel, source.bits);
+            } else {
+                encodePixel(pixel, source.bits, params.toColor & 0xFFFFFF);
+            }
+        }
+        return true;
+    }
+}
+
+bool BatchTransform::scaledSize(const BitmapData& source, int percent, int& width, int& height) {
+    if (percent <= 0) {
+        return false;
+    }
+    int64_t scaledWidth = std::max<int64_t>(1, static_cast<int64_t>(source.width) * percent / 100);
+    int64_t scaledHeight = std::max<int64_t>(1, static_cast<int64_t>(source.height) * percent / 100);
+    if (scaledWidth > MaxSide || scaledHeight > MaxSide || scaledWidth * scaledHeight > MaxPixels) {
+        return false;
+    }
+    width = static_cast<int>(scaledWidth);
+    height = static_cast<int>(scaledHeight);
+    return true;
+}
+
+bool BatchTransform::apply(const BitmapData& source, const Params& params, BitmapData& result) {
+    if (!validBitmap(source)) {
+        return false;
+    }
+    int width = source.width;
+    int height = source.height;
+    bool ok = true;
+    // Runs on worker threads, where an escaping exception would terminate the program
+    try {
+        switch (params.operation) {
+            case Operation::RemapPalette:
+                ok = remapPalette(source, params, result);
+                break;
+            case Operation::FlipHorizontal:
+                prepareResult(source, width, height, result);
+                remapPixels(source, result, [&](int x, int y) { return static_cast<size_t>(y) * width + (width - 1 - x); });
+                break;
+            case Operation::FlipVertical:
+                prepareResult(source, width, height, result);
+                remapPixels(source, result, [&](int x, int y) { return static_cast<size_t>(height - 1 - y) * width + x; });
+                break;
+            case Operation::Rotate90:
+                prepareResult(source, height, width, result);
+                remapPixels(source, result, [&](int x, int y) { return static_cast<size_t>(height - 1 - x) * width + y; });
+                break;
+            case Operation::Rotate180:
+                prepareResult(source, width, height, result);
+                remapPixels(source, result, [&](int x, int y) { return static_cast<size_t>(height - 1 - y) * width + (width - 1 - x); });
+                break;
+            case Operation::Rotate270:
+                prepareResult(source, height, width, result);
+                remapPixels(source, result, [&](int x, int y) { return static_cast<size_t>(x) * width + (width - 1 - y); });
+                break;
+            case Operation::Scale:
+                ok = scale(source, params.scalePercent, result);
+                break;
+            case Operation::ReplaceColor:
+                ok = replaceColor(source, params, result);
+                break;
+        }
+        if (ok) {
+            result.updateAlphaChannel();
+        }
+    } catch (const std::bad_alloc&) {
+        logError("Batch transform: out of memory for a " + std::to_string(width) + "x" + std::to_string(height) + " bitmap");
+        result = BitmapData();
+        return false;
+    }
+    return ok;
+}
+
+int BatchTransform::run(std::vector<Job>& jobs, const Params& params, unsigned threadCount) {
+    PROFILE_SCOPE("BatchTransform::run");
+    if (jobs.empty()) {
+        return 0;
+    }
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, jobs.size()));
+
+    std::atomic<size_t> nextJob{0};
+    std::atomic<int> succeeded{0};
+    auto worker = [&]() {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            jobs[i].done = jobs[i].source && apply(*jobs[i].source, params, jobs[i].result);
+            if (jobs[i].done) {
+                succeeded++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    LOG_INFO("Batch transform: %d of %zu bitmaps changed", succeeded.load(), jobs.size());
+    return succeeded.load();
+}
@@ -10,7 +10,6 @@
 #include <unordered_set>
 #include <wx/string.h>
 #include <vector>
-#include <queue>
 #include <map> // For visited tracking, avoids complex 2D array management
 #include <algorithm> // For std::min/max
 #include <wx/gdicmn.h> // For wxRect
@@ -18,6 +17,8 @@
 #include <wx/dcmemory.h> // For wxMemoryDC
 #include <wx/font.h> // For wxFont
 #include "../include/CommonTypes.h"
+#include "../include/ContentBounds.h"
+#include "../include/ImageCodec.h"
 
 // Define the static member
 std::vector<uint8_t> BitmapData::allegro_palette;
@@ -312,6 +313,7 @@ int BitmapData::getBytesPerPixel() const {
 }
 
 bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, BitmapData& outBitmap) {
+    PROFILE_SCOPE("BitmapData::parse");
     // Check if it's palette data
     if (typeID == ObjectType::DAT_PALETTE) {
         // Expected size: 256 entries * 4 bytes/entry (R, G, B, Pad)
@@ -361,10 +363,8 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
         outBitmap.height = (buffer[4] << 8) | buffer[5];
         if (outBitmap.bits & 0x8000) outBitmap.bits |= ~0xFFFF;  // Sign extend if negative
         uint32_t dataSize = (buffer[6] << 24) | (buffer[7] << 16) | (buffer[8] << 8) | buffer[9];
-        logDebug("RLE sprite header - Bits: " + std::to_string(outBitmap.bits) + 
-                ", Width: " + std::to_string(outBitmap.width) + 
-                ", Height: " + std::to_string(outBitmap.height) + 
-                ", Data size: " + std::to_string(dataSize));
+        LOG_DEBUG("RLE sprite header - Bits: %d, Width: %d, Height: %d, Data size: %u",
+                  outBitmap.bits, outBitmap.width, outBitmap.height, dataSize);
 
         // Validate format and dimensions
         if (!outBitmap.isValidFormat() || outBitmap.width <= 0 || outBitmap.height <= 0) {
@@ -380,11 +380,11 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
             logError("Invalid bytes per pixel for RLE sprite: " + std::to_string(bytesPerPixel));
             return false;
         }
-        logDebug("Bytes per pixel: " + std::to_string(bytesPerPixel));
+        LOG_DEBUG("Bytes per pixel: %d", bytesPerPixel);
 
         // Allocate output buffer and fill with zeros
         size_t expectedDataSize = outBitmap.width * outBitmap.height * bytesPerPixel;
-        logDebug("Allocating output buffer of size: " + std::to_string(expectedDataSize));
+        LOG_DEBUG("Allocating output buffer of size: %zu", expectedDataSize);
         outBitmap.data.resize(expectedDataSize, 0);
         outBitmap.alpha.resize(outBitmap.width * outBitmap.height, 255);
         size_t outPos = 0;
@@ -405,7 +405,7 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
                 int8_t count8 = buffer[inPos];
                 count = static_cast<int32_t>(count8);
                 inPos += 1;
-                logDebug("Read 8-bit count: " + std::to_string(count) + " at position " + std::to_string(inPos - 1));
+                LOG_DEBUG("Read 8-bit count: %d at position %zu", count, inPos - 1);
             }
             else if (outBitmap.bits == 15 || outBitmap.bits == 16) {
                 if (inPos + 2 > buffer.size()) {
@@ -415,7 +415,7 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
                 int16_t count16 = buffer[inPos] | (buffer[inPos + 1] << 8);
                 count = static_cast<int32_t>(count16);
                 inPos += 2;
-                logDebug("Read 16-bit count: " + std::to_string(count) + " at position " + std::to_string(inPos - 2));
+                LOG_DEBUG("Read 16-bit count: %d at position %zu", count, inPos - 2);
             } else {
                 if (inPos + 4 > buffer.size()) {
                     logError("Buffer underflow while reading 32-bit count at position " + std::to_string(inPos));
@@ -424,26 +424,26 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
                 count = buffer[inPos] | (buffer[inPos + 1] << 8) | 
                        (buffer[inPos + 2] << 16) | (buffer[inPos + 3] << 24);
                 inPos += 4;
-                logDebug("Read 32-bit count: " + std::to_string(count) + " at position " + std::to_string(inPos - 4));
+                LOG_DEBUG("Read 32-bit count: %d at position %zu", count, inPos - 4);
             }
 
             if (outBitmap.bits == 8 && count == RLE_EOL_MARKER_8) {
-                logDebug("Found 8-bit EOL marker");
+                LOG_DEBUG("Found 8-bit EOL marker");
                 continue;
             }
             if ((outBitmap.bits == 15 || outBitmap.bits == 16) && count == RLE_EOL_MARKER_16) {
-                logDebug("Found 16-bit EOL marker");
+                LOG_DEBUG("Found 16-bit EOL marker");
                 continue;
             }
             if ((outBitmap.bits == 24 || outBitmap.bits == 32 || outBitmap.bits == -32) && count == RLE_EOL_MARKER_32) {
-                logDebug("Found 32-bit EOL marker");
+                LOG_DEBUG("Found 32-bit EOL marker");
                 continue;
             }
 
             if (count < 0) {
                 // negative count means zero run
                 count = -count;
-                logDebug("Processing zero run of length: " + std::to_string(count));
+                LOG_DEBUG("Processing zero run of length: %d", count);
                 // fill the alpha channel with 0
                 if (outPos/bytesPerPixel + count > outBitmap.alpha.size()) {
                     logError("Alpha channel size mismatch - Position: " + std::to_string(outPos/bytesPerPixel) + 
@@ -459,8 +459,7 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
             else {
                 // positive count means run
                 int bytesToCopy = count * bytesPerPixel;
-                logDebug("Processing data run of length: " + std::to_string(count) + 
-                       " (" + std::to_string(bytesToCopy) + " bytes)");
+                LOG_DEBUG("Processing data run of length: %d (%d bytes)", count, bytesToCopy);
                 // check if we have enough data
                 if (inPos + bytesToCopy > buffer.size()) {
                     logError("Not enough data to copy - Need: " + std::to_string(bytesToCopy) + 
@@ -481,8 +480,8 @@ bool BitmapData::parse(const std::vector<uint8_t>& buffer, ObjectType typeID, Bi
             }
         }
 
-        logDebug("RLE data processing complete - Processed " + std::to_string(outPos) + 
-                " bytes of output data from " + std::to_string(inPos) + " bytes of input data");
+        LOG_DEBUG("RLE data processing complete - Processed %zu bytes of output data from %zu bytes of input data",
+                  outPos, inPos);
         outBitmap.typeID = typeID; // Store the type ID
         return true;
     }
@@ -581,6 +580,7 @@ void BitmapData::updateAlphaChannel() {
 }
 
 std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const {
+    PROFILE_SCOPE("BitmapData::serialize");
     // Validate format and dimensions
     if (!isValidFormat() || width <= 0 || height <= 0) {
         return std::vector<uint8_t>();
@@ -606,13 +606,12 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
             return std::vector<uint8_t>();
         }
 
-        logInfo("Starting RLE sprite serialization: " + std::to_string(width) + "x" + std::to_string(height) + 
-                " (" + std::to_string(bits) + " bit)");
+        LOG_INFO("Starting RLE sprite serialization: %dx%d (%d bit)", width, height, bits);
 
         // Create buffer for RLE data
         std::vector<uint8_t> buffer;
         buffer.reserve(10 + data.size() * 2); // Reserve space for header and worst-case RLE data
-        logInfo("Reserved buffer space: " + std::to_string(10 + data.size() * 2) + " bytes");
+        LOG_DEBUG("Reserved buffer space: %zu bytes", 10 + data.size() * 2);
 
         // Write header (big endian)
         buffer.push_back(static_cast<uint8_t>((bits >> 8) & 0xFF));
@@ -621,18 +620,16 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
         buffer.push_back(static_cast<uint8_t>(width & 0xFF));
         buffer.push_back(static_cast<uint8_t>((height >> 8) & 0xFF));
         buffer.push_back(static_cast<uint8_t>(height & 0xFF));
-        logInfo("Written header - Bits: " + std::to_string(bits) + 
-                ", Width: " + std::to_string(width) + 
-                ", Height: " + std::to_string(height));
+        LOG_DEBUG("Written header - Bits: %d, Width: %d, Height: %d", bits, width, height);
 
         // Reserve space for data size (will be filled later)
         size_t dataSizePos = buffer.size();
         buffer.resize(buffer.size() + 4);
         uint32_t nonZeroDataSize = 0;
-        logInfo("Reserved space for data size at position: " + std::to_string(dataSizePos));
+        LOG_DEBUG("Reserved space for data size at position: %zu", dataSizePos);
 
         // Process each row
-        logInfo("Starting row processing");
+        LOG_DEBUG("Starting row processing");
         //TODO: check 8 bit palette indexing
         int32_t zeroColor = bits == 8 ? RLE_ZERO_COLOR_8 : (bits == 15 || bits == 16 ? RLE_ZERO_COLOR_16 : RLE_ZERO_COLOR_32);
         for (int y = 0; y < height; y++) {
@@ -642,9 +639,7 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
             int32_t zeroRunLength = 0;
             size_t runStart = pos;
             int32_t runLength = 0;
-            logDebug("Processing row " + std::to_string(y) + 
-                    " (start: " + std::to_string(rowStart) + 
-                    ", end: " + std::to_string(rowEnd) + ")");
+            LOG_DEBUG("Processing row %d (start: %zu, end: %zu)", y, rowStart, rowEnd);
 
             while (pos <= rowEnd) {
                 bool bAnyRunEnded = false;
@@ -653,7 +648,7 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
                 if (pos >= rowEnd) {    // end of line
                     bAnyRunEnded = true;
                     bLineEnded = true;
-                    logDebug("Reached end of line at position " + std::to_string(pos));
+                    LOG_DEBUG("Reached end of line at position %zu", pos);
                 }
                 if (!bLineEnded) {
                     if (bits == 8) {
@@ -669,16 +664,16 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
                 }
                 if (runLength > 0 && bZeroPixel) {
                     bAnyRunEnded = true;
-                    logDebug("Run ended due to zero color at position " + std::to_string(pos));
+                    LOG_DEBUG("Run ended due to zero color at position %zu", pos);
                 }
                 if (!bLineEnded && zeroRunLength > 0 && !bZeroPixel) {
                     bAnyRunEnded = true;
-                    logDebug("Zero run ended due to non-zero color at position " + std::to_string(pos));
+                    LOG_DEBUG("Zero run ended due to non-zero color at position %zu", pos);
                 }
                 if (bAnyRunEnded) {
                     if (runLength > 0) {
                         // Write positive count (run of non-zero pixels)
-                        logDebug("Writing non-zero run of length " + std::to_string(runLength));
+                        LOG_DEBUG("Writing non-zero run of length %d", runLength);
                         if (bits == 8) {
                             // Split long runs into multiple runs of max 127 pixels
                             while (runLength > 0) {
@@ -710,7 +705,7 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
                     }
                     else if (zeroRunLength > 0) {
                         // Write negative count (run of zero pixels)
-                        logInfo("Writing zero run of length " + std::to_string(zeroRunLength));
+                        LOG_DEBUG("Writing zero run of length %d", zeroRunLength);
                         if (bits == 8) {
                             // Split long zero runs into multiple runs of max 128 pixels
                             while (zeroRunLength > 0) {
@@ -759,15 +754,14 @@ std::vector<uint8_t> BitmapData::serialize(std::vector<uint8_t>& palette) const
 
         // Write data size (big endian)
         uint32_t dataSize = buffer.size() - 10 + nonZeroDataSize;
-        logInfo("Writing final data size: " + std::to_string(dataSize) + 
-                " (buffer size: " + std::to_string(buffer.size()) + 
-                ", non-zero data: " + std::to_string(nonZeroDataSize) + ")");
+        LOG_DEBUG("Writing final data size: %u (buffer size: %zu, non-zero data: %u)",
+                  dataSize, buffer.size(), nonZeroDataSize);
         buffer[dataSizePos] = static_cast<uint8_t>((dataSize >> 24) & 0xFF);
         buffer[dataSizePos + 1] = static_cast<uint8_t>((dataSize >> 16) & 0xFF);
         buffer[dataSizePos + 2] = static_cast<uint8_t>((dataSize >> 8) & 0xFF);
         buffer[dataSizePos + 3] = static_cast<uint8_t>(dataSize & 0xFF);
 
-        logInfo("RLE sprite serialization complete: " + std::to_string(buffer.size()) + " bytes");
+        LOG_INFO("RLE sprite serialization complete: %zu bytes", buffer.size());
 
         return buffer;
     }
@@ -1005,7 +999,7 @@ bool BitmapData::ReadPCXFile(const wxString& filename, wxImage& image) {
                 scanline[linePos++] = byte;
             }
         }
-        logDebug("ReadPCXFile: Read " + std::to_string(bytesReadForLine) + " bytes for line " + std::to_string(y));
+        LOG_DEBUG("ReadPCXFile: Read %zu bytes for line %d", bytesReadForLine, y);
 
         // Convert scanline to RGB pixels
         if (is24BitColor) {
@@ -1095,6 +1089,7 @@ bool BitmapData::ReadPCXFile(const wxString& filename, wxImage& image) {
 }
 
 bool BitmapData::loadFromWxImage(const wxImage& image, int bits, std::vector<uint8_t>* currentPalette, bool useDithering, bool preserveTransparency) {
+    PROFILE_SCOPE("BitmapData::loadFromWxImage");
     if (!image.IsOk()) {
         return false;
     }
@@ -1164,7 +1159,7 @@ bool BitmapData::loadFromWxImage(const wxImage& image, int bits, std::vector<uin
                 uint8_t b = rgbData[idx + 2];
 
                 if (x == 0 && y == 0) {
-                    logDebug("First pixel RGB: (" + std::to_string(r) + "," + std::to_string(g) + "," + std::to_string(b) + ")");
+                    LOG_DEBUG("First pixel RGB: (%d,%d,%d)", r, g, b);
                 }
 
                 // Find closest color in palette
@@ -1225,7 +1220,7 @@ bool BitmapData::loadFromWxImage(const wxImage& image, int bits, std::vector<uin
                 int pixelIdx = y * width + x;
 
                 if (preserveTransparency && compareRGBwithColor(rgbData + idx, TRANSPARENT_COLOR, 24)) {
-                    logDebug("Preserving transparency for pixel " + std::to_string(x) + "," + std::to_string(y));
+                    LOG_DEBUG("Preserving transparency for pixel %d,%d", x, y);
                     if (this->bits == 15) {
                         this->data[pixelIdx * 2] = TRANSPARENT_COLOR_15 & 0xFF;
                         this->data[pixelIdx * 2 + 1] = (TRANSPARENT_COLOR_15 >> 8) & 0xFF;
@@ -1272,6 +1267,10 @@ bool BitmapData::loadFromWxImage(const wxImage& image, int bits, std::vector<uin
 }
 
 bool BitmapData::importFromFile(const std::string& filepath, std::vector<uint8_t>* currentPalette, bool useDithering, bool preserveTransparency) {
+    PROFILE_SCOPE("BitmapData::importFromFile");
+    if (importWithCodec(filepath, currentPalette, useDithering, preserveTransparency)) {
+        return true;
+    }
     wxImage image;
     if (!BitmapData::readFileToWxImage(filepath, image)) {
         return false;
@@ -1279,6 +1278,87 @@ bool BitmapData::importFromFile(const std::string& filepath, std::vector<uint8_t
     return loadFromWxImage(image, bits, currentPalette, useDithering, preserveTransparency);
 }
 
+bool BitmapData::importWithCodec(const std::string& filepath, std::vector<uint8_t>* currentPalette, bool useDithering, bool preserveTransparency) {
+    if (ImageCodec::formatFromPath(filepath) == ImageCodec::Format::Unknown) {
+        return false;
+    }
+    ImageCodec::DecodedImage decoded;
+    if (!ImageCodec::readFile(filepath, decoded)) {
+        return false;
+    }
+    const BitmapData& source = decoded.bitmap;
+    int targetBits = (bits == 0) ? (source.bits == -32 ? -32 : 24) : bits;
+    size_t pixelCount = static_cast<size_t>(source.width) * source.height;
+    std::vector<uint8_t> newData;
+    std::vector<uint8_t> newAlpha;
+
+    if (source.bits == 8) {
+        // Dithering looks at neighbouring pixels and transparent palette entries need the alpha path
+        bool dithered = useDithering && (targetBits == 8 || targetBits == 15 || targetBits == 16);
+        if (dithered || decoded.paletteHasAlpha) {
+            return false;
+        }
+        // Convert each palette entry the way loadFromWxImage converts a pixel of that color,
+        // then the image itself is a table lookup per pixel
+        wxImage paletteImage(256, 1);
+        std::memcpy(paletteImage.GetData(), decoded.palette.data(), 768);
+        BitmapData lut;
+        lut.typeID = typeID;
+        if (!lut.loadFromWxImage(paletteImage, targetBits, currentPalette, false, preserveTransparency)) {
+            return false;
+        }
+        int bytesPerPixel = lut.getBytesPerPixel();
+        newData.resize(pixelCount * bytesPerPixel);
+        for (size_t i = 0; i < pixelCount; i++) {
+            std::memcpy(newData.data() + i * bytesPerPixel, lut.data.data() + source.data[i] * bytesPerPixel, bytesPerPixel);
+        }
+        // 8-bit RLE sprites get their alpha from loadFromWxImage, other types from updateAlphaChannel
+        if (targetBits == 8 && lut.alpha.size() == 256) {
+            newAlpha.resize(pixelCount);
+            for (size_t i = 0; i < pixelCount; i++) {
+                newAlpha[i] = lut.alpha[source.data[i]];
+            }
+        }
+    } else if (targetBits == 24 || targetBits == 32 || targetBits == -32) {
+        int sourceBytes = source.getBytesPerPixel();
+        int targetBytes = targetBits == -32 ? 4 : 3;
+        newData.resize(pixelCount * targetBytes);
+        for (size_t i = 0; i < pixelCount; i++) {
+            const uint8_t* src = source.data.data() + i * sourceBytes;
+            uint8_t* dst = newData.data() + i * targetBytes;
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            if (targetBytes == 4) {
+                dst[3] = sourceBytes == 4 ? src[3] : 255;
+            }
+        }
+    } else {
+        // Truecolor to a palette or 15/16-bit depth: reuse the decoded pixels instead of decoding again
+        wxImage image(source.width, source.height);
+        unsigned char* rgb = image.GetData();
+        int sourceBytes = source.getBytesPerPixel();
+        if (sourceBytes == 4) {
+            image.SetAlpha();
+        }
+        for (size_t i = 0; i < pixelCount; i++) {
+            std::memcpy(rgb + i * 3, source.data.data() + i * sourceBytes, 3);
+            if (sourceBytes == 4) {
+                image.GetAlpha()[i] = source.data[i * 4 + 3];
+            }
+        }
+        return loadFromWxImage(image, targetBits, currentPalette, useDithering, preserveTransparency);
+    }
+
+    width = source.width;
+    height = source.height;
+    bits = targetBits;
+    data = std::move(newData);
+    alpha = std::move(newAlpha);
+    updateAlphaChannel();
+    return true;
+}
+
 bool BitmapData::generateOptimalPalette(const wxImage& image, std::vector<uint8_t>& palette) {
     if (!image.IsOk()) {
         palette = BitmapData::allegro_palette;  // Set to default Allegro palette on failure
@@ -1492,6 +1572,7 @@ bool BitmapData::createFromPalette(const std::vector<uint8_t>& palette, BitmapDa
 }
 
 bool BitmapData::toWxImage(wxImage& outImage, std::vector<uint8_t>& palette, bool PreserveTransparency) const {
+    PROFILE_SCOPE("BitmapData::toWxImage");
     
     if (typeID == ObjectType::DAT_PALETTE) {
         
@@ -1611,6 +1692,13 @@ bool BitmapData::readFileToWxImage(const wxString& filepath, wxImage& image) {
     return image.LoadFile(filepath);
 }
 
+// Bytes of a pixel that take part in color comparisons: 15-bit pixels
+// (RRRRRGGGGG1BBBBB) ignore their unused bit 5, 32-bit RGB is stored as 3 bytes already
+static const uint8_t* pixelCompareMask(int bits) {
+    static const uint8_t mask15[4] = {0xDF, 0xFF, 0x00, 0x00};
+    return bits == 15 ? mask15 : nullptr;
+}
+
 bool BitmapData::isMonocolor() const {
     if (data.empty() || width == 0 || height == 0) {
         return true; // Empty bitmap is considered monocolor
@@ -1622,73 +1710,57 @@ bool BitmapData::isMonocolor() const {
         return false; // Invalid format
     }
 
-    // Get the first pixel's color
-    if (bits == 8) {
-        // For 8-bit indexed color, check if all pixels have the same index
-        uint8_t firstIndex = data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int offset = y * width + x;
-                if (data[offset] != firstIndex) {
-                    return false;
-                }
-            }
-        }
-    }
-    else if (bits == 15 || bits == 16) {
-        // For 15/16-bit color, compare 16-bit values
-        uint16_t firstPixel = *reinterpret_cast<const uint16_t*>(data.data());
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int offset = (y * width + x) * bytesPerPixel;
-                uint16_t pixel = *reinterpret_cast<const uint16_t*>(data.data() + offset);
-                if (pixel != firstPixel) {
-                    return false;
-                }
-            }
-        }
+    return ContentBounds::isUniform(data.data(), width, height, static_cast<size_t>(width) * bytesPerPixel,
+                                    bytesPerPixel, pixelCompareMask(bits));
+}
+
+bool BitmapData::findDominantColor(uint8_t* color) const {
+    int bytesPerPixel = getBytesPerPixel();
+    if (bytesPerPixel == 0 || data.empty()) {
+        return false;
     }
-    else if (bits == 24 || bits == 32) {
-        // For 24/32-bit color, compare RGB components
-        uint8_t firstR = data[0];
-        uint8_t firstG = data[1];
-        uint8_t firstB = data[2];
+    const uint8_t* mask = pixelCompareMask(bits);
+    size_t pixelCount = static_cast<size_t>(width) * height;
 
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int offset = (y * width + x) * bytesPerPixel;
-                if (data[offset] != firstR || 
-                    data[offset + 1] != firstG || 
-                    data[offset + 2] != firstB) {
-                    return false;
-                }
+    // Histogram over the packed (masked) pixel value, ties go to the lowest value
+    auto packPixel = [&](size_t i) {
+        uint32_t key = 0;
+        for (int b = 0; b < bytesPerPixel; b++) {
+            key = (key << 8) | (data[i * bytesPerPixel + b] & (mask ? mask[b] : 0xFF));
+        }
+        return key;
+    };
+    uint32_t bestKey = 0;
+    size_t bestCount = 0;
+    if (bytesPerPixel <= 2) {
+        std::vector<uint32_t> counts(bytesPerPixel == 1 ? 256 : 65536, 0);
+        for (size_t i = 0; i < pixelCount; i++) {
+            counts[packPixel(i)]++;
+        }
+        for (uint32_t key = 0; key < counts.size(); key++) {
+            if (counts[key] > bestCount) {
+                bestCount = counts[key];
+                bestKey = key;
             }
         }
-    }
-    else if (bits == -32) {
-        // For true 32-bit RGBA, compare all components
-        uint8_t firstR = data[0];
-        uint8_t firstG = data[1];
-        uint8_t firstB = data[2];
-        uint8_t firstA = data[3];
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int offset = (y * width + x) * bytesPerPixel;
-                if (data[offset] != firstR || 
-                    data[offset + 1] != firstG || 
-                    data[offset + 2] != firstB ||
-                    data[offset + 3] != firstA) {
-                    return false;
-                }
+    } else {
+        std::unordered_map<uint32_t, size_t> counts;
+        for (size_t i = 0; i < pixelCount; i++) {
+            counts[packPixel(i)]++;
+        }
+        for (const auto& [key, count] : counts) {
+            if (count > bestCount || (count == bestCount && key < bestKey)) {
+                bestCount = count;
+                bestKey = key;
             }
         }
     }
-    else {
-        return false; // Unsupported bit depth
-    }
 
-    return true; // All pixels are the same color
+    for (int b = bytesPerPixel - 1; b >= 0; b--) {
+        color[b] = bestKey & 0xFF;
+        bestKey >>= 8;
+    }
+    return true;
 }
 
 bool BitmapData::autoCrop(int& xCrop, int& yCrop) {
@@ -1704,258 +1776,145 @@ bool BitmapData::autoCrop(int& xCrop, int& yCrop) {
         return false; // Invalid format
     }
 
-    bool wasCropped = false;
-    // Find bounds of non-transparent content
-    int minX = width, minY = height, maxX = 0, maxY = 0;
-
-    // First pass: find the dominant color
-    std::map<std::vector<uint8_t>, int> colorCounts;
-    for (int py = 0; py < height; py++) {
-        for (int px = 0; px < width; px++) {
-            int offset = (py * width + px) * bytesPerPixel;
-            std::vector<uint8_t> color;
-            
-            if (bits == 8) {
-                // For 8-bit, use the palette index as the color
-                color.push_back(data[offset]);
-            }
-            else if (bits == 15 || bits == 16) {
-                // For 15/16-bit, convert to RGB
-                uint16_t pixel = *reinterpret_cast<const uint16_t*>(data.data() + offset);
-                if (bits == 15) {
-                    color.push_back(((pixel >> 11) & 0x1F) << 3);     // R
-                    color.push_back(((pixel >> 6) & 0x1F) << 3);      // G
-                    color.push_back((pixel & 0x1F) << 3);             // B
-                } else {
-                    color.push_back(((pixel >> 11) & 0x1F) << 3);     // R
-                    color.push_back(((pixel >> 5) & 0x3F) << 2);      // G
-                    color.push_back((pixel & 0x1F) << 3);             // B
-                }
-            }
-            else if (bits == 24 || bits == 32) {
-                // For 24/32-bit, use RGB components
-                color.push_back(data[offset]);     // R
-                color.push_back(data[offset + 1]); // G
-                color.push_back(data[offset + 2]); // B
-            }
-            else if (bits == -32) {
-                // For true 32-bit, use RGBA components
-                color.push_back(data[offset]);     // R
-                color.push_back(data[offset + 1]); // G
-                color.push_back(data[offset + 2]); // B
-                color.push_back(data[offset + 3]); // A
-            }
-            
-            colorCounts[color]++;
-        }
+    // The most common color is the background, crop to everything else
+    uint8_t background[4] = {0, 0, 0, 0};
+    if (!findDominantColor(background)) {
+        return false;
     }
-    
-    // Find the most common color
-    std::vector<uint8_t> dominantColor;
-    int maxCount = 0;
-    for (const auto& [color, count] : colorCounts) {
-        if (count > maxCount) {
-            maxCount = count;
-            dominantColor = color;
-        }
-    }
-     
-    // Second pass: find bounds of non-dominant color content
-    for (int py = 0; py < height; py++) {
-        for (int px = 0; px < width; px++) {
-            int offset = (py * width + px) * bytesPerPixel;
-            std::vector<uint8_t> currentColor;
-            
-            if (bits == 8) {
-                currentColor.push_back(data[offset]);
-            }
-            else if (bits == 15 || bits == 16) {
-                uint16_t pixel = *reinterpret_cast<const uint16_t*>(data.data() + offset);
-                if (bits == 15) {
-                    currentColor.push_back(((pixel >> 11) & 0x1F) << 3);
-                    currentColor.push_back(((pixel >> 6) & 0x1F) << 3);
-                    currentColor.push_back((pixel & 0x1F) << 3);
-                } else {
-                    currentColor.push_back(((pixel >> 11) & 0x1F) << 3);
-                    currentColor.push_back(((pixel >> 5) & 0x3F) << 2);
-                    currentColor.push_back((pixel & 0x1F) << 3);
-                }
-            }
-            else if (bits == 24 || bits == 32) {
-                currentColor.push_back(data[offset]);
-                currentColor.push_back(data[offset + 1]);
-                currentColor.push_back(data[offset + 2]);
-            }
-            else if (bits == -32) {
-                currentColor.push_back(data[offset]);
-                currentColor.push_back(data[offset + 1]);
-                currentColor.push_back(data[offset + 2]);
-                currentColor.push_back(data[offset + 3]);
-            }
-            
-            if (currentColor != dominantColor) {
-                minX = std::min(minX, px);
-                minY = std::min(minY, py);
-                maxX = std::max(maxX, px);
-                maxY = std::max(maxY, py);
-            }
-        }
+    size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+    wxRect bounds;
+    if (!ContentBounds::find(data.data(), width, height, rowBytes, bytesPerPixel, background, pixelCompareMask(bits), bounds)) {
+        return false; // Nothing but background
     }
-     
-    // Check if we found any non-dominant color content
-    wasCropped = (minX <= maxX && minY <= maxY) && 
-                (minX > 0 || minY > 0 || maxX < width-1 || maxY < height-1);
-
-    if (wasCropped) {
-        // Set the crop offsets
-        xCrop = minX;
-        yCrop = minY;
-
-        // Crop the bitmap
-        int cropWidth = maxX - minX + 1;
-        int cropHeight = maxY - minY + 1;
-        BitmapData croppedBitmap;
-        croppedBitmap.width = cropWidth;
-        croppedBitmap.height = cropHeight;
-        croppedBitmap.bits = bits;
-        croppedBitmap.data.resize(cropWidth * cropHeight * bytesPerPixel);
-        
-        // Copy the cropped area
-        for (int y = 0; y < cropHeight; y++) {
-            for (int x = 0; x < cropWidth; x++) {
-                int srcOffset = ((minY + y) * width + (minX + x)) * bytesPerPixel;
-                int dstOffset = (y * cropWidth + x) * bytesPerPixel;
-                std::copy(data.begin() + srcOffset,
-                         data.begin() + srcOffset + bytesPerPixel,
-                         croppedBitmap.data.begin() + dstOffset);
-            }
+    if (bounds.width == width && bounds.height == height) {
+        return false;
+    }
+
+    // Crop in place, keeping the type and the separate alpha plane (RLE sprites) in sync
+    size_t croppedRowBytes = static_cast<size_t>(bounds.width) * bytesPerPixel;
+    std::vector<uint8_t> croppedData(croppedRowBytes * bounds.height);
+    for (int y = 0; y < bounds.height; y++) {
+        std::memcpy(croppedData.data() + y * croppedRowBytes,
+                    data.data() + (bounds.y + y) * rowBytes + static_cast<size_t>(bounds.x) * bytesPerPixel,
+                    croppedRowBytes);
+    }
+    if (alpha.size() == static_cast<size_t>(width) * height) {
+        std::vector<uint8_t> croppedAlpha(static_cast<size_t>(bounds.width) * bounds.height);
+        for (int y = 0; y < bounds.height; y++) {
+            std::memcpy(croppedAlpha.data() + static_cast<size_t>(y) * bounds.width,
+                        alpha.data() + static_cast<size_t>(bounds.y + y) * width + bounds.x, bounds.width);
         }
-        
-        *this = croppedBitmap;
+        alpha = std::move(croppedAlpha);
+    } else {
+        alpha.clear();
     }
+    data = std::move(croppedData);
+    width = bounds.width;
+    height = bounds.height;
 
-    return wasCropped;
+    // Set the crop offsets
+    xCrop = bounds.x;
+    yCrop = bounds.y;
+    return true;
 }
 
 std::vector<BitmapData::GridCell> BitmapData::gridByColor(const wxImage& image, const wxColour& gridColor) {
     std::vector<GridCell> gridCells;
+    for (const wxRect& rect : findGridCellsByColor(image, gridColor)) {
+        gridCells.push_back({rect.x, rect.y, rect.width, rect.height, image.GetSubImage(rect)});
+    }
+    return gridCells;
+}
+
+std::vector<wxRect> BitmapData::findGridCellsByColor(const wxImage& image, const wxColour& gridColor) {
+    PROFILE_SCOPE("BitmapData::findGridCellsByColor");
+    std::vector<wxRect> cells;
 
     if (!image.IsOk() || !gridColor.IsOk()) {
         logError("gridByColor: Input image or grid color is invalid.");
-        return gridCells;
+        return cells;
     }
 
     int width = image.GetWidth();
     int height = image.GetHeight();
-    std::vector<bool> visited(width * height, false);
+    const unsigned char* rgb = image.GetData();
+    const unsigned char* alpha = image.HasAlpha() ? image.GetAlpha() : nullptr;
 
     unsigned char gridR = gridColor.Red();
     unsigned char gridG = gridColor.Green();
     unsigned char gridB = gridColor.Blue();
-    bool checkAlpha = image.HasAlpha();
-    unsigned char gridA = checkAlpha ? gridColor.Alpha() : 255;
+    unsigned char gridA = alpha ? gridColor.Alpha() : 255;
 
+    // One pass over the raw buffer: grid pixels start out visited, so the
+    // region search below only ever looks at this byte map
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> visited(pixelCount);
+    for (size_t i = 0; i < pixelCount; i++) {
+        const unsigned char* pixel = rgb + i * 3;
+        visited[i] = pixel[0] == gridR && pixel[1] == gridG && pixel[2] == gridB && (!alpha || alpha[i] == gridA);
+    }
+
+    // Flood fill every unvisited region (4-connectivity) to get its bounding box
+    std::vector<size_t> stack;
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
-            int currentIdx = y * width + x;
-
-            // Skip visited pixels
-            if (visited[currentIdx]) {
+            size_t startIdx = static_cast<size_t>(y) * width + x;
+            if (visited[startIdx]) {
                 continue;
             }
 
-            // Check if the current pixel is the grid color
-            unsigned char r = image.GetRed(x, y);
-            unsigned char g = image.GetGreen(x, y);
-            unsigned char b = image.GetBlue(x, y);
-            unsigned char a = checkAlpha ? image.GetAlpha(x, y) : 255;
-
-            bool isGridPixel = (r == gridR && g == gridG && b == gridB && (!checkAlpha || a == gridA));
-
-            // Mark grid pixels as visited and continue
-            if (isGridPixel) {
-                visited[currentIdx] = true;
-                continue;
-            }
-
-            // Found the start of a non-grid region
-            std::queue<std::pair<int, int>> q;
-            q.push({x, y});
-            visited[currentIdx] = true;
-
-            int minX = x, minY = y, maxX = x, maxY = y; // Bounding box for the region
-
-            while (!q.empty()) {
-                std::pair<int, int> current = q.front();
-                q.pop();
-                int cx = current.first;
-                int cy = current.second;
-
-                // Update bounding box
+            int minX = x, minY = y, maxX = x, maxY = y;
+            visited[startIdx] = 1;
+            stack.push_back(startIdx);
+            while (!stack.empty()) {
+                size_t idx = stack.back();
+                stack.pop_back();
+                int cx = static_cast<int>(idx % width);
+                int cy = static_cast<int>(idx / width);
                 minX = std::min(minX, cx);
                 minY = std::min(minY, cy);
                 maxX = std::max(maxX, cx);
                 maxY = std::max(maxY, cy);
 
-                // Check neighbors (4-connectivity)
-                int dx[] = {0, 0, 1, -1};
-                int dy[] = {1, -1, 0, 0};
-
-                for (int i = 0; i < 4; ++i) {
-                    int nx = cx + dx[i];
-                    int ny = cy + dy[i];
-                    int neighborIdx = ny * width + nx;
-
-                    // Check bounds
-                    if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                         // Check visited status
-                        if (!visited[neighborIdx]) {
-                            // Check if neighbor is NOT the grid color
-                            unsigned char nr = image.GetRed(nx, ny);
-                            unsigned char ng = image.GetGreen(nx, ny);
-                            unsigned char nb = image.GetBlue(nx, ny);
-                            unsigned char na = checkAlpha ? image.GetAlpha(nx, ny) : 255;
-                            bool isNeighborGrid = (nr == gridR && ng == gridG && nb == gridB && (!checkAlpha || na == gridA));
-
-                            if (!isNeighborGrid) {
-                                // Add non-grid, unvisited neighbor to queue
-                                visited[neighborIdx] = true;
-                                q.push({nx, ny});
-                            } else {
-                                // Mark grid neighbors as visited so we don't process them later
-                                visited[neighborIdx] = true;
-                            }
-                        }
-                    }
+                if (cx > 0 && !visited[idx - 1]) {
+                    visited[idx - 1] = 1;
+                    stack.push_back(idx - 1);
+                }
+                if (cx + 1 < width && !visited[idx + 1]) {
+                    visited[idx + 1] = 1;
+                    stack.push_back(idx + 1);
+                }
+                if (cy > 0 && !visited[idx - width]) {
+                    visited[idx - width] = 1;
+                    stack.push_back(idx - width);
+                }
+                if (cy + 1 < height && !visited[idx + width]) {
+                    visited[idx + width] = 1;
+                    stack.push_back(idx + width);
                 }
             }
 
-            // BFS for this region is complete, calculate properties
-            int cellWidth = maxX - minX + 1;
-            int cellHeight = maxY - minY + 1;
-
-            if (cellWidth > 0 && cellHeight > 0) {
-                // Extract the sub-image based on the bounding box
-                wxRect cellRect(minX, minY, cellWidth, cellHeight);
-                wxImage subImage = image.GetSubImage(cellRect);
-
-                // Add the found region as a GridCell
-                gridCells.push_back({minX, minY, cellWidth, cellHeight, subImage});
-                 logInfo(wxString::Format("Found cell at (%d, %d) size %dx%d", minX, minY, cellWidth, cellHeight).ToStdString());
-            } else {
-                 logWarning(wxString::Format("Found invalid cell at (%d, %d) size %dx%d", minX, minY, cellWidth, cellHeight).ToStdString());
-            }
+            cells.emplace_back(minX, minY, maxX - minX + 1, maxY - minY + 1);
+            LOG_VERBOSE("Found cell at (%d, %d) size %dx%d", minX, minY, maxX - minX + 1, maxY - minY + 1);
         }
     }
-    logDebug("gridByColor finished. Found " + std::to_string(gridCells.size()) + " cells.");
-    return gridCells;
+    LOG_DEBUG("gridByColor finished. Found %zu cells.", cells.size());
+    return cells;
 }
 
 std::vector<BitmapData::GridCell> BitmapData::gridBySize(const wxImage& image, int cellWidth, int cellHeight) {
     std::vector<GridCell> gridCells;
-    
-    if (!image.IsOk()) {
-        return gridCells;
+    for (const wxRect& rect : findGridCellsBySize(image, cellWidth, cellHeight)) {
+        gridCells.push_back(GridCell{rect.x, rect.y, rect.width, rect.height, image.GetSubImage(rect)});
+    }
+    return gridCells;
+}
+
+std::vector<wxRect> BitmapData::findGridCellsBySize(const wxImage& image, int cellWidth, int cellHeight) {
+    std::vector<wxRect> cells;
+
+    if (!image.IsOk() || cellWidth <= 0 || cellHeight <= 0) {
+        return cells;
     }
 
     int imageWidth = image.GetWidth();
@@ -1964,6 +1923,7 @@ std::vector<BitmapData::GridCell> BitmapData::gridBySize(const wxImage& image, i
     // Calculate the number of cells in each dimension
     int numCols = (imageWidth + cellWidth - 1) / cellWidth;
     int numRows = (imageHeight + cellHeight - 1) / cellHeight;
+    cells.reserve(static_cast<size_t>(numCols) * numRows);
     
     // Iterate through each cell
     for (int row = 0; row < numRows; row++) {
@@ -1980,13 +1940,11 @@ std::vector<BitmapData::GridCell> BitmapData::gridBySize(const wxImage& image, i
                 continue;
             }
 
-            // Create sub-image for this cell
-            wxImage cellImage = image.GetSubImage(wxRect(x, y, width, height));
-            gridCells.push_back(GridCell{x, y, width, height, cellImage});
+            cells.emplace_back(x, y, width, height);
         }
     }
 
-    return gridCells;
+    return cells;
 }
 
 double BitmapData::calculatePaletteMatch(const wxImage& image, const std::vector<uint8_t>& palette) {
@@ -2215,7 +2173,7 @@ bool BitmapData::WritePCXFile(const wxString& filepath, const wxImage& image) {
         // Pad to even bytes
         if (width & 1) scanline[width] = 0;
         encodeRLE(scanline.data(), bytesPerLine);
-        logDebug(wxString::Format("WritePCXFile: Wrote %d bytes for red plane, line %d", bytesPerLine, y).ToStdString());
+        LOG_DEBUG("WritePCXFile: Wrote %d bytes for red plane, line %d", bytesPerLine, y);
         
         // Green plane
         for (int x = 0; x < width; x++) {
@@ -2223,7 +2181,7 @@ bool BitmapData::WritePCXFile(const wxString& filepath, const wxImage& image) {
         }
         if (width & 1) scanline[width] = 0;
         encodeRLE(scanline.data(), bytesPerLine);
-        logDebug(wxString::Format("WritePCXFile: Wrote %d bytes for green plane, line %d", bytesPerLine, y).ToStdString());
+        LOG_DEBUG("WritePCXFile: Wrote %d bytes for green plane, line %d", bytesPerLine, y);
         
         // Blue plane
         for (int x = 0; x < width; x++) {
@@ -2231,7 +2189,7 @@ bool BitmapData::WritePCXFile(const wxString& filepath, const wxImage& image) {
         }
         if (width & 1) scanline[width] = 0;
         encodeRLE(scanline.data(), bytesPerLine);
-        logDebug(wxString::Format("WritePCXFile: Wrote %d bytes for blue plane, line %d", bytesPerLine, y).ToStdString());
+        LOG_DEBUG("WritePCXFile: Wrote %d bytes for blue plane, line %d", bytesPerLine, y);
     }
     
     // PCX files don't require a palette for 24-bit RGB images
@@ -2610,4 +2568,35 @@ wxRect BitmapData::findCharacterRegion(const std::shared_ptr<wxImage>& image, in
         return wxRect(0, 0, width, height);
     }
     return wxRect(left, top, right - left + 1, bottom - top + 1);
-}
\ No newline at end of file
+}
+
+uint64_t BitmapData::hashBytes(const uint8_t* bytes, size_t size, uint64_t seed) {
+    // Word-at-a-time multiply/xorshift mix, not cryptographic but fast and well spread
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = seed ^ (size * multiplier);
+    size_t pos = 0;
+    for (; pos + 8 <= size; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + pos, 8);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+    if (pos < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + pos, size - pos);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+    // Final avalanche
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t BitmapData::contentHash() const {
+    int32_t header[4] = {bits, width, height, static_cast<int32_t>(typeID)};
+    uint64_t hash = hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+    hash = hashBytes(data.data(), data.size(), hash);
+    return hashBytes(alpha.data(), alpha.size(), hash);
+}
@@ -0,0 +1,312 @@
+#include "../include/CompiledSprite.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    // Visible part of a sprite drawn at (x, y), in sprite coordinates
+    struct ClipRect {
+        int x0, y0, x1, y1;
+        bool empty() const { return x0 >= x1 || y0 >= y1; }
+    };
+
+    ClipRect clipSprite(const SpriteSurface& surface, int width, int height, int x, int y) {
+        return ClipRect{std::max(0, -x), std::max(0, -y),
+                        std::min(width, surface.width - x), std::min(height, surface.height - y)};
+    }
+
+    bool validSpriteBitmap(const BitmapData& bitmap) {
+        int bytesPerPixel = bitmap.getBytesPerPixel();
+        return bytesPerPixel > 0 && !bitmap.isPalette() && bitmap.width > 0 && bitmap.height > 0 &&
+               bitmap.width <= 0xFFFF &&
+               bitmap.data.size() >= static_cast<size_t>(bitmap.width) * bitmap.height * bytesPerPixel;
+    }
+
+    template <int Bytes, typename IsMask>
+    void drawMaskedRows(SpriteSurface& surface, const BitmapData& bitmap, int x, int y, const ClipRect& clip, IsMask isMask) {
+        size_t srcStride = static_cast<size_t>(bitmap.width) * Bytes;
+        size_t dstStride = static_cast<size_t>(surface.width) * Bytes;
+        for (int row = clip.y0; row < clip.y1; row++) {
+            const uint8_t* src = bitmap.data.data() + row * srcStride + clip.x0 * Bytes;
+            uint8_t* dst = surface.pixels.data() + (row + y) * dstStride + (clip.x0 + x) * Bytes;
+            for (int col = clip.x0; col < clip.x1; col++, src += Bytes, dst += Bytes) {
+                if (!isMask(src)) {
+                    std::memcpy(dst, src, Bytes);
+                }
+            }
+        }
+    }
+
+    template <typename Draw>
+    double timeBlits(Draw draw, int minMillis) {
+        using Clock = std::chrono::steady_clock;
+        draw();  // Warm-up
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::milliseconds(minMillis);
+        size_t blits = 0;
+        size_t batch = 1;
+        while (true) {
+            for (size_t i = 0; i < batch; i++) {
+                draw();
+            }
+            blits += batch;
+            auto now = Clock::now();
+            if (now >= deadline) {
+                return std::chrono::duration<double, std::nano>(now - start).count() / blits;
+            }
+            batch = std::min<size_t>(batch * 2, 1024);
+        }
+    }
+}
+
+SpriteSurface::SpriteSurface(int width, int height, int bytesPerPixel)
+    : width(width), height(height), bytesPerPixel(bytesPerPixel),
+      pixels(static_cast<size_t>(width) * height * bytesPerPixel, 0) {}
+
+void SpriteSurface::clear(uint8_t value) {
+    std::fill(pixels.begin(), pixels.end(), value);
+}
+
+bool isSpriteMaskPixel(const uint8_t* pixel, int bits) {
+    switch (bits) {
+        case 8:
+            return pixel[0] == 0;
+        case 15:
+            // The unused bit 5 is ignored, as in BitmapData::compareRGBwithColor
+            return ((pixel[0] | (pixel[1] << 8)) | 0x20) == (BitmapData::RLE_ZERO_COLOR_16 | 0x20);
+        case 16:
+            return (pixel[0] | (pixel[1] << 8)) == BitmapData::RLE_ZERO_COLOR_16;
+        case 24:
+        case 32:
+            return pixel[0] == 0xFF && pixel[1] == 0x00 && pixel[2] == 0xFF;
+        case -32:
+            return pixel[3] == 0;
+        default:
+            return false;
+    }
+}
+
+bool CompiledSprite::build(const BitmapData& bitmap) {
+    PROFILE_SCOPE("CompiledSprite::build");
+    if (!validSpriteBitmap(bitmap)) {
+        return false;
+    }
+    width = bitmap.width;
+    height = bitmap.height;
+    bytesPerPixel = bitmap.getBytesPerPixel();
+    rowStart.assign(1, 0);
+    spans.clear();
+    pixels.clear();
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = bitmap.data.data() + static_cast<size_t>(y) * width * bytesPerPixel;
+        int x = 0;
+        while (x < width) {
+            while (x < width && isSpriteMaskPixel(row + x * bytesPerPixel, bitmap.bits)) {
+                x++;
+            }
+            int start = x;
+            while (x < width && !isSpriteMaskPixel(row + x * bytesPerPixel, bitmap.bits)) {
+                x++;
+            }
+            if (x > start) {
+                spans.push_back(Span{static_cast<uint16_t>(start), static_cast<uint16_t>(x - start),
+                                     static_cast<uint32_t>(pixels.size())});
+                pixels.insert(pixels.end(), row + start * bytesPerPixel, row + x * bytesPerPixel);
+            }
+        }
+        rowStart.push_back(static_cast<uint32_t>(spans.size()));
+    }
+    return true;
+}
+
+void CompiledSprite::draw(SpriteSurface& surface, int x, int y) const {
+    ClipRect clip = clipSprite(surface, width, height, x, y);
+    if (clip.empty() || surface.bytesPerPixel != bytesPerPixel) {
+        return;
+    }
+    size_t dstStride = static_cast<size_t>(surface.width) * bytesPerPixel;
+    bool clippedX = clip.x0 > 0 || clip.x1 < width;
+    for (int row = clip.y0; row < clip.y1; row++) {
+        uint8_t* dstRow = surface.pixels.data() + (row + y) * dstStride;
+        for (uint32_t i = rowStart[row]; i < rowStart[row + 1]; i++) {
+            const Span& span = spans[i];
+            int start = span.x;
+            int end = span.x + span.length;
+            if (clippedX) {
+                start = std::max(start, clip.x0);
+                end = std::min(end, clip.x1);
+                if (start >= end) {
+                    continue;
+                }
+            }
+            std::memcpy(dstRow + (start + x) * bytesPerPixel,
+                        pixels.data() + span.offset + (start - span.x) * bytesPerPixel,
+                        static_cast<size_t>(end - start) * bytesPerPixel);
+        }
+    }
+}
+
+size_t CompiledSprite::getOpaquePixelCount() const {
+    return bytesPerPixel ? pixels.size() / bytesPerPixel : 0;
+}
+
+size_t CompiledSprite::getMemoryUsage() const {
+    return rowStart.size() * sizeof(uint32_t) + spans.size() * sizeof(Span) + pixels.size();
+}
+
+bool RleSprite::build(const BitmapData& bitmap) {
+    PROFILE_SCOPE("RleSprite::build");
+    if (!validSpriteBitmap(bitmap)) {
+        return false;
+    }
+    width = bitmap.width;
+    height = bitmap.height;
+    bytesPerPixel = bitmap.getBytesPerPixel();
+    counts.clear();
+    pixels.clear();
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = bitmap.data.data() + static_cast<size_t>(y) * width * bytesPerPixel;
+        int x = 0;
+        while (x < width) {
+            int start = x;
+            bool mask = isSpriteMaskPixel(row + x * bytesPerPixel, bitmap.bits);
+            while (x < width && isSpriteMaskPixel(row + x * bytesPerPixel, bitmap.bits) == mask) {
+                x++;
+            }
+            if (mask) {
+                counts.push_back(-(x - start));
+            } else {
+                counts.push_back(x - start);
+                pixels.insert(pixels.end(), row + start * bytesPerPixel, row + x * bytesPerPixel);
+            }
+        }
+        counts.push_back(0);  // End of line
+    }
+    return true;
+}
+
+void RleSprite::draw(SpriteSurface& surface, int x, int y) const {
+    ClipRect clip = clipSprite(surface, width, height, x, y);
+    if (clip.empty() || surface.bytesPerPixel != bytesPerPixel) {
+        return;
+    }
+    size_t dstStride = static_cast<size_t>(surface.width) * bytesPerPixel;
+    const int32_t* count = counts.data();
+    const uint8_t* src = pixels.data();
+
+    // Rows above the clip rectangle still have to be walked
+    for (int row = 0; row < clip.y0; row++) {
+        for (; *count != 0; count++) {
+            if (*count > 0) {
+                src += static_cast<size_t>(*count) * bytesPerPixel;
+            }
+        }
+        count++;
+    }
+    for (int row = clip.y0; row < clip.y1; row++) {
+        uint8_t* dstRow = surface.pixels.data() + (row + y) * dstStride;
+        int pos = 0;
+        for (; *count != 0; count++) {
+            if (*count < 0) {
+                pos -= *count;
+                continue;
+            }
+            int start = std::max(pos, clip.x0);
+            int end = std::min(pos + *count, clip.x1);
+            if (start < end) {
+                std::memcpy(dstRow + (start + x) * bytesPerPixel, src + (start - pos) * bytesPerPixel,
+                            static_cast<size_t>(end - start) * bytesPerPixel);
+            }
+            src += static_cast<size_t>(*count) * bytesPerPixel;
+            pos += *count;
+        }
+        count++;
+    }
+}
+
+size_t RleSprite::getMemoryUsage() const {
+    return counts.size() * sizeof(int32_t) + pixels.size();
+}
+
+void drawMaskedSprite(SpriteSurface& surface, const BitmapData& bitmap, int x, int y) {
+    ClipRect clip = clipSprite(surface, bitmap.width, bitmap.height, x, y);
+    if (clip.empty() || surface.bytesPerPixel != bitmap.getBytesPerPixel()) {
+        return;
+    }
+    switch (bitmap.bits) {
+        case 8:
+            drawMaskedRows<1>(surface, bitmap, x, y, clip, [](const uint8_t* p) { return p[0] == 0; });
+            break;
+        case 15:
+        case 16:
+            drawMaskedRows<2>(surface, bitmap, x, y, clip, [&](const uint8_t* p) { return isSpriteMaskPixel(p, bitmap.bits); });
+            break;
+        case 24:
+        case 32:
+            drawMaskedRows<3>(surface, bitmap, x, y, clip, [](const uint8_t* p) { return p[0] == 0xFF && p[1] == 0 && p[2] == 0xFF; });
+            break;
+        case -32:
+            drawMaskedRows<4>(surface, bitmap, x, y, clip, [](const uint8_t* p) { return p[3] == 0; });
+            break;
+    }
+}
+
+bool SpriteBlitBenchmark::run(const BitmapData& bitmap, Result& result, int minMillis) {
+    PROFILE_SCOPE("SpriteBlitBenchmark::run");
+    CompiledSprite compiled;
+    RleSprite rle;
+    if (!compiled.build(bitmap) || !rle.build(bitmap)) {
+        return false;
+    }
+
+    result = Result();
+    result.compiledSupported = bitmap.bits != -32;
+    result.compiledBytes = compiled.getMemoryUsage();
+    result.rleBytes = rle.getMemoryUsage();
+    result.maskedBytes = static_cast<size_t>(bitmap.width) * bitmap.height * bitmap.getBytesPerPixel();
+    result.opaqueRatio = static_cast<double>(compiled.getOpaquePixelCount()) / (static_cast<double>(bitmap.width) * bitmap.height);
+
+    // A margin around the sprite so every blit is unclipped
+    const int margin = 8;
+    int bytesPerPixel = bitmap.getBytesPerPixel();
+    SpriteSurface reference(bitmap.width + margin * 2, bitmap.height + margin * 2, bytesPerPixel);
+    SpriteSurface surface = reference;
+    reference.clear(0x5A);
+    drawMaskedSprite(reference, bitmap, margin, margin);
+    surface.clear(0x5A);
+    compiled.draw(surface, margin, margin);
+    result.outputsMatch = surface.pixels == reference.pixels;
+    surface.clear(0x5A);
+    rle.draw(surface, margin, margin);
+    result.outputsMatch = result.outputsMatch && surface.pixels == reference.pixels;
+
+    result.maskedNs = timeBlits([&] { drawMaskedSprite(surface, bitmap, margin, margin); }, minMillis);
+    result.rleNs = timeBlits([&] { rle.draw(surface, margin, margin); }, minMillis);
+    result.compiledNs = timeBlits([&] { compiled.draw(surface, margin, margin); }, minMillis);
+
+    // Fastest type wins; types within 10% of it are treated as equal and the smaller one is chosen
+    struct Candidate { ObjectType type; double ns; size_t bytes; };
+    std::vector<Candidate> candidates = {
+        {ObjectType::DAT_BITMAP, result.maskedNs, result.maskedBytes},
+        {ObjectType::DAT_RLE_SPRITE, result.rleNs, result.rleBytes},
+    };
+    if (result.compiledSupported) {
+        candidates.push_back({ObjectType::DAT_C_SPRITE, result.compiledNs, result.compiledBytes});
+    }
+    double fastest = std::min_element(candidates.begin(), candidates.end(),
+                                      [](const Candidate& a, const Candidate& b) { return a.ns < b.ns; })->ns;
+    const Candidate* best = nullptr;
+    for (const Candidate& candidate : candidates) {
+        if (candidate.ns <= fastest * 1.1 && (!best || candidate.bytes < best->bytes)) {
+            best = &candidate;
+        }
+    }
+    result.recommended = best->type;
+
+    LOG_DEBUG("Sprite blit benchmark %dx%d (%d bit): compiled %.0f ns, RLE %.0f ns, masked %.0f ns",
+              bitmap.width, bitmap.height, bitmap.bits, result.compiledNs, result.rleNs, result.maskedNs);
+    return true;
+}
@@ -0,0 +1,188 @@
+#include "../include/ContentBounds.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // 24 bytes hold a whole number of pixels for every supported pixel size,
+    // the pattern is stored twice so a chunk can start at any phase
+    constexpr int PatternPeriod = 24;
+
+    struct Pattern {
+        uint8_t value[PatternPeriod * 2];
+        uint8_t mask[PatternPeriod * 2];
+    };
+
+    Pattern makePattern(int bytesPerPixel, const uint8_t* background, const uint8_t* compareMask) {
+        Pattern pattern;
+        for (int i = 0; i < PatternPeriod * 2; i++) {
+            uint8_t mask = compareMask ? compareMask[i % bytesPerPixel] : 0xFF;
+            pattern.mask[i] = mask;
+            pattern.value[i] = background[i % bytesPerPixel] & mask;
+        }
+        return pattern;
+    }
+
+    inline uint64_t load64(const uint8_t* bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    inline bool byteDiffers(const uint8_t* row, size_t pos, const Pattern& pattern) {
+        size_t phase = pos % PatternPeriod;
+        return ((row[pos] & pattern.mask[phase]) ^ pattern.value[phase]) != 0;
+    }
+
+    // True if the 24 bytes at pos contain a difference
+    inline bool chunkDiffers(const uint8_t* row, size_t pos, const Pattern& pattern) {
+        size_t phase = pos % PatternPeriod;
+        uint64_t diff = 0;
+        for (int i = 0; i < 3; i++) {
+            diff |= (load64(row + pos + i * 8) & load64(pattern.mask + phase + i * 8)) ^ load64(pattern.value + phase + i * 8);
+        }
+        return diff != 0;
+    }
+
+    // Byte offsets are relative to the row start so the pattern phase stays aligned with the pixels
+    long firstDifferentByte(const uint8_t* row, size_t begin, size_t end, const Pattern& pattern) {
+        size_t pos = begin;
+        for (; pos + PatternPeriod <= end; pos += PatternPeriod) {
+            if (chunkDiffers(row, pos, pattern)) {
+                break;
+            }
+        }
+        for (; pos < end; pos++) {
+            if (byteDiffers(row, pos, pattern)) {
+                return static_cast<long>(pos);
+            }
+        }
+        return -1;
+    }
+
+    long lastDifferentByte(const uint8_t* row, size_t begin, size_t end, const Pattern& pattern) {
+        size_t pos = end;
+        for (; pos >= begin + PatternPeriod; pos -= PatternPeriod) {
+            if (chunkDiffers(row, pos - PatternPeriod, pattern)) {
+                break;
+            }
+        }
+        while (pos > begin) {
+            pos--;
+            if (byteDiffers(row, pos, pattern)) {
+                return static_cast<long>(pos);
+            }
+        }
+        return -1;
+    }
+}
+
+namespace ContentBounds {
+
+int firstMismatch(const uint8_t* row, int beginX, int endX, int bytesPerPixel,
+                  const uint8_t* background, const uint8_t* compareMask) {
+    Pattern pattern = makePattern(bytesPerPixel, background, compareMask);
+    long pos = firstDifferentByte(row, static_cast<size_t>(beginX) * bytesPerPixel,
+                                  static_cast<size_t>(endX) * bytesPerPixel, pattern);
+    return pos < 0 ? -1 : static_cast<int>(pos / bytesPerPixel);
+}
+
+int lastMismatch(const uint8_t* row, int beginX, int endX, int bytesPerPixel,
+                 const uint8_t* background, const uint8_t* compareMask) {
+    Pattern pattern = makePattern(bytesPerPixel, background, compareMask);
+    long pos = lastDifferentByte(row, static_cast<size_t>(beginX) * bytesPerPixel,
+                                 static_cast<size_t>(endX) * bytesPerPixel, pattern);
+    return pos < 0 ? -1 : static_cast<int>(pos / bytesPerPixel);
+}
+
+bool find(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+          const uint8_t* background, const uint8_t* compareMask, wxRect& bounds) {
+    if (!pixels || width <= 0 || height <= 0 || bytesPerPixel < 1 || bytesPerPixel > 4) {
+        return false;
+    }
+    Pattern pattern = makePattern(bytesPerPixel, background, compareMask);
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+
+    // Top and bottom: whole rows, stop at the first row with content
+    int minY = 0;
+    while (minY < height && firstDifferentByte(pixels + minY * stride, 0, rowBytes, pattern) < 0) {
+        minY++;
+    }
+    if (minY == height) {
+        return false;
+    }
+    int maxY = height - 1;
+    while (maxY > minY && firstDifferentByte(pixels + maxY * stride, 0, rowBytes, pattern) < 0) {
+        maxY--;
+    }
+
+    // Left and right: each row only needs to look outside the bounds found so far
+    int minX = width;
+    int maxX = -1;
+    for (int y = minY; y <= maxY && (minX > 0 || maxX < width - 1); y++) {
+        const uint8_t* row = pixels + y * stride;
+        if (minX > 0) {
+            long pos = firstDifferentByte(row, 0, static_cast<size_t>(minX) * bytesPerPixel, pattern);
+            if (pos >= 0) {
+                minX = static_cast<int>(pos / bytesPerPixel);
+            }
+        }
+        if (maxX < width - 1) {
+            long pos = lastDifferentByte(row, static_cast<size_t>(maxX + 1) * bytesPerPixel, rowBytes, pattern);
+            if (pos >= 0) {
+                maxX = static_cast<int>(pos / bytesPerPixel);
+            }
+        }
+    }
+
+    bounds = wxRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+    return true;
+}
+
+bool isUniform(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+               const uint8_t* compareMask) {
+    if (!pixels || width <= 0 || height <= 0) {
+        return true;
+    }
+    uint8_t first[4] = {0, 0, 0, 0};
+    std::memcpy(first, pixels, bytesPerPixel);
+    wxRect bounds;
+    return !find(pixels, width, height, stride, bytesPerPixel, first, compareMask, bounds);
+}
+
+std::vector<int> findUniformRows(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+                                 const uint8_t* background, const uint8_t* compareMask) {
+    std::vector<int> rows;
+    Pattern pattern = makePattern(bytesPerPixel, background, compareMask);
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+    for (int y = 0; y < height; y++) {
+        if (firstDifferentByte(pixels + y * stride, 0, rowBytes, pattern) < 0) {
+            rows.push_back(y);
+        }
+    }
+    return rows;
+}
+
+std::vector<int> findUniformColumns(const uint8_t* pixels, int width, int height, size_t stride, int bytesPerPixel,
+                                    const uint8_t* background, const uint8_t* compareMask) {
+    // Walk the image row by row (cache friendly) and drop candidates as soon as they differ
+    std::vector<int> columns(width);
+    for (int x = 0; x < width; x++) {
+        columns[x] = x;
+    }
+    Pattern pattern = makePattern(bytesPerPixel, background, compareMask);
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+    for (int y = 0; y < height && !columns.empty(); y++) {
+        const uint8_t* row = pixels + y * stride;
+        if (firstDifferentByte(row, 0, rowBytes, pattern) < 0) {
+            continue;
+        }
+        auto differs = [&](int x) {
+            size_t pos = static_cast<size_t>(x) * bytesPerPixel;
+            return firstDifferentByte(row, pos, pos + bytesPerPixel, pattern) >= 0;
+        };
+        columns.erase(std::remove_if(columns.begin(), columns.end(), differs), columns.end());
+    }
+    return columns;
+}
+
+}
@@ -222,6 +222,7 @@ std::vector<uint8_t> DataParser::ReadPackfile(const std::string& inputFilename,
 }
 
 std::pair<bool, bool> DataParser::LoadPackfile(const std::string& inputFilename, std::vector<std::shared_ptr<DataObject>> &objects, const std::string& password) {
+    PROFILE_SCOPE("LoadPackfile");
     // Check if file exists and get magic number
     std::ifstream inputFile(inputFilename, std::ios::binary);
     if (!inputFile) {
@@ -253,13 +254,18 @@ std::pair<bool, bool> DataParser::LoadPackfile(const std::string& inputFilename,
     bool isCompressed = (magic == F_PACK_MAGIC);
 
     // Read the packfile
-    auto buffer = ReadPackfile(inputFilename, password);
+    std::vector<uint8_t> buffer;
+    {
+        PROFILE_SCOPE("LoadPackfile read");
+        buffer = ReadPackfile(inputFilename, password);
+    }
     if (buffer.empty()) {
         logError("Failed to read packfile: " + inputFilename);
         return {false, isCompressed};
     }
 
     // Parse the objects
+    PROFILE_SCOPE("LoadPackfile parse");
     if (!ParseDataObjects(buffer, objects)) {
         logError("Failed to parse objects from packfile: " + inputFilename);
         return {false, isCompressed};
@@ -296,6 +302,7 @@ bool DataParser::WritePackfile(const std::string& outputFilename, const std::vec
         // Compress the data if requested
         std::vector<uint8_t> dataToWrite;
         if (useCompression) {
+            PROFILE_SCOPE("WritePackfile compress");
             // The DecompressData function expects the compressed data directly after the magic number
             dataToWrite = LZSS::Compress(objectsBuffer);
         } else {
@@ -327,6 +334,7 @@ bool DataParser::WritePackfile(const std::string& outputFilename, const std::vec
 }
 
 bool DataParser::SavePackfile(const std::string& outputFilename, const std::vector<std::shared_ptr<DataObject>>& objects, bool createBackup, bool useCompression, const std::string& password) {
+    PROFILE_SCOPE("SavePackfile");
     // Create backup if requested
     if (createBackup && std::filesystem::exists(outputFilename)) {
         std::string backupPath = outputFilename + ".bak";
@@ -347,8 +355,11 @@ bool DataParser::SavePackfile(const std::string& outputFilename, const std::vect
     // Get the serialized data objects and write DAT magic number
     std::vector<uint8_t> buffer;
     writeBigEndian32(buffer, DAT_MAGIC);
-    auto serializedObjects = SerializeDataObjects(objects);
-    buffer.insert(buffer.end(), serializedObjects.begin(), serializedObjects.end());
+    {
+        PROFILE_SCOPE("SavePackfile serialize");
+        auto serializedObjects = SerializeDataObjects(objects);
+        buffer.insert(buffer.end(), serializedObjects.begin(), serializedObjects.end());
+    }
 
     // Write packfile with or without compression and password
     return WritePackfile(outputFilename, buffer, useCompression, password);
@@ -425,7 +436,8 @@ std::vector<uint8_t> DataParser::SerializeDataObjects(const std::vector<std::sha
     return buffer;
 }
 
-bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate, std::vector<uint8_t>* currentPalette, bool useDithering) {
+bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate, std::vector<uint8_t>* currentPalette, bool useDithering,
+                                    DataVariant* previousData) {
     // Check if object has ORIG property
     auto origIt = properties.find('ORIG');
     if (origIt == properties.end()) {
@@ -469,7 +481,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // update the bitmap data
-        std::get<BitmapData>(data) = bitmap;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(bitmap);
     }
     else if (isAudio()) {
         AudioData audiodata;
@@ -485,7 +500,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // update the audio data
-        std::get<AudioData>(data) = audiodata;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(audiodata);
     }
     else if (isVideo()) {
         VideoData videoData;
@@ -501,7 +519,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // update the video data
-        std::get<VideoData>(data) = videoData;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(videoData);
     }
     else if (isFont()) {
         FontData fontData = std::get<FontData>(data);
@@ -516,7 +537,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // update the font data
-        std::get<FontData>(data) = fontData;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(fontData);
     }
     else if (isNested()) {
         // Read the original file
@@ -544,7 +568,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // set the nested objects to the fileObjects
-        data = fileObjects;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(fileObjects);
     }
     else if (isRawData()) {
         // Read the original file
@@ -559,7 +586,10 @@ bool DataParser::DataObject::update(std::string &ErrorMessage, bool ForceUpdate,
             }
         }
         // Update the raw data
-        data = fileData;
+        if (previousData) {
+            *previousData = std::move(data);
+        }
+        data = std::move(fileData);
     }
     else {
         ErrorMessage = name + ": " + origPath + " is not a valid data object - skipping";
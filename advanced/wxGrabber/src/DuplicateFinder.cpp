@@ -0,0 +1,255 @@
+#include "../include/DuplicateFinder.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    struct ImageInfo {
+        uint64_t pixelHash = 0;
+        uint64_t perceptualHash = 0;
+        int meanLuma = 0;
+    };
+
+    int luma(int r, int g, int b) {
+        return (r * 299 + g * 587 + b * 114) / 1000;
+    }
+
+    // Luminance of pixel i; fully transparent RGBA pixels count as black whatever their color
+    int pixelLuma(const BitmapData& bitmap, size_t i, const std::vector<uint8_t>& palette) {
+        const uint8_t* data = bitmap.data.data();
+        switch (bitmap.bits) {
+            case 8: {
+                size_t entry = static_cast<size_t>(data[i]) * 3;
+                return entry + 2 < palette.size() ? luma(palette[entry], palette[entry + 1], palette[entry + 2]) : 0;
+            }
+            case 15: {  // RRRRRGGGGG1BBBBB
+                int pixel = data[i * 2] | (data[i * 2 + 1] << 8);
+                return luma(((pixel >> 11) & 0x1F) << 3, ((pixel >> 6) & 0x1F) << 3, (pixel & 0x1F) << 3);
+            }
+            case 16: {
+                int pixel = data[i * 2] | (data[i * 2 + 1] << 8);
+                return luma(((pixel >> 11) & 0x1F) << 3, ((pixel >> 5) & 0x3F) << 2, (pixel & 0x1F) << 3);
+            }
+            case 24:
+            case 32:
+                return luma(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+            case -32:
+                return data[i * 4 + 3] ? luma(data[i * 4], data[i * 4 + 1], data[i * 4 + 2]) : 0;
+            default:
+                return 0;
+        }
+    }
+
+    size_t findRoot(std::vector<size_t>& parent, size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Aspect ratios within 10% of each other
+    bool comparableShapes(const BitmapData& a, const BitmapData& b) {
+        double ratioA = static_cast<double>(a.width) / a.height;
+        double ratioB = static_cast<double>(b.width) / b.height;
+        return std::max(ratioA, ratioB) <= std::min(ratioA, ratioB) * 1.1;
+    }
+}
+
+uint64_t DuplicateFinder::pixelHash(const BitmapData& bitmap) {
+    int32_t header[3] = {bitmap.bits, bitmap.width, bitmap.height};
+    uint64_t hash = BitmapData::hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+    return BitmapData::hashBytes(bitmap.data.data(), bitmap.data.size(), hash);
+}
+
+uint64_t DuplicateFinder::perceptualHash(const BitmapData& bitmap, const std::vector<uint8_t>& palette, int* meanLuma) {
+    const int cellsX = 9;
+    const int cellsY = 8;
+    int width = bitmap.width;
+    int height = bitmap.height;
+    if (width <= 0 || height <= 0 || bitmap.getBytesPerPixel() == 0 ||
+        bitmap.data.size() < static_cast<size_t>(width) * height * bitmap.getBytesPerPixel()) {
+        return 0;
+    }
+
+    // Box average into 9x8 cells; images smaller than that repeat pixels across cells
+    int cells[cellsY][cellsX];
+    int64_t total = 0;
+    for (int cy = 0; cy < cellsY; cy++) {
+        int y0 = cy * height / cellsY;
+        int y1 = std::max(y0 + 1, (cy + 1) * height / cellsY);
+        for (int cx = 0; cx < cellsX; cx++) {
+            int x0 = cx * width / cellsX;
+            int x1 = std::max(x0 + 1, (cx + 1) * width / cellsX);
+            int64_t sum = 0;
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    sum += pixelLuma(bitmap, static_cast<size_t>(y) * width + x, palette);
+                }
+            }
+            cells[cy][cx] = static_cast<int>(sum / ((y1 - y0) * (x1 - x0)));
+            total += cells[cy][cx];
+        }
+    }
+    if (meanLuma) {
+        *meanLuma = static_cast<int>(total / (cellsX * cellsY));
+    }
+
+    // One bit per horizontal neighbour pair: is the right cell brighter
+    uint64_t hash = 0;
+    for (int cy = 0; cy < cellsY; cy++) {
+        for (int cx = 0; cx < cellsX - 1; cx++) {
+            hash = (hash << 1) | (cells[cy][cx] < cells[cy][cx + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+int DuplicateFinder::hammingDistance(uint64_t a, uint64_t b) {
+    uint64_t x = a ^ b;
+    int count = 0;
+    while (x) {
+        x &= x - 1;
+        count++;
+    }
+    return count;
+}
+
+std::vector<DuplicateFinder::Group> DuplicateFinder::find(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
+                                                          const std::vector<uint8_t>& palette, const Options& options) {
+    PROFILE_SCOPE("DuplicateFinder::find");
+    std::vector<std::shared_ptr<DataParser::DataObject>> images;
+    for (const auto& obj : objects) {
+        if (obj && obj->isBitmap() && !obj->getBitmap().isPalette() && !obj->getBitmap().data.empty()) {
+            images.push_back(obj);
+        }
+    }
+    std::vector<Group> groups;
+    if (images.size() < 2) {
+        return groups;
+    }
+
+    // Hash every image in parallel, the objects are only read
+    std::vector<ImageInfo> infos(images.size());
+    unsigned threadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, images.size()));
+    std::atomic<size_t> nextImage{0};
+    auto worker = [&]() {
+        for (size_t i = nextImage++; i < images.size(); i = nextImage++) {
+            const BitmapData& bitmap = images[i]->getBitmap();
+            infos[i].pixelHash = pixelHash(bitmap);
+            if (options.nearMatches) {
+                infos[i].perceptualHash = perceptualHash(bitmap, palette, &infos[i].meanLuma);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    std::vector<size_t> parent(images.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto unite = [&](size_t a, size_t b) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);  // The earliest object stays the root
+        }
+    };
+
+    // Exact matches: equal pixel hashes, confirmed byte by byte
+    std::unordered_map<uint64_t, std::vector<size_t>> exactBuckets;
+    for (size_t i = 0; i < images.size(); i++) {
+        exactBuckets[infos[i].pixelHash].push_back(i);
+    }
+    std::vector<size_t> representatives;
+    for (size_t i = 0; i < images.size(); i++) {
+        const std::vector<size_t>& bucket = exactBuckets[infos[i].pixelHash];
+        bool matched = false;
+        for (size_t j : bucket) {
+            if (j >= i) {
+                break;
+            }
+            if (images[j]->getBitmap() == images[i]->getBitmap()) {
+                unite(j, i);
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) {
+            representatives.push_back(i);
+        }
+    }
+
+    if (options.nearMatches) {
+        // Hashes within distance d agree completely on at least one of d + 1 bands
+        int maxDistance = std::max(0, std::min(options.maxDistance, 7));
+        int bandCount = maxDistance + 1;
+        std::unordered_map<uint64_t, std::vector<size_t>> bandBuckets;
+        for (size_t i : representatives) {
+            for (int band = 0; band < bandCount; band++) {
+                int begin = band * 64 / bandCount;
+                int end = (band + 1) * 64 / bandCount;
+                uint64_t mask = (end - begin == 64) ? ~0ull : ((1ull << (end - begin)) - 1);
+                uint64_t key = ((infos[i].perceptualHash >> begin) & mask) | (static_cast<uint64_t>(band) << 56);
+                bandBuckets[key].push_back(i);
+            }
+        }
+        for (auto& bucket : bandBuckets) {
+            // Flat images all land in the same bands, sorting by brightness keeps those buckets cheap
+            std::vector<size_t>& members = bucket.second;
+            std::sort(members.begin(), members.end(), [&](size_t a, size_t b) {
+                return infos[a].meanLuma < infos[b].meanLuma;
+            });
+            for (size_t a = 0; a < members.size(); a++) {
+                for (size_t b = a + 1; b < members.size(); b++) {
+                    size_t i = members[a];
+                    size_t j = members[b];
+                    if (infos[j].meanLuma - infos[i].meanLuma > 8) {
+                        break;
+                    }
+                    if (findRoot(parent, i) == findRoot(parent, j) ||
+                        hammingDistance(infos[i].perceptualHash, infos[j].perceptualHash) > maxDistance ||
+                        !comparableShapes(images[i]->getBitmap(), images[j]->getBitmap())) {
+                        continue;
+                    }
+                    unite(i, j);
+                }
+            }
+        }
+    }
+
+    // Collect the sets with more than one member, in datafile order
+    std::unordered_map<size_t, size_t> groupOfRoot;
+    for (size_t i = 0; i < images.size(); i++) {
+        size_t root = findRoot(parent, i);
+        if (root == i) {
+            continue;
+        }
+        auto it = groupOfRoot.find(root);
+        if (it == groupOfRoot.end()) {
+            it = groupOfRoot.emplace(root, groups.size()).first;
+            groups.emplace_back();
+            groups.back().objects.push_back(images[root]);
+        }
+        Group& group = groups[it->second];
+        group.objects.push_back(images[i]);
+        if (group.exact && (infos[i].pixelHash != infos[root].pixelHash || !(images[i]->getBitmap() == images[root]->getBitmap()))) {
+            group.exact = false;
+        }
+        group.maxDistance = std::max(group.maxDistance, hammingDistance(infos[i].perceptualHash, infos[root].perceptualHash));
+    }
+    std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+        return a.objects.size() > b.objects.size();
+    });
+
+    LOG_INFO("Duplicate search: %zu images, %zu groups", images.size(), groups.size());
+    return groups;
+}
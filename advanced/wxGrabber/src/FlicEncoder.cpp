@@ -0,0 +1,677 @@
+#include "../include/FlicEncoder.h"
+#include "../include/log.h"
+#include "../include/ParallelFor.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+constexpr uint16_t FLI_COLOR_256_CHUNK = 4;
+constexpr uint16_t FLI_DELTA_CHUNK     = 7;
+constexpr uint16_t FLI_COLOR_64_CHUNK  = 11;
+constexpr uint16_t FLI_LC_CHUNK        = 12;
+constexpr uint16_t FLI_BRUN_CHUNK      = 15;
+constexpr uint16_t FLI_COPY_CHUNK      = 16;
+constexpr size_t FrameHeaderSize = 16;
+constexpr size_t FileHeaderSize = 128;
+constexpr int HistogramBits = 6;        // Per channel, VGA palette precision
+constexpr size_t HistogramSize = size_t(1) << (HistogramBits * 3);
+
+void put16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+void patch16(std::vector<uint8_t>& out, size_t pos, uint32_t value) {
+    out[pos] = static_cast<uint8_t>(value);
+    out[pos + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void patch32(std::vector<uint8_t>& out, size_t pos, uint32_t value) {
+    patch16(out, pos, value & 0xFFFF);
+    patch16(out, pos + 2, value >> 16);
+}
+
+// Split units [begin, end) into runs of three or more equal units and literal stretches
+// between them, calling emit(isRun, start, length) with pieces no longer than the limits
+template <typename Equal, typename Emit>
+void splitRuns(int begin, int end, int maxRun, int maxLiteral, Equal equal, Emit emit) {
+    auto flushLiteral = [&](int from, int to) {
+        for (; from < to; from += maxLiteral) {
+            emit(false, from, std::min(maxLiteral, to - from));
+        }
+    };
+    int literalStart = begin;
+    int x = begin;
+    while (x < end) {
+        int run = 1;
+        while (x + run < end && run < maxRun && equal(x, x + run)) {
+            run++;
+        }
+        if (run >= 3) {
+            flushLiteral(literalStart, x);
+            emit(true, x, run);
+            literalStart = x + run;
+        }
+        x += run;
+    }
+    flushLiteral(literalStart, end);
+}
+
+// End of the changed stretch starting at x. Gaps of up to two unchanged units are cheaper
+// to send again than to skip with a new packet.
+template <typename Changed>
+int changedStretchEnd(int x, int end, Changed changed) {
+    while (x < end) {
+        if (changed(x)) {
+            x++;
+            continue;
+        }
+        int gap = x;
+        while (gap < end && gap - x < 3 && !changed(gap)) {
+            gap++;
+        }
+        if (gap < end && gap - x < 3) {
+            x = gap;
+        } else {
+            break;
+        }
+    }
+    return x;
+}
+
+int channelOf(uint32_t key, int channel) {
+    return (key >> (HistogramBits * (2 - channel))) & ((1 << HistogramBits) - 1);
+}
+
+struct ColorBox {
+    size_t begin = 0;
+    size_t end = 0;
+    int channel = 0;    // Widest channel and its range, the box splits along it
+    int range = 0;
+};
+
+ColorBox makeBox(const std::vector<uint32_t>& keys, size_t begin, size_t end) {
+    ColorBox box{begin, end, 0, 0};
+    int low[3] = {255, 255, 255};
+    int high[3] = {0, 0, 0};
+    for (size_t k = begin; k < end; k++) {
+        for (int channel = 0; channel < 3; channel++) {
+            int value = channelOf(keys[k], channel);
+            low[channel] = std::min(low[channel], value);
+            high[channel] = std::max(high[channel], value);
+        }
+    }
+    for (int channel = 0; channel < 3; channel++) {
+        if (high[channel] - low[channel] > box.range) {
+            box.range = high[channel] - low[channel];
+            box.channel = channel;
+        }
+    }
+    return box;
+}
+
+uint8_t expandChannel(int value) {
+    return static_cast<uint8_t>(value * 255 / ((1 << HistogramBits) - 1));
+}
+
+// Median cut over the populated histogram cells, weighted by how many pixels fall in each
+std::vector<uint8_t> medianCut(const std::vector<uint32_t>& histogram, std::vector<uint32_t>& keys) {
+    keys.clear();
+    for (uint32_t key = 0; key < HistogramSize; key++) {
+        if (histogram[key]) {
+            keys.push_back(key);
+        }
+    }
+    std::vector<ColorBox> boxes{makeBox(keys, 0, keys.size())};
+    while (boxes.size() < 256) {
+        // Split the box with the widest channel range
+        size_t bestBox = 0;
+        for (size_t i = 1; i < boxes.size(); i++) {
+            if (boxes[i].range > boxes[bestBox].range) {
+                bestBox = i;
+            }
+        }
+        ColorBox box = boxes[bestBox];
+        if (box.range == 0) {
+            break;
+        }
+        std::sort(keys.begin() + box.begin, keys.begin() + box.end, [&](uint32_t a, uint32_t b) {
+            return channelOf(a, box.channel) < channelOf(b, box.channel);
+        });
+        uint64_t total = 0;
+        for (size_t k = box.begin; k < box.end; k++) {
+            total += histogram[keys[k]];
+        }
+        // Weighted median, both halves keep at least one cell
+        uint64_t seen = 0;
+        size_t split = box.begin + 1;
+        for (size_t k = box.begin; k < box.end - 1; k++) {
+            seen += histogram[keys[k]];
+            split = k + 1;
+            if (seen * 2 >= total) {
+                break;
+            }
+        }
+        boxes[bestBox] = makeBox(keys, box.begin, split);
+        boxes.push_back(makeBox(keys, split, box.end));
+    }
+
+    std::vector<uint8_t> palette(256 * 3, 0);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        uint64_t sum[3] = {0, 0, 0};
+        uint64_t count = 0;
+        for (size_t k = boxes[i].begin; k < boxes[i].end; k++) {
+            for (int channel = 0; channel < 3; channel++) {
+                sum[channel] += static_cast<uint64_t>(expandChannel(channelOf(keys[k], channel))) * histogram[keys[k]];
+            }
+            count += histogram[keys[k]];
+        }
+        for (int channel = 0; channel < 3; channel++) {
+            palette[i * 3 + channel] = static_cast<uint8_t>((sum[channel] + count / 2) / std::max<uint64_t>(count, 1));
+        }
+    }
+    palette.resize(boxes.size() * 3);
+    return palette;
+}
+
+int nearestColor(const uint8_t* rgb, const std::vector<uint8_t>& palette) {
+    int best = 0;
+    int bestDistance = INT32_MAX;
+    for (size_t i = 0; i < palette.size() / 3; i++) {
+        int dr = rgb[0] - palette[i * 3];
+        int dg = rgb[1] - palette[i * 3 + 1];
+        int db = rgb[2] - palette[i * 3 + 2];
+        int distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+uint32_t histogramKey(const uint8_t* rgb) {
+    constexpr int shift = 8 - HistogramBits;
+    return ((rgb[0] >> shift) << (HistogramBits * 2)) | ((rgb[1] >> shift) << HistogramBits) | (rgb[2] >> shift);
+}
+
+// The colormap as the decoder rebuilds it from the color chunk
+std::vector<uint8_t> storedPalette(const std::vector<uint8_t>& palette, FlicEncoder::Format format) {
+    std::vector<uint8_t> stored(palette);
+    stored.resize(256 * 3, 0);
+    if (format == FlicEncoder::Format::FLI) {
+        for (uint8_t& value : stored) {
+            value = static_cast<uint8_t>(255 * (value >> 2) / 63);
+        }
+    }
+    return stored;
+}
+
+void appendChunk(std::vector<uint8_t>& frame, uint16_t type, const std::vector<uint8_t>& body) {
+    size_t size = 6 + body.size() + (body.size() & 1);
+    put32(frame, static_cast<uint32_t>(size));
+    put16(frame, type);
+    frame.insert(frame.end(), body.begin(), body.end());
+    if (body.size() & 1) {
+        frame.push_back(0);
+    }
+}
+}
+
+void FlicEncoder::encodeBrun(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * width;
+        size_t countPos = out.size();
+        out.push_back(0);
+        int packets = 0;
+        // Positive counts repeat the next byte, negative counts copy bytes
+        splitRuns(0, width, 127, 128,
+                  [&](int a, int b) { return row[a] == row[b]; },
+                  [&](bool run, int start, int length) {
+                      packets++;
+                      if (run) {
+                          out.push_back(static_cast<uint8_t>(length));
+                          out.push_back(row[start]);
+                      } else {
+                          out.push_back(static_cast<uint8_t>(-length));
+                          out.insert(out.end(), row + start, row + start + length);
+                      }
+                  });
+        // Decoders fill the line instead of trusting the count, which cannot describe wide lines
+        out[countPos] = static_cast<uint8_t>(std::min(packets, 255));
+    }
+}
+
+bool FlicEncoder::encodeDeltaFli(const uint8_t* pixels, const uint8_t* previous, int width, int height, std::vector<uint8_t>& out) {
+    size_t rowBytes = static_cast<size_t>(width);
+    int first = 0;
+    while (first < height && std::memcmp(pixels + first * rowBytes, previous + first * rowBytes, rowBytes) == 0) {
+        first++;
+    }
+    int last = height - 1;
+    while (last > first && std::memcmp(pixels + last * rowBytes, previous + last * rowBytes, rowBytes) == 0) {
+        last--;
+    }
+    if (first >= height || first > 0xFFFF || last - first + 1 > 0xFFFF) {
+        return false;
+    }
+    put16(out, first);
+    put16(out, last - first + 1);
+    for (int y = first; y <= last; y++) {
+        const uint8_t* row = pixels + y * rowBytes;
+        const uint8_t* before = previous + y * rowBytes;
+        auto changed = [&](int x) { return row[x] != before[x]; };
+        size_t countPos = out.size();
+        out.push_back(0);
+        int packets = 0;
+        int written = 0;    // Where the decoder stands after the packets so far
+        int x = 0;
+        while (true) {
+            while (x < width && !changed(x)) {
+                x++;
+            }
+            if (x >= width) {
+                break;
+            }
+            int skip = x - written;
+            while (skip > 255) {
+                out.push_back(255);
+                out.push_back(0);
+                packets++;
+                skip -= 255;
+            }
+            int end = changedStretchEnd(x, width, changed);
+            // Positive counts copy bytes, negative counts repeat the next byte
+            splitRuns(x, end, 128, 127,
+                      [&](int a, int b) { return row[a] == row[b]; },
+                      [&](bool run, int start, int length) {
+                          out.push_back(static_cast<uint8_t>(skip));
+                          skip = 0;
+                          packets++;
+                          if (run) {
+                              out.push_back(static_cast<uint8_t>(-length));
+                              out.push_back(row[start]);
+                          } else {
+                              out.push_back(static_cast<uint8_t>(length));
+                              out.insert(out.end(), row + start, row + start + length);
+                          }
+                      });
+            written = end;
+            x = end;
+        }
+        if (packets > 255) {
+            return false;
+        }
+        out[countPos] = static_cast<uint8_t>(packets);
+    }
+    return true;
+}
+
+bool FlicEncoder::encodeDeltaFlc(const uint8_t* pixels, const uint8_t* previous, int width, int height, std::vector<uint8_t>& out) {
+    size_t rowBytes = static_cast<size_t>(width);
+    int words = width / 2;
+    bool odd = width & 1;
+    size_t linesPos = out.size();
+    put16(out, 0);
+    int lines = 0;
+    int skippedLines = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + y * rowBytes;
+        const uint8_t* before = previous + y * rowBytes;
+        if (std::memcmp(row, before, rowBytes) == 0) {
+            skippedLines++;
+            continue;
+        }
+        // Skip opcodes hold at most 0x4000 lines each
+        while (skippedLines > 0) {
+            int skip = std::min(skippedLines, 0x4000);
+            put16(out, 0x10000 - skip);
+            skippedLines -= skip;
+        }
+        if (odd && row[width - 1] != before[width - 1]) {
+            put16(out, 0x8000 | row[width - 1]);
+        }
+
+        auto changed = [&](int w) { return row[w * 2] != before[w * 2] || row[w * 2 + 1] != before[w * 2 + 1]; };
+        size_t countPos = out.size();
+        put16(out, 0);
+        int packets = 0;
+        int written = 0;    // In words
+        int w = 0;
+        while (true) {
+            while (w < words && !changed(w)) {
+                w++;
+            }
+            if (w >= words) {
+                break;
+            }
+            // The skip byte counts pixels, whole words keep packets aligned
+            int skip = w - written;
+            while (skip > 127) {
+                out.push_back(254);
+                out.push_back(0);
+                packets++;
+                skip -= 127;
+            }
+            int end = changedStretchEnd(w, words, changed);
+            // Positive counts copy words, negative counts repeat the next word
+            splitRuns(w, end, 128, 127,
+                      [&](int a, int b) { return row[a * 2] == row[b * 2] && row[a * 2 + 1] == row[b * 2 + 1]; },
+                      [&](bool run, int start, int length) {
+                          out.push_back(static_cast<uint8_t>(skip * 2));
+                          skip = 0;
+                          packets++;
+                          if (run) {
+                              out.push_back(static_cast<uint8_t>(-length));
+                              out.push_back(row[start * 2]);
+                              out.push_back(row[start * 2 + 1]);
+                          } else {
+                              out.push_back(static_cast<uint8_t>(length));
+                              out.insert(out.end(), row + start * 2, row + (start + length) * 2);
+                          }
+                      });
+            written = end;
+            w = end;
+        }
+        if (packets >= 0x4000) {
+            return false;
+        }
+        patch16(out, countPos, packets);
+        lines++;
+    }
+    if (lines == 0 || lines > 0xFFFF) {
+        return false;
+    }
+    patch16(out, linesPos, lines);
+    return true;
+}
+
+bool FlicEncoder::encode(const std::vector<Input>& inputs, const Params& params, Result& result) {
+    PROFILE_SCOPE("FlicEncoder::encode");
+    result = Result();
+    if (inputs.empty()) {
+        logError("FLIC encoder: no frames");
+        return false;
+    }
+    if (inputs.size() > 0xFFFF) {
+        logError("FLIC encoder: too many frames (" + std::to_string(inputs.size()) + ")");
+        return false;
+    }
+
+    // Image files are read here, wxImage loading is kept off the workers
+    size_t frameCount = inputs.size();
+    std::vector<wxImage> images(frameCount);
+    bool allIndexed = true;
+    for (size_t i = 0; i < frameCount; i++) {
+        if (inputs[i].bitmap) {
+            allIndexed = allIndexed && inputs[i].bitmap->bits == 8 && !inputs[i].bitmap->isPalette();
+            continue;
+        }
+        allIndexed = false;
+        if (!BitmapData::readFileToWxImage(wxString(inputs[i].filepath), images[i]) || !images[i].IsOk()) {
+            logError("FLIC encoder: cannot read " + inputs[i].filepath);
+            return false;
+        }
+    }
+    auto frameSize = [&](size_t i, int& w, int& h) {
+        if (inputs[i].bitmap) {
+            w = inputs[i].bitmap->width;
+            h = inputs[i].bitmap->height;
+        } else {
+            w = images[i].GetWidth();
+            h = images[i].GetHeight();
+        }
+    };
+    int width = 0, height = 0;
+    frameSize(0, width, height);
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF) {
+        logError("FLIC encoder: invalid frame size " + std::to_string(width) + "x" + std::to_string(height));
+        return false;
+    }
+    for (size_t i = 1; i < frameCount; i++) {
+        int w, h;
+        frameSize(i, w, h);
+        if (w != width || h != height) {
+            logError("FLIC encoder: frame " + std::to_string(i) + " is " + std::to_string(w) + "x" + std::to_string(h) +
+                     ", expected " + std::to_string(width) + "x" + std::to_string(height));
+            return false;
+        }
+    }
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> palette(params.palette.empty() ? BitmapData::allegro_palette : params.palette);
+    palette.resize(256 * 3, 0);
+    std::vector<std::vector<uint8_t>> indexed(frameCount);
+
+    if (allIndexed) {
+        // The bitmaps already share a palette, keep their indices
+        for (size_t i = 0; i < frameCount; i++) {
+            indexed[i] = inputs[i].bitmap->data;
+            indexed[i].resize(pixelCount, 0);
+        }
+        result.colors = 256;
+        result.exactColors = true;
+    } else {
+        std::vector<std::vector<uint8_t>> rgbFrames(frameCount);
+        std::vector<char> converted(frameCount, 0);
+        parallelFor(frameCount, params.threadCount, [&](size_t i) {
+            rgbFrames[i].resize(pixelCount * 3);
+            if (inputs[i].bitmap) {
+                converted[i] = inputs[i].bitmap->toRGB(rgbFrames[i].data(), palette);
+            } else {
+                std::memcpy(rgbFrames[i].data(), images[i].GetData(), pixelCount * 3);
+                converted[i] = 1;
+            }
+        });
+        images.clear();
+        for (size_t i = 0; i < frameCount; i++) {
+            if (!converted[i]) {
+                logError("FLIC encoder: cannot convert frame " + std::to_string(i) + " to RGB");
+                return false;
+            }
+        }
+
+        // Frames are split into one block per worker, each counting into its own set or histogram
+        unsigned workers = params.threadCount ? params.threadCount : std::max(1u, std::thread::hardware_concurrency());
+        size_t blocks = std::min<size_t>(workers, frameCount);
+
+        // Distinct colors, given up on once there are more than fit
+        std::vector<std::unordered_set<uint32_t>> blockColors(blocks);
+        parallelFor(blocks, params.threadCount, [&](size_t block) {
+            for (size_t i = block; i < frameCount && blockColors[block].size() <= 256; i += blocks) {
+                const uint8_t* p = rgbFrames[i].data();
+                for (size_t k = 0; k < pixelCount && blockColors[block].size() <= 256; k++, p += 3) {
+                    blockColors[block].insert((p[0] << 16) | (p[1] << 8) | p[2]);
+                }
+            }
+        });
+        std::unordered_set<uint32_t> colors;
+        for (const auto& blockSet : blockColors) {
+            colors.insert(blockSet.begin(), blockSet.end());
+            if (colors.size() > 256) {
+                break;
+            }
+        }
+        blockColors.clear();
+
+        if (colors.size() <= 256) {
+            std::vector<uint32_t> sorted(colors.begin(), colors.end());
+            std::sort(sorted.begin(), sorted.end());
+            std::unordered_map<uint32_t, uint8_t> lookup;
+            palette.assign(256 * 3, 0);
+            for (size_t i = 0; i < sorted.size(); i++) {
+                palette[i * 3] = static_cast<uint8_t>(sorted[i] >> 16);
+                palette[i * 3 + 1] = static_cast<uint8_t>(sorted[i] >> 8);
+                palette[i * 3 + 2] = static_cast<uint8_t>(sorted[i]);
+                lookup[sorted[i]] = static_cast<uint8_t>(i);
+            }
+            parallelFor(frameCount, params.threadCount, [&](size_t i) {
+                indexed[i].resize(pixelCount);
+                const uint8_t* p = rgbFrames[i].data();
+                for (size_t k = 0; k < pixelCount; k++, p += 3) {
+                    indexed[i][k] = lookup.find((p[0] << 16) | (p[1] << 8) | p[2])->second;
+                }
+            });
+            result.colors = static_cast<int>(sorted.size());
+            result.exactColors = true;
+        } else {
+            // Histogram per block, merged, then one palette for the whole animation
+            std::vector<std::vector<uint32_t>> histograms(blocks);
+            parallelFor(blocks, params.threadCount, [&](size_t block) {
+                histograms[block].assign(HistogramSize, 0);
+                for (size_t i = block; i < frameCount; i += blocks) {
+                    const uint8_t* p = rgbFrames[i].data();
+                    for (size_t k = 0; k < pixelCount; k++, p += 3) {
+                        histograms[block][histogramKey(p)]++;
+                    }
+                }
+            });
+            std::vector<uint32_t> histogram(HistogramSize, 0);
+            for (auto& blockHistogram : histograms) {
+                for (size_t key = 0; key < HistogramSize; key++) {
+                    histogram[key] += blockHistogram[key];
+                }
+                std::vector<uint32_t>().swap(blockHistogram);
+            }
+            std::vector<uint32_t> keys;
+            std::vector<uint8_t> cutPalette = medianCut(histogram, keys);
+            result.colors = static_cast<int>(cutPalette.size() / 3);
+
+            // Nearest palette entry of every histogram cell that occurs
+            std::vector<uint8_t> cellIndex(HistogramSize, 0);
+            parallelFor((keys.size() + 1023) / 1024, params.threadCount, [&](size_t block) {
+                size_t end = std::min(keys.size(), (block + 1) * 1024);
+                for (size_t k = block * 1024; k < end; k++) {
+                    uint8_t center[3];
+                    for (int channel = 0; channel < 3; channel++) {
+                        center[channel] = expandChannel(channelOf(keys[k], channel));
+                    }
+                    cellIndex[keys[k]] = static_cast<uint8_t>(nearestColor(center, cutPalette));
+                }
+            });
+            parallelFor(frameCount, params.threadCount, [&](size_t i) {
+                indexed[i].resize(pixelCount);
+                const uint8_t* p = rgbFrames[i].data();
+                for (size_t k = 0; k < pixelCount; k++, p += 3) {
+                    indexed[i][k] = cellIndex[histogramKey(p)];
+                }
+            });
+            palette = cutPalette;
+            palette.resize(256 * 3, 0);
+        }
+    }
+
+    // Frames only depend on the frame before, which is already known, so all encode at once
+    enum class Kind { Unchanged, Brun, Delta, Copy };
+    std::vector<std::vector<uint8_t>> frames(frameCount);
+    std::vector<Kind> kinds(frameCount, Kind::Unchanged);
+    bool fli = params.format == Format::FLI;
+    parallelFor(frameCount, params.threadCount, [&](size_t i) {
+        const uint8_t* pixels = indexed[i].data();
+        const uint8_t* previous = i > 0 ? indexed[i - 1].data() : nullptr;
+        std::vector<uint8_t>& frame = frames[i];
+        frame.resize(FrameHeaderSize, 0);
+        uint16_t chunks = 0;
+        if (i == 0) {
+            std::vector<uint8_t> colors;
+            put16(colors, 1);
+            colors.push_back(0);    // Skip no colors
+            colors.push_back(0);    // 256 colors
+            for (uint8_t value : palette) {
+                colors.push_back(fli ? static_cast<uint8_t>(value >> 2) : value);
+            }
+            appendChunk(frame, fli ? FLI_COLOR_64_CHUNK : FLI_COLOR_256_CHUNK, colors);
+            chunks++;
+        }
+        if (!previous || std::memcmp(pixels, previous, pixelCount) != 0) {
+            std::vector<uint8_t> best;
+            encodeBrun(pixels, width, height, best);
+            uint16_t bestType = FLI_BRUN_CHUNK;
+            kinds[i] = Kind::Brun;
+            if (previous) {
+                std::vector<uint8_t> delta;
+                bool encoded = fli ? encodeDeltaFli(pixels, previous, width, height, delta)
+                                   : encodeDeltaFlc(pixels, previous, width, height, delta);
+                if (encoded && delta.size() <= best.size()) {
+                    best.swap(delta);
+                    bestType = fli ? FLI_LC_CHUNK : FLI_DELTA_CHUNK;
+                    kinds[i] = Kind::Delta;
+                }
+            }
+            if (pixelCount < best.size()) {
+                best.assign(pixels, pixels + pixelCount);
+                bestType = FLI_COPY_CHUNK;
+                kinds[i] = Kind::Copy;
+            }
+            appendChunk(frame, bestType, best);
+            chunks++;
+        }
+        patch32(frame, 0, static_cast<uint32_t>(frame.size()));
+        patch16(frame, 4, VideoData::FLI_FRAME_MAGIC_NUMBER);
+        patch16(frame, 6, chunks);
+    });
+
+    size_t fileSize = FileHeaderSize;
+    for (size_t i = 0; i < frameCount; i++) {
+        fileSize += frames[i].size();
+        result.brunFrames += kinds[i] == Kind::Brun;
+        result.deltaFrames += kinds[i] == Kind::Delta;
+        result.copyFrames += kinds[i] == Kind::Copy;
+        result.unchangedFrames += kinds[i] == Kind::Unchanged;
+    }
+    if (fileSize > UINT32_MAX) {
+        logError("FLIC encoder: animation too large");
+        return false;
+    }
+    int speed = fli ? std::max(1, (params.frameDelayMs * 70 + 500) / 1000) : std::max(1, params.frameDelayMs);
+    std::vector<uint8_t> file;
+    file.reserve(fileSize);
+    put32(file, static_cast<uint32_t>(fileSize));
+    put16(file, fli ? VideoData::FLI_MAGIC_NUMBER : VideoData::FLC_MAGIC_NUMBER);
+    put16(file, static_cast<uint32_t>(frameCount));
+    put16(file, width);
+    put16(file, height);
+    put16(file, 8);                 // Color depth
+    put16(file, fli ? 0 : 3);       // FLC: header updated after writing
+    put32(file, speed);
+    file.resize(FileHeaderSize, 0);
+    if (!fli) {
+        patch16(file, 38, 1);       // Square pixels
+        patch16(file, 40, 1);
+        patch32(file, 80, static_cast<uint32_t>(FileHeaderSize));
+        patch32(file, 84, static_cast<uint32_t>(FileHeaderSize + frames[0].size()));
+    }
+    for (auto& frame : frames) {
+        file.insert(file.end(), frame.begin(), frame.end());
+        std::vector<uint8_t>().swap(frame);
+    }
+
+    if (!VideoData::parse(file, ObjectType::DAT_FLI, result.video)) {
+        return false;
+    }
+    // Decode everything again through the player's chunk readers
+    std::vector<VideoData::FrameEntry> index = result.video.buildFrameIndex();
+    if (index.size() != frameCount) {
+        logError("FLIC encoder: round trip found " + std::to_string(index.size()) + " of " + std::to_string(frameCount) + " frames");
+        return false;
+    }
+    std::vector<uint8_t> expectedColormap = storedPalette(palette, params.format);
+    FlicFrameBuffer decoded;
+    for (size_t i = 0; i < frameCount; i++) {
+        if (!result.video.decodeFrame(index[i], decoded) || decoded.getPixels() != indexed[i] ||
+            decoded.getColormap() != expectedColormap) {
+            logError("FLIC encoder: round trip differs at frame " + std::to_string(i));
+            return false;
+        }
+    }
+    LOG_INFO("FLIC encoder: %zu frames %dx%d, %d colors, %d BRUN, %d delta, %d copy, %d unchanged, %zu bytes",
+             frameCount, width, height, result.colors, result.brunFrames, result.deltaFrames, result.copyFrames,
+             result.unchangedFrames, fileSize);
+    return true;
+}
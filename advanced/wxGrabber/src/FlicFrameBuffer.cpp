@@ -0,0 +1,106 @@
+#include "../include/FlicFrameBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+void FlicFrameBuffer::resize(int newWidth, int newHeight) {
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    size_t count = static_cast<size_t>(width) * height;
+    pixels.assign(count, 0);
+    rgb.assign(count * 3, 0);
+    colormap.assign(256 * 3, 0);
+    dirtyRows.assign(height, 0);
+    dirtyCount = 0;
+    colormapChanged = true;
+}
+
+void FlicFrameBuffer::markRows(int first, int count) {
+    int last = std::min(first + count, height);
+    for (int y = std::max(first, 0); y < last; y++) {
+        if (!dirtyRows[y]) {
+            dirtyRows[y] = 1;
+            dirtyCount++;
+        }
+    }
+}
+
+void FlicFrameBuffer::setColor(int index, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t* entry = &colormap[index * 3];
+    if (entry[0] != r || entry[1] != g || entry[2] != b) {
+        entry[0] = r;
+        entry[1] = g;
+        entry[2] = b;
+        colormapChanged = true;
+    }
+}
+
+void FlicFrameBuffer::setColormap(const std::vector<uint8_t>& newColormap) {
+    if (newColormap.size() == colormap.size() && newColormap != colormap) {
+        colormap = newColormap;
+        colormapChanged = true;
+    }
+}
+
+void FlicFrameBuffer::restore(const std::vector<uint8_t>& newPixels, const std::vector<uint8_t>& newColormap) {
+    if (newPixels.size() == pixels.size()) {
+        pixels = newPixels;
+        markAll();
+    }
+    setColormap(newColormap);
+}
+
+void FlicFrameBuffer::expandRow(const uint8_t* indices, size_t count, const uint32_t* lut, uint8_t* out) {
+    // Each 32-bit store writes one pixel and a spare byte the next store overwrites,
+    // so groups stop while a pixel is left to cover the spare byte of the last one
+    size_t i = 0;
+    for (; i + 4 < count; i += 4) {
+        uint32_t p0 = lut[indices[i]];
+        uint32_t p1 = lut[indices[i + 1]];
+        uint32_t p2 = lut[indices[i + 2]];
+        uint32_t p3 = lut[indices[i + 3]];
+        std::memcpy(out, &p0, 4);
+        std::memcpy(out + 3, &p1, 4);
+        std::memcpy(out + 6, &p2, 4);
+        std::memcpy(out + 9, &p3, 4);
+        out += 12;
+    }
+    for (; i < count; i++) {
+        uint32_t p = lut[indices[i]];
+        out[0] = static_cast<uint8_t>(p);
+        out[1] = static_cast<uint8_t>(p >> 8);
+        out[2] = static_cast<uint8_t>(p >> 16);
+        out += 3;
+    }
+}
+
+int FlicFrameBuffer::expandDirty() {
+    if (colormapChanged) {
+        for (int i = 0; i < 256; i++) {
+            lut[i] = colormap[i * 3] | (colormap[i * 3 + 1] << 8) | (colormap[i * 3 + 2] << 16);
+        }
+        colormapChanged = false;
+        markAll();
+    }
+    if (dirtyCount == 0) {
+        return 0;
+    }
+    int expanded = dirtyCount;
+    for (int y = 0; y < height; y++) {
+        if (dirtyRows[y]) {
+            size_t offset = static_cast<size_t>(y) * width;
+            expandRow(pixels.data() + offset, width, lut.data(), rgb.data() + offset * 3);
+            dirtyRows[y] = 0;
+        }
+    }
+    dirtyCount = 0;
+    return expanded;
+}
+
+wxImage FlicFrameBuffer::toImage() const {
+    if (width == 0 || height == 0) {
+        return wxImage();
+    }
+    wxImage image(width, height, false);
+    std::memcpy(image.GetData(), rgb.data(), rgb.size());
+    return image;
+}
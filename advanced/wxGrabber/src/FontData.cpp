@@ -16,6 +16,8 @@
 #include <algorithm>
 #include "../include/log.h"
 #include "../include/BitmapData.h"
+#include "../include/ContentBounds.h"
+#include "../include/FontImporter.h"
 #include <map>
 
 static uint16_t read16(const std::vector<uint8_t>& buf, size_t& pos, bool littleEndian = false) {
@@ -95,7 +97,7 @@ bool FontData::parse(const std::vector<uint8_t>& dataBuffer, ObjectType typeID,
     size_t pos = 0;
     int16_t fsize = (int16_t)read16(dataBuffer, pos);
     outFont.fontSize = fsize;
-    logDebug(wxString::Format("FontData::parse: font size: %d", fsize));
+    LOG_DEBUG("FontData::parse: font size: %d", fsize);
     
     // Handle obsolete 8x8 and 8x16 formats
     if (fsize == 8 || fsize == 16) {
@@ -180,7 +182,7 @@ bool FontData::parse(const std::vector<uint8_t>& dataBuffer, ObjectType typeID,
         }
         
         uint16_t rangeCount = read16(dataBuffer, pos, true);
-        logDebug(wxString::Format("FontData::parse: found %d ranges", rangeCount));
+        LOG_DEBUG("FontData::parse: found %d ranges", rangeCount);
         
         int totalGlyphs = 0;
         for (uint16_t r = 0; r < rangeCount; ++r) {
@@ -194,7 +196,7 @@ bool FontData::parse(const std::vector<uint8_t>& dataBuffer, ObjectType typeID,
             range.start = read32(dataBuffer, pos, true);
             range.end = read32(dataBuffer, pos, true);
             int glyphsInRange = range.end - range.start + 1;
-            logDebug(wxString::Format("FontData::parse: range %d: %d glyphs, start %d, end %d, depth flag %d", r, glyphsInRange, range.start, range.end, range.mono));
+            LOG_DEBUG("FontData::parse: range %d: %d glyphs, start %u, end %u, depth flag %d", r, glyphsInRange, range.start, range.end, range.mono);
             
             for (int g = 0; g < glyphsInRange; ++g) {
                 if (pos + 4 > dataBuffer.size()) {
@@ -380,6 +382,7 @@ wxString FontData::getFontFormatString() const {
 }
 
 wxImage FontData::getPreviewImage() const {
+    PROFILE_SCOPE("FontData::getPreviewImage");
     // Parameters for preview
     const int glyphsPerRow = 31; // 31 columns as in screenshot
     const int margin = 2; // margin between glyphs
@@ -409,17 +412,17 @@ wxImage FontData::getPreviewImage() const {
     memset(img.GetAlpha(), 0, imgW * imgH); // fully transparent background
     logDebug("FontData::getPreviewImage: created transparent image");
     
-    // Render all glyphs
+    // Copy all glyphs from the range atlases
     int glyphIdx = 0;
     for (const auto& range : ranges) {
-        for (const auto& glyph : range.glyphs) {
+        std::shared_ptr<const GlyphAtlas> atlas = range.getAtlas();
+        for (size_t i = 0; i < range.glyphs.size(); ++i) {
             int gx = glyphIdx % glyphsPerRow;
             int gy = glyphIdx / glyphsPerRow;
             int x0 = margin + gx * (glyphW + margin);
             int y0 = margin + gy * (glyphH + margin);
             
-            // Use the helper method to render glyph pixels
-            range.renderGlyphPixels(glyph, img, x0, y0, fontSize);
+            atlas->blit(i, img, x0, y0);
             ++glyphIdx;
         }
     }
@@ -501,9 +504,10 @@ wxString FontData::getColorDepthString(int bitDepth) {
 }
 
 void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int offsetX, int offsetY, int fontSize) const {
-    unsigned char* rgb = img.GetData();
-    unsigned char* alpha = img.GetAlpha();
-    int imgWidth = img.GetWidth();
+    renderGlyphPixels(glyph, img.GetData(), img.GetAlpha(), img.GetWidth(), img.GetHeight(), offsetX, offsetY);
+}
+
+void FontData::Range::renderGlyphPixels(const Glyph& glyph, unsigned char* rgb, unsigned char* alpha, int imgWidth, int imgHeight, int offsetX, int offsetY) const {
     int bitDepth = getBitDepth();
     int bytesPerPixel = bitDepth / 8;
     
@@ -520,7 +524,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
                     if (b & (1 << (7 - (bit % 8)))) {
                         int px = offsetX + x;
                         int py = offsetY + y;
-                        if (px >= 0 && py >= 0 && px < img.GetWidth() && py < img.GetHeight()) {
+                        if (px >= 0 && py >= 0 && px < imgWidth && py < imgHeight) {
                             size_t pixelIdx = py * imgWidth + px;
                             rgb[pixelIdx * 3] = 0;     // R - black
                             rgb[pixelIdx * 3 + 1] = 0; // G - black
@@ -533,7 +537,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
         }
     } else if (bitDepth == 8) {
         // Grayscale or color with palette
-        std::vector<uint8_t> palette = BitmapData::allegro_palette;
+        const std::vector<uint8_t>& palette = BitmapData::allegro_palette;
         for (int y = 0; y < glyph.height; ++y) {
             for (int x = 0; x < glyph.width; ++x) {
                 size_t idx = y * glyph.width + x;
@@ -542,7 +546,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
                     if (v != TRANSPARENT_COLOR_INDEX) { // Not transparent
                         int px = offsetX + x;
                         int py = offsetY + y;
-                        if (px >= 0 && py >= 0 && px < img.GetWidth() && py < img.GetHeight()) {
+                        if (px >= 0 && py >= 0 && px < imgWidth && py < imgHeight) {
                             size_t pixelIdx = py * imgWidth + px;
                             rgb[pixelIdx * 3] = palette[v*3];     // R
                             rgb[pixelIdx * 3 + 1] = palette[v*3+1]; // G
@@ -566,7 +570,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
                     if (pixel != TRANSPARENT_COLOR_16) {
                         int px = offsetX + x;
                         int py = offsetY + y;
-                        if (px >= 0 && py >= 0 && px < img.GetWidth() && py < img.GetHeight()) {
+                        if (px >= 0 && py >= 0 && px < imgWidth && py < imgHeight) {
                             size_t pixelIdx = py * imgWidth + px;
                             
                             // Convert RGB565 to RGB888
@@ -598,7 +602,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
                     if (pixelColor != TRANSPARENT_COLOR) {
                         int px = offsetX + x;
                         int py = offsetY + y;
-                        if (px >= 0 && py >= 0 && px < img.GetWidth() && py < img.GetHeight()) {
+                        if (px >= 0 && py >= 0 && px < imgWidth && py < imgHeight) {
                             size_t pixelIdx = py * imgWidth + px;
                             rgb[pixelIdx * 3] = r;
                             rgb[pixelIdx * 3 + 1] = g;
@@ -624,7 +628,7 @@ void FontData::Range::renderGlyphPixels(const Glyph& glyph, wxImage& img, int of
                     if (a > 0) {
                         int px = offsetX + x;
                         int py = offsetY + y;
-                        if (px >= 0 && py >= 0 && px < img.GetWidth() && py < img.GetHeight()) {
+                        if (px >= 0 && py >= 0 && px < imgWidth && py < imgHeight) {
                             size_t pixelIdx = py * imgWidth + px;
                             rgb[pixelIdx * 3] = r;
                             rgb[pixelIdx * 3 + 1] = g;
@@ -670,6 +674,104 @@ wxImage FontData::Range::renderGlyph(uint32_t index) const
     return img;
 }
 
+uint64_t FontData::Range::contentHash(uint64_t seed) const {
+    uint32_t header[3] = {static_cast<uint32_t>(mono), start, end};
+    uint64_t hash = BitmapData::hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header), seed);
+    for (const auto& glyph : glyphs) {
+        hash = BitmapData::hashBytes(glyph.data.data(), glyph.data.size(), hash ^ glyph.width ^ (glyph.height << 16));
+    }
+    return hash;
+}
+
+std::shared_ptr<const FontData::GlyphAtlas> FontData::Range::getAtlas() const {
+    // Hashing the glyph data is far cheaper than decoding it again, and catches
+    // every edit made through the public glyph vectors
+    uint64_t hash = contentHash();
+    std::shared_ptr<const GlyphAtlas> cached = std::atomic_load(&atlas);
+    if (cached && cached->hash == hash) {
+        return cached;
+    }
+
+    PROFILE_SCOPE("FontData::Range::getAtlas");
+    auto built = std::make_shared<GlyphAtlas>();
+    built->hash = hash;
+    built->rects.resize(glyphs.size());
+
+    // Shelf packing, tallest glyphs first, into a sheet about as wide as it is tall
+    std::vector<size_t> order;
+    order.reserve(glyphs.size());
+    size_t area = 0;
+    int maxWidth = 0;
+    for (size_t i = 0; i < glyphs.size(); ++i) {
+        const Glyph& glyph = glyphs[i];
+        if (glyph.width == 0 || glyph.height == 0 || glyph.data.empty()) {
+            continue;
+        }
+        order.push_back(i);
+        area += static_cast<size_t>(glyph.width) * glyph.height;
+        maxWidth = std::max(maxWidth, static_cast<int>(glyph.width));
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return glyphs[a].height > glyphs[b].height;
+    });
+
+    int sheetWidth = std::max(maxWidth, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(area)))));
+    int x = 0, y = 0, shelfHeight = 0;
+    for (size_t index : order) {
+        const Glyph& glyph = glyphs[index];
+        if (x + glyph.width > sheetWidth) {
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        built->rects[index] = GlyphAtlas::Rect{x, y, glyph.width, glyph.height};
+        x += glyph.width;
+        shelfHeight = std::max(shelfHeight, static_cast<int>(glyph.height));
+    }
+    if (!order.empty()) {
+        built->width = sheetWidth;
+        built->height = y + shelfHeight;
+    }
+
+    built->rgb.assign(static_cast<size_t>(built->width) * built->height * 3, 0);
+    built->alpha.assign(static_cast<size_t>(built->width) * built->height, 0);
+    for (size_t index : order) {
+        const GlyphAtlas::Rect& rect = built->rects[index];
+        renderGlyphPixels(glyphs[index], built->rgb.data(), built->alpha.data(), built->width, built->height, rect.x, rect.y);
+    }
+
+    std::shared_ptr<const GlyphAtlas> result = built;
+    std::atomic_store(&atlas, result);
+    return result;
+}
+
+void FontData::GlyphAtlas::blit(size_t glyphIndex, wxImage& img, int x, int y) const {
+    if (glyphIndex >= rects.size() || !img.HasAlpha()) {
+        return;
+    }
+    const Rect& rect = rects[glyphIndex];
+    int imgWidth = img.GetWidth();
+
+    // Clip to the image
+    int left = std::max(0, -x);
+    int top = std::max(0, -y);
+    int right = std::min(rect.width, imgWidth - x);
+    int bottom = std::min(rect.height, img.GetHeight() - y);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+
+    unsigned char* dstRgb = img.GetData();
+    unsigned char* dstAlpha = img.GetAlpha();
+    size_t count = right - left;
+    for (int row = top; row < bottom; ++row) {
+        size_t src = static_cast<size_t>(rect.y + row) * width + rect.x + left;
+        size_t dst = static_cast<size_t>(y + row) * imgWidth + x + left;
+        memcpy(dstRgb + dst * 3, rgb.data() + src * 3, count * 3);
+        memcpy(dstAlpha + dst, alpha.data() + src, count);
+    }
+}
+
 // Import/Export functions moved from FontEditDialog
 
 FontData::Range FontData::ImportBitmapAsRange(const wxString& filename, uint32_t baseCharacter, int8_t colorFormat)
@@ -972,7 +1074,7 @@ FontData::Range FontData::CreateRangeFromGrxFnt(const std::vector<uint8_t>& buff
     range.end = endChar - 1;  // Our end is inclusive, C code's is exclusive
     
     int numChars = endChar - beginChar;
-    if (numChars <= 0 || numChars > 1000) {  // Sanity check
+    if (numChars <= 0) {  // Sanity check
         logError("Invalid character range in GRX font");
         return range;
     }
@@ -1082,20 +1184,12 @@ std::vector<FontData::Glyph> FontData::ExtractGlyphsFromBitmap(const wxImage& im
     std::vector<int> columnSeparators;
     std::vector<int> rowSeparators;
     
+    // Separator lines are whole rows/columns of the separator color, scan the raw RGB buffer for them
+    const uint8_t separatorRGB[3] = {separatorColor.Red(), separatorColor.Green(), separatorColor.Blue()};
+    const size_t imgStride = static_cast<size_t>(imgWidth) * 3;
+
     // Find vertical separators (columns)
-    for (int x = 0; x < imgWidth; ++x) {
-        bool isVerticalSeparator = true;
-        for (int y = 0; y < imgHeight; ++y) {
-            wxColour pixelColor(image.GetRed(x, y), image.GetGreen(x, y), image.GetBlue(x, y));
-            if (pixelColor != separatorColor) {
-                isVerticalSeparator = false;
-                break;
-            }
-        }
-        if (isVerticalSeparator) {
-            columnSeparators.push_back(x);
-        }
-    }
+    columnSeparators = ContentBounds::findUniformColumns(image.GetData(), imgWidth, imgHeight, imgStride, 3, separatorRGB);
     logInfo(wxString::Format("Found %d vertical separators", (int)columnSeparators.size()).ToStdString());
     if (!columnSeparators.empty()) {
         logDebug(wxString::Format("First few vertical separators: %d, %d, %d...", 
@@ -1109,19 +1203,7 @@ std::vector<FontData::Glyph> FontData::ExtractGlyphsFromBitmap(const wxImage& im
     }
     
     // Find horizontal separators (rows)
-    for (int y = 0; y < imgHeight; ++y) {
-        bool isHorizontalSeparator = true;
-        for (int x = 0; x < imgWidth; ++x) {
-            wxColour pixelColor(image.GetRed(x, y), image.GetGreen(x, y), image.GetBlue(x, y));
-            if (pixelColor != separatorColor) {
-                isHorizontalSeparator = false;
-                break;
-            }
-        }
-        if (isHorizontalSeparator) {
-            rowSeparators.push_back(y);
-        }
-    }
+    rowSeparators = ContentBounds::findUniformRows(image.GetData(), imgWidth, imgHeight, imgStride, 3, separatorRGB);
     logInfo(wxString::Format("Found %d horizontal separators", (int)rowSeparators.size()).ToStdString());
     if (!rowSeparators.empty()) {
         logDebug(wxString::Format("First few horizontal separators: %d, %d, %d...", 
@@ -1169,139 +1251,18 @@ std::vector<FontData::Glyph> FontData::ExtractGlyphsFromBitmap(const wxImage& im
         return glyphs;
     }
     
-    // Extract each character
+    // Extract the characters row by row, the cells are converted on all cores
+    std::vector<wxRect> cells;
+    cells.reserve(totalChars);
     for (int row = 0; row < numRows; ++row) {
         for (int col = 0; col < numCols; ++col) {
-            int charIndex = row * numCols + col;
-            
-            int glyphLeft = charLeftBounds[col];
-            int glyphTop = charTopBounds[row];
-            int glyphRight = charRightBounds[col];
-            int glyphBottom = charBottomBounds[row];
-            
-            int glyphWidth = glyphRight - glyphLeft + 1;
-            int glyphHeight = glyphBottom - glyphTop + 1;
-            
-            if (glyphWidth <= 0 || glyphHeight <= 0) {
-                logWarning(wxString::Format("Invalid glyph dimensions for character %d: %dx%d", 
-                                          charIndex, glyphWidth, glyphHeight).ToStdString());
-                continue;
-            }
-            
-            FontData::Glyph glyph;
-            glyph.width = glyphWidth;
-            glyph.height = glyphHeight;
-            
-            // Extract glyph data based on color format
-            if (colorFormat == 1) {
-                // Monochrome format - pack into bits
-                size_t bytesPerRow = (glyphWidth + 7) / 8;
-                glyph.data.resize(bytesPerRow * glyphHeight);
-                
-                for (int y = 0; y < glyphHeight; ++y) {
-                    for (int x = 0; x < glyphWidth; ++x) {
-                        int imgX = glyphLeft + x;
-                        int imgY = glyphTop + y;
-                        wxColour pixelColor(image.GetRed(imgX, imgY), image.GetGreen(imgX, imgY), image.GetBlue(imgX, imgY));
-                        
-                        if (pixelColor != transparentColor && pixelColor != separatorColor) {
-                            // Non-transparent pixel - set bit
-                            size_t byteIndex = y * bytesPerRow + x / 8;
-                            size_t bitIndex = 7 - (x % 8);
-                            glyph.data[byteIndex] |= (1 << bitIndex);
-                        }
-                        // Transparent pixels remain 0 (already initialized)
-                    }
-                }
-            } else if (colorFormat == 0) {
-                // 8-bit indexed color format
-                glyph.data.resize(glyphWidth * glyphHeight);
-                
-                for (int y = 0; y < glyphHeight; ++y) {
-                    for (int x = 0; x < glyphWidth; ++x) {
-                        int imgX = glyphLeft + x;
-                        int imgY = glyphTop + y;
-                        size_t pixelIndex = y * glyphWidth + x;
-                        
-                        if (pixelIndex < glyph.data.size()) {
-                            wxColour pixelColor(image.GetRed(imgX, imgY), image.GetGreen(imgX, imgY), image.GetBlue(imgX, imgY));
-                            
-                            // Check pixel type
-                            if (pixelColor == transparentColor || pixelColor == separatorColor) {
-                                glyph.data[pixelIndex] = TRANSPARENT_COLOR_INDEX; // Transparent
-                            } else {
-                                // Find closest palette color (simplified - just use red component as index for now)
-                                // In a real implementation, you'd find the closest match in the palette
-                                uint8_t paletteIndex = (pixelColor.Red() + pixelColor.Green() + pixelColor.Blue()) / 3;
-                                if (paletteIndex == TRANSPARENT_COLOR_INDEX) paletteIndex = 1; // Avoid transparency index
-                                glyph.data[pixelIndex] = paletteIndex;
-                            }
-                        }
-                    }
-                }
-            } else if (colorFormat == 24) {
-                // 24-bit RGB format
-                glyph.data.resize(glyphWidth * glyphHeight * 3);
-                
-                for (int y = 0; y < glyphHeight; ++y) {
-                    for (int x = 0; x < glyphWidth; ++x) {
-                        int imgX = glyphLeft + x;
-                        int imgY = glyphTop + y;
-                        size_t pixelIndex = (y * glyphWidth + x) * 3;
-                        
-                        if (pixelIndex + 2 < glyph.data.size()) {
-                            wxColour pixelColor(image.GetRed(imgX, imgY), image.GetGreen(imgX, imgY), image.GetBlue(imgX, imgY));
-                            
-                            // Check pixel type
-                            if (pixelColor == transparentColor || pixelColor == separatorColor) {
-                                // Store transparent color (bright pink for transparency)
-                                glyph.data[pixelIndex] = red(TRANSPARENT_COLOR);     // R
-                                glyph.data[pixelIndex + 1] = green(TRANSPARENT_COLOR); // G
-                                glyph.data[pixelIndex + 2] = blue(TRANSPARENT_COLOR);  // B
-                            } else {
-                                // Store actual RGB values
-                                glyph.data[pixelIndex] = pixelColor.Red();     // R
-                                glyph.data[pixelIndex + 1] = pixelColor.Green(); // G
-                                glyph.data[pixelIndex + 2] = pixelColor.Blue();  // B
-                            }
-                        }
-                    }
-                } 
-            } else if (colorFormat == -32) {
-                // 32-bit RGBA format
-                glyph.data.resize(glyphWidth * glyphHeight * 4);
-                
-                for (int y = 0; y < glyphHeight; ++y) {
-                    for (int x = 0; x < glyphWidth; ++x) {
-                        int imgX = glyphLeft + x;
-                        int imgY = glyphTop + y;
-                        size_t pixelIndex = (y * glyphWidth + x) * 4;
-                        
-                        if (pixelIndex + 3 < glyph.data.size()) {
-                            wxColour pixelColor(image.GetRed(imgX, imgY), image.GetGreen(imgX, imgY), image.GetBlue(imgX, imgY));
-                            
-                            // Check pixel type
-                            if (pixelColor == transparentColor || pixelColor == separatorColor) {
-                                // Store transparent color with alpha = 0
-                                glyph.data[pixelIndex] = red(TRANSPARENT_COLOR);     // R
-                                glyph.data[pixelIndex + 1] = green(TRANSPARENT_COLOR); // G
-                                glyph.data[pixelIndex + 2] = blue(TRANSPARENT_COLOR);  // B
-                                glyph.data[pixelIndex + 3] = 0;                      // A (transparent)
-                            } else {
-                                // Store actual RGBA values
-                                glyph.data[pixelIndex] = pixelColor.Red();     // R
-                                glyph.data[pixelIndex + 1] = pixelColor.Green(); // G
-                                glyph.data[pixelIndex + 2] = pixelColor.Blue();  // B
-                                glyph.data[pixelIndex + 3] = 255;             // A (opaque)
-                            }
-                        }
-                    }
-                }
-            }
-            
-            glyphs.push_back(glyph);
+            cells.push_back(wxRect(charLeftBounds[col], charTopBounds[row],
+                                   charRightBounds[col] - charLeftBounds[col] + 1,
+                                   charBottomBounds[row] - charTopBounds[row] + 1));
         }
     }
+    const uint8_t transparentRGB[3] = {transparentColor.Red(), transparentColor.Green(), transparentColor.Blue()};
+    FontImporter::extractCells(image, cells, colorFormat, separatorRGB, transparentRGB, glyphs);
     
     logInfo(wxString::Format("Extracted %d glyphs from bitmap", (int)glyphs.size()).ToStdString());
     return glyphs;
@@ -1879,58 +1840,49 @@ wxString FontData::getColorDepthStringFromMono(int8_t mono) {
 }
 
 wxBitmap FontData::createGlyphDisplayBitmap(const Range& range, uint32_t glyphIndex, int targetSize) {
-    // Check if glyph index is valid
-    if (glyphIndex >= range.glyphs.size()) {
-        // Return empty bitmap for invalid glyphs
-        wxBitmap emptyBitmap(targetSize, targetSize);
-        wxMemoryDC dc(emptyBitmap);
-        dc.SetBackground(*wxWHITE_BRUSH);
-        dc.Clear();
-        return emptyBitmap;
-    }
+    return createGlyphDisplayBitmap(*range.getAtlas(), glyphIndex, targetSize);
+}
 
-    // Use the Range::renderGlyph method to get the glyph image
-    wxImage glyphImg = range.renderGlyph(glyphIndex);
-    
-    if (!glyphImg.IsOk() || glyphImg.GetWidth() == 0 || glyphImg.GetHeight() == 0) {
-        // Return empty bitmap for invalid glyph images
-        wxBitmap emptyBitmap(targetSize, targetSize);
-        wxMemoryDC dc(emptyBitmap);
-        dc.SetBackground(*wxWHITE_BRUSH);
-        dc.Clear();
-        return emptyBitmap;
-    }
-    
-    // Scale the image to fit in target size while maintaining aspect ratio
-    int scaledWidth = glyphImg.GetWidth();
-    int scaledHeight = glyphImg.GetHeight();
-    
-    // Calculate scaling factor to fit within target size
+wxBitmap FontData::createGlyphDisplayBitmap(const GlyphAtlas& atlas, uint32_t glyphIndex, int targetSize) {
+    // Target size image with white background, empty for invalid glyphs
+    wxImage image(targetSize, targetSize);
+    image.SetRGB(wxRect(0, 0, targetSize, targetSize), 255, 255, 255);
+    if (glyphIndex >= atlas.rects.size() || atlas.rects[glyphIndex].width == 0 || atlas.rects[glyphIndex].height == 0) {
+        return wxBitmap(image);
+    }
+    const GlyphAtlas::Rect& rect = atlas.rects[glyphIndex];
+
+    // Scale the glyph to fit in target size while maintaining aspect ratio
+    int scaledWidth = rect.width;
+    int scaledHeight = rect.height;
     double scaleX = (double)targetSize / scaledWidth;
     double scaleY = (double)targetSize / scaledHeight;
     double scale = std::min(scaleX, scaleY);
-    
     if (scale < 1.0) {
-        scaledWidth = (int)(scaledWidth * scale);
-        scaledHeight = (int)(scaledHeight * scale);
-        glyphImg = glyphImg.Scale(scaledWidth, scaledHeight, wxIMAGE_QUALITY_NEAREST);
+        scaledWidth = std::max(1, (int)(scaledWidth * scale));
+        scaledHeight = std::max(1, (int)(scaledHeight * scale));
     }
-    
-    // Create a target size bitmap with white background
-    wxBitmap bitmap(targetSize, targetSize);
-    wxMemoryDC dc(bitmap);
-    dc.SetBackground(*wxWHITE_BRUSH);
-    dc.Clear();
-    
-    // Center the glyph image in the bitmap
+
+    // Center the glyph, sampling the atlas nearest neighbor and blending over white
     int offsetX = (targetSize - scaledWidth) / 2;
     int offsetY = (targetSize - scaledHeight) / 2;
-    
-    wxBitmap glyphBitmap(glyphImg);
-    dc.DrawBitmap(glyphBitmap, offsetX, offsetY, true); // true for transparency
-    
-    dc.SelectObject(wxNullBitmap);
-    return bitmap;
+    unsigned char* pixels = image.GetData();
+    for (int y = 0; y < scaledHeight; ++y) {
+        int srcY = rect.y + y * rect.height / scaledHeight;
+        for (int x = 0; x < scaledWidth; ++x) {
+            size_t src = static_cast<size_t>(srcY) * atlas.width + rect.x + x * rect.width / scaledWidth;
+            int a = atlas.alpha[src];
+            if (a == 0) {
+                continue;
+            }
+            size_t dst = (static_cast<size_t>(offsetY + y) * targetSize + offsetX + x) * 3;
+            for (int c = 0; c < 3; ++c) {
+                pixels[dst + c] = (atlas.rgb[src * 3 + c] * a + 255 * (255 - a)) / 255;
+            }
+        }
+    }
+
+    return wxBitmap(image);
 }
 
 bool FontData::operator==(const FontData& other) const {
@@ -55,11 +55,13 @@ GlyphDataModel::GlyphDataModel() : m_range(nullptr) {
 
 void GlyphDataModel::SetRange(const FontData::Range* range) {
     m_range = range;
+    m_atlas = m_range ? m_range->getAtlas() : nullptr;
     Reset(m_range ? (m_range->end - m_range->start + 1) : 0);
 }
 
 void GlyphDataModel::Clear() {
     m_range = nullptr;
+    m_atlas.reset();
     Reset(0);
 }
 
@@ -106,7 +108,7 @@ void GlyphDataModel::GetValueByRow(wxVariant& variant, unsigned int row, unsigne
             break;
         case 3: // Glyph - return bitmap
             {
-                wxBitmap glyphBitmap = FontData::createGlyphDisplayBitmap(*m_range, glyphIndex, 16);
+                wxBitmap glyphBitmap = FontData::createGlyphDisplayBitmap(*m_atlas, glyphIndex, 16);
                 variant << glyphBitmap;
             }
             break;
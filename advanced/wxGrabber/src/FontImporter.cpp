@@ -0,0 +1,748 @@
+#include "../include/FontImporter.h"
+#include "../include/BitmapData.h"
+#include "../include/ContentBounds.h"
+#include "../include/log.h"
+#include "../include/ParallelFor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+struct Block {
+    uint32_t start;
+    uint32_t end;
+    const char* name;
+};
+
+// Unicode blocks a bitmap font is likely to cover, in code point order
+const Block UnicodeBlocks[] = {
+    {0x0000, 0x007F, "Basic Latin"},
+    {0x0080, 0x00FF, "Latin-1 Supplement"},
+    {0x0100, 0x017F, "Latin Extended-A"},
+    {0x0180, 0x024F, "Latin Extended-B"},
+    {0x0250, 0x02AF, "IPA Extensions"},
+    {0x02B0, 0x02FF, "Spacing Modifier Letters"},
+    {0x0300, 0x036F, "Combining Diacritical Marks"},
+    {0x0370, 0x03FF, "Greek and Coptic"},
+    {0x0400, 0x04FF, "Cyrillic"},
+    {0x0500, 0x052F, "Cyrillic Supplement"},
+    {0x0530, 0x058F, "Armenian"},
+    {0x0590, 0x05FF, "Hebrew"},
+    {0x0600, 0x06FF, "Arabic"},
+    {0x0700, 0x074F, "Syriac"},
+    {0x0780, 0x07BF, "Thaana"},
+    {0x0900, 0x097F, "Devanagari"},
+    {0x0980, 0x09FF, "Bengali"},
+    {0x0A00, 0x0A7F, "Gurmukhi"},
+    {0x0A80, 0x0AFF, "Gujarati"},
+    {0x0B00, 0x0B7F, "Oriya"},
+    {0x0B80, 0x0BFF, "Tamil"},
+    {0x0C00, 0x0C7F, "Telugu"},
+    {0x0C80, 0x0CFF, "Kannada"},
+    {0x0D00, 0x0D7F, "Malayalam"},
+    {0x0D80, 0x0DFF, "Sinhala"},
+    {0x0E00, 0x0E7F, "Thai"},
+    {0x0E80, 0x0EFF, "Lao"},
+    {0x0F00, 0x0FFF, "Tibetan"},
+    {0x1000, 0x109F, "Myanmar"},
+    {0x10A0, 0x10FF, "Georgian"},
+    {0x1100, 0x11FF, "Hangul Jamo"},
+    {0x1200, 0x137F, "Ethiopic"},
+    {0x13A0, 0x13FF, "Cherokee"},
+    {0x1400, 0x167F, "Unified Canadian Aboriginal Syllabics"},
+    {0x1680, 0x169F, "Ogham"},
+    {0x16A0, 0x16FF, "Runic"},
+    {0x1780, 0x17FF, "Khmer"},
+    {0x1800, 0x18AF, "Mongolian"},
+    {0x1D00, 0x1D7F, "Phonetic Extensions"},
+    {0x1E00, 0x1EFF, "Latin Extended Additional"},
+    {0x1F00, 0x1FFF, "Greek Extended"},
+    {0x2000, 0x206F, "General Punctuation"},
+    {0x2070, 0x209F, "Superscripts and Subscripts"},
+    {0x20A0, 0x20CF, "Currency Symbols"},
+    {0x20D0, 0x20FF, "Combining Diacritical Marks for Symbols"},
+    {0x2100, 0x214F, "Letterlike Symbols"},
+    {0x2150, 0x218F, "Number Forms"},
+    {0x2190, 0x21FF, "Arrows"},
+    {0x2200, 0x22FF, "Mathematical Operators"},
+    {0x2300, 0x23FF, "Miscellaneous Technical"},
+    {0x2400, 0x243F, "Control Pictures"},
+    {0x2440, 0x245F, "Optical Character Recognition"},
+    {0x2460, 0x24FF, "Enclosed Alphanumerics"},
+    {0x2500, 0x257F, "Box Drawing"},
+    {0x2580, 0x259F, "Block Elements"},
+    {0x25A0, 0x25FF, "Geometric Shapes"},
+    {0x2600, 0x26FF, "Miscellaneous Symbols"},
+    {0x2700, 0x27BF, "Dingbats"},
+    {0x27C0, 0x27EF, "Miscellaneous Mathematical Symbols-A"},
+    {0x27F0, 0x27FF, "Supplemental Arrows-A"},
+    {0x2800, 0x28FF, "Braille Patterns"},
+    {0x2900, 0x297F, "Supplemental Arrows-B"},
+    {0x2980, 0x29FF, "Miscellaneous Mathematical Symbols-B"},
+    {0x2A00, 0x2AFF, "Supplemental Mathematical Operators"},
+    {0x2B00, 0x2BFF, "Miscellaneous Symbols and Arrows"},
+    {0x2C00, 0x2C5F, "Glagolitic"},
+    {0x2C60, 0x2C7F, "Latin Extended-C"},
+    {0x2E80, 0x2EFF, "CJK Radicals Supplement"},
+    {0x2F00, 0x2FDF, "Kangxi Radicals"},
+    {0x3000, 0x303F, "CJK Symbols and Punctuation"},
+    {0x3040, 0x309F, "Hiragana"},
+    {0x30A0, 0x30FF, "Katakana"},
+    {0x3100, 0x312F, "Bopomofo"},
+    {0x3130, 0x318F, "Hangul Compatibility Jamo"},
+    {0x3190, 0x319F, "Kanbun"},
+    {0x31F0, 0x31FF, "Katakana Phonetic Extensions"},
+    {0x3200, 0x32FF, "Enclosed CJK Letters and Months"},
+    {0x3300, 0x33FF, "CJK Compatibility"},
+    {0x3400, 0x4DBF, "CJK Unified Ideographs Extension A"},
+    {0x4DC0, 0x4DFF, "Yijing Hexagram Symbols"},
+    {0x4E00, 0x9FFF, "CJK Unified Ideographs"},
+    {0xA000, 0xA48F, "Yi Syllables"},
+    {0xA490, 0xA4CF, "Yi Radicals"},
+    {0xA640, 0xA69F, "Cyrillic Extended-B"},
+    {0xA720, 0xA7FF, "Latin Extended-D"},
+    {0xAC00, 0xD7AF, "Hangul Syllables"},
+    {0xE000, 0xF8FF, "Private Use Area"},
+    {0xF900, 0xFAFF, "CJK Compatibility Ideographs"},
+    {0xFB00, 0xFB4F, "Alphabetic Presentation Forms"},
+    {0xFB50, 0xFDFF, "Arabic Presentation Forms-A"},
+    {0xFE00, 0xFE0F, "Variation Selectors"},
+    {0xFE10, 0xFE1F, "Vertical Forms"},
+    {0xFE20, 0xFE2F, "Combining Half Marks"},
+    {0xFE30, 0xFE4F, "CJK Compatibility Forms"},
+    {0xFE50, 0xFE6F, "Small Form Variants"},
+    {0xFE70, 0xFEFF, "Arabic Presentation Forms-B"},
+    {0xFF00, 0xFFEF, "Halfwidth and Fullwidth Forms"},
+    {0xFFF0, 0xFFFF, "Specials"},
+    {0x1D400, 0x1D7FF, "Mathematical Alphanumeric Symbols"},
+    {0x1F000, 0x1F02F, "Mahjong Tiles"},
+    {0x1F0A0, 0x1F0FF, "Playing Cards"},
+    {0x1F300, 0x1F5FF, "Miscellaneous Symbols and Pictographs"},
+    {0x1F600, 0x1F64F, "Emoticons"},
+    {0x1F680, 0x1F6FF, "Transport and Map Symbols"},
+    {0x20000, 0x2A6DF, "CJK Unified Ideographs Extension B"},
+};
+constexpr size_t BlockCount = sizeof(UnicodeBlocks) / sizeof(UnicodeBlocks[0]);
+
+struct Entry {
+    uint32_t code;
+    int8_t mono;
+    FontData::Glyph glyph;
+};
+
+// Hex with a 0x or U+ prefix, decimal otherwise
+bool parseCode(const std::string& token, uint32_t& code) {
+    std::string digits = token;
+    int base = 10;
+    if (token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+        digits = token.substr(2);
+        base = 16;
+    } else if (token.size() > 2 && (token[0] == 'U' || token[0] == 'u') && token[1] == '+') {
+        digits = token.substr(2);
+        base = 16;
+    }
+    if (digits.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(digits.c_str(), &end, base);
+    if (*end != '\0' || value > 0x10FFFF) {
+        return false;
+    }
+    code = static_cast<uint32_t>(value);
+    return true;
+}
+
+// Next line of text without the line break, false at the end
+bool nextLine(const std::string& text, size_t& pos, std::string& line) {
+    if (pos >= text.size()) {
+        return false;
+    }
+    size_t end = text.find('\n', pos);
+    if (end == std::string::npos) {
+        end = text.size();
+    }
+    size_t length = end - pos;
+    if (length > 0 && text[pos + length - 1] == '\r') {
+        length--;
+    }
+    line.assign(text, pos, length);
+    pos = end + 1;
+    return true;
+}
+
+bool startsWith(const std::string& line, const char* keyword) {
+    size_t length = std::strlen(keyword);
+    return line.compare(0, length, keyword) == 0 && (line.size() == length || line[length] == ' ');
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+bool loadGridSheet(const FontImporter::Source& source, uint32_t firstCode, unsigned threadCount, std::vector<Entry>& entries) {
+    wxImage image;
+    if (!BitmapData::readFileToWxImage(source.filepath, image) || !image.IsOk() || image.GetWidth() == 0 || image.GetHeight() == 0) {
+        logError("Font import: cannot read image " + source.filepath);
+        return false;
+    }
+    int imgWidth = image.GetWidth();
+    int imgHeight = image.GetHeight();
+
+    // 8-bit sheets use palette entries 255 and 0, others bright yellow and pink, as in ExtractGlyphsFromBitmap
+    uint8_t separatorRGB[3] = {red(SEPARATOR_COLOR), green(SEPARATOR_COLOR), blue(SEPARATOR_COLOR)};
+    uint8_t transparentRGB[3] = {red(TRANSPARENT_COLOR), green(TRANSPARENT_COLOR), blue(TRANSPARENT_COLOR)};
+    if (image.HasPalette()) {
+        const wxPalette& palette = image.GetPalette();
+        palette.GetRGB(SEPARATOR_COLOR_INDEX, &separatorRGB[0], &separatorRGB[1], &separatorRGB[2]);
+        palette.GetRGB(TRANSPARENT_COLOR_INDEX, &transparentRGB[0], &transparentRGB[1], &transparentRGB[2]);
+    }
+
+    std::vector<wxRect> cells;
+    if (source.cellWidth > 0 && source.cellHeight > 0) {
+        for (int y = 0; y + source.cellHeight <= imgHeight; y += source.cellHeight) {
+            for (int x = 0; x + source.cellWidth <= imgWidth; x += source.cellWidth) {
+                cells.push_back(wxRect(x, y, source.cellWidth, source.cellHeight));
+            }
+        }
+    } else {
+        size_t stride = static_cast<size_t>(imgWidth) * 3;
+        std::vector<int> columns = ContentBounds::findUniformColumns(image.GetData(), imgWidth, imgHeight, stride, 3, separatorRGB);
+        std::vector<int> rows = ContentBounds::findUniformRows(image.GetData(), imgWidth, imgHeight, stride, 3, separatorRGB);
+        for (size_t row = 0; row + 1 < rows.size(); row++) {
+            for (size_t col = 0; col + 1 < columns.size(); col++) {
+                int left = columns[col] + 1;
+                int top = rows[row] + 1;
+                if (left < columns[col + 1] && top < rows[row + 1]) {
+                    cells.push_back(wxRect(left, top, columns[col + 1] - left, rows[row + 1] - top));
+                }
+            }
+        }
+    }
+    if (cells.empty()) {
+        logError("Font import: no glyph cells found in " + source.filepath);
+        return false;
+    }
+
+    // Cells filled with the separator color pad the last row, they take no code
+    const unsigned char* pixels = image.GetData();
+    std::vector<char> padding(cells.size(), 0);
+    parallelFor(cells.size(), threadCount, [&](size_t i) {
+        const wxRect& cell = cells[i];
+        for (int y = cell.y; y < cell.y + cell.height; y++) {
+            const unsigned char* p = pixels + (static_cast<size_t>(y) * imgWidth + cell.x) * 3;
+            for (int x = 0; x < cell.width; x++, p += 3) {
+                if (p[0] != separatorRGB[0] || p[1] != separatorRGB[1] || p[2] != separatorRGB[2]) {
+                    return;
+                }
+            }
+        }
+        padding[i] = 1;
+    });
+    std::vector<wxRect> glyphCells;
+    std::vector<uint32_t> codes;
+    size_t pastLastCode = 0;
+    for (size_t i = 0; i < cells.size(); i++) {
+        if (padding[i]) {
+            continue;
+        }
+        if (firstCode > 0x10FFFF || i > 0x10FFFF - firstCode) {
+            pastLastCode++;
+            continue;
+        }
+        codes.push_back(firstCode + static_cast<uint32_t>(i));
+        glyphCells.push_back(cells[i]);
+    }
+    if (pastLastCode > 0) {
+        logWarning("Font import: skipping " + std::to_string(pastLastCode) + " cells of " + source.filepath +
+                   " that would be past U+10FFFF");
+    }
+
+    std::vector<FontData::Glyph> glyphs;
+    FontImporter::extractCells(image, glyphCells, source.colorFormat, separatorRGB, transparentRGB, glyphs, threadCount);
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        entries.push_back(Entry{codes[i], source.colorFormat, std::move(glyphs[i])});
+    }
+    LOG_INFO("Font import: %zu glyphs from %zu cells in %s", glyphs.size(), cells.size(), source.filepath.c_str());
+    return true;
+}
+
+bool loadBdf(const FontImporter::Source& source, unsigned threadCount, std::vector<Entry>& entries) {
+    std::string text;
+    if (!readFile(source.filepath, text)) {
+        logError("Font import: cannot read " + source.filepath);
+        return false;
+    }
+    std::vector<std::pair<uint32_t, FontData::Glyph>> glyphs;
+    if (!FontImporter::parseBdf(text, glyphs, threadCount)) {
+        logError("Font import: no glyphs in BDF font " + source.filepath);
+        return false;
+    }
+    for (auto& glyph : glyphs) {
+        entries.push_back(Entry{glyph.first, 1, std::move(glyph.second)});
+    }
+    LOG_INFO("Font import: %zu glyphs from BDF font %s", glyphs.size(), source.filepath.c_str());
+    return true;
+}
+
+bool loadGrx(const FontImporter::Source& source, std::vector<Entry>& entries) {
+    std::string contents;
+    if (!readFile(source.filepath, contents)) {
+        logError("Font import: cannot read " + source.filepath);
+        return false;
+    }
+    std::vector<uint8_t> buffer(contents.begin(), contents.end());
+    uint32_t magic = buffer.size() >= 4 ? (buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | (static_cast<uint32_t>(buffer[3]) << 24)) : 0;
+    if (magic != FONT_GRX_MAGIC) {
+        logError("Font import: not a GRX font " + source.filepath);
+        return false;
+    }
+    FontData::Range range = FontData::CreateRangeFromGrxFnt(buffer);
+    if (range.glyphs.empty()) {
+        logError("Font import: no glyphs in GRX font " + source.filepath);
+        return false;
+    }
+    for (size_t i = 0; i < range.glyphs.size(); i++) {
+        entries.push_back(Entry{range.start + static_cast<uint32_t>(i), range.mono, std::move(range.glyphs[i])});
+    }
+    return true;
+}
+}
+
+FontImporter::SourceType FontImporter::detectType(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == "bdf") {
+        return SourceType::Bdf;
+    }
+    if (extension == "fnt") {
+        return SourceType::Grx;
+    }
+    return SourceType::GridSheet;
+}
+
+bool FontImporter::readMappingFile(const std::string& path, std::map<uint32_t, uint32_t>& mapping) {
+    std::string text;
+    if (!readFile(path, text)) {
+        logError("Font import: cannot read mapping file " + path);
+        return false;
+    }
+    size_t pos = 0;
+    std::string line;
+    int lineNumber = 0;
+    while (nextLine(text, pos, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::string sourceToken, codeToken;
+        if (!(tokens >> sourceToken)) {
+            continue;   // Blank or comment only
+        }
+        uint32_t first = 0, last = 0, code = 0;
+        size_t dash = sourceToken.find('-', 1);
+        bool sourceOk = dash == std::string::npos
+            ? parseCode(sourceToken, first) && parseCode(sourceToken, last)
+            : parseCode(sourceToken.substr(0, dash), first) && parseCode(sourceToken.substr(dash + 1), last);
+        // Legacy tables list undefined source codes without a code point, skip those
+        if (!(tokens >> codeToken)) {
+            continue;
+        }
+        if (!sourceOk || !parseCode(codeToken, code) || last < first || code + (last - first) > 0x10FFFF) {
+            logWarning("Font import: skipping mapping line " + std::to_string(lineNumber) + " of " + path);
+            continue;
+        }
+        for (uint32_t source = first; source <= last; source++) {
+            mapping[source] = code + (source - first);
+        }
+    }
+    return true;
+}
+
+void FontImporter::extractCells(const wxImage& image, const std::vector<wxRect>& cells, int8_t colorFormat,
+                                const uint8_t separatorRGB[3], const uint8_t transparentRGB[3],
+                                std::vector<FontData::Glyph>& glyphs, unsigned threadCount) {
+    glyphs.assign(cells.size(), FontData::Glyph{});
+    const unsigned char* pixels = image.GetData();
+    int imgWidth = image.GetWidth();
+    parallelFor(cells.size(), threadCount, [&](size_t i) {
+        const wxRect& cell = cells[i];
+        FontData::Glyph& glyph = glyphs[i];
+        glyph.width = cell.width;
+        glyph.height = cell.height;
+        size_t bytesPerRow = (cell.width + 7) / 8;
+        size_t pixelCount = static_cast<size_t>(cell.width) * cell.height;
+        if (colorFormat == 1) {
+            glyph.data.assign(bytesPerRow * cell.height, 0);
+        } else if (colorFormat == 0) {
+            glyph.data.assign(pixelCount, 0);
+        } else if (colorFormat == 24) {
+            glyph.data.assign(pixelCount * 3, 0);
+        } else if (colorFormat == -32) {
+            glyph.data.assign(pixelCount * 4, 0);
+        } else {
+            return;     // Unsupported format, the glyph keeps its size without pixels
+        }
+
+        for (int y = 0; y < cell.height; y++) {
+            const unsigned char* p = pixels + (static_cast<size_t>(cell.y + y) * imgWidth + cell.x) * 3;
+            for (int x = 0; x < cell.width; x++, p += 3) {
+                bool blank = (p[0] == separatorRGB[0] && p[1] == separatorRGB[1] && p[2] == separatorRGB[2]) ||
+                             (p[0] == transparentRGB[0] && p[1] == transparentRGB[1] && p[2] == transparentRGB[2]);
+                size_t pixel = static_cast<size_t>(y) * cell.width + x;
+                if (colorFormat == 1) {
+                    if (!blank) {
+                        glyph.data[y * bytesPerRow + x / 8] |= 0x80 >> (x % 8);
+                    }
+                } else if (colorFormat == 0) {
+                    // Gray level as the palette index, never the transparent one
+                    uint8_t index = (p[0] + p[1] + p[2]) / 3;
+                    if (index == TRANSPARENT_COLOR_INDEX) {
+                        index = 1;
+                    }
+                    glyph.data[pixel] = blank ? TRANSPARENT_COLOR_INDEX : index;
+                } else {
+                    size_t bytesPerPixel = colorFormat == 24 ? 3 : 4;
+                    uint8_t* out = &glyph.data[pixel * bytesPerPixel];
+                    out[0] = blank ? red(TRANSPARENT_COLOR) : p[0];
+                    out[1] = blank ? green(TRANSPARENT_COLOR) : p[1];
+                    out[2] = blank ? blue(TRANSPARENT_COLOR) : p[2];
+                    if (bytesPerPixel == 4) {
+                        out[3] = blank ? 0 : 255;
+                    }
+                }
+            }
+        }
+    });
+}
+
+void FontImporter::trimGlyph(FontData::Glyph& glyph, int8_t mono, int spacing) {
+    int bitDepth = FontData::getBitDepthFromMono(mono);
+    int width = glyph.width;
+    int height = glyph.height;
+    if (width == 0 || height == 0 || bitDepth == 0) {
+        return;
+    }
+    size_t bytesPerRow = bitDepth == 1 ? (width + 7) / 8 : static_cast<size_t>(width) * (bitDepth / 8);
+    if (glyph.data.size() < bytesPerRow * height) {
+        return;
+    }
+    auto opaque = [&](int x, int y) {
+        const uint8_t* row = glyph.data.data() + y * bytesPerRow;
+        switch (bitDepth) {
+            case 1:  return (row[x / 8] & (0x80 >> (x % 8))) != 0;
+            case 8:  return row[x] != TRANSPARENT_COLOR_INDEX;
+            case 16: return (row[x * 2] | (row[x * 2 + 1] << 8)) != TRANSPARENT_COLOR_16;
+            case 24: return ((row[x * 3] << 16) | (row[x * 3 + 1] << 8) | row[x * 3 + 2]) != TRANSPARENT_COLOR;
+            default: return row[x * 4 + 3] != 0;
+        }
+    };
+    int left = width, right = -1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (opaque(x, y)) {
+                left = std::min(left, x);
+                right = std::max(right, x);
+            }
+        }
+    }
+    if (right < 0) {
+        return;     // Blank glyphs such as the space keep their advance
+    }
+
+    int newWidth = std::min(right - left + 1 + std::max(spacing, 0), 0xFFFF);
+    size_t newBytesPerRow = bitDepth == 1 ? (newWidth + 7) / 8 : static_cast<size_t>(newWidth) * (bitDepth / 8);
+    std::vector<uint8_t> data(newBytesPerRow * height, 0);
+    size_t bytesPerPixel = bitDepth / 8;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = glyph.data.data() + y * bytesPerRow;
+        uint8_t* dst = data.data() + y * newBytesPerRow;
+        if (bitDepth == 1) {
+            for (int x = left; x <= right; x++) {
+                if (src[x / 8] & (0x80 >> (x % 8))) {
+                    dst[(x - left) / 8] |= 0x80 >> ((x - left) % 8);
+                }
+            }
+            continue;
+        }
+        // Spacing columns get the transparent value of the format
+        for (int x = 0; x < newWidth; x++) {
+            uint8_t* out = dst + x * bytesPerPixel;
+            if (bitDepth == 16) {
+                out[0] = TRANSPARENT_COLOR_16 & 0xFF;
+                out[1] = TRANSPARENT_COLOR_16 >> 8;
+            } else if (bitDepth >= 24) {
+                out[0] = red(TRANSPARENT_COLOR);
+                out[1] = green(TRANSPARENT_COLOR);
+                out[2] = blue(TRANSPARENT_COLOR);
+            }
+        }
+        std::memcpy(dst, src + left * bytesPerPixel, (right - left + 1) * bytesPerPixel);
+    }
+    glyph.width = static_cast<uint16_t>(newWidth);
+    glyph.data.swap(data);
+}
+
+bool FontImporter::parseBdf(const std::string& text, std::vector<std::pair<uint32_t, FontData::Glyph>>& glyphs, unsigned threadCount) {
+    struct BdfChar {
+        long encoding = -1;
+        int advance = -1;
+        int width = 0, height = 0, offsetX = 0, offsetY = 0;
+        size_t bitmap = 0;      // Offset of the first bitmap row in the text
+        int rows = 0;
+    };
+    std::vector<BdfChar> chars;
+    int boxHeight = 0, boxOffsetY = 0;
+    int ascent = -1, descent = -1;
+    bool started = false;
+
+    // Headers are read in one pass, the bitmaps are only located here
+    size_t pos = 0;
+    std::string line;
+    BdfChar current;
+    bool inChar = false;
+    while (nextLine(text, pos, line)) {
+        if (!started) {
+            started = startsWith(line, "STARTFONT");
+            if (!started && !line.empty() && !startsWith(line, "COMMENT")) {
+                return false;
+            }
+        } else if (startsWith(line, "FONTBOUNDINGBOX")) {
+            int boxWidth = 0, boxOffsetX = 0;
+            std::sscanf(line.c_str() + 15, "%d %d %d %d", &boxWidth, &boxHeight, &boxOffsetX, &boxOffsetY);
+        } else if (startsWith(line, "FONT_ASCENT")) {
+            std::sscanf(line.c_str() + 11, "%d", &ascent);
+        } else if (startsWith(line, "FONT_DESCENT")) {
+            std::sscanf(line.c_str() + 12, "%d", &descent);
+        } else if (startsWith(line, "STARTCHAR")) {
+            current = BdfChar();
+            inChar = true;
+        } else if (!inChar) {
+            continue;
+        } else if (startsWith(line, "ENCODING")) {
+            // "ENCODING -1 n" carries a non standard code n
+            long standard = -1, alternative = -1;
+            int fields = std::sscanf(line.c_str() + 8, "%ld %ld", &standard, &alternative);
+            current.encoding = standard >= 0 ? standard : (fields == 2 ? alternative : -1);
+        } else if (startsWith(line, "DWIDTH")) {
+            std::sscanf(line.c_str() + 6, "%d", &current.advance);
+        } else if (startsWith(line, "BBX")) {
+            std::sscanf(line.c_str() + 3, "%d %d %d %d", &current.width, &current.height, &current.offsetX, &current.offsetY);
+        } else if (startsWith(line, "BITMAP")) {
+            current.bitmap = pos;
+            while (nextLine(text, pos, line) && !startsWith(line, "ENDCHAR")) {
+                current.rows++;
+            }
+            if (current.encoding >= 0 && current.encoding <= 0x10FFFF && current.width >= 0 && current.height >= 0) {
+                chars.push_back(current);
+            }
+            inChar = false;
+        }
+    }
+    if (chars.empty()) {
+        return false;
+    }
+
+    // Cell height from the font ascent and descent, the font bounding box when they are missing
+    if (ascent < 0 || descent < 0) {
+        ascent = boxHeight + boxOffsetY;
+        descent = -boxOffsetY;
+    }
+    int cellHeight = std::max(ascent + descent, 1);
+
+    glyphs.assign(chars.size(), std::pair<uint32_t, FontData::Glyph>());
+    parallelFor(chars.size(), threadCount, [&](size_t i) {
+        const BdfChar& c = chars[i];
+        FontData::Glyph& glyph = glyphs[i].second;
+        glyphs[i].first = static_cast<uint32_t>(c.encoding);
+        int left = std::max(c.offsetX, 0);
+        int advance = c.advance >= 0 ? c.advance : left + c.width;
+        int width = std::min(std::max(advance, left + c.width), 0xFFFF);
+        glyph.width = static_cast<uint16_t>(width);
+        glyph.height = static_cast<uint16_t>(cellHeight);
+        size_t bytesPerRow = (width + 7) / 8;
+        glyph.data.assign(bytesPerRow * cellHeight, 0);
+
+        // Row 0 of the bitmap is the top of the box, which sits offsetY above the baseline
+        int top = ascent - (c.offsetY + c.height);
+        size_t rowPos = c.bitmap;
+        std::string row;
+        for (int r = 0; r < std::min(c.rows, c.height) && nextLine(text, rowPos, row); r++) {
+            int y = top + r;
+            if (y < 0 || y >= cellHeight) {
+                continue;
+            }
+            uint8_t* out = glyph.data.data() + y * bytesPerRow;
+            for (int x = 0; x < c.width && static_cast<size_t>(x / 4) < row.size(); x++) {
+                if (hexDigit(row[x / 4]) & (8 >> (x % 4))) {
+                    int px = left + x;
+                    out[px / 8] |= 0x80 >> (px % 8);
+                }
+            }
+        }
+    });
+    return true;
+}
+
+std::vector<FontImporter::BlockCoverage> FontImporter::computeCoverage(const FontData& font) {
+    std::vector<int> counts(BlockCount + 1, 0);   // Last one counts code points outside the table
+    for (const auto& range : font.ranges) {
+        for (size_t i = 0; i < range.glyphs.size(); i++) {
+            if (range.glyphs[i].width == 0 || range.glyphs[i].height == 0) {
+                continue;
+            }
+            uint32_t code = range.start + static_cast<uint32_t>(i);
+            const Block* block = std::upper_bound(UnicodeBlocks, UnicodeBlocks + BlockCount, code,
+                                                  [](uint32_t value, const Block& b) { return value < b.start; });
+            size_t index = block - UnicodeBlocks;
+            if (index > 0 && code <= UnicodeBlocks[index - 1].end) {
+                counts[index - 1]++;
+            } else {
+                counts[BlockCount]++;
+            }
+        }
+    }
+
+    std::vector<BlockCoverage> coverage;
+    for (size_t i = 0; i < BlockCount; i++) {
+        if (counts[i] > 0) {
+            coverage.push_back(BlockCoverage{UnicodeBlocks[i].name, UnicodeBlocks[i].start, UnicodeBlocks[i].end, counts[i]});
+        }
+    }
+    if (counts[BlockCount] > 0) {
+        coverage.push_back(BlockCoverage{"Other", 0, 0, counts[BlockCount]});
+    }
+    return coverage;
+}
+
+std::string FontImporter::formatCoverage(const std::vector<BlockCoverage>& coverage) {
+    std::string report;
+    char line[160];
+    for (const auto& block : coverage) {
+        if (block.start == 0 && block.end == 0) {
+            std::snprintf(line, sizeof(line), "Outside the known blocks: %d glyphs\n", block.glyphs);
+        } else {
+            uint32_t size = block.end - block.start + 1;
+            std::snprintf(line, sizeof(line), "U+%04X-U+%04X %s: %d of %u (%.0f%%)\n", block.start, block.end,
+                          block.name.c_str(), block.glyphs, size, 100.0 * block.glyphs / size);
+        }
+        report += line;
+    }
+    return report;
+}
+
+bool FontImporter::import(const std::vector<Source>& sources, const Options& options, Result& result) {
+    result = Result();
+    if (sources.empty()) {
+        logError("Font import: no sources");
+        return false;
+    }
+
+    // Sources are read one after the other, each one extracts its glyphs on all cores
+    std::vector<Entry> entries;
+    uint32_t nextSheetCode = Source().firstCode;
+    for (const auto& source : sources) {
+        std::vector<Entry> sourceEntries;
+        SourceType type = source.type == SourceType::Auto ? detectType(source.filepath) : source.type;
+        uint32_t firstCode = source.followPrevious ? nextSheetCode : source.firstCode;
+        bool loaded = type == SourceType::Bdf ? loadBdf(source, options.threadCount, sourceEntries)
+                    : type == SourceType::Grx ? loadGrx(source, sourceEntries)
+                    : loadGridSheet(source, firstCode, options.threadCount, sourceEntries);
+        if (!loaded) {
+            return false;
+        }
+        // Unmapped, so a following sheet continues the numbering of this one
+        if (type == SourceType::GridSheet && !sourceEntries.empty()) {
+            nextSheetCode = sourceEntries.back().code + 1;
+        }
+        if (!source.mappingFile.empty()) {
+            std::map<uint32_t, uint32_t> mapping;
+            if (!readMappingFile(source.mappingFile, mapping)) {
+                return false;
+            }
+            for (auto& entry : sourceEntries) {
+                auto it = mapping.find(entry.code);
+                if (it != mapping.end()) {
+                    entry.code = it->second;
+                }
+            }
+        }
+        entries.insert(entries.end(), std::make_move_iterator(sourceEntries.begin()), std::make_move_iterator(sourceEntries.end()));
+    }
+
+    // Code point order, the first source to give a code point keeps it
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.code < b.code; });
+    size_t kept = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (kept > 0 && entries[kept - 1].code == entries[i].code) {
+            result.duplicates++;
+            continue;
+        }
+        if (kept != i) {
+            entries[kept] = std::move(entries[i]);
+        }
+        kept++;
+    }
+    entries.resize(kept);
+    if (entries.empty()) {
+        logError("Font import: no glyphs found");
+        return false;
+    }
+
+    if (options.trim) {
+        parallelFor(entries.size(), options.threadCount, [&](size_t i) {
+            trimGlyph(entries[i].glyph, entries[i].mono, options.spacing);
+        });
+    }
+
+    // Split into ranges of consecutive code points and one color format
+    FontData& font = result.font;
+    font.typeID = ObjectType::DAT_FONT;
+    font.fontSize = 0;
+    for (auto& entry : entries) {
+        if (font.ranges.empty() || font.ranges.back().mono != entry.mono ||
+            entry.code - font.ranges.back().end - 1 > options.maxGapFill) {
+            FontData::Range range;
+            range.mono = entry.mono;
+            range.start = entry.code;
+            range.end = entry.code;
+            range.glyphs.push_back(std::move(entry.glyph));
+            font.ranges.push_back(std::move(range));
+            continue;
+        }
+        FontData::Range& range = font.ranges.back();
+        range.glyphs.resize(range.glyphs.size() + (entry.code - range.end - 1), FontData::Glyph{});
+        range.glyphs.push_back(std::move(entry.glyph));
+        range.end = entry.code;
+    }
+    if (font.ranges.size() > 0xFFFF) {
+        logError("Font import: " + std::to_string(font.ranges.size()) + " ranges do not fit in a font, allow larger gaps");
+        return false;
+    }
+    font.UpdateGlyphCount();
+    result.glyphs = static_cast<int>(entries.size());
+    result.coverage = computeCoverage(font);
+
+    LOG_INFO("Font import: %d glyphs in %zu ranges from %zu sources, %d duplicates dropped",
+             result.glyphs, font.ranges.size(), sources.size(), result.duplicates);
+    return true;
+}
@@ -21,6 +21,7 @@ GrabberInfo::GrabberInfo()
     , m_griddleAutocrop(false)
     , m_griddleType(0)  // bitmap
     , m_griddleColor(0xffffff)
+    , m_undoMemory(256)
 {
 }
 
@@ -176,6 +177,13 @@ bool GrabberInfo::LoadSettings(const std::string& filename)
         else if (key == "password") {
             m_password = value;
         }
+        else if (key == "undo_memory") {
+            try {
+                m_undoMemory = std::max(0, std::stoi(value));
+            } catch (const std::exception&) {
+                logWarning("Invalid undo_memory value in settings file");
+            }
+        }
         // Shell association: store any unknown key as a shell association
         else {
             // Trim trailing whitespace from key
@@ -216,6 +224,7 @@ bool GrabberInfo::SaveSettings(const std::string& filename) const
     std::stringstream colorStream;
     colorStream << "#" << std::hex << std::setfill('0') << std::setw(6) << m_griddleColor;
     file << "griddle_color = " << colorStream.str() << "\n";
+    file << "undo_memory = " << m_undoMemory << "\n";
 
     // Save password only if not empty
     if (!m_password.empty()) {
@@ -0,0 +1,102 @@
+#include "../include/GridGrabber.h"
+#include "../include/log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+void GridGrabber::processCell(const wxImage& image, const Options& options, std::vector<uint8_t>& palette, Cell& cell) {
+    PROFILE_SCOPE("GridGrabber::processCell");
+    cell.bitmap.typeID = options.typeID;
+    wxImage cellImage = image.GetSubImage(cell.rect);
+    if (!cell.bitmap.loadFromWxImage(cellImage, options.bits, &palette, options.useDithering, options.preserveTransparency)) {
+        LOG_WARNING("Failed to load cell image at position %d,%d", cell.rect.x, cell.rect.y);
+        return;
+    }
+
+    if (options.skipEmpties && cell.bitmap.isMonocolor()) {
+        return;
+    }
+
+    if (options.autoCrop) {
+        cell.cropped = cell.bitmap.autoCrop(cell.cropX, cell.cropY);
+    }
+    cell.keep = true;
+}
+
+bool GridGrabber::processCells(const wxImage& image, const std::vector<wxRect>& rects, const Options& options,
+                               const std::vector<uint8_t>& palette, std::vector<Cell>& cells,
+                               const ProgressCallback& progress, unsigned threadCount) {
+    PROFILE_SCOPE("GridGrabber::processCells");
+    cells.clear();
+    cells.resize(rects.size());
+    for (size_t i = 0; i < rects.size(); i++) {
+        cells[i].rect = rects[i];
+    }
+    if (rects.empty()) {
+        return true;
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, rects.size()));
+
+    std::atomic<size_t> nextCell{0};
+    std::atomic<size_t> doneCount{0};
+    std::atomic<bool> cancelled{false};
+    std::mutex doneMutex;
+    std::condition_variable allDone;
+
+    // Workers pull cells one at a time, so uneven cell sizes still balance out
+    auto worker = [&]() {
+        // loadFromWxImage takes a mutable palette, give every worker its own copy
+        std::vector<uint8_t> workerPalette = palette;
+        while (!cancelled) {
+            size_t index = nextCell++;
+            if (index >= cells.size()) {
+                break;
+            }
+            processCell(image, options, workerPalette, cells[index]);
+            if (++doneCount == cells.size()) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                allDone.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+
+    // The calling thread only reports progress, typically it is the UI thread
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        while (doneCount < cells.size() && !cancelled) {
+            allDone.wait_for(lock, std::chrono::milliseconds(50));
+            if (progress) {
+                lock.unlock();
+                if (!progress(doneCount, cells.size())) {
+                    cancelled = true;
+                }
+                lock.lock();
+            }
+        }
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (cancelled) {
+        LOG_INFO("Grid grab cancelled after %zu of %zu cells", doneCount.load(), cells.size());
+        cells.clear();
+        return false;
+    }
+    if (progress) {
+        progress(cells.size(), cells.size());
+    }
+    return true;
+}
@@ -0,0 +1,1113 @@
+#include "../include/ImageCodec.h"
+#include "../include/log.h"
+#include <wx/stream.h>
+#include <wx/zstream.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    constexpr int MaxDimension = 32768;
+
+    // Buffered sequential reader, the codecs pull a scanline at a time from it
+    class FileReader {
+    public:
+        explicit FileReader(const std::string& path) : file(path, std::ios::binary), buffer(BufferSize) {}
+
+        bool isOpen() const { return file.is_open(); }
+
+        bool read(void* destination, size_t size) {
+            uint8_t* out = static_cast<uint8_t*>(destination);
+            while (size > 0) {
+                if (pos == avail && !fill()) {
+                    return false;
+                }
+                size_t count = std::min(size, avail - pos);
+                std::memcpy(out, buffer.data() + pos, count);
+                pos += count;
+                out += count;
+                size -= count;
+            }
+            return true;
+        }
+
+        bool readByte(uint8_t& value) {
+            if (pos == avail && !fill()) {
+                return false;
+            }
+            value = buffer[pos++];
+            return true;
+        }
+
+        bool skip(size_t size) {
+            uint8_t scratch[256];
+            while (size > 0) {
+                size_t count = std::min(size, sizeof(scratch));
+                if (!read(scratch, count)) {
+                    return false;
+                }
+                size -= count;
+            }
+            return true;
+        }
+
+        bool seek(uint64_t offset) {
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            pos = avail = 0;
+            return static_cast<bool>(file);
+        }
+
+        uint64_t size() {
+            file.clear();
+            std::streampos current = file.tellg();
+            file.seekg(0, std::ios::end);
+            uint64_t end = static_cast<uint64_t>(file.tellg());
+            file.seekg(current);
+            return end;
+        }
+
+    private:
+        bool fill() {
+            file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+            avail = static_cast<size_t>(file.gcount());
+            pos = 0;
+            return avail > 0;
+        }
+
+        static constexpr size_t BufferSize = 64 * 1024;
+        std::ifstream file;
+        std::vector<uint8_t> buffer;
+        size_t pos = 0;
+        size_t avail = 0;
+    };
+
+    class FileWriter {
+    public:
+        explicit FileWriter(const std::string& path) : file(path, std::ios::binary) { buffer.reserve(BufferSize); }
+
+        bool isOpen() const { return file.is_open(); }
+
+        void write(const void* data, size_t size) {
+            if (buffer.size() + size > BufferSize) {
+                flushBuffer();
+            }
+            if (size >= BufferSize) {
+                file.write(static_cast<const char*>(data), size);
+                return;
+            }
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            buffer.insert(buffer.end(), bytes, bytes + size);
+        }
+
+        void writeByte(uint8_t value) {
+            if (buffer.size() == BufferSize) {
+                flushBuffer();
+            }
+            buffer.push_back(value);
+        }
+
+        bool close() {
+            flushBuffer();
+            file.close();
+            return !file.fail();
+        }
+
+    private:
+        void flushBuffer() {
+            if (!buffer.empty()) {
+                file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+                buffer.clear();
+            }
+        }
+
+        static constexpr size_t BufferSize = 64 * 1024;
+        std::ofstream file;
+        std::vector<uint8_t> buffer;
+    };
+
+    inline uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    inline uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+    inline uint32_t be32(const uint8_t* p) { return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+    inline void storeLE16(uint8_t* p, uint32_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; }
+    inline void storeLE32(uint8_t* p, uint32_t v) { storeLE16(p, v); storeLE16(p + 2, v >> 16); }
+    inline void storeBE32(uint8_t* p, uint32_t v) { p[0] = v >> 24; p[1] = (v >> 16) & 0xFF; p[2] = (v >> 8) & 0xFF; p[3] = v & 0xFF; }
+
+    bool validDimensions(int width, int height) {
+        return width > 0 && height > 0 && width <= MaxDimension && height <= MaxDimension;
+    }
+
+    // Size the bitmap for decoding, pixels are written row by row afterwards
+    void prepareBitmap(ImageCodec::DecodedImage& image, int width, int height, int bits) {
+        BitmapData& bitmap = image.bitmap;
+        bitmap.typeID = ObjectType::DAT_BITMAP;
+        bitmap.width = width;
+        bitmap.height = height;
+        bitmap.bits = bits;
+        bitmap.alpha.clear();
+        bitmap.data.assign(static_cast<size_t>(width) * height * bitmap.getBytesPerPixel(), 0);
+        if (bits == 8) {
+            image.palette.assign(768, 0);
+        } else {
+            image.palette.clear();
+        }
+        image.paletteHasAlpha = false;
+    }
+
+    uint8_t* rowPointer(BitmapData& bitmap, int y) {
+        return bitmap.data.data() + static_cast<size_t>(y) * bitmap.width * bitmap.getBytesPerPixel();
+    }
+
+    const uint8_t* rowPointer(const BitmapData& bitmap, int y) {
+        return bitmap.data.data() + static_cast<size_t>(y) * bitmap.width * bitmap.getBytesPerPixel();
+    }
+
+    // Palette entry i as RGB, missing entries are black
+    void paletteColor(const std::vector<uint8_t>& palette, int i, uint8_t* rgb) {
+        for (int c = 0; c < 3; c++) {
+            size_t index = static_cast<size_t>(i) * 3 + c;
+            rgb[c] = index < palette.size() ? palette[index] : 0;
+        }
+    }
+
+    // Reads the BGR(A) channels of a source row into RGB/RGBA
+    void swapRedBlue(const uint8_t* src, uint8_t* dst, int width, int srcBytes, int dstBytes) {
+        for (int x = 0; x < width; x++) {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+            if (dstBytes == 4) {
+                dst[3] = srcBytes == 4 ? src[3] : 255;
+            }
+            src += srcBytes;
+            dst += dstBytes;
+        }
+    }
+
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void writePngChunk(FileWriter& writer, const char* type, const uint8_t* data, size_t size) {
+        uint8_t header[8];
+        storeBE32(header, static_cast<uint32_t>(size));
+        std::memcpy(header + 4, type, 4);
+        writer.write(header, 8);
+        if (size > 0) {
+            writer.write(data, size);
+        }
+        uint8_t crc[4];
+        storeBE32(crc, crc32(data, size, crc32(header + 4, 4)));
+        writer.write(crc, 4);
+    }
+
+    // Concatenated IDAT payloads as one stream, read lazily chunk by chunk
+    class PngIdatInputStream : public wxInputStream {
+    public:
+        PngIdatInputStream(FileReader& reader, uint32_t firstChunkLength)
+            : reader(reader), remaining(firstChunkLength) {}
+
+    protected:
+        size_t OnSysRead(void* buffer, size_t size) override {
+            uint8_t* out = static_cast<uint8_t*>(buffer);
+            size_t total = 0;
+            while (total < size && !finished) {
+                if (remaining == 0) {
+                    finished = !nextChunk();
+                    continue;
+                }
+                size_t count = std::min<size_t>(size - total, remaining);
+                if (!reader.read(out + total, count)) {
+                    finished = true;
+                    m_lasterror = wxSTREAM_READ_ERROR;
+                    return total;
+                }
+                total += count;
+                remaining -= static_cast<uint32_t>(count);
+            }
+            if (total == 0) {
+                m_lasterror = wxSTREAM_EOF;
+            }
+            return total;
+        }
+
+    private:
+        bool nextChunk() {
+            // CRC of the finished chunk, then length and type of the next one
+            uint8_t header[12];
+            if (!reader.read(header, sizeof(header)) || std::memcmp(header + 8, "IDAT", 4) != 0) {
+                return false;
+            }
+            remaining = be32(header + 4);
+            return true;
+        }
+
+        FileReader& reader;
+        uint32_t remaining;
+        bool finished = false;
+    };
+
+    // Collects compressed data and emits it as IDAT chunks of a fixed size
+    class PngIdatOutputStream : public wxOutputStream {
+    public:
+        explicit PngIdatOutputStream(FileWriter& writer) : writer(writer) {}
+
+        void flushChunk() {
+            if (!chunk.empty()) {
+                writePngChunk(writer, "IDAT", chunk.data(), chunk.size());
+                chunk.clear();
+            }
+        }
+
+    protected:
+        size_t OnSysWrite(const void* buffer, size_t size) override {
+            const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+            chunk.insert(chunk.end(), bytes, bytes + size);
+            if (chunk.size() >= ChunkSize) {
+                flushChunk();
+            }
+            return size;
+        }
+
+    private:
+        static constexpr size_t ChunkSize = 64 * 1024;
+        FileWriter& writer;
+        std::vector<uint8_t> chunk;
+    };
+
+    bool readFully(wxInputStream& stream, uint8_t* buffer, size_t size) {
+        while (size > 0) {
+            stream.Read(buffer, size);
+            size_t count = stream.LastRead();
+            if (count == 0) {
+                return false;
+            }
+            buffer += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    uint8_t paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+        if (pb <= pc) return static_cast<uint8_t>(b);
+        return static_cast<uint8_t>(c);
+    }
+
+    bool unfilterPngRow(uint8_t filter, uint8_t* row, const uint8_t* previous, size_t size, size_t bpp) {
+        switch (filter) {
+            case 0:
+                break;
+            case 1:
+                for (size_t i = bpp; i < size; i++) row[i] += row[i - bpp];
+                break;
+            case 2:
+                for (size_t i = 0; i < size; i++) row[i] += previous[i];
+                break;
+            case 3:
+                for (size_t i = 0; i < size; i++) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    row[i] += static_cast<uint8_t>((left + previous[i]) / 2);
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < size; i++) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    int upLeft = i >= bpp ? previous[i - bpp] : 0;
+                    row[i] += paeth(left, previous[i], upLeft);
+                }
+                break;
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    // PCX scanline RLE: a byte with both top bits set is a run count (low 6 bits) for the next byte
+    void encodePcxLine(FileWriter& writer, const uint8_t* line, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            uint8_t value = line[i];
+            size_t run = 1;
+            while (i + run < size && run < 63 && line[i + run] == value) {
+                run++;
+            }
+            if (run > 1 || (value & 0xC0) == 0xC0) {
+                writer.writeByte(static_cast<uint8_t>(0xC0 | run));
+            }
+            writer.writeByte(value);
+            i += run;
+        }
+    }
+
+    // TGA RLE packets: high bit set is a run of one pixel, otherwise a literal span (both up to 128 pixels)
+    void encodeTgaRow(FileWriter& writer, const uint8_t* row, int width, int bytes) {
+        auto same = [&](int a, int b) { return std::memcmp(row + a * bytes, row + b * bytes, bytes) == 0; };
+        int x = 0;
+        while (x < width) {
+            int run = 1;
+            while (x + run < width && run < 128 && same(x, x + run)) {
+                run++;
+            }
+            if (run > 1) {
+                writer.writeByte(static_cast<uint8_t>(0x80 | (run - 1)));
+                writer.write(row + x * bytes, bytes);
+                x += run;
+                continue;
+            }
+            int literal = 1;
+            while (x + literal < width && literal < 128 &&
+                   !(x + literal + 1 < width && same(x + literal, x + literal + 1))) {
+                literal++;
+            }
+            writer.writeByte(static_cast<uint8_t>(literal - 1));
+            writer.write(row + x * bytes, static_cast<size_t>(literal) * bytes);
+            x += literal;
+        }
+    }
+}
+
+ImageCodec::Format ImageCodec::formatFromPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) {
+        return Format::Unknown;
+    }
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (ext == "pcx") return Format::PCX;
+    if (ext == "bmp") return Format::BMP;
+    if (ext == "tga") return Format::TGA;
+    if (ext == "png") return Format::PNG;
+    return Format::Unknown;
+}
+
+bool ImageCodec::readFile(const std::string& path, DecodedImage& image) {
+    PROFILE_SCOPE("ImageCodec::readFile");
+    switch (formatFromPath(path)) {
+        case Format::PCX: return readPCX(path, image);
+        case Format::BMP: return readBMP(path, image);
+        case Format::TGA: return readTGA(path, image);
+        case Format::PNG: return readPNG(path, image);
+        default: return false;
+    }
+}
+
+bool ImageCodec::writeFile(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette) {
+    PROFILE_SCOPE("ImageCodec::writeFile");
+    if (bitmap.bits != 8 && bitmap.bits != 24 && bitmap.bits != 32 && bitmap.bits != -32) {
+        logError("ImageCodec: unsupported color depth " + std::to_string(bitmap.bits) + " for " + path);
+        return false;
+    }
+    if (!validDimensions(bitmap.width, bitmap.height) ||
+        bitmap.data.size() < static_cast<size_t>(bitmap.width) * bitmap.height * bitmap.getBytesPerPixel()) {
+        logError("ImageCodec: invalid bitmap for " + path);
+        return false;
+    }
+    switch (formatFromPath(path)) {
+        case Format::PCX: return writePCX(path, bitmap, palette);
+        case Format::BMP: return writeBMP(path, bitmap, palette);
+        case Format::TGA: return writeTGA(path, bitmap, palette);
+        case Format::PNG: return writePNG(path, bitmap, palette);
+        default:
+            logError("ImageCodec: unsupported file type " + path);
+            return false;
+    }
+}
+
+bool ImageCodec::readPCX(const std::string& path, DecodedImage& image) {
+    FileReader reader(path);
+    uint8_t header[128];
+    if (!reader.isOpen() || !reader.read(header, sizeof(header))) {
+        logError("Failed to open PCX file: " + path);
+        return false;
+    }
+    if (header[0] != 0x0A || header[2] != 1) {
+        logDebug("ImageCodec: not an RLE PCX file: " + path);
+        return false;
+    }
+
+    int bitsPerPixel = header[3];
+    int width = le16(header + 8) - le16(header + 4) + 1;
+    int height = le16(header + 10) - le16(header + 6) + 1;
+    int planes = header[65];
+    int bytesPerLine = le16(header + 66);
+    if (bitsPerPixel != 8 || (planes != 1 && planes != 3 && planes != 4) ||
+        !validDimensions(width, height) || bytesPerLine < width) {
+        LOG_DEBUG("ImageCodec: unsupported PCX variant (%d bpp, %d planes)", bitsPerPixel, planes);
+        return false;
+    }
+
+    prepareBitmap(image, width, height, planes == 1 ? 8 : (planes == 3 ? 24 : -32));
+    if (planes == 1) {
+        // The 256 color palette trails the image data
+        uint64_t fileSize = reader.size();
+        uint8_t marker = 0;
+        if (fileSize < sizeof(header) + 769 || !reader.seek(fileSize - 769) || !reader.readByte(marker) ||
+            marker != 0x0C || !reader.read(image.palette.data(), 768) || !reader.seek(sizeof(header))) {
+            logDebug("ImageCodec: PCX file has no 256 color palette: " + path);
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> line(static_cast<size_t>(bytesPerLine) * planes);
+    int runCount = 0;
+    uint8_t runValue = 0;
+    for (int y = 0; y < height; y++) {
+        // Runs may carry over into the next scanline
+        size_t filled = 0;
+        while (filled < line.size()) {
+            if (runCount == 0) {
+                uint8_t value;
+                if (!reader.readByte(value)) {
+                    logError("Unexpected end of PCX data: " + path);
+                    return false;
+                }
+                if ((value & 0xC0) == 0xC0) {
+                    runCount = value & 0x3F;
+                    if (!reader.readByte(runValue)) {
+                        logError("Unexpected end of PCX data: " + path);
+                        return false;
+                    }
+                } else {
+                    runCount = 1;
+                    runValue = value;
+                }
+            }
+            size_t count = std::min(static_cast<size_t>(runCount), line.size() - filled);
+            std::memset(line.data() + filled, runValue, count);
+            filled += count;
+            runCount -= static_cast<int>(count);
+        }
+
+        uint8_t* dst = rowPointer(image.bitmap, y);
+        if (planes == 1) {
+            std::memcpy(dst, line.data(), width);
+        } else {
+            // Planar scanline (all red, then green, ...) to interleaved pixels
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < planes; c++) {
+                    dst[x * planes + c] = line[c * bytesPerLine + x];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool ImageCodec::writePCX(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette) {
+    FileWriter writer(path);
+    if (!writer.isOpen()) {
+        logError("Failed to create PCX file: " + path);
+        return false;
+    }
+
+    int width = bitmap.width;
+    int height = bitmap.height;
+    int planes = bitmap.bits == 8 ? 1 : 3;
+    int srcBytes = bitmap.getBytesPerPixel();
+    int bytesPerLine = (width + 1) & ~1;  // Scanlines are padded to an even size
+
+    uint8_t header[128] = {};
+    header[0] = 0x0A;  // Manufacturer
+    header[1] = 5;     // Version 3.0
+    header[2] = 1;     // RLE encoding
+    header[3] = 8;     // Bits per pixel per plane
+    storeLE16(header + 8, width - 1);
+    storeLE16(header + 10, height - 1);
+    storeLE16(header + 12, 72);
+    storeLE16(header + 14, 72);
+    if (planes == 1) {
+        for (int i = 0; i < 16; i++) {
+            paletteColor(palette, i, header + 16 + i * 3);
+        }
+    }
+    header[65] = static_cast<uint8_t>(planes);
+    storeLE16(header + 66, bytesPerLine);
+    storeLE16(header + 68, 1);  // Color palette
+    writer.write(header, sizeof(header));
+
+    std::vector<uint8_t> line(bytesPerLine, 0);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = rowPointer(bitmap, y);
+        for (int c = 0; c < planes; c++) {
+            for (int x = 0; x < width; x++) {
+                line[x] = src[x * srcBytes + c];
+            }
+            encodePcxLine(writer, line.data(), line.size());
+        }
+    }
+
+    if (planes == 1) {
+        writer.writeByte(0x0C);
+        for (int i = 0; i < 256; i++) {
+            uint8_t rgb[3];
+            paletteColor(palette, i, rgb);
+            writer.write(rgb, 3);
+        }
+    }
+
+    if (!writer.close()) {
+        logError("Failed to write PCX file: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool ImageCodec::readBMP(const std::string& path, DecodedImage& image) {
+    FileReader reader(path);
+    uint8_t fileHeader[14];
+    if (!reader.isOpen() || !reader.read(fileHeader, sizeof(fileHeader))) {
+        logError("Failed to open BMP file: " + path);
+        return false;
+    }
+    if (fileHeader[0] != 'B' || fileHeader[1] != 'M') {
+        logDebug("ImageCodec: not a BMP file: " + path);
+        return false;
+    }
+    uint32_t dataOffset = le32(fileHeader + 10);
+
+    uint8_t info[124] = {};
+    if (!reader.read(info, 4)) {
+        return false;
+    }
+    uint32_t infoSize = le32(info);
+    if (infoSize < 40) {
+        logDebug("ImageCodec: OS/2 BMP headers are not handled natively: " + path);
+        return false;
+    }
+    uint32_t storedSize = std::min<uint32_t>(infoSize, sizeof(info));
+    if (!reader.read(info + 4, storedSize - 4) || !reader.skip(infoSize - storedSize)) {
+        return false;
+    }
+
+    int width = static_cast<int32_t>(le32(info + 4));
+    int32_t rawHeight = static_cast<int32_t>(le32(info + 8));
+    bool topDown = rawHeight < 0;
+    int height = topDown ? -rawHeight : rawHeight;
+    int bitCount = le16(info + 14);
+    uint32_t compression = le32(info + 16);
+    uint32_t colorsUsed = le32(info + 32);
+    if (!validDimensions(width, height)) {
+        logError("Invalid BMP dimensions: " + path);
+        return false;
+    }
+
+    uint32_t redMask = 0x00FF0000, greenMask = 0x0000FF00, blueMask = 0x000000FF, alphaMask = 0;
+    if (compression == 3 || compression == 6) {
+        if (infoSize == 40) {
+            // Plain info header, the masks follow it
+            uint8_t masks[12];
+            if (!reader.read(masks, sizeof(masks))) {
+                return false;
+            }
+            std::memcpy(info + 40, masks, sizeof(masks));
+        }
+        redMask = le32(info + 40);
+        greenMask = le32(info + 44);
+        blueMask = le32(info + 48);
+        alphaMask = infoSize >= 56 ? le32(info + 52) : 0;
+    }
+
+    int bits;
+    if ((bitCount == 1 || bitCount == 4 || bitCount == 8) && compression == 0) {
+        bits = 8;
+    } else if (bitCount == 24 && compression == 0) {
+        bits = 24;
+    } else if (bitCount == 32 && (compression == 0 || compression == 3 || compression == 6) &&
+               redMask == 0x00FF0000 && greenMask == 0x0000FF00 && blueMask == 0x000000FF &&
+               (alphaMask == 0 || alphaMask == 0xFF000000)) {
+        bits = alphaMask ? -32 : 24;
+    } else {
+        LOG_DEBUG("ImageCodec: unsupported BMP variant (%d bpp, compression %u)", bitCount, compression);
+        return false;
+    }
+
+    prepareBitmap(image, width, height, bits);
+    if (bits == 8) {
+        uint32_t entries = colorsUsed ? std::min<uint32_t>(colorsUsed, 256) : (1u << bitCount);
+        std::vector<uint8_t> bgrx(entries * 4);
+        if (!reader.read(bgrx.data(), bgrx.size())) {
+            logError("Failed to read BMP palette: " + path);
+            return false;
+        }
+        for (uint32_t i = 0; i < entries; i++) {
+            image.palette[i * 3] = bgrx[i * 4 + 2];
+            image.palette[i * 3 + 1] = bgrx[i * 4 + 1];
+            image.palette[i * 3 + 2] = bgrx[i * 4];
+        }
+    }
+    if (!reader.seek(dataOffset)) {
+        return false;
+    }
+
+    size_t stride = ((static_cast<size_t>(width) * bitCount + 31) / 32) * 4;
+    std::vector<uint8_t> row(stride);
+    for (int i = 0; i < height; i++) {
+        if (!reader.read(row.data(), stride)) {
+            logError("Unexpected end of BMP data: " + path);
+            return false;
+        }
+        uint8_t* dst = rowPointer(image.bitmap, topDown ? i : height - 1 - i);
+        if (bitCount == 8) {
+            std::memcpy(dst, row.data(), width);
+        } else if (bitCount < 8) {
+            int mask = (1 << bitCount) - 1;
+            for (int x = 0; x < width; x++) {
+                int bit = x * bitCount;
+                dst[x] = (row[bit / 8] >> (8 - bitCount - bit % 8)) & mask;
+            }
+        } else {
+            swapRedBlue(row.data(), dst, width, bitCount / 8, image.bitmap.getBytesPerPixel());
+        }
+    }
+    return true;
+}
+
+bool ImageCodec::writeBMP(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette) {
+    FileWriter writer(path);
+    if (!writer.isOpen()) {
+        logError("Failed to create BMP file: " + path);
+        return false;
+    }
+
+    int width = bitmap.width;
+    int height = bitmap.height;
+    bool indexed = bitmap.bits == 8;
+    bool withAlpha = bitmap.bits == -32;
+    int bitCount = indexed ? 8 : (withAlpha ? 32 : 24);
+    // RGBA needs a V4 header to declare the alpha mask
+    uint32_t infoSize = withAlpha ? 108 : 40;
+    uint32_t paletteSize = indexed ? 256 * 4 : 0;
+    size_t stride = ((static_cast<size_t>(width) * bitCount + 31) / 32) * 4;
+    uint32_t dataOffset = 14 + infoSize + paletteSize;
+    uint32_t imageSize = static_cast<uint32_t>(stride * height);
+
+    uint8_t fileHeader[14] = {'B', 'M'};
+    storeLE32(fileHeader + 2, dataOffset + imageSize);
+    storeLE32(fileHeader + 10, dataOffset);
+    writer.write(fileHeader, sizeof(fileHeader));
+
+    uint8_t info[108] = {};
+    storeLE32(info, infoSize);
+    storeLE32(info + 4, width);
+    storeLE32(info + 8, height);  // Positive height, rows are stored bottom-up
+    storeLE16(info + 12, 1);
+    storeLE16(info + 14, bitCount);
+    storeLE32(info + 16, withAlpha ? 3 : 0);
+    storeLE32(info + 20, imageSize);
+    storeLE32(info + 24, 2835);  // 72 DPI
+    storeLE32(info + 28, 2835);
+    storeLE32(info + 32, indexed ? 256 : 0);
+    if (withAlpha) {
+        storeLE32(info + 40, 0x00FF0000);
+        storeLE32(info + 44, 0x0000FF00);
+        storeLE32(info + 48, 0x000000FF);
+        storeLE32(info + 52, 0xFF000000);
+        storeLE32(info + 56, 0x73524742);  // 'sRGB'
+    }
+    writer.write(info, infoSize);
+
+    if (indexed) {
+        for (int i = 0; i < 256; i++) {
+            uint8_t rgb[3];
+            paletteColor(palette, i, rgb);
+            uint8_t bgrx[4] = {rgb[2], rgb[1], rgb[0], 0};
+            writer.write(bgrx, 4);
+        }
+    }
+
+    int srcBytes = bitmap.getBytesPerPixel();
+    std::vector<uint8_t> row(stride, 0);
+    for (int i = 0; i < height; i++) {
+        const uint8_t* src = rowPointer(bitmap, height - 1 - i);
+        if (indexed) {
+            std::memcpy(row.data(), src, width);
+        } else {
+            // RGB(A) to BGR(A), the same swap in the other direction
+            swapRedBlue(src, row.data(), width, srcBytes, bitCount / 8);
+        }
+        writer.write(row.data(), stride);
+    }
+
+    if (!writer.close()) {
+        logError("Failed to write BMP file: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool ImageCodec::readTGA(const std::string& path, DecodedImage& image) {
+    FileReader reader(path);
+    uint8_t header[18];
+    if (!reader.isOpen() || !reader.read(header, sizeof(header))) {
+        logError("Failed to open TGA file: " + path);
+        return false;
+    }
+
+    int idLength = header[0];
+    int colorMapType = header[1];
+    int imageType = header[2];
+    int mapFirst = le16(header + 3);
+    int mapLength = le16(header + 5);
+    int mapEntryBits = header[7];
+    int width = le16(header + 12);
+    int height = le16(header + 14);
+    int depth = header[16];
+    int descriptor = header[17];
+
+    bool rle = imageType == 9 || imageType == 10;
+    int baseType = rle ? imageType - 8 : imageType;
+    int bits;
+    if (baseType == 1 && colorMapType == 1 && depth == 8 && mapFirst + mapLength <= 256 &&
+        (mapEntryBits == 15 || mapEntryBits == 16 || mapEntryBits == 24 || mapEntryBits == 32)) {
+        bits = 8;
+    } else if (baseType == 2 && (depth == 24 || depth == 32)) {
+        // 32-bit files without alpha bits in the descriptor carry an unused fourth byte
+        bits = (depth == 32 && (descriptor & 0x0F)) ? -32 : 24;
+    } else {
+        LOG_DEBUG("ImageCodec: unsupported TGA variant (type %d, %d bpp)", imageType, depth);
+        return false;
+    }
+    if ((descriptor & 0x10) || !validDimensions(width, height)) {
+        logDebug("ImageCodec: unsupported TGA layout: " + path);
+        return false;
+    }
+
+    prepareBitmap(image, width, height, bits);
+    if (!reader.skip(idLength)) {
+        return false;
+    }
+    if (colorMapType == 1) {
+        int entryBytes = (mapEntryBits + 7) / 8;
+        std::vector<uint8_t> map(static_cast<size_t>(mapLength) * entryBytes);
+        if (!reader.read(map.data(), map.size())) {
+            logError("Failed to read TGA color map: " + path);
+            return false;
+        }
+        for (int i = 0; bits == 8 && i < mapLength; i++) {
+            const uint8_t* entry = map.data() + i * entryBytes;
+            uint8_t* rgb = image.palette.data() + (mapFirst + i) * 3;
+            if (entryBytes == 2) {
+                uint16_t value = le16(entry);
+                rgb[0] = static_cast<uint8_t>(((value >> 10) & 0x1F) * 255 / 31);
+                rgb[1] = static_cast<uint8_t>(((value >> 5) & 0x1F) * 255 / 31);
+                rgb[2] = static_cast<uint8_t>((value & 0x1F) * 255 / 31);
+            } else {
+                rgb[0] = entry[2];
+                rgb[1] = entry[1];
+                rgb[2] = entry[0];
+            }
+        }
+    }
+
+    bool topDown = (descriptor & 0x20) != 0;
+    int srcBytes = depth / 8;
+    std::vector<uint8_t> row(static_cast<size_t>(width) * srcBytes);
+    // RLE packets may span scanlines, keep the packet state between rows
+    int packetLeft = 0;
+    bool packetIsRun = false;
+    uint8_t runPixel[4] = {};
+    for (int i = 0; i < height; i++) {
+        if (!rle) {
+            if (!reader.read(row.data(), row.size())) {
+                logError("Unexpected end of TGA data: " + path);
+                return false;
+            }
+        } else {
+            int x = 0;
+            while (x < width) {
+                if (packetLeft == 0) {
+                    uint8_t packet;
+                    if (!reader.readByte(packet) || ((packet & 0x80) && !reader.read(runPixel, srcBytes))) {
+                        logError("Unexpected end of TGA data: " + path);
+                        return false;
+                    }
+                    packetIsRun = (packet & 0x80) != 0;
+                    packetLeft = (packet & 0x7F) + 1;
+                }
+                int count = std::min(packetLeft, width - x);
+                if (packetIsRun) {
+                    for (int k = 0; k < count; k++) {
+                        std::memcpy(row.data() + (x + k) * srcBytes, runPixel, srcBytes);
+                    }
+                } else if (!reader.read(row.data() + x * srcBytes, static_cast<size_t>(count) * srcBytes)) {
+                    logError("Unexpected end of TGA data: " + path);
+                    return false;
+                }
+                x += count;
+                packetLeft -= count;
+            }
+        }
+
+        uint8_t* dst = rowPointer(image.bitmap, topDown ? i : height - 1 - i);
+        if (bits == 8) {
+            std::memcpy(dst, row.data(), width);
+        } else {
+            swapRedBlue(row.data(), dst, width, srcBytes, image.bitmap.getBytesPerPixel());
+        }
+    }
+    return true;
+}
+
+bool ImageCodec::writeTGA(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette) {
+    FileWriter writer(path);
+    if (!writer.isOpen()) {
+        logError("Failed to create TGA file: " + path);
+        return false;
+    }
+
+    int width = bitmap.width;
+    int height = bitmap.height;
+    bool indexed = bitmap.bits == 8;
+    bool withAlpha = bitmap.bits == -32;
+    int dstBytes = indexed ? 1 : (withAlpha ? 4 : 3);
+
+    // RLE compressed, rows stored top-down
+    uint8_t header[18] = {};
+    header[1] = indexed ? 1 : 0;
+    header[2] = indexed ? 9 : 10;
+    if (indexed) {
+        storeLE16(header + 5, 256);
+        header[7] = 24;
+    }
+    storeLE16(header + 12, width);
+    storeLE16(header + 14, height);
+    header[16] = static_cast<uint8_t>(dstBytes * 8);
+    header[17] = static_cast<uint8_t>(0x20 | (withAlpha ? 8 : 0));
+    writer.write(header, sizeof(header));
+
+    if (indexed) {
+        for (int i = 0; i < 256; i++) {
+            uint8_t rgb[3];
+            paletteColor(palette, i, rgb);
+            uint8_t bgr[3] = {rgb[2], rgb[1], rgb[0]};
+            writer.write(bgr, 3);
+        }
+    }
+
+    int srcBytes = bitmap.getBytesPerPixel();
+    std::vector<uint8_t> row(static_cast<size_t>(width) * dstBytes);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = rowPointer(bitmap, y);
+        if (indexed) {
+            std::memcpy(row.data(), src, width);
+        } else {
+            swapRedBlue(src, row.data(), width, srcBytes, dstBytes);
+        }
+        encodeTgaRow(writer, row.data(), width, dstBytes);
+    }
+
+    if (!writer.close()) {
+        logError("Failed to write TGA file: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool ImageCodec::readPNG(const std::string& path, DecodedImage& image) {
+    static const uint8_t signature[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+    FileReader reader(path);
+    uint8_t fileSignature[8];
+    if (!reader.isOpen() || !reader.read(fileSignature, sizeof(fileSignature))) {
+        logError("Failed to open PNG file: " + path);
+        return false;
+    }
+    if (std::memcmp(fileSignature, signature, sizeof(signature)) != 0) {
+        logDebug("ImageCodec: not a PNG file: " + path);
+        return false;
+    }
+
+    // Walk the chunks up to the first IDAT
+    int width = 0, height = 0, bitDepth = 0, colorType = -1, interlace = 0;
+    std::vector<uint8_t> plte;
+    std::vector<uint8_t> trns;
+    uint32_t firstIdatLength = 0;
+    while (true) {
+        uint8_t chunkHeader[8];
+        if (!reader.read(chunkHeader, sizeof(chunkHeader))) {
+            logError("Unexpected end of PNG file: " + path);
+            return false;
+        }
+        uint32_t length = be32(chunkHeader);
+        const uint8_t* type = chunkHeader + 4;
+        if (std::memcmp(type, "IDAT", 4) == 0) {
+            firstIdatLength = length;
+            break;
+        }
+        if (std::memcmp(type, "IEND", 4) == 0) {
+            logError("PNG file has no image data: " + path);
+            return false;
+        }
+        if (std::memcmp(type, "IHDR", 4) == 0 || std::memcmp(type, "PLTE", 4) == 0 || std::memcmp(type, "tRNS", 4) == 0) {
+            if (length > 1024) {
+                return false;
+            }
+            std::vector<uint8_t> payload(length);
+            if (!reader.read(payload.data(), length) || !reader.skip(4)) {
+                return false;
+            }
+            if (type[0] == 'I') {
+                if (length < 13) {
+                    return false;
+                }
+                width = static_cast<int>(be32(payload.data()));
+                height = static_cast<int>(be32(payload.data() + 4));
+                bitDepth = payload[8];
+                colorType = payload[9];
+                interlace = payload[12];
+            } else if (type[0] == 'P') {
+                plte = std::move(payload);
+            } else {
+                trns = std::move(payload);
+            }
+        } else if (!reader.skip(static_cast<size_t>(length) + 4)) {
+            return false;
+        }
+    }
+
+    bool indexed = colorType == 3 && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8);
+    bool truecolor = (colorType == 2 || colorType == 6) && bitDepth == 8;
+    if ((!indexed && !truecolor) || interlace != 0 || !validDimensions(width, height)) {
+        LOG_DEBUG("ImageCodec: unsupported PNG variant (color type %d, depth %d, interlace %d)", colorType, bitDepth, interlace);
+        return false;
+    }
+
+    // A tRNS color key makes an RGB image transparent wherever that color is, it is decoded with alpha
+    bool colorKey = colorType == 2 && trns.size() >= 6;
+    uint8_t key[3] = {};
+    if (colorKey) {
+        if (trns[0] != 0 || trns[2] != 0 || trns[4] != 0) {
+            colorKey = false;   // Samples above 255 never match an 8-bit pixel
+        }
+        key[0] = trns[1];
+        key[1] = trns[3];
+        key[2] = trns[5];
+    }
+    prepareBitmap(image, width, height, indexed ? 8 : (colorType == 6 || colorKey ? -32 : 24));
+    if (indexed) {
+        std::memcpy(image.palette.data(), plte.data(), std::min<size_t>(plte.size(), 768));
+        image.paletteHasAlpha = std::any_of(trns.begin(), trns.end(), [](uint8_t a) { return a != 255; });
+    }
+
+    int channels = indexed ? 1 : (colorType == 6 ? 4 : 3);
+    size_t bitsPerPixel = static_cast<size_t>(channels) * bitDepth;
+    size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+    size_t filterBytes = std::max<size_t>(1, bitsPerPixel / 8);
+
+    PngIdatInputStream idat(reader, firstIdatLength);
+    wxZlibInputStream zlib(idat, wxZLIB_ZLIB);
+    std::vector<uint8_t> previous(rowBytes, 0);
+    std::vector<uint8_t> current(rowBytes + 1);
+    for (int y = 0; y < height; y++) {
+        if (!readFully(zlib, current.data(), current.size()) ||
+            !unfilterPngRow(current[0], current.data() + 1, previous.data(), rowBytes, filterBytes)) {
+            logError("Corrupt PNG image data: " + path);
+            return false;
+        }
+        const uint8_t* src = current.data() + 1;
+        uint8_t* dst = rowPointer(image.bitmap, y);
+        if (colorKey) {
+            for (int x = 0; x < width; x++, src += 3, dst += 4) {
+                std::memcpy(dst, src, 3);
+                dst[3] = std::memcmp(src, key, 3) == 0 ? 0 : 255;
+            }
+        } else if (bitDepth == 8) {
+            std::memcpy(dst, src, rowBytes);
+        } else {
+            int mask = (1 << bitDepth) - 1;
+            for (int x = 0; x < width; x++) {
+                int bit = x * bitDepth;
+                dst[x] = (src[bit / 8] >> (8 - bitDepth - bit % 8)) & mask;
+            }
+        }
+        std::copy(current.begin() + 1, current.end(), previous.begin());
+    }
+    return true;
+}
+
+bool ImageCodec::writePNG(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette) {
+    static const uint8_t signature[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+    FileWriter writer(path);
+    if (!writer.isOpen()) {
+        logError("Failed to create PNG file: " + path);
+        return false;
+    }
+
+    int width = bitmap.width;
+    int height = bitmap.height;
+    bool indexed = bitmap.bits == 8;
+    bool withAlpha = bitmap.bits == -32;
+    int channels = indexed ? 1 : (withAlpha ? 4 : 3);
+
+    writer.write(signature, sizeof(signature));
+    uint8_t ihdr[13] = {};
+    storeBE32(ihdr, width);
+    storeBE32(ihdr + 4, height);
+    ihdr[8] = 8;
+    ihdr[9] = indexed ? 3 : (withAlpha ? 6 : 2);
+    writePngChunk(writer, "IHDR", ihdr, sizeof(ihdr));
+
+    if (indexed) {
+        std::vector<uint8_t> plte(768);
+        for (int i = 0; i < 256; i++) {
+            paletteColor(palette, i, plte.data() + i * 3);
+        }
+        writePngChunk(writer, "PLTE", plte.data(), plte.size());
+    }
+
+    {
+        PngIdatOutputStream idat(writer);
+        wxZlibOutputStream zlib(idat, -1, wxZLIB_ZLIB);
+        size_t rowBytes = static_cast<size_t>(width) * channels;
+        std::vector<uint8_t> row(rowBytes + 1);
+        for (int y = 0; y < height; y++) {
+            const uint8_t* src = rowPointer(bitmap, y);
+            uint8_t* dst = row.data() + 1;
+            std::memcpy(dst, src, rowBytes);
+            if (indexed) {
+                row[0] = 0;  // Filters rarely help paletted images
+            } else {
+                // Sub filter: difference to the pixel on the left
+                row[0] = 1;
+                for (size_t i = rowBytes; i-- > static_cast<size_t>(channels);) {
+                    dst[i] = static_cast<uint8_t>(dst[i] - dst[i - channels]);
+                }
+            }
+            zlib.Write(row.data(), row.size());
+        }
+        if (!zlib.Close()) {
+            logError("Failed to compress PNG data: " + path);
+            return false;
+        }
+        idat.flushChunk();
+    }
+    writePngChunk(writer, "IEND", nullptr, 0);
+
+    if (!writer.close()) {
+        logError("Failed to write PNG file: " + path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,214 @@
+#include "../include/ImagePreviewCanvas.h"
+#include "../include/log.h"
+#include <wx/dcbuffer.h>
+#include <algorithm>
+
+wxBEGIN_EVENT_TABLE(ImagePreviewCanvas, wxScrolledCanvas)
+    EVT_PAINT(ImagePreviewCanvas::OnPaint)
+    EVT_SIZE(ImagePreviewCanvas::OnSize)
+wxEND_EVENT_TABLE()
+
+ImagePreviewCanvas::ImagePreviewCanvas(wxWindow* parent, wxWindowID id)
+    : wxScrolledCanvas(parent, id, wxDefaultPosition, wxDefaultSize, wxHSCROLL | wxVSCROLL | wxFULL_REPAINT_ON_RESIZE)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT); // Needed for double buffering
+    SetScrollRate(10, 10); // Enable scrolling with 10 pixel steps
+}
+
+void ImagePreviewCanvas::SetImage(const wxImage& image, bool addBorder) {
+    m_mipLevels.clear();
+    m_addBorder = addBorder;
+    if (image.IsOk()) {
+        m_mipLevels.push_back(image.Copy());
+        // The bordered preview used to be pasted onto an opaque image, keep showing it opaque
+        if (addBorder && m_mipLevels[0].HasAlpha()) {
+            m_mipLevels[0].ClearAlpha();
+        }
+    }
+    InvalidateTiles();
+    UpdateVirtualSize();
+    Refresh();
+}
+
+void ImagePreviewCanvas::SetZoom(double zoomLevel) {
+    if (zoomLevel <= 0 || zoomLevel == m_zoom) {
+        return;
+    }
+    m_zoom = zoomLevel;
+    InvalidateTiles();
+    UpdateVirtualSize();
+    Refresh();
+}
+
+void ImagePreviewCanvas::ClearImage() {
+    SetImage(wxImage());
+}
+
+void ImagePreviewCanvas::UpdateVirtualSize() {
+    if (m_mipLevels.empty()) {
+        m_scaledWidth = 0;
+        m_scaledHeight = 0;
+        SetVirtualSize(0, 0);
+        return;
+    }
+
+    // Same rounding as wxImage::Scale used before, never collapse to nothing
+    m_scaledWidth = std::max(1, static_cast<int>(m_mipLevels[0].GetWidth() * m_zoom));
+    m_scaledHeight = std::max(1, static_cast<int>(m_mipLevels[0].GetHeight() * m_zoom));
+    int border = m_addBorder ? 1 : 0;
+    SetVirtualSize(m_scaledWidth + 2 * (border + Margin), m_scaledHeight + 2 * (border + Margin));
+}
+
+void ImagePreviewCanvas::InvalidateTiles() {
+    m_tiles.clear();
+    m_tileOrder.clear();
+}
+
+void ImagePreviewCanvas::UpdateTileCapacity() {
+    // Enough tiles to cover the window twice, so scrolling back and forth stays cached
+    wxSize client = GetClientSize();
+    size_t across = client.GetWidth() / TileSize + 2;
+    size_t down = client.GetHeight() / TileSize + 2;
+    m_tileCapacity = std::max<size_t>(4, across * down * 2);
+    while (m_tileOrder.size() > m_tileCapacity) {
+        m_tiles.erase(m_tileOrder.back());
+        m_tileOrder.pop_back();
+    }
+}
+
+void ImagePreviewCanvas::OnSize(wxSizeEvent& event) {
+    UpdateTileCapacity();
+    event.Skip();
+}
+
+int ImagePreviewCanvas::SelectMipLevel() {
+    // Pick the smallest level that is still at least as large as the zoomed image
+    int level = 0;
+    double levelZoom = m_zoom;
+    while (levelZoom * 2 <= 1.0) {
+        const wxImage& current = m_mipLevels[level];
+        if (current.GetWidth() < 2 || current.GetHeight() < 2) {
+            break;
+        }
+        if (level + 1 >= static_cast<int>(m_mipLevels.size())) {
+            m_mipLevels.push_back(current.ShrinkBy(2, 2));
+        }
+        level++;
+        levelZoom *= 2;
+    }
+    return level;
+}
+
+wxImage ImagePreviewCanvas::RenderTile(int tileX, int tileY) {
+    PROFILE_SCOPE("ImagePreviewCanvas::RenderTile");
+    int level = SelectMipLevel();
+    const wxImage& source = m_mipLevels[level];
+    int srcWidth = source.GetWidth();
+    int srcHeight = source.GetHeight();
+    const unsigned char* srcRGB = source.GetData();
+    const unsigned char* srcAlpha = source.HasAlpha() ? source.GetAlpha() : nullptr;
+
+    int x0 = tileX * TileSize;
+    int y0 = tileY * TileSize;
+    int tileWidth = std::min(TileSize, m_scaledWidth - x0);
+    int tileHeight = std::min(TileSize, m_scaledHeight - y0);
+
+    // Map every destination column and row to its nearest source pixel once
+    std::vector<int> srcColumns(tileWidth);
+    for (int x = 0; x < tileWidth; x++) {
+        srcColumns[x] = std::min(srcWidth - 1, static_cast<int>(static_cast<int64_t>(x0 + x) * srcWidth / m_scaledWidth));
+    }
+
+    wxImage tile(tileWidth, tileHeight, false);
+    unsigned char* dstRGB = tile.GetData();
+    unsigned char* dstAlpha = nullptr;
+    if (srcAlpha) {
+        tile.SetAlpha();
+        dstAlpha = tile.GetAlpha();
+    }
+
+    int previousRow = -1;
+    for (int y = 0; y < tileHeight; y++) {
+        int srcY = std::min(srcHeight - 1, static_cast<int>(static_cast<int64_t>(y0 + y) * srcHeight / m_scaledHeight));
+        unsigned char* dstRow = dstRGB + static_cast<size_t>(y) * tileWidth * 3;
+        unsigned char* dstAlphaRow = dstAlpha ? dstAlpha + static_cast<size_t>(y) * tileWidth : nullptr;
+        if (srcY == previousRow) {
+            // Magnified rows repeat, copy the row we just produced
+            std::copy(dstRow - tileWidth * 3, dstRow, dstRow);
+            if (dstAlphaRow) {
+                std::copy(dstAlphaRow - tileWidth, dstAlphaRow, dstAlphaRow);
+            }
+            continue;
+        }
+        previousRow = srcY;
+
+        const unsigned char* srcRow = srcRGB + static_cast<size_t>(srcY) * srcWidth * 3;
+        for (int x = 0; x < tileWidth; x++) {
+            const unsigned char* pixel = srcRow + srcColumns[x] * 3;
+            dstRow[x * 3] = pixel[0];
+            dstRow[x * 3 + 1] = pixel[1];
+            dstRow[x * 3 + 2] = pixel[2];
+        }
+        if (dstAlphaRow) {
+            const unsigned char* srcAlphaRow = srcAlpha + static_cast<size_t>(srcY) * srcWidth;
+            for (int x = 0; x < tileWidth; x++) {
+                dstAlphaRow[x] = srcAlphaRow[srcColumns[x]];
+            }
+        }
+    }
+    return tile;
+}
+
+const wxBitmap& ImagePreviewCanvas::GetTile(int tileX, int tileY) {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(tileY)) << 32) | static_cast<uint32_t>(tileX);
+    auto it = m_tiles.find(key);
+    if (it != m_tiles.end()) {
+        m_tileOrder.splice(m_tileOrder.begin(), m_tileOrder, it->second.second);
+        return it->second.first;
+    }
+
+    while (m_tileOrder.size() >= m_tileCapacity) {
+        m_tiles.erase(m_tileOrder.back());
+        m_tileOrder.pop_back();
+    }
+    m_tileOrder.push_front(key);
+    auto inserted = m_tiles.emplace(key, std::make_pair(wxBitmap(RenderTile(tileX, tileY)), m_tileOrder.begin()));
+    return inserted.first->second.first;
+}
+
+void ImagePreviewCanvas::OnPaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(this);
+    DoPrepareDC(dc);
+    dc.SetBackground(wxBrush(GetBackgroundColour()));
+    dc.Clear();
+    if (m_mipLevels.empty()) {
+        return;
+    }
+
+    int border = m_addBorder ? 1 : 0;
+    wxRect imageRect(Margin + border, Margin + border, m_scaledWidth, m_scaledHeight);
+    if (m_addBorder) {
+        // 1-pixel black frame around the image
+        dc.SetPen(*wxBLACK_PEN);
+        dc.SetBrush(*wxTRANSPARENT_BRUSH);
+        dc.DrawRectangle(imageRect.x - 1, imageRect.y - 1, imageRect.width + 2, imageRect.height + 2);
+    }
+
+    // Only the part of the image inside the viewport is drawn
+    wxRect view(CalcUnscrolledPosition(wxPoint(0, 0)), GetClientSize());
+    wxRect visible = view.Intersect(imageRect);
+    if (visible.IsEmpty()) {
+        return;
+    }
+
+    int firstTileX = (visible.x - imageRect.x) / TileSize;
+    int firstTileY = (visible.y - imageRect.y) / TileSize;
+    int lastTileX = (visible.GetRight() - imageRect.x) / TileSize;
+    int lastTileY = (visible.GetBottom() - imageRect.y) / TileSize;
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            const wxBitmap& tile = GetTile(tileX, tileY);
+            dc.DrawBitmap(tile, imageRect.x + tileX * TileSize, imageRect.y + tileY * TileSize, true);
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#include "../include/MidiSequence.h"
+#include "../include/log.h"
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t DefaultTempo = 500000;  // Microseconds per quarter note, 120 BPM
+
+    bool readVarLen(const std::vector<uint8_t>& data, size_t& pos, uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            if (pos >= data.size()) {
+                return false;
+            }
+            uint8_t byte = data[pos++];
+            value = (value << 7) | (byte & 0x7F);
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;  // More than four bytes is not a valid quantity
+    }
+}
+
+bool MidiSequence::parseTrack(const std::vector<uint8_t>& data, uint8_t track, uint32_t& endTick,
+                              std::vector<std::pair<uint32_t, uint32_t>>& tempos) {
+    TrackInfo& info = tracks[track];
+    size_t pos = 0;
+    uint32_t tick = 0;
+    uint8_t runningStatus = 0;
+    while (pos < data.size()) {
+        uint32_t delta;
+        if (!readVarLen(data, pos, delta) || pos >= data.size()) {
+            break;
+        }
+        tick += delta;
+
+        uint8_t status = data[pos];
+        if (status < 0x80) {
+            if (runningStatus == 0) {
+                logWarning("MIDI track " + std::to_string(track) + ": data byte without a status");
+                return false;
+            }
+            status = runningStatus;
+        } else {
+            pos++;
+        }
+
+        if (status == 0xFF) {
+            runningStatus = 0;  // Meta and SysEx events cancel running status
+            if (pos >= data.size()) {
+                break;
+            }
+            uint8_t metaType = data[pos++];
+            uint32_t length;
+            if (!readVarLen(data, pos, length) || pos + length > data.size()) {
+                break;
+            }
+            if (metaType == 0x51 && length == 3) {
+                tempos.emplace_back(tick, (data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]);
+            } else if (metaType == 0x03 && info.name.empty()) {
+                info.name.assign(data.begin() + pos, data.begin() + pos + length);
+            }
+            pos += length;
+            if (metaType == 0x2F) {
+                break;  // End of track
+            }
+        } else if (status == 0xF0 || status == 0xF7) {
+            runningStatus = 0;
+            uint32_t length;
+            if (!readVarLen(data, pos, length) || pos + length > data.size()) {
+                break;
+            }
+            pos += length;
+        } else if (status >= 0xF0) {
+            // System common and realtime messages do not belong in files, skip their data
+            pos += status == 0xF2 ? 2 : (status == 0xF1 || status == 0xF3) ? 1 : 0;
+        } else {
+            runningStatus = status;
+            int command = status & 0xF0;
+            int dataLength = (command == 0xC0 || command == 0xD0) ? 1 : 2;
+            if (pos + dataLength > data.size()) {
+                break;
+            }
+            Event event;
+            event.tick = tick;
+            event.track = track;
+            event.status = status;
+            event.data1 = data[pos] & 0x7F;
+            event.data2 = dataLength == 2 ? data[pos + 1] & 0x7F : 0;
+            pos += dataLength;
+            events.push_back(event);
+
+            int channel = event.channel();
+            info.eventCount++;
+            info.channelMask |= 1 << channel;
+            channels[channel].trackMask |= 1u << track;
+            if (event.isNoteOn()) {
+                info.noteCount++;
+                channels[channel].noteCount++;
+                channels[channel].lowestNote = std::min(channels[channel].lowestNote, event.data1);
+                channels[channel].highestNote = std::max(channels[channel].highestNote, event.data1);
+            } else if (command == 0xC0 && channels[channel].firstProgram < 0) {
+                channels[channel].firstProgram = event.data1;
+            }
+        }
+    }
+    endTick = tick;
+    return true;
+}
+
+bool MidiSequence::parse(const AudioData& audio) {
+    events.clear();
+    tempoMap.clear();
+    checkpoints.clear();
+    tracks.assign(audio.midiTracks.size(), TrackInfo());
+    channels.fill(ChannelInfo());
+    durationUs = 0;
+    if (audio.typeID != ObjectType::DAT_MIDI || audio.midiDivisions == 0) {
+        return false;
+    }
+
+    if (audio.midiDivisions & 0x8000) {
+        // SMPTE: frames per second in the negated high byte, ticks per frame in the low byte
+        int framesPerSecond = -static_cast<int8_t>(audio.midiDivisions >> 8);
+        int ticksPerFrame = audio.midiDivisions & 0xFF;
+        if (framesPerSecond <= 0 || ticksPerFrame == 0) {
+            logError("Invalid SMPTE MIDI division");
+            return false;
+        }
+        smpteUsPerTick = 1000000.0 / (framesPerSecond * ticksPerFrame);
+    } else {
+        ticksPerQuarter = audio.midiDivisions;
+        smpteUsPerTick = 0.0;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> tempos;
+    uint32_t lastTick = 0;
+    for (size_t track = 0; track < audio.midiTracks.size(); track++) {
+        uint32_t endTick = 0;
+        if (!parseTrack(audio.midiTracks[track].data, static_cast<uint8_t>(track), endTick, tempos)) {
+            events.clear();
+            return false;
+        }
+        lastTick = std::max(lastTick, endTick);
+    }
+
+    // Tempo map, a later change at the same tick wins
+    std::stable_sort(tempos.begin(), tempos.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    tempoMap.push_back(TempoChange{0, 0, DefaultTempo});
+    for (const auto& tempo : tempos) {
+        TempoChange& last = tempoMap.back();
+        if (tempo.first == last.tick) {
+            last.microsPerQuarter = tempo.second;
+            continue;
+        }
+        int64_t timeUs = last.timeUs + static_cast<int64_t>(tempo.first - last.tick) * last.microsPerQuarter / ticksPerQuarter;
+        tempoMap.push_back(TempoChange{tempo.first, timeUs, tempo.second});
+    }
+
+    // Merge the tracks. Events of one tick keep their track order, so note offs
+    // written before note ons in a track still come first.
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.tick < b.tick; });
+    for (Event& event : events) {
+        event.timeUs = tickToUs(event.tick);
+    }
+    durationUs = tickToUs(lastTick);
+
+    ChannelStates states;
+    checkpoints.reserve(events.size() / CheckpointInterval + 1);
+    for (size_t i = 0; i < events.size(); i++) {
+        if (i % CheckpointInterval == 0) {
+            checkpoints.push_back(states);
+        }
+        applyEvent(events[i], states);
+    }
+    return true;
+}
+
+int64_t MidiSequence::tickToUs(uint32_t tick) const {
+    if (smpteUsPerTick > 0.0) {
+        return static_cast<int64_t>(tick * smpteUsPerTick);
+    }
+    if (tempoMap.empty()) {
+        return static_cast<int64_t>(tick) * DefaultTempo / ticksPerQuarter;
+    }
+    auto it = std::upper_bound(tempoMap.begin(), tempoMap.end(), tick,
+                               [](uint32_t value, const TempoChange& change) { return value < change.tick; });
+    const TempoChange& change = *(it - 1);
+    return change.timeUs + static_cast<int64_t>(tick - change.tick) * change.microsPerQuarter / ticksPerQuarter;
+}
+
+size_t MidiSequence::findEvent(int64_t timeUs) const {
+    auto it = std::lower_bound(events.begin(), events.end(), timeUs,
+                               [](const Event& event, int64_t value) { return event.timeUs < value; });
+    return static_cast<size_t>(it - events.begin());
+}
+
+MidiSequence::ChannelStates MidiSequence::stateBefore(size_t eventIndex) const {
+    eventIndex = std::min(eventIndex, events.size());
+    if (checkpoints.empty()) {
+        return ChannelStates();
+    }
+    size_t checkpoint = std::min(eventIndex / CheckpointInterval, checkpoints.size() - 1);
+    ChannelStates states = checkpoints[checkpoint];
+    for (size_t i = checkpoint * CheckpointInterval; i < eventIndex; i++) {
+        applyEvent(events[i], states);
+    }
+    return states;
+}
+
+void MidiSequence::applyEvent(const Event& event, ChannelStates& states) {
+    ChannelState& state = states[event.channel()];
+    switch (event.command()) {
+        case 0x80:
+        case 0x90:
+            state.notes[event.data1] = event.isNoteOn();
+            break;
+        case 0xC0:
+            state.program = event.data1;
+            break;
+        case 0xE0:
+            state.pitchBend = static_cast<int16_t>(((event.data2 << 7) | event.data1) - 8192);
+            break;
+        case 0xB0:
+            switch (event.data1) {
+                case 6:     // Data entry, only the pitch bend range RPN is used
+                    if (state.rpnMsb == 0 && state.rpnLsb == 0) {
+                        state.bendRange = std::min<uint8_t>(event.data2, 24);
+                    }
+                    break;
+                case 7:   state.volume = event.data2; break;
+                case 10:  state.pan = event.data2; break;
+                case 11:  state.expression = event.data2; break;
+                case 64:  state.sustain = event.data2 >= 64; break;
+                case 100: state.rpnLsb = event.data2; break;
+                case 101: state.rpnMsb = event.data2; break;
+                case 121:   // Reset all controllers
+                    state.expression = 127;
+                    state.sustain = false;
+                    state.pitchBend = 0;
+                    state.rpnMsb = state.rpnLsb = 127;
+                    break;
+                case 123:   // All notes off
+                    state.notes.reset();
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
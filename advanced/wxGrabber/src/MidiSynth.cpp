@@ -0,0 +1,318 @@
+#include "../include/MidiSynth.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr double Pi = 3.14159265358979323846;
+    constexpr float MasterGain = 0.3f;
+    constexpr float SilentLevel = 1e-4f;
+    constexpr double MaxIncrement = 0.45;  // Keep bent notes below Nyquist
+
+    double noteFrequency(int note) {
+        return 440.0 * std::pow(2.0, (note - 69) / 12.0);
+    }
+
+    // Per sample factor that scales a level by ratio over the given time
+    float factorOver(float ratio, float seconds, int sampleRate) {
+        return static_cast<float>(std::exp(std::log(ratio) / std::max(seconds * sampleRate, 1.0f)));
+    }
+
+    // Polynomial correction around a discontinuity, removes most aliasing of saw and square
+    double polyBlep(double t, double dt) {
+        if (t < dt) {
+            t /= dt;
+            return t + t - t * t - 1.0;
+        }
+        if (t > 1.0 - dt) {
+            t = (t - 1.0) / dt;
+            return t * t + t + t + 1.0;
+        }
+        return 0.0;
+    }
+}
+
+MidiSynth::MidiSynth(int sampleRate)
+    : sampleRate(std::max(sampleRate, 1)) {
+}
+
+const MidiSynth::Patch& MidiSynth::patchFor(uint8_t program) {
+    // One patch per General MIDI family of eight programs
+    static const Patch patches[16] = {
+        {Wave::Triangle, 0.002f, 1.5f, 0.0f, 0.3f},   // Piano
+        {Wave::Sine,     0.001f, 0.8f, 0.0f, 0.3f},   // Chromatic percussion
+        {Wave::Square,   0.005f, 0.1f, 0.8f, 0.08f},  // Organ
+        {Wave::Saw,      0.002f, 1.2f, 0.0f, 0.2f},   // Guitar
+        {Wave::Triangle, 0.003f, 1.0f, 0.3f, 0.1f},   // Bass
+        {Wave::Saw,      0.08f,  1.0f, 0.8f, 0.3f},   // Strings
+        {Wave::Saw,      0.1f,   1.0f, 0.8f, 0.4f},   // Ensemble
+        {Wave::Saw,      0.03f,  0.5f, 0.7f, 0.15f},  // Brass
+        {Wave::Square,   0.02f,  0.5f, 0.7f, 0.1f},   // Reed
+        {Wave::Sine,     0.03f,  0.5f, 0.8f, 0.15f},  // Pipe
+        {Wave::Square,   0.005f, 0.3f, 0.7f, 0.1f},   // Synth lead
+        {Wave::Triangle, 0.3f,   2.0f, 0.8f, 0.8f},   // Synth pad
+        {Wave::Triangle, 0.1f,   2.0f, 0.5f, 0.6f},   // Synth effects
+        {Wave::Saw,      0.002f, 1.0f, 0.0f, 0.2f},   // Ethnic
+        {Wave::Sine,     0.001f, 0.4f, 0.0f, 0.1f},   // Percussive
+        {Wave::Noise,    0.01f,  0.5f, 0.3f, 0.3f},   // Sound effects
+    };
+    return patches[(program & 0x7F) / 8];
+}
+
+float MidiSynth::nextNoise() {
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (noiseState >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+void MidiSynth::reset(const MidiSequence::ChannelStates& channelStates) {
+    for (Voice& voice : voices) {
+        voice.active = false;
+    }
+    states = channelStates;
+    for (int channel = 0; channel < 16; channel++) {
+        if (channel == MidiSequence::PercussionChannel) {
+            continue;
+        }
+        for (int note = 0; note < 128; note++) {
+            if (states[channel].notes[note]) {
+                noteOn(static_cast<uint8_t>(channel), static_cast<uint8_t>(note), 90);
+            }
+        }
+    }
+}
+
+void MidiSynth::handle(const MidiSequence::Event& event) {
+    MidiSequence::applyEvent(event, states);
+    uint8_t channel = static_cast<uint8_t>(event.channel());
+    if (event.isNoteOn()) {
+        noteOn(channel, event.data1, event.data2);
+    } else if (event.isNoteOff()) {
+        noteOff(channel, event.data1);
+    } else if (event.command() == 0xB0) {
+        if (event.data1 == 64 && !states[channel].sustain) {
+            releaseSustained(channel);
+        } else if (event.data1 == 120) {   // All sound off
+            for (Voice& voice : voices) {
+                voice.active = voice.active && voice.channel != channel;
+            }
+        } else if (event.data1 == 123) {   // All notes off
+            for (Voice& voice : voices) {
+                if (voice.active && voice.channel == channel && !voice.drum) {
+                    voice.released = true;
+                }
+            }
+        }
+    }
+}
+
+MidiSynth::Voice& MidiSynth::allocateVoice() {
+    Voice* best = nullptr;
+    for (Voice& voice : voices) {
+        if (!voice.active) {
+            return voice;
+        }
+        // Steal the quietest released voice, else the oldest
+        if (!best || (voice.released && (!best->released || voice.level < best->level)) ||
+            (!voice.released && !best->released && voice.age < best->age)) {
+            best = &voice;
+        }
+    }
+    return *best;
+}
+
+void MidiSynth::noteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
+    // A repeated key ends the note it interrupts
+    for (Voice& voice : voices) {
+        if (voice.active && voice.channel == channel && voice.note == note && !voice.released) {
+            voice.released = true;
+            voice.sustained = false;
+        }
+    }
+
+    Voice& voice = allocateVoice();
+    voice = Voice();
+    voice.active = true;
+    voice.channel = channel;
+    voice.note = note;
+    voice.age = nextAge++;
+    voice.gain = velocity / 127.0f;
+    voice.attacking = true;
+
+    if (channel == MidiSequence::PercussionChannel) {
+        startDrum(voice, note);
+        return;
+    }
+    const Patch& patch = patchFor(states[channel].program);
+    voice.wave = patch.wave;
+    voice.increment = noteFrequency(note) / sampleRate;
+    voice.attackStep = 1.0f / std::max(patch.attack * sampleRate, 1.0f);
+    voice.sustainLevel = patch.sustain;
+    voice.decayFactor = factorOver(0.001f, patch.decay, sampleRate);
+    voice.releaseFactor = factorOver(0.001f, patch.release, sampleRate);
+    if (patch.wave == Wave::Saw || patch.wave == Wave::Square) {
+        voice.gain *= 0.5f;  // Rich waveforms sound louder at the same peak
+    }
+}
+
+void MidiSynth::startDrum(Voice& voice, uint8_t note) {
+    voice.drum = true;
+    voice.wave = Wave::Sine;
+    voice.attackStep = 1.0f / std::max(0.001f * sampleRate, 1.0f);
+    voice.sustainLevel = 0.0f;
+    float decay = 0.1f;
+    double frequency = noteFrequency(note);
+    switch (note) {
+        case 35: case 36:                               // Bass drum
+            frequency = 120.0;
+            voice.sweepFactor = factorOver(0.375f, 0.08f, sampleRate);
+            voice.noiseMix = 0.05f;
+            decay = 0.35f;
+            break;
+        case 37: case 38: case 39: case 40:             // Snare, side stick, clap
+            frequency = 200.0;
+            voice.sweepFactor = factorOver(0.8f, 0.1f, sampleRate);
+            voice.noiseMix = 0.6f;
+            decay = 0.2f;
+            break;
+        case 41: case 43: case 45: case 47: case 48: case 50:  // Toms
+            voice.sweepFactor = factorOver(0.7f, 0.15f, sampleRate);
+            voice.noiseMix = 0.1f;
+            decay = 0.4f;
+            break;
+        case 42: case 44:                               // Closed and pedal hi-hat
+            voice.noiseMix = 1.0f;
+            voice.bright = true;
+            decay = 0.06f;
+            break;
+        case 46:                                        // Open hi-hat
+            voice.noiseMix = 1.0f;
+            voice.bright = true;
+            decay = 0.4f;
+            break;
+        case 49: case 52: case 55: case 57:             // Crash, china, splash
+            voice.noiseMix = 1.0f;
+            voice.bright = true;
+            decay = 1.2f;
+            break;
+        case 51: case 53: case 59:                      // Ride
+            voice.noiseMix = 0.8f;
+            voice.bright = true;
+            decay = 0.8f;
+            break;
+        default:
+            voice.noiseMix = 0.7f;
+            break;
+    }
+    voice.increment = frequency / sampleRate;
+    voice.decayFactor = factorOver(0.001f, decay, sampleRate);
+    voice.releaseFactor = voice.decayFactor;
+}
+
+void MidiSynth::noteOff(uint8_t channel, uint8_t note) {
+    for (Voice& voice : voices) {
+        // Drums ring out whatever the note off says
+        if (voice.active && !voice.released && !voice.drum && voice.channel == channel && voice.note == note) {
+            if (states[channel].sustain) {
+                voice.sustained = true;
+            } else {
+                voice.released = true;
+            }
+        }
+    }
+}
+
+void MidiSynth::releaseSustained(uint8_t channel) {
+    for (Voice& voice : voices) {
+        if (voice.active && voice.sustained && voice.channel == channel) {
+            voice.sustained = false;
+            voice.released = true;
+        }
+    }
+}
+
+void MidiSynth::render(int16_t* samples, size_t frameCount) {
+    mix.assign(frameCount * 2, 0.0f);
+    for (Voice& voice : voices) {
+        if (!voice.active) {
+            continue;
+        }
+        // Controllers only change between render calls, so they are constant here
+        const MidiSequence::ChannelState& state = states[voice.channel];
+        float loudness = (state.volume / 127.0f) * (state.expression / 127.0f);
+        float amplitude = loudness * loudness * voice.gain;
+        double angle = state.pan / 127.0 * Pi / 2.0;
+        float left = static_cast<float>(std::cos(angle)) * amplitude;
+        float right = static_cast<float>(std::sin(angle)) * amplitude;
+        double increment = voice.increment;
+        if (!voice.drum && state.pitchBend != 0) {
+            increment *= std::pow(2.0, state.pitchBend / 8192.0 * state.bendRange / 12.0);
+        }
+        increment = std::min(increment, MaxIncrement);
+
+        for (size_t i = 0; i < frameCount; i++) {
+            double phase = voice.phase;
+            float value;
+            switch (voice.wave) {
+                case Wave::Triangle:
+                    value = static_cast<float>(4.0 * std::fabs(phase - 0.5) - 1.0);
+                    break;
+                case Wave::Square:
+                    value = static_cast<float>((phase < 0.5 ? 1.0 : -1.0) + polyBlep(phase, increment) -
+                                               polyBlep(std::fmod(phase + 0.5, 1.0), increment));
+                    break;
+                case Wave::Saw:
+                    value = static_cast<float>(2.0 * phase - 1.0 - polyBlep(phase, increment));
+                    break;
+                case Wave::Noise:
+                    value = nextNoise();
+                    break;
+                default:
+                    value = static_cast<float>(std::sin(2.0 * Pi * phase));
+                    break;
+            }
+            if (voice.drum) {
+                float noise = nextNoise();
+                if (voice.bright) {
+                    // First difference keeps the hiss of cymbals
+                    float previous = voice.highPass;
+                    voice.highPass = noise;
+                    noise = (noise - previous) * 0.5f;
+                }
+                value = value * (1.0f - voice.noiseMix) + noise * voice.noiseMix;
+                increment *= voice.sweepFactor;
+            }
+            voice.phase += increment;
+            if (voice.phase >= 1.0) {
+                voice.phase -= 1.0;
+            }
+
+            if (voice.attacking) {
+                voice.level += voice.attackStep;
+                if (voice.level >= 1.0f) {
+                    voice.level = 1.0f;
+                    voice.attacking = false;
+                }
+            } else if (voice.released) {
+                voice.level *= voice.releaseFactor;
+            } else {
+                voice.level = voice.sustainLevel + (voice.level - voice.sustainLevel) * voice.decayFactor;
+            }
+
+            value *= voice.level;
+            mix[i * 2] += value * left;
+            mix[i * 2 + 1] += value * right;
+        }
+        if (voice.drum) {
+            voice.increment = increment;
+        }
+        if (!voice.attacking && voice.level < SilentLevel && (voice.released || voice.sustainLevel == 0.0f)) {
+            voice.active = false;
+        }
+    }
+
+    for (size_t i = 0; i < frameCount * 2; i++) {
+        float value = std::clamp(mix[i] * MasterGain, -1.0f, 1.0f);
+        samples[i] = static_cast<int16_t>(std::lround(value * 32767.0f));
+    }
+}
@@ -1,10 +1,171 @@
 #include "../include/ObjectTraversalUtils.h"
 #include <algorithm>
+#include <unordered_map>
 
 namespace ObjectTraversalUtils {
 
+namespace {
+    using ObjectPtr = std::shared_ptr<DataParser::DataObject>;
+    using ObjectList = std::vector<ObjectPtr>;
+
+    // Where every object of the last searched tree sits: its parent datafile
+    // (none for the top level) and its position in the parent's list. Positions
+    // are hints: inserts and removals do not renumber the siblings, a stale
+    // position is repaired by searching outwards from it, which is cheap because
+    // the object has only moved by the number of changes near it. Changes made
+    // elsewhere (sorting, merging, undo) are caught because every entry is checked
+    // against the lists before it is trusted, and a failed check rebuilds the
+    // index once. Only used from the UI thread.
+    class ObjectIndex {
+    public:
+        // Position of target in list, if the index knows it is there
+        bool findIn(const ObjectList& list, const DataParser::DataObject* target, ObjectPtr& parent, size_t& position) {
+            auto found = entries.find(target->ui_id);
+            if (found == entries.end()) {
+                return false;
+            }
+            auto matches = [target](const DataParser::DataObject* obj) { return obj == target; };
+            if (listOf(found->second, list, parent) != &list || !seek(list, found->second.position, matches)) {
+                return false;
+            }
+            position = found->second.position;
+            return true;
+        }
+
+        // Find target anywhere under tree, rebuilding the index once if it is out of date
+        bool find(const ObjectList& tree, const DataParser::DataObject* target, ObjectPtr& parent, size_t& position) {
+            if (root == &tree && findChecked(tree, target, parent, position)) {
+                return true;
+            }
+            rebuild(tree);
+            return findChecked(tree, target, parent, position);
+        }
+
+        ObjectPtr find(const ObjectList& tree, uint32_t uid) {
+            if (root == &tree) {
+                if (ObjectPtr object = findChecked(tree, uid)) {
+                    return object;
+                }
+            }
+            rebuild(tree);
+            return findChecked(tree, uid);
+        }
+
+        // Record where list[position] now is
+        void update(const ObjectList& list, const ObjectPtr& parent, size_t position) {
+            Entry& entry = entries[list[position]->ui_id];
+            entry.parent = parent;
+            entry.topLevel = !parent;
+            entry.position = position;
+        }
+
+        void remove(uint32_t uid) {
+            entries.erase(uid);
+        }
+
+    private:
+        struct Entry {
+            std::weak_ptr<DataParser::DataObject> parent;
+            bool topLevel = true;
+            size_t position = 0;
+        };
+
+        // The list an entry points into, topLevel is the list a top level entry belongs to
+        const ObjectList* listOf(const Entry& entry, const ObjectList& topLevel, ObjectPtr& parent) const {
+            if (entry.topLevel) {
+                parent = nullptr;
+                return &topLevel == root ? &topLevel : nullptr;
+            }
+            parent = entry.parent.lock();
+            return parent && parent->isNested() ? &parent->getNestedObjects() : nullptr;
+        }
+
+        // Find a matching object in list starting at position, moving position to where it is
+        template<typename Match>
+        static bool seek(const ObjectList& list, size_t& position, Match&& matches) {
+            size_t size = list.size();
+            size_t start = std::min(position, size);
+            for (size_t distance = 0; distance <= std::max(start, size - start); ++distance) {
+                if (start >= distance && start - distance < size && matches(list[start - distance].get())) {
+                    position = start - distance;
+                    return true;
+                }
+                if (distance > 0 && start + distance < size && matches(list[start + distance].get())) {
+                    position = start + distance;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // findIn on the list holding target, then the same check for its parents up to the top
+        bool findChecked(const ObjectList& tree, const DataParser::DataObject* target, ObjectPtr& parent, size_t& position) {
+            auto found = entries.find(target->ui_id);
+            if (found == entries.end()) {
+                return false;
+            }
+            const ObjectList* list = listOf(found->second, tree, parent);
+            if (!list || !findIn(*list, target, parent, position)) {
+                return false;
+            }
+            if (!parent) {
+                return true;
+            }
+            ObjectPtr grandparent;
+            size_t parentPosition;
+            return findChecked(tree, parent.get(), grandparent, parentPosition);
+        }
+
+        ObjectPtr findChecked(const ObjectList& tree, uint32_t uid) {
+            auto found = entries.find(uid);
+            if (found == entries.end()) {
+                return nullptr;
+            }
+            ObjectPtr parent;
+            const ObjectList* list = listOf(found->second, tree, parent);
+            auto matches = [uid](const DataParser::DataObject* obj) { return obj->ui_id == uid; };
+            if (!list || !seek(*list, found->second.position, matches)) {
+                return nullptr;
+            }
+            ObjectPtr object = (*list)[found->second.position];
+            size_t position;
+            return findChecked(tree, object.get(), parent, position) ? object : nullptr;
+        }
+
+        void rebuild(const ObjectList& tree) {
+            entries.clear();
+            root = &tree;
+            add(tree, nullptr);
+        }
+
+        void add(const ObjectList& list, const ObjectPtr& parent) {
+            for (size_t i = 0; i < list.size(); ++i) {
+                update(list, parent, i);
+            }
+            for (const auto& obj : list) {
+                if (obj->isNested()) {
+                    add(obj->getNestedObjects(), obj);
+                }
+            }
+        }
+
+        std::unordered_map<uint32_t, Entry> entries;
+        const ObjectList* root = nullptr;  // Only followed when a caller passes the same list again
+    };
+
+    ObjectIndex index;
+}
+
 bool FindAndRemoveObject(std::vector<std::shared_ptr<DataParser::DataObject>>& objects, 
                         std::shared_ptr<DataParser::DataObject> targetObj) {
+    ObjectPtr parent;
+    size_t position = 0;
+    if (targetObj && index.findIn(objects, targetObj.get(), parent, position)) {
+        index.remove(targetObj->ui_id);
+        objects.erase(objects.begin() + position);
+        return true;
+    }
+
     auto it = std::find_if(objects.begin(), objects.end(),
         [targetObj](const std::shared_ptr<DataParser::DataObject> obj) {
             return obj == targetObj;
@@ -19,41 +180,24 @@ bool FindAndRemoveObject(std::vector<std::shared_ptr<DataParser::DataObject>>& o
 
 std::shared_ptr<DataParser::DataObject> FindObjectByUID(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects, 
                                                        uint32_t uid) {
-    for (const auto& obj : objects) {
-        if (obj->ui_id == uid) {
-            return obj;
-        }
-        
-        // Check nested objects
-        if (obj->isNested()) {
-            const auto& nested = obj->getNestedObjects();
-            auto found = FindObjectByUID(nested, uid);
-            if (found) {
-                return found;
-            }
-        }
-    }
-    return nullptr;
+    return index.find(objects, uid);
 }
 
 bool FindAndReplaceObject(std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
                          std::shared_ptr<DataParser::DataObject> targetObj,
                          std::shared_ptr<DataParser::DataObject> replacementObj) {
-    for (auto& obj : objects) {
-        if (obj == targetObj) {
-            obj = replacementObj;
-            return true;
-        }
-        
-        // Check nested objects
-        if (obj->isNested()) {
-            auto& nested = obj->getNestedObjects();
-            if (FindAndReplaceObject(nested, targetObj, replacementObj)) {
-                return true;
-            }
-        }
+    ObjectPtr parent;
+    size_t position = 0;
+    if (!targetObj || !index.find(objects, targetObj.get(), parent, position)) {
+        return false;
     }
-    return false;
+    ObjectList& list = parent ? parent->getNestedObjects() : objects;
+    index.remove(targetObj->ui_id);
+    list[position] = replacementObj;
+    if (replacementObj) {
+        index.update(list, parent, position);
+    }
+    return true;
 }
 
 int CountObjects(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects) {
@@ -71,47 +215,48 @@ int CountObjects(const std::vector<std::shared_ptr<DataParser::DataObject>>& obj
 std::vector<std::shared_ptr<DataParser::DataObject>>* FindParentVector(
     std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
     std::shared_ptr<DataParser::DataObject> targetObj) {
-    for (auto& obj : objects) {
-        if (obj == targetObj) {
-            return &objects;
-        }
-        
-        if (obj->isNested()) {
-            auto& nested = obj->getNestedObjects();
-            auto* result = FindParentVector(nested, targetObj);
-            if (result) return result;
-        }
+    ObjectPtr parent;
+    size_t position = 0;
+    if (!targetObj || !index.find(objects, targetObj.get(), parent, position)) {
+        return nullptr;
     }
-    return nullptr;
+    return parent ? &parent->getNestedObjects() : &objects;
 }
 
 bool InsertAfterTarget(std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
                       std::shared_ptr<DataParser::DataObject> toInsert,
                       std::shared_ptr<DataParser::DataObject> target) {
-    for (size_t i = 0; i < objects.size(); ++i) {
-        if (objects[i] == target) {
-            objects.insert(objects.begin() + i + 1, toInsert);
-            return true;
-        }
-        
-        if (objects[i]->isNested()) {
-            auto& nested = objects[i]->getNestedObjects();
-            if (InsertAfterTarget(nested, toInsert, target)) {
-                return true;
-            }
-        }
+    ObjectPtr parent;
+    size_t position = 0;
+    if (!target || !index.find(objects, target.get(), parent, position)) {
+        return false;
     }
-    return false;
+    ObjectList& list = parent ? parent->getNestedObjects() : objects;
+    list.insert(list.begin() + position + 1, toInsert);
+    index.update(list, parent, position + 1);
+    return true;
 }
 
 bool MoveObjectUp(std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
                  std::shared_ptr<DataParser::DataObject> targetObj) {
+    ObjectPtr parent;
+    size_t position = 0;
+    if (targetObj && index.findIn(objects, targetObj.get(), parent, position)) {
+        if (position == 0) {
+            return false; // Already at the top
+        }
+        std::swap(objects[position], objects[position - 1]);
+        index.update(objects, parent, position - 1);
+        index.update(objects, parent, position);
+        return true;
+    }
+
     auto it = std::find_if(objects.begin(), objects.end(),
         [targetObj](const std::shared_ptr<DataParser::DataObject> obj) {
             return obj == targetObj;
         });
 
-    if (it == objects.begin()) {
+    if (it == objects.begin() || it == objects.end()) {
         return false; // Already at the top or not found
     }
 
@@ -122,6 +267,18 @@ bool MoveObjectUp(std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
 
 bool MoveObjectDown(std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
                    std::shared_ptr<DataParser::DataObject> targetObj) {
+    ObjectPtr parent;
+    size_t position = 0;
+    if (targetObj && index.findIn(objects, targetObj.get(), parent, position)) {
+        if (position + 1 >= objects.size()) {
+            return false; // Already at the bottom
+        }
+        std::swap(objects[position], objects[position + 1]);
+        index.update(objects, parent, position);
+        index.update(objects, parent, position + 1);
+        return true;
+    }
+
     auto it = std::find_if(objects.begin(), objects.end(),
         [targetObj](const std::shared_ptr<DataParser::DataObject> obj) {
             return obj == targetObj;
@@ -136,4 +293,4 @@ bool MoveObjectDown(std::vector<std::shared_ptr<DataParser::DataObject>>& object
     return true;
 }
 
-} // namespace ObjectTraversalUtils 
\ No newline at end of file
+} // namespace ObjectTraversalUtils
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "../include/PlaybackClock.h"
+#include <algorithm>
+
+void PlaybackClock::setFrameDuration(int64_t newFrameDurationUs) {
+    frameDurationUs = std::max<int64_t>(newFrameDurationUs, 1);
+}
+
+void PlaybackClock::rebase(int64_t mediaUs, Clock::time_point now) {
+    originTime = now;
+    originUs = mediaUs;
+    positionUs = mediaUs;
+}
+
+int64_t PlaybackClock::localPositionUs(Clock::time_point now) const {
+    if (!running) {
+        return positionUs;
+    }
+    return originUs + std::chrono::duration_cast<std::chrono::microseconds>(now - originTime).count();
+}
+
+void PlaybackClock::start(int64_t mediaUs) {
+    rebase(std::max<int64_t>(mediaUs, 0), Clock::now());
+    running = true;
+    lastShownFrame = -1;
+}
+
+void PlaybackClock::pause() {
+    positionUs = localPositionUs(Clock::now());
+    running = false;
+}
+
+void PlaybackClock::seek(int64_t mediaUs) {
+    rebase(std::max<int64_t>(mediaUs, 0), Clock::now());
+    lastShownFrame = -1;
+}
+
+int64_t PlaybackClock::update() {
+    Clock::time_point now = Clock::now();
+    positionUs = localPositionUs(now);
+    if (!running || !master) {
+        return positionUs;
+    }
+    int64_t masterUs = master();
+    if (masterUs < 0) {
+        return positionUs;
+    }
+    int64_t error = masterUs - positionUs;
+    if (error > ResyncThresholdUs || error < -ResyncThresholdUs) {
+        rebase(masterUs, now);
+        lastShownFrame = -1;
+        stats.resyncs++;
+    } else {
+        // The master advances in steps (audio in whole buffers), so move towards it gradually
+        originUs += error / SlewDivisor;
+        positionUs += error / SlewDivisor;
+    }
+    return positionUs;
+}
+
+int64_t PlaybackClock::getUsUntil(int frame) const {
+    return std::max<int64_t>(frameStartUs(frame) - localPositionUs(Clock::now()), 0);
+}
+
+void PlaybackClock::frameShown(int frame) {
+    if (lastShownFrame >= 0 && frame > lastShownFrame + 1) {
+        stats.framesDropped += frame - lastShownFrame - 1;
+    }
+    lastShownFrame = frame;
+    stats.framesShown++;
+    // Measured now, so the time spent decoding the frame counts
+    int64_t late = localPositionUs(Clock::now()) - frameStartUs(frame);
+    if (late > frameDurationUs) {
+        stats.lateFrames++;
+    }
+    stats.maxLateUs = std::max(stats.maxLateUs, late);
+}
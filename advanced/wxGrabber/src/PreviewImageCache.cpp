@@ -0,0 +1,175 @@
+#include "../include/PreviewImageCache.h"
+#include "../include/log.h"
+
+PreviewImageCache::PreviewImageCache(size_t budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+    worker = std::thread(&PreviewImageCache::workerLoop, this);
+}
+
+PreviewImageCache::~PreviewImageCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopWorker = true;
+        jobs.clear();
+    }
+    jobsAvailable.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+uint64_t PreviewImageCache::hashPalette(const std::vector<uint8_t>& palette) {
+    return BitmapData::hashBytes(palette.data(), palette.size());
+}
+
+PreviewImageCache::Key PreviewImageCache::makeKey(const DataParser::DataObject& obj, uint64_t paletteHash, bool preserveTransparency) {
+    const BitmapData& bitmap = obj.getBitmap();
+    // Only 8-bit images are expanded through the palette, others can share entries across palettes
+    bool usesPalette = bitmap.bits == 8 && !bitmap.isPalette();
+    return Key{obj.ui_id, bitmap.contentHash(), usesPalette ? paletteHash : 0, preserveTransparency};
+}
+
+size_t PreviewImageCache::imageBytes(const wxImage& image) {
+    size_t pixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
+    return pixels * (image.HasAlpha() ? 4 : 3);
+}
+
+std::shared_ptr<const wxImage> PreviewImageCache::convert(const BitmapData& bitmap, std::vector<uint8_t>& palette,
+                                                          bool preserveTransparency) {
+    wxImage image;
+    if (!bitmap.toWxImage(image, palette, preserveTransparency)) {
+        return nullptr;
+    }
+    return std::make_shared<const wxImage>(image);
+}
+
+std::shared_ptr<const wxImage> PreviewImageCache::get(const DataParser::DataObject& obj, const std::vector<uint8_t>& palette,
+                                                      bool preserveTransparency) {
+    if (!obj.isBitmap()) {
+        return nullptr;
+    }
+
+    Key key = makeKey(obj, hashPalette(palette), preserveTransparency);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto image = lookupLocked(key)) {
+            PROFILE_COUNTER("preview cache hits", 1);
+            return image;
+        }
+    }
+
+    PROFILE_COUNTER("preview cache misses", 1);
+    std::vector<uint8_t> paletteCopy = palette;
+    auto image = convert(obj.getBitmap(), paletteCopy, preserveTransparency);
+    if (image) {
+        std::lock_guard<std::mutex> lock(mutex);
+        insertLocked(key, image);
+    }
+    return image;
+}
+
+void PreviewImageCache::prefetch(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
+                                 const std::vector<uint8_t>& palette, bool preserveTransparency) {
+    uint64_t paletteHash = hashPalette(palette);
+    std::deque<PrefetchJob> newJobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& obj : objects) {
+            if (!obj || !obj->isBitmap()) {
+                continue;
+            }
+            Key key = makeKey(*obj, paletteHash, preserveTransparency);
+            if (entries.find(key) != entries.end()) {
+                continue;
+            }
+            newJobs.push_back(PrefetchJob{key, obj->getBitmap()});
+        }
+        // Latest selection wins, older pending requests are dropped
+        jobs = std::move(newJobs);
+        jobPalette = palette;
+        jobTransparency = preserveTransparency;
+    }
+    jobsAvailable.notify_one();
+}
+
+void PreviewImageCache::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobsAvailable.wait(lock, [this] { return stopWorker || !jobs.empty(); });
+        if (stopWorker) {
+            break;
+        }
+
+        PrefetchJob job = std::move(jobs.front());
+        jobs.pop_front();
+        std::vector<uint8_t> palette = jobPalette;
+        bool preserveTransparency = jobTransparency;
+        lock.unlock();
+
+        auto image = convert(job.bitmap, palette, preserveTransparency);
+
+        lock.lock();
+        if (image && entries.find(job.key) == entries.end()) {
+            insertLocked(job.key, std::move(image));
+        }
+    }
+}
+
+std::shared_ptr<const wxImage> PreviewImageCache::lookupLocked(const Key& key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    order.splice(order.begin(), order, it->second.orderIt);
+    return it->second.image;
+}
+
+void PreviewImageCache::insertLocked(const Key& key, std::shared_ptr<const wxImage> image) {
+    auto existing = entries.find(key);
+    if (existing != entries.end()) {
+        usedBytes -= existing->second.bytes;
+        order.erase(existing->second.orderIt);
+        entries.erase(existing);
+    }
+
+    size_t bytes = imageBytes(*image);
+    order.push_front(key);
+    entries[key] = Entry{std::move(image), bytes, order.begin()};
+    usedBytes += bytes;
+    evictLocked();
+}
+
+void PreviewImageCache::evictLocked() {
+    // Keep at least the most recent entry even if it alone exceeds the budget
+    while (usedBytes > budgetBytes && order.size() > 1) {
+        auto it = entries.find(order.back());
+        usedBytes -= it->second.bytes;
+        entries.erase(it);
+        order.pop_back();
+    }
+}
+
+void PreviewImageCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.clear();
+    entries.clear();
+    order.clear();
+    usedBytes = 0;
+}
+
+void PreviewImageCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budgetBytes = budgetBytes;
+    evictLocked();
+}
+
+size_t PreviewImageCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+size_t PreviewImageCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
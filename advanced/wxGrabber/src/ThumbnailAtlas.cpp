@@ -0,0 +1,333 @@
+#include "../include/ThumbnailAtlas.h"
+#include "../include/log.h"
+#include <algorithm>
+#include <cstring>
+
+const wxColour ThumbnailGenerator::BackgroundColour(255, 255, 255);
+
+ThumbnailAtlas::ThumbnailAtlas(size_t maxPages)
+    : maxPages(std::max<size_t>(1, maxPages))
+{
+}
+
+ThumbnailAtlas::Slot ThumbnailAtlas::allocateCellLocked() {
+    const size_t cellsPerPage = CellsPerRow * CellsPerRow;
+    if (nextCell < maxPages * cellsPerPage) {
+        size_t cell = nextCell++;
+        size_t page = cell / cellsPerPage;
+        if (page >= pages.size()) {
+            Page newPage;
+            newPage.rgb.assign(static_cast<size_t>(PageSize) * PageSize * 3, 0);
+            pages.push_back(std::move(newPage));
+        }
+        size_t index = cell % cellsPerPage;
+        Slot slot;
+        slot.page = static_cast<int>(page);
+        slot.x = static_cast<int>(index % CellsPerRow) * ThumbSize;
+        slot.y = static_cast<int>(index / CellsPerRow) * ThumbSize;
+        return slot;
+    }
+
+    // Atlas is full, reuse the least recently used cell
+    auto it = cells.find(order.back());
+    Slot slot = it->second.slot;
+    cells.erase(it);
+    order.pop_back();
+    PROFILE_COUNTER("thumbnail evictions", 1);
+    return slot;
+}
+
+void ThumbnailAtlas::store(uint32_t uid, uint64_t stamp, const wxImage& thumbnail) {
+    if (!thumbnail.IsOk()) {
+        return;
+    }
+    int width = std::min(thumbnail.GetWidth(), static_cast<int>(ThumbSize));
+    int height = std::min(thumbnail.GetHeight(), static_cast<int>(ThumbSize));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot slot;
+    auto existing = cells.find(uid);
+    if (existing != cells.end()) {
+        // Re-render of the same object, overwrite its cell in place
+        slot = existing->second.slot;
+        order.erase(existing->second.orderIt);
+        cells.erase(existing);
+    } else {
+        slot = allocateCellLocked();
+    }
+    slot.width = width;
+    slot.height = height;
+
+    Page& page = pages[slot.page];
+    const unsigned char* src = thumbnail.GetData();
+    for (int y = 0; y < ThumbSize; y++) {
+        uint8_t* dst = page.rgb.data() + (static_cast<size_t>(slot.y + y) * PageSize + slot.x) * 3;
+        if (y < height) {
+            std::memcpy(dst, src + static_cast<size_t>(y) * thumbnail.GetWidth() * 3, static_cast<size_t>(width) * 3);
+            std::memset(dst + width * 3, 0, static_cast<size_t>(ThumbSize - width) * 3);
+        } else {
+            std::memset(dst, 0, ThumbSize * 3);
+        }
+    }
+    page.version++;
+
+    order.push_front(uid);
+    cells[uid] = CellEntry{slot, stamp, order.begin()};
+}
+
+bool ThumbnailAtlas::find(uint32_t uid, uint64_t stamp, Slot& slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cells.find(uid);
+    if (it == cells.end() || it->second.stamp != stamp) {
+        return false;
+    }
+    order.splice(order.begin(), order, it->second.orderIt);
+    slot = it->second.slot;
+    return true;
+}
+
+bool ThumbnailAtlas::contains(uint32_t uid, uint64_t stamp) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cells.find(uid);
+    return it != cells.end() && it->second.stamp == stamp;
+}
+
+void ThumbnailAtlas::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cells.clear();
+    order.clear();
+    // Pages are kept allocated and reused from the first cell, bump versions so views re-upload them
+    nextCell = 0;
+    for (auto& page : pages) {
+        std::fill(page.rgb.begin(), page.rgb.end(), 0);
+        page.version++;
+    }
+}
+
+size_t ThumbnailAtlas::getPageCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pages.size();
+}
+
+uint64_t ThumbnailAtlas::getPageVersion(size_t page) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return page < pages.size() ? pages[page].version : 0;
+}
+
+wxImage ThumbnailAtlas::getPageImage(size_t page) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (page >= pages.size()) {
+        return wxImage();
+    }
+    wxImage image(PageSize, PageSize, false);
+    std::memcpy(image.GetData(), pages[page].rgb.data(), pages[page].rgb.size());
+    return image;
+}
+
+ThumbnailGenerator::ThumbnailGenerator(ThumbnailAtlas& atlas, unsigned threadCount)
+    : atlas(atlas)
+{
+    if (threadCount == 0) {
+        // Leave one core for the UI thread
+        unsigned cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThumbnailGenerator::workerLoop, this);
+    }
+}
+
+ThumbnailGenerator::~ThumbnailGenerator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopWorkers = true;
+        jobs.clear();
+    }
+    jobsAvailable.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+bool ThumbnailGenerator::canRender(const DataParser::DataObject& obj) {
+    return obj.isBitmap() || obj.isFont() || obj.isVideo();
+}
+
+uint64_t ThumbnailGenerator::stampFor(const DataParser::DataObject& obj, uint64_t paletteHash) {
+    if (obj.isBitmap()) {
+        const BitmapData& bitmap = obj.getBitmap();
+        // Only 8-bit images depend on the current palette
+        bool usesPalette = bitmap.bits == 8 && !bitmap.isPalette();
+        return bitmap.contentHash() ^ (usesPalette ? paletteHash : 0);
+    }
+    if (obj.isFont()) {
+        const FontData& font = obj.getFont();
+        uint64_t hash = 0;
+        for (const auto& range : font.ranges) {
+            hash = range.contentHash(hash);
+        }
+        return hash;
+    }
+    if (obj.isVideo()) {
+        const VideoData& video = obj.getVideo();
+        int32_t header[3] = {video.width, video.height, video.frameCount};
+        uint64_t hash = BitmapData::hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+        // FLIC files can be megabytes, hash the start (header and first frame) plus evenly spaced samples
+        const size_t headSize = std::min<size_t>(video.data.size(), 64 * 1024);
+        hash = BitmapData::hashBytes(video.data.data(), headSize, hash);
+        const size_t samples = 64;
+        if (video.data.size() > headSize + samples * 8) {
+            size_t step = (video.data.size() - headSize) / samples;
+            for (size_t i = 0; i < samples; i++) {
+                hash = BitmapData::hashBytes(video.data.data() + headSize + i * step, 8, hash);
+            }
+        }
+        return hash;
+    }
+    return 0;
+}
+
+void ThumbnailGenerator::request(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects,
+                                 const std::vector<uint8_t>& palette) {
+    PROFILE_SCOPE("ThumbnailGenerator::request");
+    auto sharedPalette = std::make_shared<const std::vector<uint8_t>>(palette);
+    uint64_t paletteHash = BitmapData::hashBytes(palette.data(), palette.size());
+
+    std::deque<Job> newJobs;
+    for (const auto& obj : objects) {
+        if (!obj || !canRender(*obj)) {
+            continue;
+        }
+        uint64_t stamp = stampFor(*obj, paletteHash);
+        if (atlas.contains(obj->ui_id, stamp)) {
+            continue;
+        }
+        // Copy the payload now, the UI thread may edit or delete the object later
+        Job job{obj->ui_id, stamp, Snapshot(), sharedPalette};
+        if (obj->isBitmap()) {
+            job.snapshot = obj->getBitmap();
+        } else if (obj->isFont()) {
+            job.snapshot = obj->getFont();
+        } else {
+            job.snapshot = obj->getVideo();
+        }
+        newJobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Latest request wins, skip objects a worker is already rendering
+        jobs.clear();
+        for (auto& job : newJobs) {
+            auto failedIt = failed.find(job.uid);
+            if (failedIt != failed.end() && failedIt->second == job.stamp) {
+                continue;
+            }
+            if (inFlight.find(job.uid) == inFlight.end()) {
+                jobs.push_back(std::move(job));
+            }
+        }
+    }
+    jobsAvailable.notify_all();
+}
+
+std::vector<uint32_t> ThumbnailGenerator::takeCompleted() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<uint32_t> result;
+    result.swap(completed);
+    return result;
+}
+
+void ThumbnailGenerator::cancelPending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.clear();
+    completed.clear();
+    failed.clear();
+}
+
+wxImage ThumbnailGenerator::makeThumbnail(const wxImage& image, const wxColour& background) {
+    if (!image.IsOk() || image.GetWidth() <= 0 || image.GetHeight() <= 0) {
+        return wxImage();
+    }
+
+    const int size = ThumbnailAtlas::ThumbSize;
+    int width = image.GetWidth();
+    int height = image.GetHeight();
+    wxImage result;
+    if (width <= size && height <= size) {
+        // Small sprites are magnified by a whole factor so pixels stay crisp
+        int factor = std::max(1, std::min(4, std::min(size / width, size / height)));
+        result = factor > 1 ? image.Scale(width * factor, height * factor, wxIMAGE_QUALITY_NEAREST) : image.Copy();
+    } else {
+        double scale = std::min(static_cast<double>(size) / width, static_cast<double>(size) / height);
+        int scaledWidth = std::max(1, static_cast<int>(width * scale));
+        int scaledHeight = std::max(1, static_cast<int>(height * scale));
+        result = image.Scale(scaledWidth, scaledHeight, wxIMAGE_QUALITY_BOX_AVERAGE);
+    }
+
+    if (result.HasAlpha()) {
+        unsigned char* rgb = result.GetData();
+        const unsigned char* alpha = result.GetAlpha();
+        size_t pixels = static_cast<size_t>(result.GetWidth()) * result.GetHeight();
+        const unsigned char bg[3] = {background.Red(), background.Green(), background.Blue()};
+        for (size_t i = 0; i < pixels; i++) {
+            for (int c = 0; c < 3; c++) {
+                rgb[i * 3 + c] = static_cast<unsigned char>((rgb[i * 3 + c] * alpha[i] + bg[c] * (255 - alpha[i]) + 127) / 255);
+            }
+        }
+        result.ClearAlpha();
+    }
+    return result;
+}
+
+wxImage ThumbnailGenerator::renderSnapshot(const Job& job) {
+    wxImage image;
+    if (std::holds_alternative<BitmapData>(job.snapshot)) {
+        std::vector<uint8_t> palette = *job.palette;
+        if (!std::get<BitmapData>(job.snapshot).toWxImage(image, palette, true)) {
+            return wxImage();
+        }
+    } else if (std::holds_alternative<FontData>(job.snapshot)) {
+        image = std::get<FontData>(job.snapshot).getPreviewImage();
+    } else {
+        image = std::get<VideoData>(job.snapshot).getPreviewFrame();
+    }
+    return makeThumbnail(image, BackgroundColour);
+}
+
+void ThumbnailGenerator::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobsAvailable.wait(lock, [this] { return stopWorkers || !jobs.empty(); });
+        if (stopWorkers) {
+            break;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        inFlight.insert(job.uid);
+        lock.unlock();
+
+        wxImage thumbnail;
+        {
+            PROFILE_SCOPE("ThumbnailGenerator::render");
+            thumbnail = renderSnapshot(job);
+        }
+        if (thumbnail.IsOk()) {
+            atlas.store(job.uid, job.stamp, thumbnail);
+        } else {
+            LOG_DEBUG("Thumbnail rendering failed for object %u", job.uid);
+        }
+        PROFILE_COUNTER("thumbnails rendered", 1);
+
+        lock.lock();
+        inFlight.erase(job.uid);
+        if (thumbnail.IsOk()) {
+            completed.push_back(job.uid);
+        } else {
+            failed[job.uid] = job.stamp;
+        }
+    }
+}
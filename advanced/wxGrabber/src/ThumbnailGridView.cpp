@@ -0,0 +1,253 @@
+#include "../include/ThumbnailGridView.h"
+#include "../include/log.h"
+#include <wx/dcbuffer.h>
+#include <wx/dcmemory.h>
+#include <wx/settings.h>
+#include <algorithm>
+
+wxBEGIN_EVENT_TABLE(ThumbnailGridView, wxScrolledCanvas)
+    EVT_PAINT(ThumbnailGridView::OnPaint)
+    EVT_SIZE(ThumbnailGridView::OnSize)
+    EVT_LEFT_DOWN(ThumbnailGridView::OnMouse)
+    EVT_LEFT_DCLICK(ThumbnailGridView::OnMouse)
+    EVT_TIMER(wxID_ANY, ThumbnailGridView::OnPollTimer)
+wxEND_EVENT_TABLE()
+
+ThumbnailGridView::ThumbnailGridView(wxWindow* parent, SelectCallback selectCallback)
+    : wxScrolledCanvas(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxFULL_REPAINT_ON_RESIZE),
+      m_generator(m_atlas),
+      m_selectCallback(selectCallback),
+      m_pollTimer(this)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT); // Needed for double buffering
+    SetScrollRate(0, CellHeight / 4);
+    m_paletteHash = BitmapData::hashBytes(m_palette.data(), m_palette.size());
+}
+
+ThumbnailGridView::~ThumbnailGridView() {
+    m_pollTimer.Stop();
+}
+
+void ThumbnailGridView::SetObjects(const std::vector<std::shared_ptr<DataParser::DataObject>>& objects) {
+    std::shared_ptr<DataParser::DataObject> selected = m_selected >= 0 ? m_items[m_selected].object : nullptr;
+    m_items.clear();
+    m_items.reserve(objects.size());
+    m_selected = -1;
+    for (const auto& obj : objects) {
+        if (obj == selected) {
+            m_selected = static_cast<int>(m_items.size());
+        }
+        m_items.push_back(Item{obj});
+    }
+    UpdateVirtualSize();
+    Refresh();
+}
+
+void ThumbnailGridView::SetPalette(const std::vector<uint8_t>& palette) {
+    if (palette == m_palette) {
+        return;
+    }
+    m_palette = palette;
+    m_paletteHash = BitmapData::hashBytes(m_palette.data(), m_palette.size());
+    // Stamps of 8-bit bitmaps include the palette
+    for (auto& item : m_items) {
+        item.stampValid = false;
+    }
+    Refresh();
+}
+
+void ThumbnailGridView::SetSelection(const std::shared_ptr<DataParser::DataObject>& obj) {
+    int selected = -1;
+    for (size_t i = 0; i < m_items.size(); i++) {
+        if (m_items[i].object == obj) {
+            selected = static_cast<int>(i);
+            break;
+        }
+    }
+    if (selected == m_selected) {
+        return;
+    }
+    m_selected = selected;
+    if (m_selected >= 0) {
+        // Scroll the selected cell into view
+        int columns = GetColumns();
+        int top = (m_selected / columns) * CellHeight;
+        int unitX, unitY;
+        GetScrollPixelsPerUnit(&unitX, &unitY);
+        wxPoint viewStart = CalcUnscrolledPosition(wxPoint(0, 0));
+        int clientHeight = GetClientSize().GetHeight();
+        if (unitY > 0 && (top < viewStart.y || top + CellHeight > viewStart.y + clientHeight)) {
+            Scroll(-1, top / unitY);
+        }
+    }
+    Refresh();
+}
+
+void ThumbnailGridView::ClearThumbnails() {
+    m_generator.cancelPending();
+    m_atlas.clear();
+    for (auto& item : m_items) {
+        item.stampValid = false;
+    }
+    Refresh();
+}
+
+int ThumbnailGridView::GetColumns() const {
+    return std::max(1, GetClientSize().GetWidth() / CellWidth);
+}
+
+void ThumbnailGridView::UpdateVirtualSize() {
+    int columns = GetColumns();
+    int rows = static_cast<int>((m_items.size() + columns - 1) / columns);
+    SetVirtualSize(columns * CellWidth, rows * CellHeight);
+}
+
+void ThumbnailGridView::OnSize(wxSizeEvent& event) {
+    UpdateVirtualSize();
+    event.Skip();
+}
+
+int ThumbnailGridView::HitTest(const wxPoint& position) const {
+    wxPoint pos = CalcUnscrolledPosition(position);
+    int columns = GetColumns();
+    int column = pos.x / CellWidth;
+    if (pos.x < 0 || pos.y < 0 || column >= columns) {
+        return -1;
+    }
+    size_t index = static_cast<size_t>(pos.y / CellHeight) * columns + column;
+    return index < m_items.size() ? static_cast<int>(index) : -1;
+}
+
+void ThumbnailGridView::OnMouse(wxMouseEvent& event) {
+    SetFocus();
+    int index = HitTest(event.GetPosition());
+    if (index < 0) {
+        return;
+    }
+    m_selected = index;
+    Refresh();
+    if (m_selectCallback) {
+        m_selectCallback(m_items[index].object, event.LeftDClick());
+    }
+}
+
+uint64_t ThumbnailGridView::GetStamp(Item& item) {
+    // Computed once per item, SetObjects/SetPalette reset it when content may have changed
+    if (!item.stampValid) {
+        item.stamp = ThumbnailGenerator::stampFor(*item.object, m_paletteHash);
+        item.stampValid = true;
+    }
+    return item.stamp;
+}
+
+const wxBitmap& ThumbnailGridView::GetPageBitmap(size_t page) {
+    if (m_pageBitmaps.size() <= page) {
+        m_pageBitmaps.resize(page + 1);
+    }
+    // Re-upload a page only when thumbnails were added to it since the last paint
+    uint64_t version = m_atlas.getPageVersion(page);
+    auto& cached = m_pageBitmaps[page];
+    if (!cached.first.IsOk() || cached.second != version) {
+        cached.first = wxBitmap(m_atlas.getPageImage(page));
+        cached.second = version;
+    }
+    return cached.first;
+}
+
+void ThumbnailGridView::RequestVisible(const std::vector<std::shared_ptr<DataParser::DataObject>>& missing) {
+    if (!missing.empty()) {
+        m_generator.request(missing, m_palette);
+    }
+    if (!m_pollTimer.IsRunning()) {
+        m_pollTimer.Start(PollIntervalMs);
+    }
+}
+
+void ThumbnailGridView::OnPollTimer(wxTimerEvent& event) {
+    std::vector<uint32_t> completed = m_generator.takeCompleted();
+    if (!completed.empty()) {
+        Refresh();
+    }
+}
+
+void ThumbnailGridView::OnPaint(wxPaintEvent& event) {
+    PROFILE_SCOPE("ThumbnailGridView::OnPaint");
+    wxAutoBufferedPaintDC dc(this);
+    DoPrepareDC(dc);
+    dc.SetBackground(wxBrush(GetBackgroundColour()));
+    dc.Clear();
+    if (m_items.empty()) {
+        m_pollTimer.Stop();
+        return;
+    }
+
+    int columns = GetColumns();
+    wxRect view(CalcUnscrolledPosition(wxPoint(0, 0)), GetClientSize());
+    size_t firstRow = std::max(0, view.y / CellHeight);
+    size_t lastRow = std::max(0, view.GetBottom() / CellHeight);
+    size_t first = firstRow * columns;
+    size_t last = std::min(m_items.size(), (lastRow + 1) * columns);
+
+    dc.SetFont(GetFont());
+    dc.SetTextForeground(GetForegroundColour());
+    std::vector<std::shared_ptr<DataParser::DataObject>> missing;
+    wxMemoryDC pageDC;
+    size_t selectedPage = static_cast<size_t>(-1);
+    const int thumbSize = ThumbnailAtlas::ThumbSize;
+    for (size_t i = first; i < last; i++) {
+        Item& item = m_items[i];
+        int cellX = static_cast<int>(i % columns) * CellWidth;
+        int cellY = static_cast<int>(i / columns) * CellHeight;
+        int thumbX = cellX + (CellWidth - thumbSize) / 2;
+        int thumbY = cellY + 4;
+
+        if (static_cast<int>(i) == m_selected) {
+            dc.SetPen(*wxTRANSPARENT_PEN);
+            dc.SetBrush(wxBrush(wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT)));
+            dc.DrawRectangle(cellX + 1, cellY + 1, CellWidth - 2, CellHeight - 2);
+        }
+
+        ThumbnailAtlas::Slot slot;
+        if (ThumbnailGenerator::canRender(*item.object) && m_atlas.find(item.object->ui_id, GetStamp(item), slot)) {
+            if (selectedPage != static_cast<size_t>(slot.page)) {
+                pageDC.SelectObject(wxNullBitmap);
+                const wxBitmap& page = GetPageBitmap(slot.page);
+                pageDC.SelectObjectAsSource(page);
+                selectedPage = slot.page;
+            }
+            dc.Blit(thumbX + (thumbSize - slot.width) / 2, thumbY + (thumbSize - slot.height) / 2,
+                    slot.width, slot.height, &pageDC, slot.x, slot.y);
+        } else {
+            // Placeholder with the type ID until the thumbnail is ready
+            dc.SetPen(*wxLIGHT_GREY_PEN);
+            dc.SetBrush(*wxTRANSPARENT_BRUSH);
+            dc.DrawRectangle(thumbX, thumbY, thumbSize, thumbSize);
+            wxString type = DataParser::ConvertIDToString(item.object->typeID);
+            wxSize extent = dc.GetTextExtent(type);
+            dc.DrawText(type, thumbX + (thumbSize - extent.GetWidth()) / 2, thumbY + (thumbSize - extent.GetHeight()) / 2);
+            if (ThumbnailGenerator::canRender(*item.object)) {
+                missing.push_back(item.object);
+            }
+        }
+
+        // Name below the thumbnail, shortened to the cell width
+        wxString name = item.object->getProperty('NAME');
+        wxString label = name;
+        while (label.length() > 1 && dc.GetTextExtent(label).GetWidth() > CellWidth - 4) {
+            label.RemoveLast();
+        }
+        if (label.length() < name.length() && label.length() > 1) {
+            label.RemoveLast();
+            label += "~";
+        }
+        dc.DrawText(label, cellX + (CellWidth - dc.GetTextExtent(label).GetWidth()) / 2, thumbY + thumbSize + 2);
+    }
+    pageDC.SelectObject(wxNullBitmap);
+
+    // Visible cells first; off-screen requests are dropped when the view scrolls on
+    if (missing.empty()) {
+        m_pollTimer.Stop();
+    } else {
+        RequestVisible(missing);
+    }
+}
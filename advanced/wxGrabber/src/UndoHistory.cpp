@@ -0,0 +1,203 @@
+#include "../include/UndoHistory.h"
+#include "../include/ObjectTraversalUtils.h"
+#include "../include/log.h"
+#include <unordered_set>
+
+namespace {
+    using ObjectPtr = std::shared_ptr<DataParser::DataObject>;
+
+    template<class... Ts> struct Overloaded : Ts... { using Ts::operator()...; };
+    template<class... Ts> Overloaded(Ts...) -> Overloaded<Ts...>;
+}
+
+UndoHistory::UndoHistory(size_t budgetBytes)
+    : budgetBytes(budgetBytes) {
+}
+
+size_t UndoHistory::payloadBytes(const DataParser::DataObject& obj) {
+    size_t bytes = sizeof(DataParser::DataObject) + obj.propertyOrder.size() * sizeof(uint32_t);
+    for (const auto& property : obj.properties) {
+        bytes += sizeof(property) + property.second.size();
+    }
+    bytes += std::visit(Overloaded{
+        [](const std::vector<uint8_t>& raw) { return raw.size(); },
+        [](const BitmapData& bitmap) { return bitmap.data.size() + bitmap.alpha.size(); },
+        [](const AudioData& audio) {
+            size_t size = audio.data.size();
+            for (const auto& track : audio.midiTracks) {
+                size += track.data.size();
+            }
+            return size;
+        },
+        [](const VideoData& video) { return video.data.size(); },
+        [](const DataParser::NestedObjects& nested) { return nested.size() * sizeof(ObjectPtr); },
+        [](const FontData& font) {
+            size_t size = 0;
+            for (const auto& range : font.ranges) {
+                for (const auto& glyph : range.glyphs) {
+                    size += sizeof(glyph) + glyph.data.size();
+                }
+            }
+            return size;
+        }
+    }, obj.data);
+    return bytes;
+}
+
+void UndoHistory::record(const std::string& description, ObjectList& root, const ObjectList& changed) {
+    SavedContents previous;
+    std::unordered_set<const DataParser::DataObject*> saved;
+    if (budgetBytes > 0) {
+        for (const auto& obj : changed) {
+            if (obj && saved.insert(obj.get()).second) {
+                previous.emplace_back(obj, *obj);
+            }
+        }
+    }
+    recordPrevious(description, root, std::move(previous));
+}
+
+void UndoHistory::recordPrevious(const std::string& description, ObjectList& root, SavedContents previous) {
+    Step step;
+    step.description = description;
+    for (auto& content : previous) {
+        step.bytes += payloadBytes(content.second);
+    }
+    step.contents = std::move(previous);
+    push(std::move(step), root);
+}
+
+void UndoHistory::recordProperties(const std::string& description, ObjectList& root, const ObjectList& changed) {
+    Step step;
+    step.description = description;
+    for (const auto& obj : changed) {
+        if (obj) {
+            step.properties.emplace_back(obj, Properties{obj->properties, obj->propertyOrder, obj->name});
+            for (const auto& property : obj->properties) {
+                step.bytes += sizeof(property) + property.second.size();
+            }
+        }
+    }
+    push(std::move(step), root);
+}
+
+void UndoHistory::push(Step step, ObjectList& root) {
+    PROFILE_SCOPE("UndoHistory::record");
+    for (const auto& redoStep : redoSteps) {
+        usedBytes -= redoStep.bytes;
+    }
+    redoSteps.clear();
+    if (budgetBytes == 0) {
+        undoSteps.clear();
+        usedBytes = 0;
+        return;
+    }
+
+    // Child lists of saved objects are already part of their contents
+    std::unordered_set<const DataParser::DataObject*> saved;
+    for (const auto& content : step.contents) {
+        saved.insert(content.first.get());
+    }
+    step.root = root;
+    step.bytes += root.size() * sizeof(ObjectPtr);
+    ObjectTraversalUtils::ForEachObjectRecursive(root, [&](ObjectPtr& obj) {
+        if (obj->isNested() && !saved.count(obj.get())) {
+            step.children.emplace_back(obj, obj->getNestedObjects());
+            step.bytes += (obj->getNestedObjects().size() + 2) * sizeof(ObjectPtr);
+        }
+        return false;
+    });
+
+    usedBytes += step.bytes;
+    undoSteps.push_back(std::move(step));
+    evict();
+}
+
+DataParser::DataObject UndoHistory::withData(const DataParser::DataObject& obj, DataParser::DataVariant data) {
+    DataParser::DataObject previous;
+    previous.typeID = obj.typeID;
+    previous.properties = obj.properties;
+    previous.propertyOrder = obj.propertyOrder;
+    previous.name = obj.name;
+    previous.ui_id = obj.ui_id;
+    previous.data = std::move(data);
+    return previous;
+}
+
+void UndoHistory::discardLast() {
+    if (!undoSteps.empty()) {
+        usedBytes -= undoSteps.back().bytes;
+        undoSteps.pop_back();
+    }
+}
+
+void UndoHistory::swapState(Step& step, ObjectList& root) {
+    for (auto& content : step.contents) {
+        std::swap(*content.first, content.second);
+    }
+    for (auto& saved : step.properties) {
+        std::swap(saved.first->properties, saved.second.values);
+        std::swap(saved.first->propertyOrder, saved.second.order);
+        std::swap(saved.first->name, saved.second.name);
+    }
+    std::swap(root, step.root);
+    for (auto& child : step.children) {
+        if (child.first->isNested()) {
+            std::swap(child.first->getNestedObjects(), child.second);
+        }
+    }
+}
+
+bool UndoHistory::undo(ObjectList& root) {
+    if (undoSteps.empty()) {
+        return false;
+    }
+    PROFILE_SCOPE("UndoHistory::undo");
+    Step step = std::move(undoSteps.back());
+    undoSteps.pop_back();
+    swapState(step, root);
+    logDebug("Undo: " + step.description);
+    redoSteps.push_back(std::move(step));
+    return true;
+}
+
+bool UndoHistory::redo(ObjectList& root) {
+    if (redoSteps.empty()) {
+        return false;
+    }
+    PROFILE_SCOPE("UndoHistory::redo");
+    Step step = std::move(redoSteps.back());
+    redoSteps.pop_back();
+    swapState(step, root);
+    logDebug("Redo: " + step.description);
+    undoSteps.push_back(std::move(step));
+    return true;
+}
+
+std::string UndoHistory::undoDescription() const {
+    return undoSteps.empty() ? std::string() : undoSteps.back().description;
+}
+
+std::string UndoHistory::redoDescription() const {
+    return redoSteps.empty() ? std::string() : redoSteps.back().description;
+}
+
+void UndoHistory::clear() {
+    undoSteps.clear();
+    redoSteps.clear();
+    usedBytes = 0;
+}
+
+void UndoHistory::setBudget(size_t budgetBytes) {
+    this->budgetBytes = budgetBytes;
+    evict();
+}
+
+void UndoHistory::evict() {
+    // Redo steps are the most recent history and never dropped. Keep at least the
+    // newest undo step so the change just made can always be undone.
+    while (usedBytes > budgetBytes && undoSteps.size() > 1) {
+        usedBytes -= undoSteps.front().bytes;
+        undoSteps.pop_front();
+    }
+}
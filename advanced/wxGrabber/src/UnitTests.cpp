@@ -1,9 +1,16 @@
 #include "../include/UnitTests.h"
 #include "../include/log.h"
+#include "../include/VideoData.h"
+#include "../include/FlicEncoder.h"
+#include "../include/ImageCodec.h"
+#include "../include/FontImporter.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <chrono>
+#include <map>
+#include <filesystem>
+#include <cstdio>
 
 std::vector<UnitTests::TestCase> UnitTests::GetTestCases() {
     return {
@@ -507,3 +514,510 @@ bool UnitTests::CompareBuffers(const std::vector<uint8_t>& original, const std::
 
     return true;
 }
+
+namespace {
+    using FlicChunk = std::pair<uint16_t, std::vector<uint8_t>>;
+
+    void put16(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void put32(std::vector<uint8_t>& out, uint32_t value) {
+        put16(out, value & 0xFFFF);
+        put16(out, value >> 16);
+    }
+
+    // FLC file of the given frames. A chunk stores its size as 6 plus its body unless
+    // declaredSizes gives one, which lets a chunk claim more bytes than the file has.
+    VideoData buildFlic(int width, int height, const std::vector<std::vector<FlicChunk>>& frames,
+                        const std::map<size_t, uint32_t>& declaredSizes = {}) {
+        std::vector<uint8_t> file(128, 0);
+        size_t chunkNumber = 0;
+        for (const auto& chunks : frames) {
+            std::vector<uint8_t> frame;
+            for (const auto& chunk : chunks) {
+                auto declared = declaredSizes.find(chunkNumber++);
+                put32(frame, declared != declaredSizes.end() ? declared->second : static_cast<uint32_t>(6 + chunk.second.size()));
+                put16(frame, chunk.first);
+                frame.insert(frame.end(), chunk.second.begin(), chunk.second.end());
+            }
+            put32(file, static_cast<uint32_t>(16 + frame.size()));
+            put16(file, VideoData::FLI_FRAME_MAGIC_NUMBER);
+            put16(file, static_cast<uint32_t>(chunks.size()));
+            file.resize(file.size() + 8, 0);
+            file.insert(file.end(), frame.begin(), frame.end());
+        }
+        std::vector<uint8_t> header;
+        put32(header, static_cast<uint32_t>(file.size()));
+        put16(header, VideoData::FLC_MAGIC_NUMBER);
+        put16(header, static_cast<uint32_t>(frames.size()));
+        put16(header, width);
+        put16(header, height);
+        put16(header, 8);
+        put16(header, 0);
+        put32(header, 50);
+        std::copy(header.begin(), header.end(), file.begin());
+        file[80] = 128;     // Offset of frame 1
+        VideoData video;
+        VideoData::parse(file, ObjectType::DAT_FLI, video);
+        return video;
+    }
+
+    bool checkPixels(const std::string& name, const std::vector<uint8_t>& actual, const std::vector<uint8_t>& expected) {
+        if (actual == expected) {
+            logInfo(name + " passed");
+            return true;
+        }
+        for (size_t i = 0; i < std::min(actual.size(), expected.size()); i++) {
+            if (actual[i] != expected[i]) {
+                logError(name + " FAILED at pixel " + std::to_string(i) + ": got " + std::to_string(actual[i]) +
+                         ", expected " + std::to_string(expected[i]));
+                return false;
+            }
+        }
+        logError(name + " FAILED: " + std::to_string(actual.size()) + " pixels, expected " + std::to_string(expected.size()));
+        return false;
+    }
+}
+
+bool UnitTests::FlicDecoderTests() {
+    logInfo("\nRunning FLIC chunk decoder tests...\n");
+    // 7x4 so DELTA_FLC needs its last pixel opcode
+    const int width = 7, height = 4;
+    std::vector<std::vector<FlicChunk>> frames = {
+        // BRUN: the packet count byte is ignored, runs fill each line
+        {{15, {0, 3, 0x11, 0xFC, 1, 2, 3, 4,
+               1, 7, 0x22,
+               2, 0xFE, 5, 6, 5, 0x33,
+               1, 0xF9, 10, 11, 12, 13, 14, 15, 16}}},
+        // DELTA_FLC: skip a line, set its last pixel and patch it, then a line of a word run and a literal
+        {{7, {2, 0,
+              0xFF, 0xFF,
+              0x77, 0x80,
+              1, 0, 2, 1, 0xA1, 0xA2,
+              2, 0, 0, 0xFE, 0xB1, 0xB2, 1, 1, 0xC1, 0xC2}}},
+        // LC: start at line 3, a literal and a byte run
+        {{12, {3, 0, 1, 0, 2, 1, 2, 0xD1, 0xD2, 2, 0xFE, 0xE1}}},
+        // BLACK
+        {{13, {}}},
+        // COPY
+        {{16, {}}},
+        // BRUN cut off inside line 1, the LC chunk after it must not be read as its pixels
+        {{15, {1, 7, 0xF1, 1, 0xFD, 0x99}},
+         {12, {2, 0, 1, 0, 1, 0, 0xF9, 0x5A}}},
+        // COPY claiming a whole frame at the end of the file, only its first line is there
+        {{16, {0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69}}},
+    };
+    for (int i = 0; i < width * height; i++) {
+        frames[4][0].second.push_back(static_cast<uint8_t>(0x40 + i));
+    }
+    const std::vector<std::vector<uint8_t>> expected = {
+        {0x11, 0x11, 0x11, 1, 2, 3, 4,
+         0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+         5, 6, 0x33, 0x33, 0x33, 0x33, 0x33,
+         10, 11, 12, 13, 14, 15, 16},
+        {0x11, 0x11, 0x11, 1, 2, 3, 4,
+         0x22, 0x22, 0xA1, 0xA2, 0x22, 0x22, 0x77,
+         0xB1, 0xB2, 0xB1, 0xB2, 0x33, 0xC1, 0xC2,
+         10, 11, 12, 13, 14, 15, 16},
+        {0x11, 0x11, 0x11, 1, 2, 3, 4,
+         0x22, 0x22, 0xA1, 0xA2, 0x22, 0x22, 0x77,
+         0xB1, 0xB2, 0xB1, 0xB2, 0x33, 0xC1, 0xC2,
+         10, 0xD1, 0xD2, 13, 14, 0xE1, 0xE1},
+        std::vector<uint8_t>(width * height, 0),
+        frames[4][0].second,
+        {0xF1, 0xF1, 0xF1, 0xF1, 0xF1, 0xF1, 0xF1,
+         0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D,
+         0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A,
+         0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B},
+        {0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+         0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D,
+         0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A,
+         0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B},
+    };
+    const char* names[] = {"BRUN", "DELTA_FLC", "LC", "BLACK", "COPY", "Truncated BRUN", "COPY past the end of the file"};
+
+    VideoData video = buildFlic(width, height, frames, {{7, 6 + width * height}});
+    std::vector<VideoData::FrameEntry> index = video.buildFrameIndex();
+    if (index.size() != frames.size()) {
+        logError("FLIC frame index FAILED: " + std::to_string(index.size()) + " frames, expected " + std::to_string(frames.size()));
+        return false;
+    }
+    bool allTestsPassed = true;
+    FlicFrameBuffer frame;
+    for (size_t i = 0; i < frames.size(); i++) {
+        video.decodeFrame(index[i], frame);
+        allTestsPassed &= checkPixels(names[i], frame.getPixels(), expected[i]);
+    }
+    if (!index[0].keyframe || index[1].keyframe || index[2].keyframe || !index[3].keyframe || !index[4].keyframe) {
+        logError("FLIC keyframe detection FAILED");
+        allTestsPassed = false;
+    }
+
+    if (allTestsPassed) {
+        logInfo("\nAll FLIC decoder tests PASSED!");
+    } else {
+        logError("\nSome FLIC decoder tests FAILED!");
+    }
+    return allTestsPassed;
+}
+
+namespace {
+    BitmapData makeBitmap(int width, int height, int bits, const std::vector<uint8_t>& data) {
+        BitmapData bitmap;
+        bitmap.width = width;
+        bitmap.height = height;
+        bitmap.bits = bits;
+        bitmap.data = data;
+        return bitmap;
+    }
+
+    // Encodes the frames, decodes the animation again and compares it with the source frames as RGB,
+    // each channel may be off by maxError. 8-bit frames must also keep their indices.
+    bool checkEncoderRoundTrip(const std::string& name, const std::vector<BitmapData>& frames, FlicEncoder::Format format,
+                               const std::vector<uint8_t>& palette, int maxError, FlicEncoder::Result& result) {
+        std::vector<FlicEncoder::Input> inputs(frames.size());
+        for (size_t i = 0; i < frames.size(); i++) {
+            inputs[i].bitmap = &frames[i];
+        }
+        FlicEncoder::Params params;
+        params.format = format;
+        params.palette = palette;
+        if (!FlicEncoder::encode(inputs, params, result)) {
+            logError(name + " FAILED: cannot encode");
+            return false;
+        }
+        std::vector<VideoData::FrameEntry> index = result.video.buildFrameIndex();
+        if (index.size() != frames.size()) {
+            logError(name + " FAILED: " + std::to_string(index.size()) + " frames, expected " + std::to_string(frames.size()));
+            return false;
+        }
+        FlicFrameBuffer decoded;
+        int worst = 0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (!result.video.decodeFrame(index[i], decoded)) {
+                logError(name + " FAILED: frame " + std::to_string(i) + " does not decode");
+                return false;
+            }
+            const std::vector<uint8_t>& pixels = decoded.getPixels();
+            const std::vector<uint8_t>& colormap = decoded.getColormap();
+            if (frames[i].bits == 8 && !checkPixels(name + " frame " + std::to_string(i), pixels, frames[i].data)) {
+                return false;
+            }
+            for (size_t k = 0; k < pixels.size(); k++) {
+                for (int channel = 0; channel < 3; channel++) {
+                    int source = frames[i].bits == 8 ? palette[frames[i].data[k] * 3 + channel] : frames[i].data[k * 3 + channel];
+                    worst = std::max(worst, std::abs(colormap[pixels[k] * 3 + channel] - source));
+                }
+            }
+        }
+        if (worst > maxError) {
+            logError(name + " FAILED: a color is off by " + std::to_string(worst) + ", at most " + std::to_string(maxError) + " expected");
+            return false;
+        }
+        logInfo(name + " passed");
+        return true;
+    }
+}
+
+bool UnitTests::FlicEncoderTests() {
+    logInfo("\nRunning FLIC encoder round trip tests...\n");
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> byte(0, 255);
+    std::vector<uint8_t> palette(256 * 3);
+    std::generate(palette.begin(), palette.end(), [&]() { return static_cast<uint8_t>(byte(gen)); });
+
+    // 8-bit: a repeated frame, then single pixels at the end of a line (odd width) and inside one
+    const int width = 7, height = 5;
+    std::vector<uint8_t> pixels(width * height);
+    std::generate(pixels.begin(), pixels.end(), [&]() { return static_cast<uint8_t>(byte(gen)); });
+    std::vector<BitmapData> indexed;
+    indexed.push_back(makeBitmap(width, height, 8, pixels));
+    indexed.push_back(indexed.back());
+    pixels[2 * width + width - 1] ^= 0x5A;
+    indexed.push_back(makeBitmap(width, height, 8, pixels));
+    pixels[4 * width + 3] ^= 0x01;
+    indexed.push_back(makeBitmap(width, height, 8, pixels));
+
+    // 8-bit lines wider than 510 pixels: every 4th pixel changed gives more than 255 packets,
+    // a change in the last pixel only a skip over more than 255 pixels
+    const int wideWidth = 1025, wideHeight = 6;
+    std::vector<uint8_t> widePixels(wideWidth * wideHeight);
+    std::generate(widePixels.begin(), widePixels.end(), [&]() { return static_cast<uint8_t>(byte(gen)); });
+    std::vector<BitmapData> wide;
+    wide.push_back(makeBitmap(wideWidth, wideHeight, 8, widePixels));
+    for (int x = 0; x < wideWidth; x += 4) {
+        widePixels[wideWidth + x] ^= 0x80;
+    }
+    widePixels[3 * wideWidth + wideWidth - 1] ^= 0x80;
+    widePixels[5 * wideWidth + 300] ^= 0x80;
+    widePixels[5 * wideWidth + 900] ^= 0x80;
+    wide.push_back(makeBitmap(wideWidth, wideHeight, 8, widePixels));
+    for (int x = 1; x < wideWidth; x += 3) {
+        widePixels[x] ^= 0x40;
+    }
+    wide.push_back(makeBitmap(wideWidth, wideHeight, 8, widePixels));
+
+    // RGB with 40 colors, kept exactly
+    std::vector<uint8_t> colors(40 * 3);
+    std::generate(colors.begin(), colors.end(), [&]() { return static_cast<uint8_t>(byte(gen)); });
+    const int rgbWidth = 9, rgbHeight = 7;
+    std::vector<uint8_t> rgbPixels(rgbWidth * rgbHeight * 3);
+    for (int k = 0; k < rgbWidth * rgbHeight; k++) {
+        std::copy_n(&colors[(k % 40) * 3], 3, &rgbPixels[k * 3]);
+    }
+    std::vector<BitmapData> fewColors;
+    fewColors.push_back(makeBitmap(rgbWidth, rgbHeight, 24, rgbPixels));
+    fewColors.push_back(fewColors.back());
+    std::copy_n(&colors[7 * 3], 3, &rgbPixels[(rgbWidth - 1) * 3]);
+    fewColors.push_back(makeBitmap(rgbWidth, rgbHeight, 24, rgbPixels));
+
+    // RGB gradient with a moving box, far more than 256 colors
+    const int gradientWidth = 63, gradientHeight = 31;
+    std::vector<BitmapData> gradient;
+    for (int frame = 0; frame < 4; frame++) {
+        std::vector<uint8_t> data(gradientWidth * gradientHeight * 3);
+        for (int y = 0; y < gradientHeight; y++) {
+            for (int x = 0; x < gradientWidth; x++) {
+                uint8_t* p = &data[(y * gradientWidth + x) * 3];
+                bool box = x >= frame * 5 && x < frame * 5 + 10 && y >= 10 && y < 20;
+                p[0] = box ? 255 : static_cast<uint8_t>(x * 4);
+                p[1] = box ? 0 : static_cast<uint8_t>(y * 8);
+                p[2] = box ? 0 : static_cast<uint8_t>((x + y) * 2);
+            }
+        }
+        gradient.push_back(makeBitmap(gradientWidth, gradientHeight, 24, data));
+    }
+
+    bool allTestsPassed = true;
+    for (FlicEncoder::Format format : {FlicEncoder::Format::FLI, FlicEncoder::Format::FLC}) {
+        bool fli = format == FlicEncoder::Format::FLI;
+        std::string suffix = fli ? " (FLI)" : " (FLC)";
+        // FLI palettes keep 6 bits per channel
+        int paletteError = fli ? 3 : 0;
+        FlicEncoder::Result result;
+
+        bool passed = checkEncoderRoundTrip("8-bit frames" + suffix, indexed, format, palette, paletteError, result);
+        if (passed && result.unchangedFrames != 1) {
+            logError("8-bit frames" + suffix + " FAILED: the repeated frame is not stored as unchanged");
+            passed = false;
+        }
+        allTestsPassed &= passed;
+
+        // LC counts the packets of a line in a byte, the line of more than 255 is stored another way
+        int wideDeltas = fli ? 1 : 2;
+        passed = checkEncoderRoundTrip("Wide 8-bit frames" + suffix, wide, format, palette, paletteError, result);
+        if (passed && result.deltaFrames != wideDeltas) {
+            logError("Wide 8-bit frames" + suffix + " FAILED: " + std::to_string(result.deltaFrames) + " delta frames, expected " +
+                     std::to_string(wideDeltas));
+            passed = false;
+        }
+        allTestsPassed &= passed;
+
+        passed = checkEncoderRoundTrip("RGB frames with 40 colors" + suffix, fewColors, format, {}, paletteError, result);
+        if (passed && (!result.exactColors || result.colors != 40)) {
+            logError("RGB frames with 40 colors" + suffix + " FAILED: " + std::to_string(result.colors) + " palette colors");
+            passed = false;
+        }
+        allTestsPassed &= passed;
+
+        passed = checkEncoderRoundTrip("RGB gradient" + suffix, gradient, format, {}, 32, result);
+        if (passed && result.exactColors) {
+            logError("RGB gradient" + suffix + " FAILED: more than 256 colors reported as exact");
+            passed = false;
+        }
+        allTestsPassed &= passed;
+    }
+
+    if (allTestsPassed) {
+        logInfo("\nAll FLIC encoder tests PASSED!");
+    } else {
+        logError("\nSome FLIC encoder tests FAILED!");
+    }
+    return allTestsPassed;
+}
+
+namespace {
+    uint32_t pngCrc(const uint8_t* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int k = 0; k < 8; k++) {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+        }
+        return ~crc;
+    }
+
+    // Writes the bitmap, reads it back and compares size, depth, pixels and for 8-bit the palette
+    bool checkCodecRoundTrip(const std::string& path, const BitmapData& bitmap, const std::vector<uint8_t>& palette, int expectedBits) {
+        std::string name = "ImageCodec " + path.substr(path.find_last_of('.') + 1) + " " + std::to_string(bitmap.bits) + "-bit";
+        ImageCodec::DecodedImage image;
+        if (!ImageCodec::writeFile(path, bitmap, palette) || !ImageCodec::readFile(path, image)) {
+            logError(name + " FAILED: cannot write or read " + path);
+            return false;
+        }
+        if (image.bitmap.width != bitmap.width || image.bitmap.height != bitmap.height || image.bitmap.bits != expectedBits) {
+            logError(name + " FAILED: read back " + std::to_string(image.bitmap.width) + "x" + std::to_string(image.bitmap.height) +
+                     " at " + std::to_string(image.bitmap.bits) + " bits");
+            return false;
+        }
+        if (expectedBits == 8 && image.palette != palette) {
+            logError(name + " FAILED: palette differs");
+            return false;
+        }
+        // Depths read back with fewer channels are compared on the channels that are left
+        int sourceBytes = bitmap.getBytesPerPixel();
+        int readBytes = image.bitmap.getBytesPerPixel();
+        std::vector<uint8_t> expected;
+        for (size_t k = 0; k < static_cast<size_t>(bitmap.width) * bitmap.height; k++) {
+            expected.insert(expected.end(), &bitmap.data[k * sourceBytes], &bitmap.data[k * sourceBytes] + readBytes);
+        }
+        return checkPixels(name, image.bitmap.data, expected);
+    }
+}
+
+bool UnitTests::ImageCodecTests() {
+    logInfo("\nRunning image codec round trip tests...\n");
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<> byte(0, 255);
+    std::vector<uint8_t> palette(768);
+    std::generate(palette.begin(), palette.end(), [&]() { return static_cast<uint8_t>(byte(gen)); });
+    std::string base = (std::filesystem::temp_directory_path() / "wxGrabber_codec_test").string();
+
+    bool allTestsPassed = true;
+    for (const char* extension : {".pcx", ".bmp", ".tga", ".png"}) {
+        std::string path = base + extension;
+        for (int bits : {8, 24, 32, -32}) {
+            // Odd width for the row padding, runs and bytes of 0xC0 and above for the RLE packets
+            BitmapData bitmap;
+            bitmap.width = 13;
+            bitmap.height = 5;
+            bitmap.bits = bits;
+            bitmap.data.resize(static_cast<size_t>(bitmap.width) * bitmap.height * bitmap.getBytesPerPixel());
+            for (size_t i = 0; i < bitmap.data.size(); i++) {
+                bitmap.data[i] = i < bitmap.data.size() / 2 ? static_cast<uint8_t>(byte(gen)) : 0xC5;
+            }
+            // 32-bit bitmaps keep no alpha and PCX stores none, those come back as 24-bit
+            int expectedBits = bits == 8 ? 8 : (bits == -32 && std::string(extension) != ".pcx" ? -32 : 24);
+            allTestsPassed &= checkCodecRoundTrip(path, bitmap, palette, expectedBits);
+        }
+        std::remove(path.c_str());
+    }
+
+    // RGB PNG with a tRNS color key: the key color must come back transparent
+    {
+        std::string path = base + ".png";
+        BitmapData bitmap;
+        bitmap.width = 4;
+        bitmap.height = 2;
+        bitmap.bits = 24;
+        bitmap.data = {255, 0, 255, 1, 2, 3, 255, 0, 255, 255, 0, 254,
+                       0, 0, 0, 255, 0, 255, 9, 9, 9, 255, 255, 255};
+        std::vector<uint8_t> file;
+        if (ImageCodec::writeFile(path, bitmap, {})) {
+            std::ifstream in(path, std::ios::binary);
+            file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        bool passed = file.size() > 33;
+        if (passed) {
+            // Inserted after the signature and IHDR chunk
+            std::vector<uint8_t> chunk = {0, 0, 0, 6, 't', 'R', 'N', 'S', 0, 255, 0, 0, 0, 255};
+            uint32_t crc = pngCrc(chunk.data() + 4, chunk.size() - 4);
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                chunk.push_back(static_cast<uint8_t>(crc >> shift));
+            }
+            file.insert(file.begin() + 33, chunk.begin(), chunk.end());
+            std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), file.size());
+            ImageCodec::DecodedImage image;
+            passed = ImageCodec::readFile(path, image) && image.bitmap.bits == -32;
+            std::vector<uint8_t> expected;
+            for (size_t k = 0; k < 8; k++) {
+                const uint8_t* rgb = &bitmap.data[k * 3];
+                expected.insert(expected.end(), rgb, rgb + 3);
+                expected.push_back(rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 255 ? 0 : 255);
+            }
+            passed = passed && checkPixels("ImageCodec png tRNS color key", image.bitmap.data, expected);
+        }
+        if (!passed) {
+            logError("ImageCodec png tRNS color key FAILED");
+        }
+        allTestsPassed &= passed;
+        std::remove(path.c_str());
+    }
+
+    if (allTestsPassed) {
+        logInfo("\nAll image codec tests PASSED!");
+    } else {
+        logError("\nSome image codec tests FAILED!");
+    }
+    return allTestsPassed;
+}
+
+bool UnitTests::FontImporterTests() {
+    logInfo("\nRunning font importer tests...\n");
+    bool allTestsPassed = true;
+
+    // BDF: a plain glyph, one with negative BBX offsets, "ENCODING -1 n" and "ENCODING -1" without a code
+    const std::string bdf =
+        "STARTFONT 2.1\n"
+        "FONTBOUNDINGBOX 8 8 -1 -2\n"
+        "FONT_ASCENT 6\n"
+        "FONT_DESCENT 2\n"
+        "CHARS 4\n"
+        "STARTCHAR A\nENCODING 65\nDWIDTH 6 0\nBBX 4 3 1 0\nBITMAP\nF0\n90\nF0\nENDCHAR\n"
+        "STARTCHAR g\nENCODING 103\nDWIDTH 5 0\nBBX 3 4 -1 -2\nBITMAP\nE0\nA0\nE0\n20\nENDCHAR\n"
+        "STARTCHAR private\nENCODING -1 57344\nDWIDTH 3 0\nBBX 2 2 0 4\nBITMAP\nC0\n40\nENDCHAR\n"
+        "STARTCHAR unencoded\nENCODING -1\nBBX 1 1 0 0\nBITMAP\n80\nENDCHAR\n"
+        "ENDFONT\n";
+    // Cells are 8 rows (ascent plus descent) and as wide as the advance, the baseline is under row 5
+    const std::vector<std::pair<uint32_t, std::vector<uint8_t>>> expectedGlyphs = {
+        {65, {0, 0, 0, 0x78, 0x48, 0x78, 0, 0}},
+        {103, {0, 0, 0, 0, 0xE0, 0xA0, 0xE0, 0x20}},
+        {0xE000, {0xC0, 0x40, 0, 0, 0, 0, 0, 0}},
+    };
+    const int expectedWidths[] = {6, 5, 3};
+    std::vector<std::pair<uint32_t, FontData::Glyph>> glyphs;
+    if (!FontImporter::parseBdf(bdf, glyphs, 1) || glyphs.size() != expectedGlyphs.size()) {
+        logError("BDF parsing FAILED: " + std::to_string(glyphs.size()) + " glyphs, expected " + std::to_string(expectedGlyphs.size()));
+        allTestsPassed = false;
+    } else {
+        for (size_t i = 0; i < glyphs.size(); i++) {
+            std::string name = "BDF glyph " + std::to_string(expectedGlyphs[i].first);
+            if (glyphs[i].first != expectedGlyphs[i].first || glyphs[i].second.width != expectedWidths[i] || glyphs[i].second.height != 8) {
+                logError(name + " FAILED: code " + std::to_string(glyphs[i].first) + ", " + std::to_string(glyphs[i].second.width) +
+                         "x" + std::to_string(glyphs[i].second.height));
+                allTestsPassed = false;
+                continue;
+            }
+            allTestsPassed &= checkPixels(name, glyphs[i].second.data, expectedGlyphs[i].second);
+        }
+    }
+
+    // Mapping file: single codes, a range, a later line overriding part of it, a line without a target
+    // and a range that would run past U+10FFFF
+    std::string path = (std::filesystem::temp_directory_path() / "wxGrabber_mapping_test.txt").string();
+    std::ofstream(path) << "# Test mapping\n"
+                           "0x20\t0x3000\n"
+                           "0x41-0x43 U+0391   # Alpha to Gamma\n"
+                           "0x50\n"
+                           "0x60-0x61 0x10FFFF\n"
+                           "66 0x100\n";
+    std::map<uint32_t, uint32_t> mapping;
+    const std::map<uint32_t, uint32_t> expectedMapping = {{0x20, 0x3000}, {0x41, 0x391}, {0x42, 0x100}, {0x43, 0x393}};
+    if (!FontImporter::readMappingFile(path, mapping) || mapping != expectedMapping) {
+        logError("Mapping file FAILED: " + std::to_string(mapping.size()) + " codes mapped, expected " + std::to_string(expectedMapping.size()));
+        allTestsPassed = false;
+    } else {
+        logInfo("Mapping file passed");
+    }
+    std::remove(path.c_str());
+
+    if (allTestsPassed) {
+        logInfo("\nAll font importer tests PASSED!");
+    } else {
+        logError("\nSome font importer tests FAILED!");
+    }
+    return allTestsPassed;
+}
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <filesystem>
 #include "../include/log.h"
+#include <algorithm>
 #include <wx/image.h>
 #include <wx/bitmap.h>
 
@@ -15,6 +16,13 @@ int VideoData::getDurationMs() const {
     return durationMs;
 }
 
+int64_t VideoData::getFrameDurationUs() const {
+    if (frameDurationUs > 0) {
+        return frameDurationUs;
+    }
+    return frameRate > 0 ? 1000000 / frameRate : 0;
+}
+
 bool VideoData::parse(const std::vector<uint8_t>& dataBuffer, ObjectType typeID, VideoData& outVideo) {
     outVideo.typeID = typeID;
     if (typeID == ObjectType::DAT_FLI) {
@@ -51,20 +59,21 @@ bool VideoData::parse(const std::vector<uint8_t>& dataBuffer, ObjectType typeID,
             logError("Invalid FLIC magic number: 0x" + std::to_string(magic));
             return false;
         }
-        //adjust speed
+        //adjust speed: FLI counts 1/70 s jiffies, FLC milliseconds
         if (speed == 0)
         {
-            outVideo.frameRate = 70;
+            outVideo.frameDurationUs = 1000000 / 70;
+        }
+        else if (magic == FLI_MAGIC_NUMBER)
+        {
+            outVideo.frameDurationUs = static_cast<int64_t>(speed) * 1000000 / 70;
         }
         else
         {
-            if (magic == FLI_MAGIC_NUMBER) {
-                outVideo.frameRate = 1000 * speed / 70;
-            }
-            else if (magic == FLC_MAGIC_NUMBER) 
-                outVideo.frameRate = 1000 / speed;
+            outVideo.frameDurationUs = static_cast<int64_t>(speed) * 1000;
         }
-        outVideo.durationMs = (outVideo.frameCount * 1000) / outVideo.frameRate;
+        outVideo.frameRate = std::max<int>(static_cast<int>((1000000 + outVideo.frameDurationUs / 2) / outVideo.frameDurationUs), 1);
+        outVideo.durationMs = static_cast<int>(outVideo.frameCount * outVideo.frameDurationUs / 1000);
         std::stringstream ss;
         ss << "Duration, sec: " << outVideo.durationMs / 1000.0;
         // get offset of frame 1 and frame 2
@@ -124,51 +133,18 @@ wxString VideoData::getPreviewCaption() const {
 
 std::vector<wxImage> VideoData::getFrameArray(int32_t requestedFrameCount) const {
     std::vector<wxImage> frames;
-    std::vector<uint8_t> colormap(256*3, 0);
-    size_t frameOffset = 128; // Default for FLI
     if (requestedFrameCount == -1) {
         requestedFrameCount = frameCount;
     }
-    std::vector<uint8_t> pixels(width * height);
-    for (int i = 0; i < requestedFrameCount; ++i) {
-        if (i == 0 && offsetFrame1) {
-            frameOffset = offsetFrame1;
-        }
-        if (i == 1 && offsetFrame2) {
-            frameOffset = offsetFrame2;
-        }
-        if (data.size() < frameOffset + 16) {
+    FlicFrameBuffer frame;
+    frame.resize(width, height);
+    std::vector<FrameEntry> index = buildFrameIndex();
+    for (int i = 0; i < requestedFrameCount && i < static_cast<int>(index.size()); ++i) {
+        if (!decodeFrame(index[i], frame)) {
             return frames;
         }
-        // Frame header: 16 bytes
-        uint32_t frameSize = data[frameOffset+0] | (data[frameOffset+1]<<8) | (data[frameOffset+2]<<16) | (data[frameOffset+3]<<24);
-        uint16_t frameMagic = data[frameOffset+4] | (data[frameOffset+5]<<8);
-        std::stringstream ss;
-        ss << std::hex << std::uppercase << frameMagic;
-        if (frameMagic != FLI_FRAME_MAGIC_NUMBER) {
-            return frames;
-        }
-        uint16_t chunks = data[frameOffset+6] | (data[frameOffset+7]<<8);
-        // skip padding 8 bytes
-        size_t chunkOffset = frameOffset + 16;
-        for (int j = 0; j < chunks; j++) {
-            size_t chunkSize = readChunk(chunkOffset, pixels, colormap);
-            chunkOffset += chunkSize;
-        }
-        // convert pixels to wxImage
-        wxImage img(width, height);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                uint8_t pixelValue = pixels[y*width+x];
-                uint8_t r = colormap[pixelValue*3];
-                uint8_t g = colormap[pixelValue*3+1];
-                uint8_t b = colormap[pixelValue*3+2];
-                img.SetRGB(x, y, r, g, b);
-            }
-        }
-        
-        frames.push_back(img);
-        frameOffset += frameSize;
+        frame.expandDirty();
+        frames.push_back(frame.toImage());
     }
     return frames;
 }
@@ -219,164 +195,205 @@ std::string getChunkTypeString(uint16_t chunkType) {
     }
 }
 
-// Chunk Handlers
-void readColorChunk(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>& colormap, bool oldColorChunk) {
-    int npackets = read16(data, pos);
+// Reads within one chunk, a chunk that ends early stops its decoder instead of overrunning
+struct ChunkReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool ok = true;
+
+    const uint8_t* take(size_t count) {
+        if (static_cast<size_t>(end - pos) < count) {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* start = pos;
+        pos += count;
+        return start;
+    }
+    uint8_t u8() {
+        const uint8_t* p = take(1);
+        return p ? p[0] : 0;
+    }
+    int8_t s8() { return static_cast<int8_t>(u8()); }
+    uint16_t u16() {
+        const uint8_t* p = take(2);
+        return p ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : 0;
+    }
+};
+
+// Chunk Handlers, all drawing whole runs with memcpy/memset and marking the rows they change
+void readColorChunk(ChunkReader& in, FlicFrameBuffer& frame, bool oldColorChunk) {
+    int npackets = in.u16();
     int i = 0;
-    while (npackets--) {
-        i += read8(data, pos); // Colors to skip
-        int colors = read8(data, pos);
+    while (npackets-- > 0 && in.ok) {
+        i += in.u8(); // Colors to skip
+        int colors = in.u8();
         if (colors == 0) colors = 256;
-        for (int j = 0; j < colors && i + j < 256; ++j) {
-            uint8_t r = read8(data, pos);
-            uint8_t g = read8(data, pos);
-            uint8_t b = read8(data, pos);
-            if (oldColorChunk) {
-                r = 255 * int(r) / 63;
-                g = 255 * int(g) / 63;
-                b = 255 * int(b) / 63;
+        for (int j = 0; j < colors; ++j) {
+            const uint8_t* rgb = in.take(3);
+            if (!rgb) {
+                return;
+            }
+            if (i + j < 256) {
+                if (oldColorChunk) {
+                    frame.setColor(i + j, 255 * (rgb[0] & 63) / 63, 255 * (rgb[1] & 63) / 63, 255 * (rgb[2] & 63) / 63);
+                } else {
+                    frame.setColor(i + j, rgb[0], rgb[1], rgb[2]);
+                }
             }
-            colormap[(i + j) * 3 + 0] = r;
-            colormap[(i + j) * 3 + 1] = g;
-            colormap[(i + j) * 3 + 2] = b;
         }
         i += colors;
     }
 }
 
-void readDeltaChunk(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>& pixels, int width, int height) {
-    int nlines = read16(data, pos);
+// Copy count bytes, or as many as fit, to x of a row; x moves on by count either way
+void copyRun(uint8_t* row, int width, int& x, const uint8_t* src, int count) {
+    if (x >= 0 && x < width) {
+        std::memcpy(row + x, src, std::min(count, width - x));
+    }
+    x += count;
+}
+
+void fillRun(uint8_t* row, int width, int& x, uint8_t color, int count) {
+    if (x >= 0 && x < width) {
+        std::memset(row + x, color, std::min(count, width - x));
+    }
+    x += count;
+}
+
+// DELTA_FLC: word oriented line packets
+void readDeltaChunk(ChunkReader& in, FlicFrameBuffer& frame) {
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    int nlines = in.u16();
     int y = 0;
-    while (nlines-- != 0) {
-        int npackets = 0;
-        while (pos + 2 <= data.size()) {
-            int16_t word = read16(data, pos);
-            if (word < 0) {
-                if (word & 0x4000) {
-                    y += -word;
-                } else {
-                    if (y >= 0 && y < height) {
-                        size_t idx = y * width + width - 1;
-                        if (idx < pixels.size())
-                            pixels[idx] = word & 0xff;
-                    }
-                    ++y;
-                    if (nlines-- == 0) return;
-                }
-            } else {
-                npackets = word;
-                break;
-            }
+    while (nlines > 0 && y < height && in.ok) {
+        uint16_t word = in.u16();
+        if ((word & 0xC000) == 0xC000) {
+            y += 0x10000 - word; // Skip lines
+            continue;
+        }
+        if ((word & 0xC000) == 0x8000) {
+            // Last pixel of the line, the packet count follows
+            frame.row(y)[width - 1] = word & 0xFF;
+            frame.markRows(y, 1);
+            continue;
+        }
+        if (word & 0x4000) {
+            return; // Undefined opcode
         }
-        if (y >= height) break;
+        uint8_t* row = frame.row(y);
         int x = 0;
-        while (npackets-- != 0) {
-            x += read8(data, pos);
-            int8_t count = read8s(data, pos);
-            size_t idx = y * width + x;
+        for (int npackets = word; npackets > 0 && in.ok; --npackets) {
+            x += in.u8();
+            int count = in.s8();
             if (count >= 0) {
-                while (count-- != 0 && x < width) {
-                    int color1 = read8(data, pos);
-                    int color2 = read8(data, pos);
-                    if (idx < pixels.size()) pixels[idx] = color1;
-                    ++idx; ++x;
-                    if (x < width && idx < pixels.size()) pixels[idx] = color2;
-                    ++idx; ++x;
-                }
+                const uint8_t* src = in.take(count * 2);
+                if (!src) break;
+                copyRun(row, width, x, src, count * 2);
             } else {
-                int color1 = read8(data, pos);
-                int color2 = read8(data, pos);
-                while (count++ != 0 && x < width) {
-                    if (idx < pixels.size()) pixels[idx] = color1;
-                    ++idx; ++x;
-                    if (x < width && idx < pixels.size()) pixels[idx] = color2;
-                    ++idx; ++x;
+                uint8_t color1 = in.u8();
+                uint8_t color2 = in.u8();
+                for (; count < 0 && x < width; ++count) {
+                    row[x++] = color1;
+                    if (x < width) row[x] = color2;
+                    ++x;
                 }
             }
         }
+        if (word > 0) {
+            frame.markRows(y, 1);
+        }
         ++y;
+        --nlines;
     }
 }
 
-void readLcChunk(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>& pixels, int width, int height) {
-    int skipLines = read16(data, pos);
-    int nlines = read16(data, pos);
-    for (int y = skipLines; y < skipLines + nlines; ++y) {
-        if (y < 0 || y >= height) break;
-        size_t row = y * width;
+// DELTA_FLI: byte oriented line packets after a count of unchanged lines
+void readLcChunk(ChunkReader& in, FlicFrameBuffer& frame) {
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    int y = in.u16();
+    int nlines = in.u16();
+    for (; nlines > 0 && y < height && in.ok; --nlines, ++y) {
+        uint8_t* row = frame.row(y);
         int x = 0;
-        int npackets = read8(data, pos);
-        while (npackets-- && x < width) {
-            int skip = read8(data, pos);
-            x += skip;
-            int count = int(read8s(data, pos));
+        int npackets = in.u8();
+        if (npackets > 0) {
+            frame.markRows(y, 1);
+        }
+        while (npackets-- > 0 && in.ok) {
+            x += in.u8();
+            int count = in.s8();
             if (count >= 0) {
-                while (count-- && x < width) {
-                    pixels[row + x] = read8(data, pos);
-                    ++x;
-                }
+                const uint8_t* src = in.take(count);
+                if (!src) break;
+                copyRun(row, width, x, src, count);
             } else {
-                uint8_t color = read8(data, pos);
-                while (count++ && x < width) {
-                    pixels[row + x] = color;
-                    ++x;
-                }
+                fillRun(row, width, x, in.u8(), -count);
             }
         }
     }
 }
 
-void readBlackChunk(std::vector<uint8_t>& pixels) {
-    std::fill(pixels.begin(), pixels.end(), 0);
+void readBlackChunk(FlicFrameBuffer& frame) {
+    if (frame.getHeight() > 0) {
+        std::memset(frame.row(0), 0, static_cast<size_t>(frame.getWidth()) * frame.getHeight());
+    }
+    frame.markAll();
 }
 
-void readBrunChunk(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>& pixels, int width, int height) {
-    for (int y = 0; y < height; ++y) {
-        size_t row = y * width;
-        int npackets = read8(data, pos);
+void readBrunChunk(ChunkReader& in, FlicFrameBuffer& frame) {
+    int width = frame.getWidth();
+    for (int y = 0; y < frame.getHeight() && in.ok; ++y) {
+        uint8_t* row = frame.row(y);
+        // The packet count byte cannot describe wide lines, runs are decoded until the line is full
+        in.u8();
         int x = 0;
-        while (npackets-- && x < width) {
-            int count = int(read8s(data, pos));
+        while (x < width && in.ok) {
+            int count = in.s8();
             if (count >= 0) {
-                uint8_t color = read8(data, pos);
-                while (count-- && x < width) {
-                    pixels[row + x] = color;
-                    ++x;
-                }
+                fillRun(row, width, x, in.u8(), count);
             } else {
-                while (count++ && x < width) {
-                    pixels[row + x] = read8(data, pos);
-                    ++x;
-                }
+                const uint8_t* src = in.take(-count);
+                if (!src) break;
+                copyRun(row, width, x, src, -count);
             }
         }
     }
+    frame.markAll();
 }
 
-void readCopyChunk(const std::vector<uint8_t>& data, size_t& pos, std::vector<uint8_t>& pixels, int width, int height) {
-    for (int y = 0; y < height; ++y) {
-        size_t row = y * width;
-        for (int x = 0; x < width; ++x) {
-            if (row + x < pixels.size() && pos < data.size())
-                pixels[row + x] = read8(data, pos);
-        }
+void readCopyChunk(ChunkReader& in, FlicFrameBuffer& frame) {
+    for (int y = 0; y < frame.getHeight(); ++y) {
+        const uint8_t* src = in.take(frame.getWidth());
+        if (!src) break;
+        std::memcpy(frame.row(y), src, frame.getWidth());
     }
+    frame.markAll();
 }
 }
 
-size_t VideoData::readChunk(size_t offset, std::vector<uint8_t>& outPixels, std::vector<uint8_t>& colormap) const {
-    uint32_t chunkStartPos = offset;
+size_t VideoData::readChunk(size_t offset, FlicFrameBuffer& frame) const {
+    if (offset + 6 > data.size()) {
+        return 0;
+    }
+    size_t chunkStartPos = offset;
     uint32_t chunkSize = read32(data, offset);
     uint16_t type = read16(data, offset);
+    size_t chunkEnd = std::min<size_t>(chunkStartPos + std::max<uint32_t>(chunkSize, 6), data.size());
+    ChunkReader in{data.data() + offset, data.data() + chunkEnd};
 
+    // Pixel chunks need a framebuffer, the frame index only reads colors
+    bool hasPixels = frame.getWidth() == width && frame.getHeight() == height && width > 0 && height > 0;
     switch (type) {
-        case FLI_COLOR_256_CHUNK: readColorChunk(data, offset, colormap, false); break;
-        case FLI_DELTA_CHUNK:     readDeltaChunk(data, offset, outPixels, width, height); break;
-        case FLI_COLOR_64_CHUNK:  readColorChunk(data, offset, colormap, true); break;
-        case FLI_LC_CHUNK:        readLcChunk(data, offset, outPixels, width, height); break;
-        case FLI_BLACK_CHUNK:     readBlackChunk(outPixels); break;
-        case FLI_BRUN_CHUNK:      readBrunChunk(data, offset, outPixels, width, height); break;
-        case FLI_COPY_CHUNK:      readCopyChunk(data, offset, outPixels, width, height); break;
+        case FLI_COLOR_256_CHUNK: readColorChunk(in, frame, false); break;
+        case FLI_COLOR_64_CHUNK:  readColorChunk(in, frame, true); break;
+        case FLI_DELTA_CHUNK:     if (hasPixels) readDeltaChunk(in, frame); break;
+        case FLI_LC_CHUNK:        if (hasPixels) readLcChunk(in, frame); break;
+        case FLI_BLACK_CHUNK:     if (hasPixels) readBlackChunk(frame); break;
+        case FLI_BRUN_CHUNK:      if (hasPixels) readBrunChunk(in, frame); break;
+        case FLI_COPY_CHUNK:      if (hasPixels) readCopyChunk(in, frame); break;
         default:
             // Ignore all other kind of chunks
             break;
@@ -384,6 +401,69 @@ size_t VideoData::readChunk(size_t offset, std::vector<uint8_t>& outPixels, std:
     return chunkSize;
 }
 
+std::vector<VideoData::FrameEntry> VideoData::buildFrameIndex() const {
+    std::vector<FrameEntry> frames;
+    FlicFrameBuffer colors;  // No pixels, only the colormap is followed
+    size_t frameOffset = offsetFrame1 ? offsetFrame1 : 128; // 128 for FLI
+    for (int i = 0; i < frameCount; ++i) {
+        if (i == 1 && offsetFrame2) {
+            frameOffset = offsetFrame2;
+        }
+        if (data.size() < frameOffset + 16) {
+            break;
+        }
+        size_t pos = frameOffset;
+        uint32_t frameSize = read32(data, pos);
+        uint16_t frameMagic = read16(data, pos);
+        if (frameMagic != FLI_FRAME_MAGIC_NUMBER || frameSize < 16) {
+            break;
+        }
+        FrameEntry entry;
+        entry.offset = frameOffset;
+        entry.chunks = read16(data, pos);
+
+        // Only colormap chunks are decoded here, the first pixel chunk tells whether the frame is a keyframe
+        std::vector<uint8_t> colormapBefore = colors.getColormap();
+        bool pixelChunkSeen = false;
+        size_t chunkOffset = frameOffset + 16;
+        for (int j = 0; j < entry.chunks && chunkOffset + 6 <= data.size(); j++) {
+            pos = chunkOffset + 4;
+            uint16_t type = read16(data, pos);
+            size_t chunkSize = readChunk(chunkOffset, colors);
+            if (chunkSize < 6) {
+                break;
+            }
+            if (!pixelChunkSeen && (type == FLI_DELTA_CHUNK || type == FLI_LC_CHUNK || type == FLI_BLACK_CHUNK ||
+                                    type == FLI_BRUN_CHUNK || type == FLI_COPY_CHUNK)) {
+                pixelChunkSeen = true;
+                entry.keyframe = type == FLI_BLACK_CHUNK || type == FLI_BRUN_CHUNK || type == FLI_COPY_CHUNK;
+            }
+            chunkOffset += chunkSize;
+        }
+        if (entry.keyframe) {
+            entry.palette = std::move(colormapBefore);
+        }
+        frames.push_back(std::move(entry));
+        frameOffset += frameSize;
+    }
+    return frames;
+}
+
+bool VideoData::decodeFrame(const FrameEntry& entry, FlicFrameBuffer& frame) const {
+    if (frame.getWidth() != width || frame.getHeight() != height) {
+        frame.resize(width, height);
+    }
+    size_t chunkOffset = entry.offset + 16;
+    for (int j = 0; j < entry.chunks; j++) {
+        size_t chunkSize = readChunk(chunkOffset, frame);
+        if (chunkSize < 6) {
+            return false;
+        }
+        chunkOffset += chunkSize;
+    }
+    return true;
+}
+
 VideoData VideoData::createSampleFLI() {
     VideoData video;
     
@@ -26,10 +26,11 @@ VideoDataPanel::VideoDataPanel(wxWindow* parent, std::function<void(int, int)> u
 }
 
 void VideoDataPanel::SetVideoData(std::shared_ptr<DataParser::DataObject> videoObject) {
+    m_stream.reset();
     m_videoObject = videoObject;
     if (m_videoObject && m_videoObject->isVideo()) {
-        VideoData videoData = m_videoObject->getVideo();
-        m_frameRate = videoData.frameRate;
+        const VideoData& videoData = m_videoObject->getVideo();
+        m_clock.setFrameDuration(videoData.getFrameDurationUs());
         SetTotalDurationMs(videoData.getDurationMs());
         // Set the panel's minimum and initial size to match the video dimensions
         if (videoData.width > 0 && videoData.height > 0) {
@@ -37,12 +38,23 @@ void VideoDataPanel::SetVideoData(std::shared_ptr<DataParser::DataObject> videoO
             SetInitialSize(wxSize(videoData.width, videoData.height));
             if (GetParent()) GetParent()->Layout();
         }
+        m_stream = std::make_unique<FlicStream>(videoData);
     }
-    m_frames.clear();
     UpdatePreview();
     Refresh();
 }
 
+void VideoDataPanel::SetSyncSource(std::function<int()> positionMs) {
+    if (!positionMs) {
+        m_clock.setMaster(nullptr);
+        return;
+    }
+    m_clock.setMaster([positionMs]() -> int64_t {
+        int position = positionMs();
+        return position < 0 ? -1 : static_cast<int64_t>(position) * 1000;
+    });
+}
+
 void VideoDataPanel::OnPaint(wxPaintEvent& event) {
     wxBufferedPaintDC dc(this);
     RenderFrame(dc);
@@ -63,21 +75,32 @@ void VideoDataPanel::RenderFrame(wxDC& dc) {
 }
 
 void VideoDataPanel::PlayPause() {
-    if (!m_videoObject) return;
-    AVControlInterface::PlayPause();
-    if (m_frames.empty()) {
-        m_frames = m_videoObject->getVideo().getFrameArray();
+    if (!m_videoObject || !m_stream) return;
+    bool resuming = m_isPaused;
+    if (m_isPlaying) {
+        // Hand the exact position to the interface before it pauses
+        m_currentPositionMs = static_cast<int>(m_clock.update() / 1000);
+        m_lastUpdateTime = std::chrono::steady_clock::now();
     }
+    AVControlInterface::PlayPause();
     if (m_isPlaying) {
-        int delay = (m_frameRate > 0) ? (1000 / m_frameRate) : 100;
-        m_timer->Start(delay);
+        // The playback clock reports the position, the interface timer would only round it
+        AVControlInterface::m_timer->Stop();
+        if (!resuming) m_clock.resetStats();
+        m_clock.start(static_cast<int64_t>(m_currentPositionMs) * 1000);
+        m_lastReportUs = m_clock.getPositionUs();
+        OnTimer();
     } else {
+        m_clock.pause();
         m_timer->Stop();
+        LogPlaybackStats();
     }
 }
 
 void VideoDataPanel::Stop() {
+    if (m_isPlaying || m_isPaused) LogPlaybackStats();
     AVControlInterface::Stop();
+    m_clock.pause();
     m_currentFrameIndex = 0;
     if (m_timer) m_timer->Stop();
     UpdatePreview();
@@ -85,36 +108,69 @@ void VideoDataPanel::Stop() {
 }
 
 void VideoDataPanel::OnTimer() {
-    if (m_frames.empty()) return;
-    m_currentFrameIndex++;
-    if (m_currentFrameIndex >= m_frames.size()) {
-        m_currentFrameIndex = m_frames.size() - 1;
+    if (!m_stream || m_stream->getFrameCount() == 0 || !m_isPlaying) return;
+    int64_t positionUs = m_clock.update();
+    int frame = m_clock.frameAt(positionUs);
+    if (frame >= m_stream->getFrameCount()) {
+        m_currentPositionMs = m_totalDurationMs;
+        m_updateCallback(m_currentPositionMs, m_totalDurationMs);
+        Stop();
         return;
     }
-    m_currentFrame = m_frames[m_currentFrameIndex];
+    // Frames whose time has passed are skipped, the stream decodes through them without converting them
+    if (frame != static_cast<int>(m_currentFrameIndex)) {
+        ShowFrame(frame);
+        m_clock.frameShown(frame);
+    }
+    m_currentPositionMs = static_cast<int>(positionUs / 1000);
+    m_lastUpdateTime = std::chrono::steady_clock::now();
+    if (positionUs < m_lastReportUs || positionUs - m_lastReportUs >= m_updateIntervalMs * 1000) {
+        m_lastReportUs = positionUs;
+        m_updateCallback(m_currentPositionMs, m_totalDurationMs);
+    }
+    ScheduleNextFrame();
+}
+
+void VideoDataPanel::ScheduleNextFrame() {
+    // Wake when the next frame is due, or in time for the next position update of a slow clip
+    int64_t waitUs = m_clock.getUsUntil(static_cast<int>(m_currentFrameIndex) + 1);
+    int waitMs = static_cast<int>(std::min<int64_t>((waitUs + 999) / 1000, m_updateIntervalMs));
+    m_timer->Start(std::max(waitMs, 1), wxTIMER_ONE_SHOT);
+}
+
+void VideoDataPanel::ShowFrame(int frame) {
+    m_currentFrameIndex = frame;
+    m_currentFrame = m_stream->getFrame(frame);
     Refresh();
 }
 
+void VideoDataPanel::LogPlaybackStats() const {
+    const PlaybackClock::Stats& stats = m_clock.getStats();
+    if (stats.framesShown == 0) return;
+    LOG_INFO("FLIC playback: %d frames shown, %d dropped, %d late (worst %.1f ms), %d resyncs",
+             stats.framesShown, stats.framesDropped, stats.lateFrames, stats.maxLateUs / 1000.0, stats.resyncs);
+}
+
 void VideoDataPanel::UpdatePreview() {
     m_currentFrame = wxImage();
-    if (!m_videoObject || m_videoObject->getVideo().frameCount == 0) return;
-    m_currentFrame = m_videoObject->getVideo().getPreviewFrame();
+    if (!m_stream) return;
+    m_currentFrame = m_stream->getFrame(0);
 }
 
 void VideoDataPanel::SetCurrentPositionMs(int currentPositionMs) {
     AVControlInterface::SetCurrentPositionMs(currentPositionMs);
-    m_currentFrameIndex = (currentPositionMs * m_frameRate) / 1000;
-    if (!m_videoObject) return;
-    if (m_frames.empty()) {
-        m_frames = m_videoObject->getVideo().getFrameArray();
-    }
-    if (m_frames.empty()) {
+    if (!m_stream) return;
+    int64_t positionUs = static_cast<int64_t>(currentPositionMs) * 1000;
+    m_lastReportUs = positionUs;
+    if (m_stream->getFrameCount() == 0) {
         m_currentFrameIndex = 0;
         m_currentFrame = wxImage();
-    } else {
-        m_currentFrameIndex = std::min(m_currentFrameIndex, m_frames.size() - 1);
-        //logDebug("SetCurrentPositionMs: m_currentFrameIndex = " + std::to_string(m_currentFrameIndex) + " m_frames.size() = " + std::to_string(m_frames.size()));
-        m_currentFrame = m_frames[m_currentFrameIndex];
+        Refresh();
+        return;
+    }
+    ShowFrame(std::min(m_clock.frameAt(positionUs), m_stream->getFrameCount() - 1));
+    if (m_isPlaying) {
+        m_clock.seek(positionUs);
+        ScheduleNextFrame();
     }
-    Refresh();
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "../include/WaveformView.h"
+#include "../include/log.h"
+#include <wx/dcbuffer.h>
+#include <algorithm>
+#include <cmath>
+
+wxBEGIN_EVENT_TABLE(WaveformView, wxWindow)
+    EVT_PAINT(WaveformView::OnPaint)
+    EVT_MOUSEWHEEL(WaveformView::OnMouseWheel)
+    EVT_LEFT_DOWN(WaveformView::OnLeftDown)
+    EVT_TIMER(wxID_ANY, WaveformView::OnPollTimer)
+wxEND_EVENT_TABLE()
+
+namespace {
+    const wxColour BackgroundColour(32, 32, 32);
+    const wxColour WaveColour(90, 200, 120);
+    const wxColour AxisColour(70, 70, 70);
+    const wxColour PlayheadColour(230, 70, 60);
+    const wxColour TextColour(200, 200, 200);
+
+    wxString FormatLevel(float level) {
+        if (level <= 0.0f) {
+            return "-inf dB";
+        }
+        return wxString::Format("%.1f dB", 20.0 * std::log10(level));
+    }
+}
+
+WaveformView::WaveformView(wxWindow* parent, AudioAnalysisCache& cache, SeekCallback seekCallback)
+    : wxWindow(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxFULL_REPAINT_ON_RESIZE),
+      m_cache(cache),
+      m_seekCallback(seekCallback),
+      m_pollTimer(this)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT); // Needed for double buffering
+}
+
+WaveformView::~WaveformView() {
+    m_pollTimer.Stop();
+}
+
+void WaveformView::SetAudio(const std::shared_ptr<DataParser::DataObject>& obj) {
+    m_pollTimer.Stop();
+    m_analysis = nullptr;
+    m_viewStart = 0;
+    m_viewFrames = 0;
+    m_positionMs = 0;
+    m_hasAudio = obj && obj->isAudio() && AudioAnalysisCache::canAnalyze(obj->getAudio());
+    if (m_hasAudio) {
+        const AudioData& audio = obj->getAudio();
+        m_key = AudioAnalysisCache::makeKey(audio);
+        m_analysis = m_cache.find(m_key);
+        if (!m_analysis) {
+            m_cache.request(m_key, audio);
+            m_pollTimer.Start(PollIntervalMs);
+        }
+    }
+    Refresh();
+}
+
+void WaveformView::SetPositionMs(int positionMs) {
+    if (positionMs == m_positionMs) {
+        return;
+    }
+    m_positionMs = positionMs;
+    if (m_analysis && m_viewFrames > 0) {
+        // Page along with the playhead when zoomed in
+        int64_t frame = static_cast<int64_t>(positionMs) * m_analysis->sampleRate / 1000;
+        if (frame < m_viewStart || frame >= m_viewStart + m_viewFrames) {
+            m_viewStart = frame;
+            ClampView();
+        }
+    }
+    Refresh();
+}
+
+void WaveformView::OnPollTimer(wxTimerEvent& event) {
+    m_analysis = m_cache.find(m_key);
+    if (m_analysis || m_cache.hasFailed(m_key)) {
+        m_pollTimer.Stop();
+        Refresh();
+    }
+}
+
+int64_t WaveformView::ViewFrames() const {
+    return m_viewFrames > 0 ? m_viewFrames : std::max<int64_t>(m_analysis->totalFrames, 1);
+}
+
+int64_t WaveformView::FrameAt(int x) const {
+    int width = std::max(GetClientSize().GetWidth(), 1);
+    return m_viewStart + static_cast<int64_t>(static_cast<double>(x) * ViewFrames() / width);
+}
+
+int WaveformView::XAt(int64_t frame) const {
+    int width = GetClientSize().GetWidth();
+    return static_cast<int>(static_cast<double>(frame - m_viewStart) * width / ViewFrames());
+}
+
+void WaveformView::ClampView() {
+    if (m_viewFrames >= m_analysis->totalFrames) {
+        m_viewFrames = 0;  // Zoomed out all the way
+    }
+    m_viewStart = m_viewFrames > 0 ? std::clamp<int64_t>(m_viewStart, 0, m_analysis->totalFrames - m_viewFrames) : 0;
+}
+
+void WaveformView::OnMouseWheel(wxMouseEvent& event) {
+    if (!m_analysis || m_analysis->totalFrames <= 0 || event.GetWheelRotation() == 0) {
+        return;
+    }
+    double steps = static_cast<double>(event.GetWheelRotation()) / event.GetWheelDelta();
+    if (event.ShiftDown()) {
+        m_viewStart -= static_cast<int64_t>(steps * ViewFrames() / 8);
+    } else {
+        // Keep the frame under the pointer in place
+        int64_t anchor = FrameAt(event.GetX());
+        double anchorFraction = static_cast<double>(anchor - m_viewStart) / ViewFrames();
+        int64_t minFrames = std::max(GetClientSize().GetWidth() / 4, 16);
+        m_viewFrames = std::max<int64_t>(minFrames, static_cast<int64_t>(ViewFrames() * std::pow(0.8, steps)));
+        m_viewStart = anchor - static_cast<int64_t>(anchorFraction * m_viewFrames);
+    }
+    ClampView();
+    Refresh();
+}
+
+void WaveformView::OnLeftDown(wxMouseEvent& event) {
+    if (!m_analysis || m_analysis->sampleRate <= 0) {
+        return;
+    }
+    int64_t frame = std::clamp<int64_t>(FrameAt(event.GetX()), 0, m_analysis->totalFrames);
+    if (m_seekCallback) {
+        m_seekCallback(static_cast<int>(frame * 1000 / m_analysis->sampleRate));
+    }
+}
+
+void WaveformView::OnPaint(wxPaintEvent& event) {
+    PROFILE_SCOPE("WaveformView::OnPaint");
+    wxAutoBufferedPaintDC dc(this);
+    dc.SetBackground(wxBrush(BackgroundColour));
+    dc.Clear();
+    if (!m_hasAudio) {
+        return;
+    }
+
+    wxSize size = GetClientSize();
+    dc.SetTextForeground(TextColour);
+    if (!m_analysis) {
+        dc.DrawText(m_cache.hasFailed(m_key) ? "Waveform not available" : "Analyzing...", 5, 5);
+        return;
+    }
+
+    int channels = std::max(m_analysis->channels, 1);
+    int laneHeight = size.GetHeight() / channels;
+    int64_t viewEnd = m_viewStart + ViewFrames();
+    for (int ch = 0; ch < channels; ch++) {
+        int top = ch * laneHeight;
+        int middle = top + laneHeight / 2;
+        double scale = (laneHeight / 2 - 1) / 32768.0;
+        dc.SetPen(wxPen(AxisColour));
+        dc.DrawLine(0, middle, size.GetWidth(), middle);
+
+        m_analysis->peaks(ch, m_viewStart, viewEnd, size.GetWidth(), m_peaks);
+        dc.SetPen(wxPen(WaveColour));
+        for (int x = 0; x < static_cast<int>(m_peaks.size()); x++) {
+            int y0 = middle - static_cast<int>(m_peaks[x].max * scale);
+            int y1 = middle - static_cast<int>(m_peaks[x].min * scale);
+            dc.DrawLine(x, y0, x, y1 + 1);
+        }
+
+        if (ch < static_cast<int>(m_analysis->stats.size())) {
+            const AudioAnalysis::ChannelStats& stats = m_analysis->stats[ch];
+            dc.DrawText("Peak " + FormatLevel(stats.peak) + "  RMS " + FormatLevel(stats.rms), 5, top + 2);
+        }
+    }
+
+    int64_t positionFrame = static_cast<int64_t>(m_positionMs) * m_analysis->sampleRate / 1000;
+    if (positionFrame >= m_viewStart && positionFrame <= viewEnd) {
+        int x = XAt(positionFrame);
+        dc.SetPen(wxPen(PlayheadColour));
+        dc.DrawLine(x, 0, x, size.GetHeight());
+    }
+}
@@ -1,5 +1,34 @@
 #include "../include/log.h"
 #include <mutex>
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
+#include <map>
+
+namespace {
+    // Small sequential thread ids read better in traces than hashed std::thread::id
+    std::atomic<uint32_t> nextProfileThreadId{1};
+    thread_local uint32_t profileThreadId = 0;
+    thread_local uint32_t profileDepth = 0;
+
+    uint32_t currentProfileThreadId() {
+        if (profileThreadId == 0) {
+            profileThreadId = nextProfileThreadId++;
+        }
+        return profileThreadId;
+    }
+
+    void writeJsonString(std::ostream& out, const char* text) {
+        out << '"';
+        for (const char* c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+}
 
 // Logger implementation
 Logger& Logger::getInstance() {
@@ -8,14 +37,282 @@ Logger& Logger::getInstance() {
 }
 
 bool Logger::init(const std::string& filename) {
+    // Stop a previous writer before reopening the file
+    shutdown();
+
     std::lock_guard<std::mutex> lock(logMutex);
     logFile.open(filename, std::ios::out | std::ios::trunc);
-    return logFile.is_open();
+    if (!logFile.is_open()) {
+        return false;
+    }
+    stopWriter = false;
+    writerThread = std::thread(&Logger::writerLoop, this);
+    return true;
 }
 
 void Logger::setLevel(Level level) {
+    currentLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::logf(Level level, const char* format, ...) {
+    char stackBuffer[512];
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = std::vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+
+    if (length < 0) {
+        va_end(argsCopy);
+        return;
+    }
+    if (static_cast<size_t>(length) < sizeof(stackBuffer)) {
+        va_end(argsCopy);
+        enqueue(level, std::string(stackBuffer, length));
+        return;
+    }
+
+    // Message did not fit, format again into a heap buffer of the exact size
+    std::string message(length, '\0');
+    std::vsnprintf(&message[0], length + 1, format, argsCopy);
+    va_end(argsCopy);
+    enqueue(level, std::move(message));
+}
+
+void Logger::enqueue(Level level, std::string message) {
+    Entry entry{std::chrono::system_clock::now(), level, std::move(message)};
+
+    std::unique_lock<std::mutex> lock(logMutex);
+    if (!writerThread.joinable()) {
+        // No writer running (before init or after shutdown), write synchronously
+        if (logFile.is_open()) {
+            writeEntry(entry);
+            logFile.flush();
+        }
+        return;
+    }
+
+    // When the ring is full, wait for the writer to make room rather than losing lines
+    queueDrained.wait(lock, [this] { return queueCount < QueueCapacity; });
+
+    queue[(queueHead + queueCount) % QueueCapacity] = std::move(entry);
+    queueCount++;
+    lock.unlock();
+    queueNotEmpty.notify_one();
+}
+
+void Logger::writerLoop() {
+    std::vector<Entry> batch;
+    batch.reserve(QueueCapacity);
+
+    std::unique_lock<std::mutex> lock(logMutex);
+    while (true) {
+        queueNotEmpty.wait(lock, [this] { return queueCount > 0 || stopWriter; });
+        if (queueCount == 0 && stopWriter) {
+            break;
+        }
+
+        // Take the whole backlog in one go so it can be written with a single flush
+        while (queueCount > 0) {
+            batch.push_back(std::move(queue[queueHead]));
+            queueHead = (queueHead + 1) % QueueCapacity;
+            queueCount--;
+        }
+        writerBusy = true;
+        lock.unlock();
+        queueDrained.notify_all();
+
+        for (const Entry& entry : batch) {
+            writeEntry(entry);
+        }
+        logFile.flush();
+        batch.clear();
+
+        lock.lock();
+        writerBusy = false;
+        queueDrained.notify_all();
+    }
+}
+
+void Logger::writeEntry(const Entry& entry) {
+    auto time = std::chrono::system_clock::to_time_t(entry.time);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        entry.time.time_since_epoch()) % 1000;
+
+    std::tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &time);
+#else
+    localtime_r(&time, &timeinfo);
+#endif
+
+    logFile << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S")
+            << '.' << std::setfill('0') << std::setw(3) << ms.count()
+            << " [" << getLevelString(entry.level) << "] "
+            << entry.message << '\n';
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(logMutex);
+    if (!writerThread.joinable()) {
+        if (logFile.is_open()) {
+            logFile.flush();
+        }
+        return;
+    }
+    queueDrained.wait(lock, [this] { return queueCount == 0 && !writerBusy; });
+}
+
+void Logger::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if (!writerThread.joinable()) {
+            return;
+        }
+        stopWriter = true;
+    }
+    queueNotEmpty.notify_one();
+    writerThread.join();
+
     std::lock_guard<std::mutex> lock(logMutex);
-    currentLevel = level;
+    writerThread = std::thread();
+    if (logFile.is_open()) {
+        logFile.flush();
+    }
+}
+
+void Logger::setProfiling(bool enabled) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    if (enabled && !profiling.load()) {
+        profileSpans.clear();
+        profileCounters.clear();
+        counterTotals.clear();
+        droppedSpans = 0;
+        profileStart = std::chrono::steady_clock::now();
+    }
+    profiling.store(enabled);
+}
+
+uint64_t Logger::profileTimeUs() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - profileStart).count();
+}
+
+void Logger::recordSpan(const char* name, uint64_t startUs, uint64_t durationUs, uint32_t depth) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    if (profileSpans.size() >= MaxProfileSpans) {
+        droppedSpans++;
+        return;
+    }
+    profileSpans.push_back({name, startUs, durationUs, currentProfileThreadId(), depth});
+}
+
+void Logger::addCounter(const char* name, int64_t delta) {
+    uint64_t now = profileTimeUs();
+    std::lock_guard<std::mutex> lock(profileMutex);
+    int64_t& total = counterTotals[name];
+    total += delta;
+    if (profileCounters.size() < MaxProfileSpans) {
+        profileCounters.push_back({name, now, total, currentProfileThreadId()});
+    }
+}
+
+bool Logger::writeChromeTrace(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const ProfileSpan& span : profileSpans) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(out, span.name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.threadId
+            << ",\"ts\":" << span.startUs << ",\"dur\":" << span.durationUs
+            << ",\"args\":{\"depth\":" << span.depth << "}}";
+        first = false;
+    }
+    for (const ProfileCounter& counter : profileCounters) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(out, counter.name);
+        out << ",\"ph\":\"C\",\"pid\":1,\"tid\":" << counter.threadId
+            << ",\"ts\":" << counter.timeUs << ",\"args\":{\"value\":" << counter.value << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return out.good();
+}
+
+std::string Logger::getProfileSummary() const {
+    struct SpanStats {
+        size_t calls = 0;
+        uint64_t totalUs = 0;
+        uint64_t maxUs = 0;
+    };
+
+    std::map<std::string, SpanStats> stats;
+    std::map<std::string, int64_t> counters;
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        for (const ProfileSpan& span : profileSpans) {
+            SpanStats& entry = stats[span.name];
+            entry.calls++;
+            entry.totalUs += span.durationUs;
+            entry.maxUs = std::max(entry.maxUs, span.durationUs);
+        }
+        counters.insert(counterTotals.begin(), counterTotals.end());
+        dropped = droppedSpans;
+    }
+
+    std::vector<std::pair<std::string, SpanStats>> sorted(stats.begin(), stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.totalUs > b.second.totalUs;
+    });
+
+    std::ostringstream ss;
+    ss << std::left << std::setw(40) << "Span" << std::right
+       << std::setw(10) << "Calls" << std::setw(14) << "Total ms"
+       << std::setw(12) << "Avg ms" << std::setw(12) << "Max ms" << '\n';
+    ss << std::fixed << std::setprecision(3);
+    for (const auto& [name, entry] : sorted) {
+        ss << std::left << std::setw(40) << name << std::right
+           << std::setw(10) << entry.calls
+           << std::setw(14) << entry.totalUs / 1000.0
+           << std::setw(12) << entry.totalUs / 1000.0 / entry.calls
+           << std::setw(12) << entry.maxUs / 1000.0 << '\n';
+    }
+    for (const auto& [name, value] : counters) {
+        ss << std::left << std::setw(40) << name << std::right << std::setw(10) << value << " (counter)\n";
+    }
+    if (dropped > 0) {
+        ss << "Span buffer full, " << dropped << " spans not recorded\n";
+    }
+    return ss.str();
+}
+
+ScopedTimer::ScopedTimer(const char* name)
+    : name(name) {
+    Logger& logger = Logger::getInstance();
+    if (logger.isProfiling()) {
+        active = true;
+        depth = profileDepth++;
+        startUs = logger.profileTimeUs();
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!active) {
+        return;
+    }
+    profileDepth--;
+    Logger& logger = Logger::getInstance();
+    if (logger.isProfiling()) {
+        logger.recordSpan(name, startUs, logger.profileTimeUs() - startUs, depth);
+    }
 }
 
 Logger::LogBuf::LogBuf(Logger& logger, Level level) 
@@ -54,6 +351,7 @@ Logger::LogStream& Logger::getInfoStream() {
 }
 
 Logger::~Logger() {
+    shutdown();
     std::lock_guard<std::mutex> lock(logMutex);
     if (logFile.is_open()) {
         logFile.close();
@@ -61,9 +359,12 @@ Logger::~Logger() {
 }
 
 Logger::Logger() 
-    : currentLevel(Level::Info)
+    : currentLevel(static_cast<int>(Level::Info))
     , errorStream_(*this, Level::Error)
-    , infoStream_(*this, Level::Info) {}
+    , infoStream_(*this, Level::Info)
+    , queue(QueueCapacity)
+    , profiling(false)
+    , profileStart(std::chrono::steady_clock::now()) {}
 
 const char* Logger::getLevelString(Level level) const {
     switch (level) {
@@ -85,7 +386,11 @@ void setLogLevel(Logger::Level level) {
     Logger::getInstance().setLevel(level);
 }
 
+void flushLog() {
+    Logger::getInstance().flush();
+}
+
 void redirectStdStreams() {
     std::cout.rdbuf(Logger::getInstance().getInfoStream().rdbuf());
     std::cerr.rdbuf(Logger::getInstance().getErrorStream().rdbuf());
-} 
\ No newline at end of file
+}
@@ -15,10 +15,21 @@
 #include "../include/VideoDataPanel.h"
 #include "../include/AudioPlaybackControl.h"
 #include "../include/FontEditDialog.h"
+#include "../include/GridGrabber.h"
+#include "../include/ImageCodec.h"
+#include "../include/CompiledSprite.h"
+#include "../include/AtlasPacker.h"
+#include "../include/DuplicateFinder.h"
+#include "../include/BatchTransform.h"
+#include "../include/BatchAudioConvert.h"
+#include "../include/FlicStream.h"
+#include "../include/FlicEncoder.h"
+#include "../include/FontImporter.h"
 #include "wx/wx.h"
 #include <cstdint>
 #include <cctype>
 #include <wx/filename.h>
+#include <wx/dir.h>
 #include <wx/mediactrl.h>
 #include <wx/artprov.h>
 #include <wx/graphics.h>
@@ -31,6 +42,7 @@
 #include <wx/colour.h>
 #include <wx/clrpicker.h>
 #include <vector>
+#include <unordered_set>
 #include <wx/propgrid/advprops.h>
 #include <wx/textdlg.h>
 #include <wx/display.h>
@@ -68,6 +80,7 @@ class ObjectTreeData : public wxTreeItemData {
 public:
     ObjectTreeData(std::shared_ptr<DataParser::DataObject> obj) : object(obj) {}
     std::shared_ptr<DataParser::DataObject> object;
+    int index = 0;  // Position shown when indices are on
 };
 
 // Add main function for wxWidgets application
@@ -185,6 +198,18 @@ int MyApp::OnExit() {
         m_logFile.close();
     }
 
+    // Profile mode started from the command line writes its trace on exit
+    if (Logger::getInstance().isProfiling()) {
+        Logger::getInstance().setProfiling(false);
+        logInfo("Profile summary:\n" + Logger::getInstance().getProfileSummary());
+        if (!Logger::getInstance().writeChromeTrace("profile.json")) {
+            logError("Failed to write profile.json");
+        }
+    }
+
+    // Write out anything still queued for the logger thread
+    Logger::getInstance().shutdown();
+
     return wxApp::OnExit();
 }
  
@@ -206,6 +231,8 @@ bool MyApp::OnInit()
             setLogLevel(Logger::Level::Warning);
         } else if (arg == "-error") {
             setLogLevel(Logger::Level::Error);
+        } else if (arg == "-profile") {
+            Logger::getInstance().setProfiling(true);
         }
     }
 
@@ -221,14 +248,24 @@ bool MyApp::OnInit()
     if (runTests) {
         bool lzssFileDecompressTestPassed = UnitTests::LZSSFileDecompressTest();
         bool lzssTestsPassed = UnitTests::LZSSTests();
-        if (lzssFileDecompressTestPassed && lzssTestsPassed) {
-            std::cout << "All compression/decompression tests passed!" << std::endl;
+        bool flicDecoderTestsPassed = UnitTests::FlicDecoderTests();
+        bool flicEncoderTestsPassed = UnitTests::FlicEncoderTests();
+        bool imageCodecTestsPassed = UnitTests::ImageCodecTests();
+        bool fontImporterTestsPassed = UnitTests::FontImporterTests();
+        if (lzssFileDecompressTestPassed && lzssTestsPassed && flicDecoderTestsPassed && flicEncoderTestsPassed &&
+            imageCodecTestsPassed && fontImporterTestsPassed) {
+            std::cout << "All tests passed!" << std::endl;
         } else {
             std::cout << "Tests failed:" << std::endl;
             if (!lzssFileDecompressTestPassed) std::cout << "- LZSS file decompression test failed" << std::endl;
             if (!lzssTestsPassed) std::cout << "- LZSS compression tests failed" << std::endl;
+            if (!flicDecoderTestsPassed) std::cout << "- FLIC decoder tests failed" << std::endl;
+            if (!flicEncoderTestsPassed) std::cout << "- FLIC encoder tests failed" << std::endl;
+            if (!imageCodecTestsPassed) std::cout << "- Image codec tests failed" << std::endl;
+            if (!fontImporterTestsPassed) std::cout << "- Font importer tests failed" << std::endl;
         }
         std::cout << "Check the log.txt file for detailed output." << std::endl;
+        flushLog();
         return false;
     }
 
@@ -405,6 +442,13 @@ MyFrame::MyFrame()
     fileMenu->Append(wxID_EXIT, "&Quit\tCtrl+Q");
     Bind(wxEVT_MENU, &MyFrame::OnQuit, this, wxID_EXIT);
     menuBar->Append(fileMenu, "File");
+
+    wxMenu* editMenu = new wxMenu();
+    editMenu->Append(wxID_UNDO, "&Undo\tCtrl+Z");
+    Bind(wxEVT_MENU, &MyFrame::OnUndo, this, wxID_UNDO);
+    editMenu->Append(wxID_REDO, "&Redo\tCtrl+Y");
+    Bind(wxEVT_MENU, &MyFrame::OnRedo, this, wxID_REDO);
+    menuBar->Append(editMenu, "&Edit");
     
     wxMenu* objectMenu = new wxMenu();
     objectMenu->Append(ID_GRAB, "&Grab\tCtrl+G");
@@ -452,6 +496,22 @@ MyFrame::MyFrame()
     Bind(wxEVT_MENU, &MyFrame::OnSetProperty, this, ID_SET_PROPERTY);
     objectMenu->Append(ID_AUTOCROP, "&Autocrop");
     Bind(wxEVT_MENU, &MyFrame::OnAutocrop, this, ID_AUTOCROP);
+    objectMenu->Append(ID_SPRITE_BENCHMARK, "Sprite Blit Ben&chmark");
+    Bind(wxEVT_MENU, &MyFrame::OnSpriteBenchmark, this, ID_SPRITE_BENCHMARK);
+    objectMenu->Append(ID_FLIC_BENCHMARK, "FLIC &Decode Benchmark");
+    Bind(wxEVT_MENU, &MyFrame::OnFlicBenchmark, this, ID_FLIC_BENCHMARK);
+    objectMenu->Append(ID_CREATE_FLIC, "Create FLIC from &Images...");
+    Bind(wxEVT_MENU, &MyFrame::OnCreateFlic, this, ID_CREATE_FLIC);
+    objectMenu->Append(ID_IMPORT_UNICODE_FONT, "Import &Unicode Font...");
+    Bind(wxEVT_MENU, &MyFrame::OnImportUnicodeFont, this, ID_IMPORT_UNICODE_FONT);
+    objectMenu->Append(ID_BUILD_ATLAS, "Build A&tlas...");
+    Bind(wxEVT_MENU, &MyFrame::OnBuildAtlas, this, ID_BUILD_ATLAS);
+    objectMenu->Append(ID_FIND_DUPLICATES, "Find &Duplicates...");
+    Bind(wxEVT_MENU, &MyFrame::OnFindDuplicates, this, ID_FIND_DUPLICATES);
+    objectMenu->Append(ID_BATCH_TRANSFORM, "Batch &Transform...");
+    Bind(wxEVT_MENU, &MyFrame::OnBatchTransform, this, ID_BATCH_TRANSFORM);
+    objectMenu->Append(ID_BATCH_AUDIO, "Batch Con&vert Audio...");
+    Bind(wxEVT_MENU, &MyFrame::OnBatchAudio, this, ID_BATCH_AUDIO);
     objectMenu->Append(ID_BOX_GRAB, "&Box Grab\tCtrl+B");
     Bind(wxEVT_MENU, &MyFrame::OnBoxGrab, this, ID_BOX_GRAB);
     objectMenu->Append(ID_UNGRAB, "&Ungrab");
@@ -544,6 +604,12 @@ MyFrame::MyFrame()
     Bind(wxEVT_MENU, &MyFrame::OnDitherImages, this, ID_DITHER_IMAGES);
     optionsMenu->AppendCheckItem(ID_PRESERVE_TRANSPARENCY, "Preserve &Transparency");
     Bind(wxEVT_MENU, &MyFrame::OnPreserveTransparency, this, ID_PRESERVE_TRANSPARENCY);
+    optionsMenu->AppendCheckItem(ID_THUMBNAIL_VIEW, "T&humbnail View");
+    Bind(wxEVT_MENU, &MyFrame::OnThumbnailView, this, ID_THUMBNAIL_VIEW);
+    optionsMenu->AppendSeparator();
+    optionsMenu->AppendCheckItem(ID_PROFILE_MODE, "Profile &Mode");
+    optionsMenu->Check(ID_PROFILE_MODE, Logger::getInstance().isProfiling());
+    Bind(wxEVT_MENU, &MyFrame::OnProfileMode, this, ID_PROFILE_MODE);
     menuBar->Append(optionsMenu, "O&ptions");
     
     wxMenu* helpMenu = new wxMenu();
@@ -582,8 +648,15 @@ MyFrame::MyFrame()
     m_tree->Bind(wxEVT_TREE_BEGIN_DRAG, &MyFrame::OnTreeBeginDrag, this);
     m_tree->Bind(wxEVT_TREE_END_DRAG, &MyFrame::OnTreeEndDrag, this);
     
+    // Thumbnail grid alternative to the tree, hidden until enabled in the options menu
+    m_thumbnailView = new ThumbnailGridView(this, [this](std::shared_ptr<DataParser::DataObject> obj, bool activated) {
+        this->OnThumbnailSelected(obj, activated);
+    });
+    m_thumbnailView->Hide();
+
     wxBoxSizer* treeSizer = new wxBoxSizer(wxVERTICAL);
     treeSizer->Add(m_tree, 1, wxEXPAND | wxALL, 5);
+    treeSizer->Add(m_thumbnailView, 1, wxEXPAND | wxALL, 5);
     mainSizer->Add(treeSizer, 1, wxEXPAND | wxALL);
     
     wxPanel* rightPanel = new wxPanel(this);
@@ -614,12 +687,7 @@ MyFrame::MyFrame()
     wxBoxSizer* previewSizer = new wxBoxSizer(wxVERTICAL);
 
     // Create image preview panel
-    m_imagePreviewPanel = new wxScrolledWindow(previewPanel, wxID_ANY);
-    m_imagePreviewPanel->SetScrollRate(10, 10); // Enable scrolling with 10 pixel steps
-    m_imagePreview = new wxStaticBitmap(m_imagePreviewPanel, wxID_ANY, wxNullBitmap);
-    wxBoxSizer* imageSizer = new wxBoxSizer(wxVERTICAL);
-    imageSizer->Add(m_imagePreview, 1, wxALL, 5);
-    m_imagePreviewPanel->SetSizer(imageSizer);
+    m_imagePreviewPanel = new ImagePreviewCanvas(previewPanel, wxID_ANY);
 
     // Create the palette info text (initially hidden)
     m_paletteInfoText = new wxStaticText(previewPanel, wxID_ANY, 
@@ -658,10 +726,26 @@ MyFrame::MyFrame()
     previewSizer->Add(m_videoPanelContainer, 1, wxEXPAND | wxALL, 5);
     m_videoPanelContainer->Hide();
 
+    // Create the waveform view, clicking it seeks
+    m_waveformView = new WaveformView(previewPanel, m_audioCache, [this](int positionMs) {
+        m_audioControl->SetCurrentPositionMs(positionMs);
+    });
+    m_waveformView->SetMinSize(wxSize(320, 120));
+    previewSizer->Add(m_waveformView, 1, wxEXPAND | wxALL, 5);
+    m_waveformView->Hide();
+
     // Create audio controls panel
     m_audioPanel = new wxPanel(previewPanel, wxID_ANY);
     wxBoxSizer* audioSizer = new wxBoxSizer(wxHORIZONTAL);
-    m_audioControl = std::make_unique<AudioPlaybackControl>([this](int a, int b) { this->AVPositionUpdateCallback(a, b); });
+    // A sound left playing under a clip does not move the clip's slider
+    m_audioControl = std::make_unique<AudioPlaybackControl>([this](int a, int b) {
+        if (!m_currentObject || !m_currentObject->isVideo()) {
+            this->AVPositionUpdateCallback(a, b);
+        }
+    });
+    m_audioControl->SetAnalysisCache(&m_audioCache);
+    // A clip follows a sound that is playing while it plays, else the wall clock
+    m_videoPanel->SetSyncSource([this]() { return m_audioControl->GetPlaybackPositionMs(); });
     
     // Play button - fixed size, centered vertically
     m_playButton = new wxBitmapButton(m_audioPanel, ID_PLAY_AUDIOVIDEO, GetPlayIcon(), 
@@ -719,6 +803,7 @@ MyFrame::MyFrame()
     // Load settings from allegro.cfg
     m_grabberInfo.LoadSettings("allegro.cfg");
     UpdateUIFromGrabberInfo();
+    m_history.setBudget(static_cast<size_t>(m_grabberInfo.GetUndoMemory()) * 1024 * 1024);
 
     // Bind audio/video events
     Bind(wxEVT_BUTTON, &MyFrame::OnPlayPauseAV, this, ID_PLAY_AUDIOVIDEO);
@@ -879,6 +964,7 @@ void MyFrame::OnPropertyActivated(wxListEvent& event)
         logInfo("Property " + propName + " changed from " + propValue + " to " + newValue);
         if (newValue != propValue) {  // Only mark as modified if value actually changed
             m_details->SetItem(item, 1, newValue);
+            m_history.recordProperties("Edit Property", m_objects, {m_currentObject});
             
             // Update the property in the object using string-based setProperty
             m_currentObject->setProperty(propName.ToStdString(), newValue.ToStdString());
@@ -886,9 +972,9 @@ void MyFrame::OnPropertyActivated(wxListEvent& event)
             // Update the property list to reflect any changes
             UpdatePropertyList(m_currentObject);
 
-            // If this was the NAME property, refresh the tree display
+            // If this was the NAME property, relabel its tree item
             if (propName == "NAME") {
-                RefreshTreeDisplay();
+                RefreshTreeItem(m_currentObject);
             }
 
             // Mark as modified
@@ -902,36 +988,10 @@ void MyFrame::UpdateImageDisplay(const wxImage& image, double zoomLevel, bool ad
         return;
     }
 
-    try {
-        // Scale image according to zoom level
-        wxImage scaledImage = image.Scale(image.GetWidth() * zoomLevel, image.GetHeight() * zoomLevel, wxIMAGE_QUALITY_NEAREST);
-        if (!scaledImage.IsOk()) {
-            return;
-        }
-
-        wxImage finalImage;
-        if (addBorder) {
-            // Add a 1-pixel black border to the scaled image
-            finalImage = wxImage(scaledImage.GetWidth() + 2, scaledImage.GetHeight() + 2);
-            finalImage.Clear(0);  // Fill with black
-            finalImage.Paste(scaledImage, 1, 1);  // Place original image inside border
-        } else {
-            finalImage = scaledImage;
-        }
-
-        m_imagePreview->SetBitmap(finalImage);
-        
-        // Set virtual size to match the image size
-        m_imagePreviewPanel->SetVirtualSize(finalImage.GetWidth(), finalImage.GetHeight());
-        
-        // Ensure scrollbars update
-        m_imagePreviewPanel->FitInside();
-        m_imagePreviewPanel->Refresh();
-        
-        Layout();
-    } catch (const std::exception&) {
-        return;
-    }
+    // The canvas scales on demand, only the visible tiles are ever rendered
+    m_imagePreviewPanel->SetZoom(zoomLevel);
+    m_imagePreviewPanel->SetImage(image, addBorder);
+    Layout();
 }
 
 
@@ -955,18 +1015,87 @@ void MyFrame::OnTreeSelectionChanged(wxTreeEvent& event) {
 
     m_currentObject = data->object;
     UpdateObjectPreview();
+    PrefetchNeighborPreviews(item);
+    m_thumbnailView->SetSelection(m_currentObject);
+}
+
+void MyFrame::PrefetchNeighborPreviews(const wxTreeItemId& item) {
+    // Convert the siblings the user is most likely to select next in the background
+    const int neighborsPerSide = 2;
+    std::vector<std::shared_ptr<DataParser::DataObject>> neighbors;
+    wxTreeItemId prev = item;
+    wxTreeItemId next = item;
+    for (int i = 0; i < neighborsPerSide; i++) {
+        if (next.IsOk()) {
+            next = m_tree->GetNextSibling(next);
+        }
+        if (prev.IsOk()) {
+            prev = m_tree->GetPrevSibling(prev);
+        }
+        for (const wxTreeItemId& neighbor : {next, prev}) {
+            if (!neighbor.IsOk()) {
+                continue;
+            }
+            ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(neighbor));
+            if (data && data->object && data->object->isBitmap()) {
+                neighbors.push_back(data->object);
+            }
+        }
+    }
+    m_previewCache.prefetch(neighbors, m_currentPalette);
+}
+
+void MyFrame::RefreshThumbnailView() {
+    if (!m_thumbnailView->IsShown()) {
+        return;
+    }
+    // The grid is flat, nested datafiles are shown with their contents following them
+    std::vector<std::shared_ptr<DataParser::DataObject>> objects;
+    ObjectTraversalUtils::ForEachObjectRecursive(m_objects, [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        objects.push_back(obj);
+        return false;
+    });
+    m_thumbnailView->SetPalette(m_currentPalette);
+    m_thumbnailView->SetObjects(objects);
+    m_thumbnailView->SetSelection(m_currentObject);
+}
+
+void MyFrame::OnThumbnailSelected(std::shared_ptr<DataParser::DataObject> obj, bool activated) {
+    // Keep the hidden tree in sync so tree based commands act on the same object
+    wxTreeItemId item = FindTreeItem(obj);
+    if (!item.IsOk()) {
+        return;
+    }
+    m_tree->UnselectAll();
+    m_tree->SelectItem(item);
+    if (activated) {
+        wxTreeEvent activateEvent(wxEVT_TREE_ITEM_ACTIVATED, m_tree, item);
+        OnTreeItemActivated(activateEvent);
+    }
+}
+
+wxTreeItemId MyFrame::FindTreeItem(const std::shared_ptr<DataParser::DataObject>& obj) const {
+    if (!obj) {
+        return wxTreeItemId();
+    }
+    auto found = m_treeItems.find(obj->ui_id);
+    return found != m_treeItems.end() ? found->second : wxTreeItemId();
 }
 
 void MyFrame::UpdatePreviewControls(std::shared_ptr<DataParser::DataObject> obj) {
+    PROFILE_SCOPE("UpdatePreviewControls");
     // Hide all by default
     m_infoText->Hide();
     m_audioPanel->Hide();
+    m_waveformView->Hide();
     m_imagePreviewPanel->Hide();
     m_zoomLabel->Hide();
     m_zoomSlider->Hide();
     m_paletteInfoText->Hide();
     m_videoPanelContainer->Hide();
-    ResetAVPlayback();
+    // A playing sound keeps playing when a clip is selected, so the clip can follow it
+    bool keepSound = obj && obj->isVideo() && m_audioControl->GetIsPlaying();
+    ResetAVPlayback(keepSound);
 
     if (!obj) {
         // No object selected, all already hidden
@@ -985,22 +1114,21 @@ void MyFrame::UpdatePreviewControls(std::shared_ptr<DataParser::DataObject> obj)
         m_infoText->SetLabel(caption);
         m_infoText->Show();
 
-        // Disable Play button for MIDI - make it grayed out and non-functional
-        if (obj->typeID == ObjectType::DAT_MIDI) {
-            m_playButton->Disable();
-            m_playButton->SetToolTip("MIDI files cannot be played as audio");
-            m_playButton->SetCanFocus(false);
-        } else {
-            m_playButton->Enable();
-            m_playButton->SetToolTip("Play/Pause");
-            m_playButton->SetCanFocus(true);
-        }
+        // MIDI plays through the built-in synthesizer like any other sound
+        m_playButton->Enable();
+        m_playButton->SetToolTip("Play/Pause");
+        m_playButton->SetCanFocus(true);
 
         if (obj->isVideo()) {
             m_videoPanelContainer->Show();
             m_videoPanel->SetVideoData(obj);
+            if (keepSound) {
+                SetStatusText("Playing the clip follows the sound that is playing");
+            }
         } else if (obj->isAudio()) {
             m_audioControl->SetAudioData(obj);
+            m_waveformView->SetAudio(obj);
+            m_waveformView->Show(AudioAnalysisCache::canAnalyze(obj->getAudio()));
         }
     }
     else if (obj->isBitmap()) {
@@ -1010,10 +1138,10 @@ void MyFrame::UpdatePreviewControls(std::shared_ptr<DataParser::DataObject> obj)
         m_zoomSlider->Show();
         m_infoText->Show();
 
-        // Update bitmap display
-        wxImage image;
-        if (obj->getBitmap().toWxImage(image, m_currentPalette)) {
-            UpdateImageDisplay(image, m_zoomSlider->GetValue() / 10.0, true);  // Add border for bitmaps
+        // Update bitmap display, converted images are reused from the preview cache
+        std::shared_ptr<const wxImage> image = m_previewCache.get(*obj, m_currentPalette);
+        if (image) {
+            UpdateImageDisplay(*image, m_zoomSlider->GetValue() / 10.0, true);  // Add border for bitmaps
         }
         
         // Update info text with image dimensions
@@ -1185,9 +1313,13 @@ void MyFrame::OnLoad(wxCommandEvent& event)
         
         // Clear existing data
         m_objects.clear();
-        m_tree->DeleteAllItems();
+        m_history.clear();
+        ClearTree();
         m_details->DeleteAllItems();
-        m_imagePreview->SetBitmap(wxNullBitmap);
+        m_imagePreviewPanel->ClearImage();
+        m_previewCache.clear();
+        m_audioCache.clear();
+        m_thumbnailView->ClearThumbnails();
         
         // Try to load the file
         std::string password = m_grabberInfo.GetPassword();
@@ -1425,6 +1557,7 @@ void MyFrame::OnSaveStripped(wxCommandEvent& event)
                 strippedInfoObj.ParseDataObject(strippedObjects);
                 // Update our working objects with the stripped version
                 m_objects = std::move(strippedObjects);
+                m_history.clear();
                 
                 // If we stripped all properties, generate new names
                 if (selection == 2) {
@@ -1546,19 +1679,13 @@ void MyFrame::OnDelete(wxCommandEvent& event)
     if (dialog.ShowModal() != wxID_YES) {
         return;
     }
+    m_history.record("Delete", m_objects);
     int deletedCount = 0;
     for (auto& obj : selectedObjs) {
-        bool deleted = ObjectTraversalUtils::ForEachObjectRecursive(m_objects, [this, &obj](std::shared_ptr<DataParser::DataObject>& candidate) -> bool {
-            if (candidate == obj) {
-                auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, candidate);
-                if (parentVector) {
-                    ObjectTraversalUtils::FindAndRemoveObject(*parentVector, candidate);
-                    return true;
-                }
-            }
-            return false;
-        });
-        if (deleted) ++deletedCount;
+        auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, obj);
+        if (parentVector && ObjectTraversalUtils::FindAndRemoveObject(*parentVector, obj)) {
+            ++deletedCount;
+        }
     }
     m_currentObject = nullptr;
     if (deletedCount > 0) {
@@ -1566,6 +1693,7 @@ void MyFrame::OnDelete(wxCommandEvent& event)
         RefreshTreeDisplay();
         SetStatusText(wxString::Format("%d object(s) deleted", deletedCount));
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to delete selected objects.", "Delete Error", wxOK | wxICON_ERROR);
     }
 }
@@ -1589,14 +1717,16 @@ void MyFrame::ResetToDefaults() {
     
     // Clear data objects
     m_objects.clear();
+    m_history.clear();
     
     // Clear UI
-    m_tree->DeleteAllItems();
-    m_tree->AddRoot("<root>");
-    m_tree->SelectItem(m_tree->GetRootItem());
+    m_tree->SelectItem(ClearTree());
     m_details->DeleteAllItems();
     m_infoText->SetLabel("");
-    m_imagePreview->SetBitmap(wxNullBitmap);
+    m_imagePreviewPanel->ClearImage();
+    m_previewCache.clear();
+    m_audioCache.clear();
+    m_thumbnailView->ClearThumbnails();
     m_editingText->SetValue("");
     m_headerText->SetValue("");
     m_prefixText->SetValue("");
@@ -1612,6 +1742,7 @@ void MyFrame::ResetToDefaults() {
     m_zoomSlider->Hide();
     m_zoomLabel->Hide();
     m_audioPanel->Hide();
+    m_waveformView->Hide();
     m_imagePreviewPanel->Hide();
     
     // Stop any ongoing playback
@@ -1683,13 +1814,18 @@ void MyFrame::StopAVPlayback() {
     m_videoPanel->Stop();
 }
 
-void MyFrame::ResetAVPlayback() {
-    StopAVPlayback();
+void MyFrame::ResetAVPlayback(bool keepSound) {
+    if (keepSound) {
+        m_videoPanel->Stop();
+    } else {
+        StopAVPlayback();
+        m_audioControl->SetAudioData(nullptr);
+        m_audioControl->SetCurrentPositionMs(0);
+    }
     m_playButton->SetBitmap(GetPlayIcon());
     m_videoPanel->SetVideoData(nullptr);
-    m_audioControl->SetAudioData(nullptr);
+    m_waveformView->SetAudio(nullptr);
     m_videoPanel->SetCurrentPositionMs(0);
-    m_audioControl->SetCurrentPositionMs(0);
     m_AVSlider->SetValue(0);
     m_timeLabel->SetLabel("00:00.0 / " + FormatTime(m_playbackDuration));
 }
@@ -1697,7 +1833,7 @@ void MyFrame::ResetAVPlayback() {
 void MyFrame::OnPlayPauseAV(wxCommandEvent& event) {
     if (!m_currentObject) return;
     
-    // Don't process if button is disabled (e.g., for MIDI objects)
+    // Don't process if button is disabled
     if (!m_playButton->IsEnabled()) {
         return;
     }
@@ -1839,7 +1975,8 @@ void MyFrame::OnIndexObjects(wxCommandEvent& event)
 
 void MyFrame::RefreshTreeDisplay()
 {
-    // Store currently selected object pointers
+    PROFILE_SCOPE("RefreshTreeDisplay");
+    // Store currently selected object pointers, items that have to be re-inserted lose their selection
     std::vector<std::shared_ptr<DataParser::DataObject>> selectedObjs;
     wxArrayTreeItemIds selectedItems;
     m_tree->GetSelections(selectedItems);
@@ -1849,78 +1986,30 @@ void MyFrame::RefreshTreeDisplay()
             selectedObjs.push_back(data->object);
         }
     }
-    m_tree->DeleteAllItems();
-    wxTreeItemId rootId = m_tree->AddRoot("<root>");
-    logDebug("root id: " + std::to_string((uint64_t)rootId.GetID()));
+    wxTreeItemId rootId = m_tree->GetRootItem();
+    if (!rootId.IsOk()) {
+        rootId = m_tree->AddRoot("<root>");
+    }
 
     // If sorting is enabled, sort objects by name (recursively)
     if (m_grabberInfo.GetSort()) {
         this->SortObjectsByName(m_objects);
     }
 
-    // If there are objects, add them to the tree
-    if (!m_objects.empty()) {
-        // First, count total objects to determine max index width
-        int totalObjects = ObjectTraversalUtils::CountObjects(m_objects);
-        logDebug("totalObjects: " + std::to_string(totalObjects));
-
-        // Calculate width needed for index numbers
-        int indexWidth = static_cast<int>(std::to_string(totalObjects).length());
-        if (m_showIndices) {
-            logDebug("indexWidth: " + std::to_string(indexWidth));
-        }
-
-        // Helper function to recursively add objects to tree
-        std::function<void(const std::vector<std::shared_ptr<DataParser::DataObject>>&, wxTreeItemId, int&)> addObjectsToTree;
-        addObjectsToTree = [&](const std::vector<std::shared_ptr<DataParser::DataObject>>& objects, wxTreeItemId parent, int& index) {
-            for (const auto& obj : objects) {
-                std::string objType = DataParser::ConvertIDToString(obj->typeID);
-                std::string objName = obj->getProperty('NAME');
-                std::string itemText;
-                if (m_showIndices) {
-                    std::string indexStr = std::to_string(index);
-                    std::string padding(indexWidth - indexStr.length(), ' ');
-                    itemText = wxString::Format("[%s%s] %s - %s", padding, indexStr, objType, objName);
-                } else {
-                    itemText = objType + " - " + objName;
-                }
-                wxTreeItemId item = m_tree->AppendItem(parent, itemText);
-                m_tree->SetItemData(item, new ObjectTreeData(obj));
-                index++;
-                if (obj->isNested()) {
-                    auto& nestedObjects = obj->getNestedObjects();
-                    addObjectsToTree(nestedObjects, item, index);
-                }
-            }
-        };
-        int startIndex = 1; // Start indexing from 1
-        addObjectsToTree(m_objects, rootId, startIndex);
-        m_tree->ExpandAll();
-
-        // Restore selection if we had selected objects
-        if (!selectedObjs.empty()) {
-            // Helper function to recursively search tree items
-            std::function<void(wxTreeItemId)> findAndSelectObjects;
-            findAndSelectObjects = [&](wxTreeItemId parent) {
-                wxTreeItemIdValue cookie;
-                wxTreeItemId item = m_tree->GetFirstChild(parent, cookie);
-                while (item.IsOk()) {
-                    ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
-                    if (data && data->object) {
-                        for (const auto& selObj : selectedObjs) {
-                            if (data->object == selObj) {
-                                m_tree->SelectItem(item);
-                                break;
-                            }
-                        }
-                    }
-                    if (m_tree->ItemHasChildren(item)) {
-                        findAndSelectObjects(item);
-                    }
-                    item = m_tree->GetNextSibling(item);
-                }
-            };
-            findAndSelectObjects(rootId);
+    // Calculate width needed for index numbers
+    int totalObjects = ObjectTraversalUtils::CountObjects(m_objects);
+    m_treeIndexWidth = static_cast<int>(std::to_string(totalObjects).length());
+    logDebug("totalObjects: " + std::to_string(totalObjects));
+
+    // Existing items are kept and only the differences applied, so expand state survives
+    std::unordered_map<uint32_t, bool> expanded;
+    int startIndex = 1; // Start indexing from 1
+    SyncTreeChildren(rootId, m_objects, startIndex, expanded);
+
+    for (const auto& selObj : selectedObjs) {
+        wxTreeItemId item = FindTreeItem(selObj);
+        if (item.IsOk() && !m_tree->IsSelected(item)) {
+            m_tree->SelectItem(item);
         }
     }
     // Always ensure root is visible and selected when no other selection exists
@@ -1929,6 +2018,149 @@ void MyFrame::RefreshTreeDisplay()
     if (afterSelects.IsEmpty()) {
         m_tree->SelectItem(rootId);
     }
+    RefreshThumbnailView();
+}
+
+void MyFrame::RefreshTreeItem(const std::shared_ptr<DataParser::DataObject>& obj)
+{
+    wxTreeItemId item = FindTreeItem(obj);
+    if (!item.IsOk() || m_grabberInfo.GetSort()) {
+        // A new name can move the object when sorting
+        RefreshTreeDisplay();
+        return;
+    }
+    ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
+    m_tree->SetItemText(item, TreeItemText(*obj, data->index));
+    if (m_thumbnailView->IsShown()) {
+        m_thumbnailView->Refresh();
+    }
+}
+
+wxString MyFrame::TreeItemText(const DataParser::DataObject& obj, int index) const
+{
+    std::string objType = DataParser::ConvertIDToString(obj.typeID);
+    std::string objName = obj.getProperty('NAME');
+    if (m_showIndices) {
+        std::string indexStr = std::to_string(index);
+        std::string padding(std::max(0, m_treeIndexWidth - static_cast<int>(indexStr.length())), ' ');
+        return wxString::Format("[%s%s] %s - %s", padding, indexStr, objType, objName);
+    }
+    return objType + " - " + objName;
+}
+
+void MyFrame::SyncTreeChildren(const wxTreeItemId& parent, const std::vector<std::shared_ptr<DataParser::DataObject>>& objects, int& index, std::unordered_map<uint32_t, bool>& expanded)
+{
+    std::unordered_map<const DataParser::DataObject*, size_t> positions;
+    positions.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        positions.emplace(objects[i].get(), i);
+    }
+
+    // Match the current children against the new list
+    std::vector<wxTreeItemId> byPosition(objects.size());
+    std::vector<wxTreeItemId> kept, stale;
+    std::vector<size_t> keptPositions;
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId item = m_tree->GetFirstChild(parent, cookie); item.IsOk(); item = m_tree->GetNextSibling(item)) {
+        ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
+        auto found = data ? positions.find(data->object.get()) : positions.end();
+        if (found != positions.end() && !byPosition[found->second].IsOk()) {
+            byPosition[found->second] = item;
+            kept.push_back(item);
+            keptPositions.push_back(found->second);
+        } else {
+            stale.push_back(item);
+        }
+    }
+
+    // Keep the longest run of children already in the new order, the others are re-inserted
+    std::vector<size_t> tails;
+    std::vector<long> previous(kept.size(), -1);
+    for (size_t k = 0; k < kept.size(); ++k) {
+        auto slot = std::lower_bound(tails.begin(), tails.end(), keptPositions[k], [&](size_t tail, size_t position) {
+            return keptPositions[tail] < position;
+        });
+        if (slot != tails.begin()) {
+            previous[k] = static_cast<long>(*(slot - 1));
+        }
+        if (slot == tails.end()) {
+            tails.push_back(k);
+        } else {
+            *slot = k;
+        }
+    }
+    std::vector<bool> stays(kept.size(), false);
+    for (long k = tails.empty() ? -1 : static_cast<long>(tails.back()); k >= 0; k = previous[k]) {
+        stays[k] = true;
+    }
+    for (size_t k = 0; k < kept.size(); ++k) {
+        if (!stays[k]) {
+            byPosition[keptPositions[k]] = wxTreeItemId();
+            stale.push_back(kept[k]);
+        }
+    }
+    for (auto& item : stale) {
+        ForgetTreeItems(item, expanded);
+        m_tree->Delete(item);
+    }
+
+    wxTreeItemId previousItem;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const auto& obj = objects[i];
+        wxString text = TreeItemText(*obj, index);
+        wxTreeItemId item = byPosition[i];
+        bool created = !item.IsOk();
+        if (created) {
+            item = previousItem.IsOk() ? m_tree->InsertItem(parent, previousItem, text) : m_tree->PrependItem(parent, text);
+            m_tree->SetItemData(item, new ObjectTreeData(obj));
+        } else if (m_tree->GetItemText(item) != text) {
+            m_tree->SetItemText(item, text);
+        }
+        static_cast<ObjectTreeData*>(m_tree->GetItemData(item))->index = index;
+        m_treeItems[obj->ui_id] = item;
+        index++;
+
+        bool hadChildren = !created && m_tree->ItemHasChildren(item);
+        if (obj->isNested()) {
+            SyncTreeChildren(item, obj->getNestedObjects(), index, expanded);
+            if (!hadChildren) {
+                // New branches open, unless they were re-inserted after being collapsed
+                auto state = expanded.find(obj->ui_id);
+                if (state == expanded.end() || state->second) {
+                    m_tree->Expand(item);
+                }
+            }
+        } else if (hadChildren) {
+            SyncTreeChildren(item, {}, index, expanded);
+        }
+        previousItem = item;
+    }
+}
+
+void MyFrame::ForgetTreeItems(const wxTreeItemId& item, std::unordered_map<uint32_t, bool>& expanded)
+{
+    ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
+    if (data && data->object) {
+        // The object may already have a new item elsewhere in the tree
+        auto found = m_treeItems.find(data->object->ui_id);
+        if (found != m_treeItems.end() && found->second == item) {
+            m_treeItems.erase(found);
+        }
+        if (m_tree->ItemHasChildren(item)) {
+            expanded[data->object->ui_id] = m_tree->IsExpanded(item);
+        }
+    }
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId child = m_tree->GetFirstChild(item, cookie); child.IsOk(); child = m_tree->GetNextSibling(child)) {
+        ForgetTreeItems(child, expanded);
+    }
+}
+
+wxTreeItemId MyFrame::ClearTree()
+{
+    m_tree->DeleteAllItems();
+    m_treeItems.clear();
+    return m_tree->AddRoot("<root>");
 }
 
 void MyFrame::OnHelp(wxCommandEvent& event)
@@ -1943,21 +2175,9 @@ void MyFrame::OnZoomChange(wxCommandEvent& event) {
 
     double zoomLevel = m_zoomSlider->GetValue() / 10.0;  // Convert 5-30 to 0.5-3.0
     m_zoomLabel->SetLabel(wxString::Format("Zoom: %.1fx", zoomLevel));
-    
-    if (m_currentObject->isBitmap()) {
-        const BitmapData& bmpData = m_currentObject->getBitmap();
-        wxImage image;
-        if (bmpData.toWxImage(image, m_currentPalette)) {
-            UpdateImageDisplay(image, zoomLevel, true);  // Add border for bitmaps
-        }
-    }
-    else if (m_currentObject->isFont()) {
-        // Handle font zoom
-        wxImage fontImg = m_currentObject->getFont().getPreviewImage();
-        if (fontImg.IsOk()) {
-            UpdateImageDisplay(fontImg, zoomLevel, false);  // No border for fonts
-        }
-    }
+
+    // The canvas keeps the converted image, zooming only re-renders visible tiles
+    m_imagePreviewPanel->SetZoom(zoomLevel);
 }
 
 void MyFrame::OnPackModeChanged(wxCommandEvent& event) {
@@ -2003,6 +2223,7 @@ void MyFrame::OnMerge(wxCommandEvent& event)
         mergeInfoObj.ParseDataObject(mergeObjects);
         
         // Add all objects from merge file to current objects
+        m_history.record("Merge", m_objects);
         m_objects.insert(m_objects.end(), mergeObjects.begin(), mergeObjects.end());
         
         // Generate names for newly added objects
@@ -2050,11 +2271,20 @@ void MyFrame::UpdateObjects(std::vector<std::shared_ptr<DataParser::DataObject>>
     bool anyUpdated = false;
     std::vector<std::string> updateResults;
 
+    PROFILE_SCOPE("UpdateObjects");
+    UndoHistory::SavedContents previousContents;
     ObjectTraversalUtils::ForEachObjectRecursive(objects, [&](const std::shared_ptr<DataParser::DataObject>& obj) -> bool {
-        // Try to update the object
+        PROFILE_SCOPE("UpdateObjects object");
+        // Try to update the object, the replaced payload is kept for undo
         std::string errorMsg;
-        if (obj->update(errorMsg, ForceUpdate, &m_currentPalette, m_grabberInfo.GetDither())) {
+        DataParser::DataVariant previousData;
+        DataParser::PropertyMap previousProperties = obj->properties;
+        if (obj->update(errorMsg, ForceUpdate, &m_currentPalette, m_grabberInfo.GetDither(), &previousData)) {
+            DataParser::DataObject previous = UndoHistory::withData(*obj, std::move(previousData));
+            previous.properties = std::move(previousProperties);  // Before the new date
+            previousContents.emplace_back(obj, std::move(previous));
             anyUpdated = true;
+            PROFILE_COUNTER("objects updated", 1);
             // Get the path of the object
             std::string originalPath = obj->getProperty('ORIG');
             updateResults.push_back("Updating " + originalPath + " -> " + obj->name);
@@ -2081,6 +2311,7 @@ void MyFrame::UpdateObjects(std::vector<std::shared_ptr<DataParser::DataObject>>
 
     // If any objects were updated, mark as modified
     if (anyUpdated) {
+        m_history.recordPrevious(ForceUpdate ? "Force Update" : "Update", m_objects, std::move(previousContents));
         SetModified(true);
         RefreshTreeDisplay();
     }
@@ -2145,31 +2376,32 @@ void MyFrame::OnGrab(wxCommandEvent& event) {
 
     wxString path;
     std::string objectType;
+    m_history.record("Grab", m_objects, {m_currentObject});
 
     // Determine object type and handle accordingly
     if (m_currentObject->isBitmap()) {
         objectType = "bitmap";
-        if (!GrabBitmap(path)) return;
+        if (!GrabBitmap(path)) { m_history.discardLast(); return; }
     } 
     else if (m_currentObject->isAudio()) {
         objectType = "audio";
-        if (!GrabAudio(path)) return;
+        if (!GrabAudio(path)) { m_history.discardLast(); return; }
     }
     else if (m_currentObject->isFont()) {
         objectType = "font";
-        if (!GrabFont(path)) return;
+        if (!GrabFont(path)) { m_history.discardLast(); return; }
     }
     else if (m_currentObject->isVideo()) {
         objectType = "video";
-        if (!GrabVideo(path)) return;
+        if (!GrabVideo(path)) { m_history.discardLast(); return; }
     }
     else if (m_currentObject->isRawData()) {
         objectType = "raw binary data";
-        if (!GrabRawBinary(path)) return;
+        if (!GrabRawBinary(path)) { m_history.discardLast(); return; }
     }
     else if (m_currentObject->isNested()) {
         objectType = "datafile";
-        if (!GrabNested(path)) return;
+        if (!GrabNested(path)) { m_history.discardLast(); return; }
     }
 
     // Log the grab operation
@@ -2660,6 +2892,7 @@ void MyFrame::OnGrabFromGrid(wxCommandEvent& event) {
             return;
         }
 
+        PROFILE_SCOPE("OnGrabFromGrid");
         int bits = 0;
         switch (colorIndex) {
             case 0: bits = 8; break;  // 8 bit
@@ -2671,6 +2904,7 @@ void MyFrame::OnGrabFromGrid(wxCommandEvent& event) {
         // Store palette object temporarily if using 256 colors
         std::optional<DataParser::DataObject> paletteObj;
         if (bits == 8) {
+            PROFILE_SCOPE("OnGrabFromGrid palette");
             // 256 color palette
             // check current palette match
             double currentPaletteMatch = BitmapData::calculatePaletteMatch(*m_loadedImage, m_currentPalette);
@@ -2703,56 +2937,68 @@ void MyFrame::OnGrabFromGrid(wxCommandEvent& event) {
 
         }
 
-        std::vector<BitmapData::GridCell> gridCells;
-        if (useRegularGrid) {
-            gridCells = BitmapData::gridBySize(*m_loadedImage, xGridSize, yGridSize);
-        } else if (useCol255) {
-            // If using color 255 mode, detect the bounding box
-            gridCells = BitmapData::gridByColor(*m_loadedImage, gridColor);
+        // Stage 1: find the cell boundaries with a single scan of the raw image buffer
+        std::vector<wxRect> cellRects;
+        {
+            PROFILE_SCOPE("OnGrabFromGrid split");
+            if (useRegularGrid) {
+                cellRects = BitmapData::findGridCellsBySize(*m_loadedImage, xGridSize, yGridSize);
+            } else if (useCol255) {
+                // If using color 255 mode, detect the bounding box
+                cellRects = BitmapData::findGridCellsByColor(*m_loadedImage, gridColor);
+            }
+        }
+
+        // Stage 2: crop, convert and auto-crop the cells on all cores
+        GridGrabber::Options grabOptions;
+        switch (typeIndex) {
+            case 0: grabOptions.typeID = ObjectType::DAT_BITMAP; break; // Bitmap
+            case 1: grabOptions.typeID = ObjectType::DAT_RLE_SPRITE; break; // RLE Sprite
+            case 2: grabOptions.typeID = ObjectType::DAT_C_SPRITE; break; // Compiled Sprite
+            case 3: grabOptions.typeID = ObjectType::DAT_XC_SPRITE; break; // Mode-X Compiled
         }
+        grabOptions.bits = bits;
+        grabOptions.skipEmpties = skipEmpties;
+        grabOptions.autoCrop = autoCrop;
+        grabOptions.useDithering = m_grabberInfo.GetDither();
+        grabOptions.preserveTransparency = m_grabberInfo.GetTransparency();
 
-        // Create progress dialog
         wxProgressDialog progress("Processing Grid", 
                                 "Processing grid cells...",
-                                gridCells.size(),
+                                std::max<int>(1, static_cast<int>(cellRects.size())),
                                 dialog,
-                                wxPD_AUTO_HIDE | wxPD_APP_MODAL | wxPD_ELAPSED_TIME);
+                                wxPD_AUTO_HIDE | wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_CAN_ABORT);
+
+        std::vector<GridGrabber::Cell> cells;
+        bool completed = GridGrabber::processCells(*m_loadedImage, cellRects, grabOptions, m_currentPalette, cells,
+            [&progress](size_t done, size_t total) {
+                return progress.Update(static_cast<int>(done),
+                                       wxString::Format("Processing grid cells... %zu of %zu", done, total));
+            });
+        if (!completed) {
+            SetStatusText("Grab from grid cancelled");
+            dialog->Destroy();
+            return;
+        }
 
+        // Stage 3: build the objects in grid order and insert them in one batch
+        std::string origPath;
+        {
+            auto origHolder = std::make_shared<DataParser::DataObject>();
+            SetOrigPropertyWithFormat(origHolder, m_loadedBitmapPath.ToStdString());
+            origPath = origHolder->getProperty('ORIG');
+        }
+
+        m_history.record("Grab from Grid", m_objects);
         int objectCount = 0;
-        for (const auto& cell : gridCells) {
-            BitmapData tempBmp;
-            switch (typeIndex) {
-                case 0: tempBmp.typeID = ObjectType::DAT_BITMAP; break; // Bitmap
-                case 1: tempBmp.typeID = ObjectType::DAT_RLE_SPRITE; break; // RLE Sprite
-                case 2: tempBmp.typeID = ObjectType::DAT_C_SPRITE; break; // Compiled Sprite
-                case 3: tempBmp.typeID = ObjectType::DAT_XC_SPRITE; break; // Mode-X Compiled
-            }
-            logDebug("Loading cell image at position " + std::to_string(cell.x) + "," + std::to_string(cell.y));
-            if (!tempBmp.loadFromWxImage(cell.image, bits, &m_currentPalette, m_grabberInfo.GetDither(), m_grabberInfo.GetTransparency())) {
-                logWarning("Failed to load cell image at position " + std::to_string(cell.x) + "," + std::to_string(cell.y));
+        for (auto& cell : cells) {
+            if (!cell.keep) {
                 continue;
             }
 
-            // Skip empty cells if requested
-            if (skipEmpties) {
-                if (tempBmp.isMonocolor()) {
-                    continue;
-                }
-            }
-
-            // Auto-crop if requested
-            int minX = 0, minY = 0;
-            bool wasCropped = false;
-            if (autoCrop) {
-                // Create a temporary BitmapData object for cropping
-                if (tempBmp.autoCrop(minX, minY)) {
-                    wasCropped = true;
-                }
-            }
-
             // Create DataObject
-            DataParser::DataObject obj;
-            obj.typeID = tempBmp.typeID;
+            auto obj = std::make_shared<DataParser::DataObject>();
+            obj->typeID = cell.bitmap.typeID;
 
             // Set object properties
             wxString objName;
@@ -2761,32 +3007,30 @@ void MyFrame::OnGrabFromGrid(wxCommandEvent& event) {
             } else {
                 objName = wxString::Format("%s%03d", name, objectCount);
             }
-            obj.setProperty('NAME', objName.ToStdString());
+            obj->setProperty('NAME', objName.ToStdString());
             
             // Set ORIG property to the loaded bitmap path
-            SetOrigPropertyWithFormat(std::make_shared<DataParser::DataObject>(obj), m_loadedBitmapPath.ToStdString());
+            obj->setProperty('ORIG', origPath);
             
             // Set additional properties
-            obj.updateDateProperty();
-            obj.setProperty('XPOS', std::to_string(cell.x));
-            obj.setProperty('YPOS', std::to_string(cell.y));
-            obj.setProperty('XSIZ', std::to_string(cell.width));
-            obj.setProperty('YSIZ', std::to_string(cell.height));
+            obj->updateDateProperty();
+            obj->setProperty('XPOS', std::to_string(cell.rect.x));
+            obj->setProperty('YPOS', std::to_string(cell.rect.y));
+            obj->setProperty('XSIZ', std::to_string(cell.rect.width));
+            obj->setProperty('YSIZ', std::to_string(cell.rect.height));
 
             // If the image was cropped, add crop offset properties
-            if (wasCropped) {
-                obj.setProperty('XCRP', std::to_string(minX));
-                obj.setProperty('YCRP', std::to_string(minY));
+            if (cell.cropped) {
+                obj->setProperty('XCRP', std::to_string(cell.cropX));
+                obj->setProperty('YCRP', std::to_string(cell.cropY));
             }
             
-            obj.data = tempBmp;
-            // Add object to list
-            m_objects.push_back(std::make_shared<DataParser::DataObject>(std::move(obj)));
+            obj->data = std::move(cell.bitmap);
+            m_objects.push_back(std::move(obj));
             objectCount++;
-
-            // Update progress
-            progress.Update(objectCount);
         }
+        PROFILE_COUNTER("grid cells grabbed", objectCount);
+        LOG_INFO("Grabbed %d objects from %zu grid cells", objectCount, cells.size());
 
         // Add palette object as the last object if using 256 colors
         if (bits == 8 && paletteObj.has_value()) {
@@ -2794,7 +3038,9 @@ void MyFrame::OnGrabFromGrid(wxCommandEvent& event) {
         }
 
         // Update the tree display
+        m_tree->Freeze();
         RefreshTreeDisplay();
+        m_tree->Thaw();
         SetModified(true);
 
         // Update preview controls if an object is selected
@@ -2833,8 +3079,16 @@ void MyFrame::OnTreeItemActivated(wxTreeEvent& event) {
         DataParser::DataObject& obj = const_cast<DataParser::DataObject&>(*data->object);
         FontData& fontData = const_cast<FontData&>(obj.getFont());
         
+        // The dialog edits the font in place, even when cancelled
+        FontData previousFont = fontData;
         FontEditDialog dialog(this, fontData);
-        if (dialog.ShowModal() == wxID_OK) {
+        bool accepted = dialog.ShowModal() == wxID_OK;
+        if (fontData != previousFont) {
+            UndoHistory::SavedContents previous;
+            previous.emplace_back(data->object, UndoHistory::withData(obj, std::move(previousFont)));
+            m_history.recordPrevious("Edit Font", m_objects, std::move(previous));
+        }
+        if (accepted) {
             // Font data was modified in the dialog
             SetModified(true);
             
@@ -2899,7 +3153,7 @@ void MyFrame::OnExport(wxCommandEvent& event) {
     
     if (m_currentObject->isBitmap()) {
         defaultExt = "png";
-        filter = "PNG files (*.png)|*.png|BMP files (*.bmp)|*.bmp|JPEG files (*.jpg)|*.jpg|PCX files (*.pcx)|*.pcx|All files (*.*)|*.*";
+        filter = "PNG files (*.png)|*.png|BMP files (*.bmp)|*.bmp|JPEG files (*.jpg)|*.jpg|PCX files (*.pcx)|*.pcx|TGA files (*.tga)|*.tga|All files (*.*)|*.*";
     }
     else if (m_currentObject->isFont()) {
         defaultExt = "bmp";
@@ -2952,7 +3206,7 @@ void MyFrame::OnExport(wxCommandEvent& event) {
             // Check if the extension is valid for the current object type
             if (m_currentObject->isBitmap() && 
                 (origExt == "png" || origExt == "bmp" || origExt == "jpg" || 
-                 origExt == "jpeg" || origExt == "pcx")) {
+                 origExt == "jpeg" || origExt == "pcx" || origExt == "tga")) {
                 defaultExt = origExt;
             }
             else if (m_currentObject->isFont() && 
@@ -2995,6 +3249,7 @@ void MyFrame::OnExport(wxCommandEvent& event) {
         else if (defaultExt == "bmp") filterIndex = 1;
         else if (defaultExt == "jpg" || defaultExt == "jpeg") filterIndex = 2;
         else if (defaultExt == "pcx") filterIndex = 3;
+        else if (defaultExt == "tga") filterIndex = 4;
         else filterIndex = 0;
     } else if (m_currentObject->isFont()) {
         if (defaultExt == "bmp") filterIndex = 0;
@@ -3033,11 +3288,18 @@ void MyFrame::OnExport(wxCommandEvent& event) {
     if (m_currentObject->isBitmap()) {
         const BitmapData& bmpData = m_currentObject->getBitmap();
         wxImage image;
-        
-        if (bmpData.toWxImage(image, m_currentPalette)) {
+        wxString ext = path.AfterLast('.').Lower();
+        // The native codecs write the bitmap at its own depth (8-bit stays paletted).
+        // Sprites whose transparency only exists in the alpha vector go through wxImage.
+        bool compiledSprite8 = bmpData.bits == 8 && (bmpData.typeID == ObjectType::DAT_C_SPRITE || bmpData.typeID == ObjectType::DAT_XC_SPRITE);
+        bool nativeDepth = bmpData.bits == 8 || bmpData.bits == 24 || bmpData.bits == 32 || bmpData.bits == -32;
+        if (ImageCodec::formatFromPath(path.ToStdString()) != ImageCodec::Format::Unknown &&
+            !bmpData.isPalette() && nativeDepth && !compiledSprite8 &&
+            (bmpData.alpha.empty() || bmpData.bits == -32)) {
+            success = ImageCodec::writeFile(path.ToStdString(), bmpData, m_currentPalette);
+        }
+        else if (bmpData.toWxImage(image, m_currentPalette)) {
             // Determine file format based on extension
-            wxString ext = path.AfterLast('.').Lower();
-            
             if (ext == "png") {
                 success = image.SaveFile(path, wxBITMAP_TYPE_PNG);
             } 
@@ -3051,6 +3313,9 @@ void MyFrame::OnExport(wxCommandEvent& event) {
                 // PCX export is not natively supported by wxWidgets, implement custom PCX export
                 success = BitmapData::WritePCXFile(path, image);
             }
+            else if (ext == "tga") {
+                success = image.SaveFile(path, wxBITMAP_TYPE_TGA);
+            }
             else {
                 // Default to PNG for other extensions
                 success = image.SaveFile(path, wxBITMAP_TYPE_PNG);
@@ -3213,23 +3478,14 @@ void MyFrame::OnMoveUp(wxCommandEvent& event) {
         return;
     }
 
-    // Store the current object's UI ID before moving
-    uint32_t currentUID = m_currentObject->ui_id;
-
     // Use utility function to find and move object
-    bool moved = ObjectTraversalUtils::ForEachObjectRecursive(m_objects, [this](std::shared_ptr<DataParser::DataObject>& obj) -> bool {
-        if (obj == m_currentObject) {
-            // Find parent vector and move object up
-            auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, obj);
-            if (parentVector) {
-                return ObjectTraversalUtils::MoveObjectUp(*parentVector, obj);
-            }
-        }
-        return false;
-    });
+    m_history.record("Move Up", m_objects);
+    auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, m_currentObject);
+    bool moved = parentVector && ObjectTraversalUtils::MoveObjectUp(*parentVector, m_currentObject);
 
     if (!moved) {
         // Already at the top, silently do nothing
+        m_history.discardLast();
         return;
     }
 
@@ -3239,34 +3495,8 @@ void MyFrame::OnMoveUp(wxCommandEvent& event) {
     // Refresh the tree display to reflect the changes
     RefreshTreeDisplay();
 
-    // Find and select the moved object in the tree by UI ID
-    wxTreeItemId rootId = m_tree->GetRootItem();
-    
-    // Helper function to recursively search tree items
-    std::function<wxTreeItemId(wxTreeItemId)> findObjectInTree;
-    findObjectInTree = [&](wxTreeItemId parent) -> wxTreeItemId {
-        wxTreeItemIdValue cookie;
-        wxTreeItemId item = m_tree->GetFirstChild(parent, cookie);
-        while (item.IsOk()) {
-            ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
-            if (data && data->object && data->object->ui_id == currentUID) {
-                return item;
-            }
-            
-            // Check children recursively
-            if (m_tree->ItemHasChildren(item)) {
-                wxTreeItemId found = findObjectInTree(item);
-                if (found.IsOk()) {
-                    return found;
-                }
-            }
-            
-            item = m_tree->GetNextSibling(item);
-        }
-        return wxTreeItemId();
-    };
-
-    wxTreeItemId foundItem = findObjectInTree(rootId);
+    // Select the moved object again
+    wxTreeItemId foundItem = FindTreeItem(m_currentObject);
     if (foundItem.IsOk()) {
         ObjectTreeData* foundData = static_cast<ObjectTreeData*>(m_tree->GetItemData(foundItem));
         if (foundData && foundData->object) {
@@ -3289,23 +3519,14 @@ void MyFrame::OnMoveDown(wxCommandEvent& event) {
         return;
     }
 
-    // Store the current object's UI ID before moving
-    uint32_t currentUID = m_currentObject->ui_id;
-
     // Use utility function to find and move object
-    bool moved = ObjectTraversalUtils::ForEachObjectRecursive(m_objects, [this](std::shared_ptr<DataParser::DataObject>& obj) -> bool {
-        if (obj == m_currentObject) {
-            // Find parent vector and move object down
-            auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, obj);
-            if (parentVector) {
-                return ObjectTraversalUtils::MoveObjectDown(*parentVector, obj);
-            }
-        }
-        return false;
-    });
+    m_history.record("Move Down", m_objects);
+    auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, m_currentObject);
+    bool moved = parentVector && ObjectTraversalUtils::MoveObjectDown(*parentVector, m_currentObject);
 
     if (!moved) {
         // Already at the bottom, silently do nothing
+        m_history.discardLast();
         return;
     }
 
@@ -3315,34 +3536,8 @@ void MyFrame::OnMoveDown(wxCommandEvent& event) {
     // Refresh the tree display to reflect the changes
     RefreshTreeDisplay();
 
-    // Find and select the moved object in the tree by UI ID
-    wxTreeItemId rootId = m_tree->GetRootItem();
-    
-    // Helper function to recursively search tree items
-    std::function<wxTreeItemId(wxTreeItemId)> findObjectInTree;
-    findObjectInTree = [&](wxTreeItemId parent) -> wxTreeItemId {
-        wxTreeItemIdValue cookie;
-        wxTreeItemId item = m_tree->GetFirstChild(parent, cookie);
-        while (item.IsOk()) {
-            ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
-            if (data && data->object && data->object->ui_id == currentUID) {
-                return item;
-            }
-            
-            // Check children recursively
-            if (m_tree->ItemHasChildren(item)) {
-                wxTreeItemId found = findObjectInTree(item);
-                if (found.IsOk()) {
-                    return found;
-                }
-            }
-            
-            item = m_tree->GetNextSibling(item);
-        }
-        return wxTreeItemId();
-    };
-
-    wxTreeItemId foundItem = findObjectInTree(rootId);
+    // Select the moved object again
+    wxTreeItemId foundItem = FindTreeItem(m_currentObject);
     if (foundItem.IsOk()) {
         ObjectTreeData* foundData = static_cast<ObjectTreeData*>(m_tree->GetItemData(foundItem));
         if (foundData && foundData->object) {
@@ -3361,7 +3556,8 @@ void MyFrame::OnMoveDown(wxCommandEvent& event) {
 }
 
 // Helper to add a new object to the root or to the selected datafile's nested objects
-void MyFrame::addObjectToCurrentOrRoot(std::shared_ptr<DataParser::DataObject> obj) {
+void MyFrame::addObjectToCurrentOrRoot(std::shared_ptr<DataParser::DataObject> obj, const std::string& undoDescription) {
+    m_history.record(undoDescription, m_objects);
     if (m_currentObject && m_currentObject->isNested()) {
         auto& nested = m_currentObject->getNestedObjects();
         nested.push_back(obj);
@@ -3474,6 +3670,7 @@ void MyFrame::AVPositionUpdateCallback(int currentPositionMs, int totalDurationM
         UpdatePlayButtonIcon(m_videoPanel->GetIsPlaying());
     } else if (m_currentObject->isAudio()) {
         UpdatePlayButtonIcon(m_audioControl->GetIsPlaying());
+        m_waveformView->SetPositionMs(currentPositionMs);
     }
 }
 
@@ -3531,8 +3728,8 @@ void MyFrame::OnTreeEndDrag(wxTreeEvent& event) {
         return;
     }
 
-    // Store the UID before modifying the tree, to avoid use-after-free
-    uint32_t movedUID = sourceData->object->ui_id;
+    // Keep the object before modifying the tree, the source item may be deleted
+    std::shared_ptr<DataParser::DataObject> movedObj = sourceData->object;
     
     std::shared_ptr<DataParser::DataObject> targetObj = nullptr;
     if (targetItem != m_tree->GetRootItem()) {
@@ -3550,7 +3747,8 @@ void MyFrame::OnTreeEndDrag(wxTreeEvent& event) {
     }
 
     // Perform the move operation
-    if (MoveObjectInTree(sourceData->object, targetObj)) {
+    m_history.record("Move", m_objects);
+    if (MoveObjectInTree(movedObj, targetObj)) {
         // Mark as modified
         SetModified(true);
 
@@ -3560,34 +3758,8 @@ void MyFrame::OnTreeEndDrag(wxTreeEvent& event) {
         // Refresh the tree display
         RefreshTreeDisplay();
 
-        // Find and select the moved object using the stored UID
-        wxTreeItemId rootId = m_tree->GetRootItem();
-        
-        // Helper function to recursively search tree items
-        std::function<wxTreeItemId(wxTreeItemId)> findObjectInTree;
-        findObjectInTree = [&](wxTreeItemId parent) -> wxTreeItemId {
-            wxTreeItemIdValue cookie;
-            wxTreeItemId item = m_tree->GetFirstChild(parent, cookie);
-            while (item.IsOk()) {
-                ObjectTreeData* data = static_cast<ObjectTreeData*>(m_tree->GetItemData(item));
-                if (data && data->object && data->object->ui_id == movedUID) {
-                    return item;
-                }
-                
-                // Check children recursively
-                if (m_tree->ItemHasChildren(item)) {
-                    wxTreeItemId found = findObjectInTree(item);
-                    if (found.IsOk()) {
-                        return found;
-                    }
-                }
-                
-                item = m_tree->GetNextSibling(item);
-            }
-            return wxTreeItemId();
-        };
-
-        wxTreeItemId foundItem = findObjectInTree(rootId);
+        // Select the moved object again
+        wxTreeItemId foundItem = FindTreeItem(movedObj);
         if (foundItem.IsOk()) {
             ObjectTreeData* foundData = static_cast<ObjectTreeData*>(m_tree->GetItemData(foundItem));
             if (foundData && foundData->object) {
@@ -3603,6 +3775,7 @@ void MyFrame::OnTreeEndDrag(wxTreeEvent& event) {
 
         SetStatusText("Object moved successfully");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to move object.", "Move Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3827,6 +4000,7 @@ void MyFrame::OnReplaceWithBitmap(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3836,6 +4010,7 @@ void MyFrame::OnReplaceWithBitmap(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to Bitmap.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3859,6 +4034,7 @@ void MyFrame::OnReplaceWithFont(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3868,6 +4044,7 @@ void MyFrame::OnReplaceWithFont(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to Font.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3891,6 +4068,7 @@ void MyFrame::OnReplaceWithCompiledSprite(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3900,6 +4078,7 @@ void MyFrame::OnReplaceWithCompiledSprite(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to Compiled Sprite.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3923,6 +4102,7 @@ void MyFrame::OnReplaceWithXSprite(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3932,6 +4112,7 @@ void MyFrame::OnReplaceWithXSprite(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to X-Compiled Sprite.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3955,6 +4136,7 @@ void MyFrame::OnReplaceWithDatafile(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3964,6 +4146,7 @@ void MyFrame::OnReplaceWithDatafile(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to Datafile.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -3987,6 +4170,7 @@ void MyFrame::OnReplaceWithFLI(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -3996,6 +4180,7 @@ void MyFrame::OnReplaceWithFLI(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to FLI Animation.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -4019,6 +4204,7 @@ void MyFrame::OnReplaceWithMIDI(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -4028,6 +4214,7 @@ void MyFrame::OnReplaceWithMIDI(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to MIDI File.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -4055,6 +4242,7 @@ void MyFrame::OnReplaceWithPalette(wxCommandEvent& event)
         auto newObj = std::make_shared<DataParser::DataObject>(std::move(paletteObj));
         
         // Use utility function to find and replace object
+        m_history.record("Replace", m_objects);
         bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
         if (replaced) {
@@ -4064,6 +4252,7 @@ void MyFrame::OnReplaceWithPalette(wxCommandEvent& event)
             UpdateObjectPreview();
             SetStatusText("Object changed to Palette.");
         } else {
+            m_history.discardLast();
             wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
         }
     } else {
@@ -4090,6 +4279,7 @@ void MyFrame::OnReplaceWithRLE(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -4099,6 +4289,7 @@ void MyFrame::OnReplaceWithRLE(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to RLE Sprite.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -4122,6 +4313,7 @@ void MyFrame::OnReplaceWithSample(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -4131,6 +4323,7 @@ void MyFrame::OnReplaceWithSample(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to Audio Sample.");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -4162,6 +4355,7 @@ void MyFrame::OnReplaceWithOther(wxCommandEvent& event)
     newObj->updateDateProperty();
 
     // Use utility function to find and replace object
+    m_history.record("Replace", m_objects);
     bool replaced = ObjectTraversalUtils::FindAndReplaceObject(m_objects, m_currentObject, newObj);
 
     if (replaced) {
@@ -4171,6 +4365,7 @@ void MyFrame::OnReplaceWithOther(wxCommandEvent& event)
         UpdateObjectPreview();
         SetStatusText("Object changed to " + newType + ".");
     } else {
+        m_history.discardLast();
         wxMessageBox("Failed to find and replace object.", "Error", wxOK | wxICON_ERROR);
     }
 }
@@ -4214,11 +4409,12 @@ void MyFrame::OnRenameObject(wxCommandEvent& event)
             return;
         }
 
+        m_history.recordProperties("Rename", m_objects, {m_currentObject});
         m_currentObject->setProperty('NAME', newName.ToStdString());
         m_currentObject->updateDateProperty();
 
         SetModified(true);
-        RefreshTreeDisplay();
+        RefreshTreeItem(m_currentObject);
         UpdateObjectPreview();
         SetStatusText("Object renamed to " + newName);
     }
@@ -4291,11 +4487,15 @@ void MyFrame::OnSetProperty(wxCommandEvent& event)
                           ((unsigned char)propIdStr[2] << 8) |
                           ((unsigned char)propIdStr[3]);
 
+        m_history.recordProperties("Set Property", m_objects, {m_currentObject});
         m_currentObject->setProperty(propId, propValue.ToStdString());
         m_currentObject->updateDateProperty();
 
         SetModified(true);
         UpdatePropertyList(m_currentObject);
+        if (propId == 'NAME') {
+            RefreshTreeItem(m_currentObject);
+        }
         SetStatusText("Property " + propIdStr + " set.");
     }
 }
@@ -4308,6 +4508,7 @@ void MyFrame::OnAutocrop(wxCommandEvent& event)
         wxMessageBox("No objects selected for autocrop.", "Autocrop", wxOK | wxICON_INFORMATION);
         return;
     }
+    m_history.record("Autocrop", m_objects, selectedObjs);
     int cropped = 0, ignored = 0;
     for (auto& obj : selectedObjs) {
         if (!obj->isBitmap()) {
@@ -4321,6 +4522,9 @@ void MyFrame::OnAutocrop(wxCommandEvent& event)
             ++cropped;
         }
     }
+    if (cropped == 0) {
+        m_history.discardLast();
+    }
     if (cropped > 0) {
         SetModified(true);
         RefreshTreeDisplay();
@@ -4331,63 +4535,1140 @@ void MyFrame::OnAutocrop(wxCommandEvent& event)
     }
 }
 
-// Update OnDepth* to support multiple selection
-#define MULTI_DEPTH_HANDLER(FUNC, bits, label) \
-void MyFrame::FUNC(wxCommandEvent& event) { \
-    auto selectedObjs = GetSelectedObjects(); \
-    if (selectedObjs.empty()) { \
-        wxMessageBox("No objects selected for depth change.", "Change Depth", wxOK | wxICON_INFORMATION); \
-        return; \
-    } \
-    int changed = 0, ignored = 0; \
-    for (auto& obj : selectedObjs) { \
-        if (!obj->isBitmap()) { ++ignored; continue; } \
-        BitmapData& bmpData = const_cast<BitmapData&>(obj->getBitmap()); \
-        if (bmpData.setColorDepth(bits, m_currentPalette, m_grabberInfo.GetDither(), m_grabberInfo.GetTransparency())) { \
-            obj->updateDateProperty(); \
-            ++changed; \
-        } \
-    } \
-    if (changed > 0) { SetModified(true); RefreshTreeDisplay(); SetStatusText(wxString::Format("%d object(s) converted to %s", changed, label)); } \
-    if (ignored > 0) { wxMessageBox(wxString::Format("%d non-bitmap object(s) were ignored", ignored), "Change Depth", wxOK | wxICON_INFORMATION); } \
-}
-MULTI_DEPTH_HANDLER(OnDepth256, 8, "256 color palette")
-MULTI_DEPTH_HANDLER(OnDepth15, 15, "15-bit hicolor")
-MULTI_DEPTH_HANDLER(OnDepth16, 16, "16-bit hicolor")
-MULTI_DEPTH_HANDLER(OnDepth24, 24, "24-bit truecolor")
-MULTI_DEPTH_HANDLER(OnDepth32, 32, "32-bit truecolor")
-#undef MULTI_DEPTH_HANDLER
-
-// Update OnChangeFilenameToRelative/Absolute to support multiple selection
-void MyFrame::OnChangeFilenameToRelative(wxCommandEvent& event) {
+void MyFrame::OnSpriteBenchmark(wxCommandEvent& event)
+{
     auto selectedObjs = GetSelectedObjects();
     if (selectedObjs.empty()) {
-        wxMessageBox("No objects selected for filename change.", "Change Filename", wxOK | wxICON_INFORMATION);
+        wxMessageBox("No objects selected for the benchmark.", "Sprite Blit Benchmark", wxOK | wxICON_INFORMATION);
         return;
     }
-    int changed = 0, ignored = 0;
-    wxString cwd = wxGetCwd();
+    auto typeName = [](ObjectType type) -> wxString {
+        switch (type) {
+            case ObjectType::DAT_RLE_SPRITE: return "RLE sprite";
+            case ObjectType::DAT_C_SPRITE: return "Compiled sprite";
+            case ObjectType::DAT_XC_SPRITE: return "X-compiled sprite";
+            default: return "Bitmap";
+        }
+    };
+
+    wxBusyCursor busy;
+    wxString report;
+    std::vector<std::pair<std::shared_ptr<DataParser::DataObject>, ObjectType>> changes;
+    int ignored = 0;
     for (auto& obj : selectedObjs) {
-        std::string orig = obj->getProperty('ORIG');
-        if (orig.empty()) { ++ignored; continue; }
-        wxFileName fileName(wxString::FromUTF8(orig));
-        if (!fileName.IsAbsolute()) { ++ignored; continue; }
-        fileName.MakeRelativeTo(cwd);
-        std::string newOrig = fileName.GetFullPath().ToStdString();
-        if (newOrig == orig) { ++ignored; continue; }
-        obj->setProperty('ORIG', newOrig);
-        obj->updateDateProperty();
-        ++changed;
-    }
-    if (changed > 0) { SetModified(true); RefreshTreeDisplay(); SetStatusText(wxString::Format("%d object(s) changed to relative filename", changed)); }
-    if (ignored > 0) { wxMessageBox(wxString::Format("%d object(s) were ignored", ignored), "Change Filename", wxOK | wxICON_INFORMATION); }
-}
-void MyFrame::OnChangeFilenameToAbsolute(wxCommandEvent& event) {
+        SpriteBlitBenchmark::Result result;
+        if (!obj->isBitmap() || !SpriteBlitBenchmark::run(obj->getBitmap(), result)) {
+            ++ignored;
+            continue;
+        }
+        report += wxString::Format("%s: compiled %s, RLE %.0f ns (%zu bytes), masked %.0f ns (%zu bytes), %.0f%% opaque -> %s\n",
+                                   wxString::FromUTF8(obj->name),
+                                   result.compiledSupported ? wxString::Format("%.0f ns (%zu bytes)", result.compiledNs, result.compiledBytes) : wxString("n/a"),
+                                   result.rleNs, result.rleBytes, result.maskedNs, result.maskedBytes,
+                                   result.opaqueRatio * 100.0, typeName(result.recommended));
+        if (!result.outputsMatch) {
+            logWarning("Sprite blitters disagree on " + obj->name);
+        }
+        // X-compiled sprites draw like compiled ones, keep them when compiled wins
+        bool keep = obj->typeID == result.recommended ||
+                    (obj->typeID == ObjectType::DAT_XC_SPRITE && result.recommended == ObjectType::DAT_C_SPRITE);
+        if (!keep) {
+            changes.emplace_back(obj, result.recommended);
+        }
+    }
+    if (ignored > 0) {
+        report += wxString::Format("\n%d non-bitmap object(s) were ignored\n", ignored);
+    }
+    if (changes.empty()) {
+        wxMessageBox(report, "Sprite Blit Benchmark", wxOK | wxICON_INFORMATION);
+        return;
+    }
+
+    report += wxString::Format("\nChange %zu object(s) to the recommended type?", changes.size());
+    if (wxMessageBox(report, "Sprite Blit Benchmark", wxYES_NO | wxICON_QUESTION) != wxYES) {
+        return;
+    }
+    std::vector<std::shared_ptr<DataParser::DataObject>> changedObjs;
+    for (auto& change : changes) {
+        changedObjs.push_back(change.first);
+    }
+    m_history.record("Change Sprite Type", m_objects, changedObjs);
+    int changed = 0;
+    for (auto& change : changes) {
+        if (change.first->getBitmap().setType(change.second)) {
+            change.first->typeID = change.second;
+            ++changed;
+        }
+    }
+    if (changed > 0) {
+        SetModified(true);
+        RefreshTreeDisplay();
+        SetStatusText(wxString::Format("%d object(s) changed to the recommended sprite type", changed));
+    }
+}
+
+void MyFrame::OnFlicBenchmark(wxCommandEvent& event)
+{
+    std::vector<std::shared_ptr<DataParser::DataObject>> videos;
+    for (auto& obj : GetSelectedObjects()) {
+        if (obj->isVideo()) {
+            videos.push_back(obj);
+        }
+    }
+    if (videos.empty()) {
+        wxMessageBox("Select FLIC objects for the benchmark.", "FLIC Decode Benchmark", wxOK | wxICON_INFORMATION);
+        return;
+    }
+
+    wxBusyCursor busy;
+    wxString report;
+    for (auto& obj : videos) {
+        FlicDecodeBenchmark::Result result;
+        if (!FlicDecodeBenchmark::run(obj->getVideo(), result)) {
+            report += wxString::Format("%s: no decodable frames\n", wxString::FromUTF8(obj->name));
+            continue;
+        }
+        report += wxString::Format("%s: %dx%d, %d frames, decode %.1f us + RGB %.1f us per frame (%.0f%% of rows), %.0f fps; "
+                                   "full SetRGB conversion %.1f us per frame\n",
+                                   wxString::FromUTF8(obj->name), result.width, result.height, result.frames,
+                                   result.decodeUs, result.expandUs, result.dirtyRowShare * 100.0, result.framesPerSecond,
+                                   result.fullConvertUs);
+        if (!result.outputsMatch) {
+            logWarning("Incremental FLIC conversion differs from a full conversion in " + obj->name);
+        }
+    }
+    wxMessageBox(report, "FLIC Decode Benchmark", wxOK | wxICON_INFORMATION);
+}
+
+void MyFrame::OnCreateFlic(wxCommandEvent& event)
+{
+    // Frames are the selected bitmaps in tree order, or image files picked here when none are selected
+    std::vector<std::shared_ptr<DataParser::DataObject>> frames;
+    std::unordered_set<uint32_t> seen;
+    ObjectTraversalUtils::ForEachObjectRecursive(GetSelectedObjects(), [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isBitmap() && !obj->getBitmap().isPalette() && seen.insert(obj->ui_id).second) {
+            frames.push_back(obj);
+        }
+        return false;
+    });
+    wxArrayString paths;
+    if (frames.empty()) {
+        wxFileDialog openFileDialog(this, "Select Animation Frames", "", "",
+                                    "Image files (*.bmp;*.png;*.jpg;*.jpeg;*.tga;*.pcx)|*.bmp;*.png;*.jpg;*.jpeg;*.tga;*.pcx",
+                                    wxFD_OPEN | wxFD_FILE_MUST_EXIST | wxFD_MULTIPLE);
+        if (openFileDialog.ShowModal() == wxID_CANCEL) {
+            return;
+        }
+        openFileDialog.GetPaths(paths);
+        paths.Sort();
+    }
+    size_t frameCount = frames.empty() ? paths.size() : frames.size();
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Create FLIC",
+                                  wxDefaultPosition, wxDefaultSize,
+                                  wxDEFAULT_DIALOG_STYLE);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+    wxStaticText* info = new wxStaticText(dialog, wxID_ANY,
+        wxString::Format("%zu frame(s) will be encoded with one shared palette.", frameCount));
+    mainSizer->Add(info, 0, wxALL, 5);
+
+    wxBoxSizer* nameSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* nameLabel = new wxStaticText(dialog, wxID_ANY, "Name:");
+    wxTextCtrl* nameText = new wxTextCtrl(dialog, wxID_ANY, "animation", wxDefaultPosition, wxSize(200, -1));
+    nameSizer->Add(nameLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    nameSizer->Add(nameText, 1, wxEXPAND);
+    mainSizer->Add(nameSizer, 0, wxALL | wxEXPAND, 5);
+
+    wxRadioBox* formatBox = new wxRadioBox(dialog, wxID_ANY, "Format",
+                                           wxDefaultPosition, wxDefaultSize,
+                                           wxArrayString{"FLC", "FLI"},
+                                           2, wxRA_SPECIFY_COLS);
+    mainSizer->Add(formatBox, 0, wxEXPAND | wxALL, 5);
+
+    wxBoxSizer* delaySizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* delayLabel = new wxStaticText(dialog, wxID_ANY, "Frame delay (ms):");
+    wxTextCtrl* delayText = new wxTextCtrl(dialog, wxID_ANY, "70", wxDefaultPosition, wxSize(60, -1));
+    delaySizer->Add(delayLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    delaySizer->Add(delayText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(delaySizer, 0, wxALL, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* okButton = new wxButton(dialog, wxID_OK, "OK");
+    wxButton* cancelButton = new wxButton(dialog, wxID_CANCEL, "Cancel");
+    buttonSizer->Add(okButton, 0, wxALL, 5);
+    buttonSizer->Add(cancelButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    mainSizer->Fit(dialog);
+    dialog->Center();
+
+    if (dialog->ShowModal() != wxID_OK) {
+        dialog->Destroy();
+        return;
+    }
+
+    FlicEncoder::Params params;
+    params.format = formatBox->GetSelection() == 1 ? FlicEncoder::Format::FLI : FlicEncoder::Format::FLC;
+    long delay = 70;
+    delayText->GetValue().ToLong(&delay);
+    params.frameDelayMs = static_cast<int>(std::clamp(delay, 1L, 60000L));
+    params.palette = m_currentPalette;
+    wxString flicName = nameText->GetValue().Trim().Trim(false);
+    if (flicName.IsEmpty()) {
+        flicName = "animation";
+    }
+    dialog->Destroy();
+
+    std::vector<FlicEncoder::Input> inputs(frameCount);
+    for (size_t i = 0; i < frameCount; i++) {
+        if (frames.empty()) {
+            inputs[i].filepath = paths[i].ToStdString();
+        } else {
+            inputs[i].bitmap = &frames[i]->getBitmap();
+        }
+    }
+    FlicEncoder::Result result;
+    {
+        wxBusyCursor busy;
+        if (!FlicEncoder::encode(inputs, params, result)) {
+            wxMessageBox("Failed to create the animation, see the log for details.", "Create FLIC", wxOK | wxICON_ERROR);
+            return;
+        }
+    }
+
+    auto flicObj = std::make_shared<DataParser::DataObject>();
+    flicObj->typeID = ObjectType::DAT_FLI;
+    flicObj->setProperty('NAME', flicName.ToStdString());
+    flicObj->updateDateProperty();
+    size_t bytes = result.video.data.size();
+    flicObj->data = std::move(result.video);
+    addObjectToCurrentOrRoot(flicObj, "Create FLIC");
+    SetModified(true);
+    RefreshTreeDisplay();
+    SetStatusText(wxString::Format("Encoded %zu frames, %zu bytes: %d BRUN, %d delta, %d copy, %d unchanged%s",
+                                   frameCount, bytes, result.brunFrames, result.deltaFrames, result.copyFrames,
+                                   result.unchangedFrames, result.exactColors ? "" : ", colors reduced to 256"));
+}
+
+void MyFrame::OnImportUnicodeFont(wxCommandEvent& event)
+{
+    wxFileDialog openFileDialog(this, "Select Font Sources", "", "",
+                                "Font sources (*.bdf;*.fnt;*.bmp;*.png;*.pcx;*.tga)|*.bdf;*.fnt;*.bmp;*.png;*.pcx;*.tga|"
+                                "BDF fonts (*.bdf)|*.bdf|"
+                                "GRX fonts (*.fnt)|*.fnt|"
+                                "Grid sheets (*.bmp;*.png;*.pcx;*.tga)|*.bmp;*.png;*.pcx;*.tga",
+                                wxFD_OPEN | wxFD_FILE_MUST_EXIST | wxFD_MULTIPLE);
+    if (openFileDialog.ShowModal() == wxID_CANCEL) {
+        return;
+    }
+    wxArrayString paths;
+    openFileDialog.GetPaths(paths);
+    paths.Sort();
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Import Unicode Font",
+                                  wxDefaultPosition, wxDefaultSize,
+                                  wxDEFAULT_DIALOG_STYLE);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+    wxStaticText* info = new wxStaticText(dialog, wxID_ANY,
+        wxString::Format("%zu source(s). Where sources share a code point the first one wins.", paths.size()));
+    mainSizer->Add(info, 0, wxALL, 5);
+
+    wxBoxSizer* nameSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* nameLabel = new wxStaticText(dialog, wxID_ANY, "Name:");
+    wxTextCtrl* nameText = new wxTextCtrl(dialog, wxID_ANY, "font", wxDefaultPosition, wxSize(200, -1));
+    nameSizer->Add(nameLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    nameSizer->Add(nameText, 1, wxEXPAND);
+    mainSizer->Add(nameSizer, 0, wxALL | wxEXPAND, 5);
+
+    wxStaticBoxSizer* sheetBox = new wxStaticBoxSizer(wxVERTICAL, dialog, "Grid sheets");
+    wxBoxSizer* codeSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* codeLabel = new wxStaticText(dialog, wxID_ANY, "First codes:");
+    wxTextCtrl* codeText = new wxTextCtrl(dialog, wxID_ANY, "U+0020", wxDefaultPosition, wxSize(200, -1));
+    codeSizer->Add(codeLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    codeSizer->Add(codeText, 1, wxALIGN_CENTER_VERTICAL);
+    sheetBox->Add(codeSizer, 0, wxALL | wxEXPAND, 5);
+    wxStaticText* codeInfo = new wxStaticText(dialog, wxID_ANY,
+        "One per sheet in file name order, comma separated. A sheet without one takes\n"
+        "the code in its file name (font_U0400), else it follows the previous sheet.");
+    sheetBox->Add(codeInfo, 0, wxLEFT | wxRIGHT | wxBOTTOM, 5);
+
+    wxBoxSizer* formatSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* formatLabel = new wxStaticText(dialog, wxID_ANY, "Color format:");
+    wxChoice* formatChoice = new wxChoice(dialog, wxID_ANY);
+    formatChoice->Append("Monochrome");
+    formatChoice->Append("8-bit indexed");
+    formatChoice->Append("24-bit RGB");
+    formatChoice->Append("32-bit RGBA");
+    formatChoice->SetSelection(0);
+    formatSizer->Add(formatLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    formatSizer->Add(formatChoice, 0, wxALIGN_CENTER_VERTICAL);
+    sheetBox->Add(formatSizer, 0, wxALL, 5);
+
+    wxBoxSizer* cellSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* cellLabel = new wxStaticText(dialog, wxID_ANY, "Cell size (0 = separator lines):");
+    wxTextCtrl* cellWidthText = new wxTextCtrl(dialog, wxID_ANY, "0", wxDefaultPosition, wxSize(50, -1));
+    wxStaticText* cellTimes = new wxStaticText(dialog, wxID_ANY, "x");
+    wxTextCtrl* cellHeightText = new wxTextCtrl(dialog, wxID_ANY, "0", wxDefaultPosition, wxSize(50, -1));
+    cellSizer->Add(cellLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    cellSizer->Add(cellWidthText, 0, wxALIGN_CENTER_VERTICAL);
+    cellSizer->Add(cellTimes, 0, wxALIGN_CENTER_VERTICAL | wxLEFT | wxRIGHT, 5);
+    cellSizer->Add(cellHeightText, 0, wxALIGN_CENTER_VERTICAL);
+    sheetBox->Add(cellSizer, 0, wxALL, 5);
+
+    wxCheckBox* mappingCheck = new wxCheckBox(dialog, wxID_ANY, "Translate sheet codes with a mapping file");
+    sheetBox->Add(mappingCheck, 0, wxALL, 5);
+    mainSizer->Add(sheetBox, 0, wxALL | wxEXPAND, 5);
+
+    wxBoxSizer* trimSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxCheckBox* trimCheck = new wxCheckBox(dialog, wxID_ANY, "Trim glyph widths, spacing:");
+    wxTextCtrl* spacingText = new wxTextCtrl(dialog, wxID_ANY, "1", wxDefaultPosition, wxSize(40, -1));
+    trimSizer->Add(trimCheck, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    trimSizer->Add(spacingText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(trimSizer, 0, wxALL, 5);
+
+    wxBoxSizer* gapSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* gapLabel = new wxStaticText(dialog, wxID_ANY, "Join ranges across gaps up to:");
+    wxTextCtrl* gapText = new wxTextCtrl(dialog, wxID_ANY, "0", wxDefaultPosition, wxSize(50, -1));
+    gapSizer->Add(gapLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    gapSizer->Add(gapText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(gapSizer, 0, wxALL, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* okButton = new wxButton(dialog, wxID_OK, "OK");
+    wxButton* cancelButton = new wxButton(dialog, wxID_CANCEL, "Cancel");
+    buttonSizer->Add(okButton, 0, wxALL, 5);
+    buttonSizer->Add(cancelButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    mainSizer->Fit(dialog);
+    dialog->Center();
+
+    if (dialog->ShowModal() != wxID_OK) {
+        dialog->Destroy();
+        return;
+    }
+
+    // Same code syntax as the script files: 0x or U+ for hex, decimal otherwise
+    wxArrayString codeStrings = wxSplit(codeText->GetValue(), ',');
+    std::vector<long> firstCodes;    // -1 where a sheet has no code of its own
+    for (wxString codeString : codeStrings) {
+        codeString.Trim().Trim(false);
+        unsigned long code = 0;
+        bool parsed = codeString.StartsWith("0x") || codeString.StartsWith("0X") || codeString.StartsWith("U+") || codeString.StartsWith("u+")
+                    ? codeString.Mid(2).ToULong(&code, 16) : codeString.ToULong(&code, 10);
+        if (codeString.IsEmpty()) {
+            firstCodes.push_back(-1);
+        } else if (!parsed || code > 0x10FFFF) {
+            dialog->Destroy();
+            wxMessageBox("Invalid first code: " + codeString, "Import Unicode Font", wxOK | wxICON_ERROR);
+            return;
+        } else {
+            firstCodes.push_back(static_cast<long>(code));
+        }
+    }
+    const int8_t colorFormats[] = {1, 0, 24, -32};
+    long cellWidth = 0, cellHeight = 0, spacing = 1, maxGap = 0;
+    cellWidthText->GetValue().ToLong(&cellWidth);
+    cellHeightText->GetValue().ToLong(&cellHeight);
+    spacingText->GetValue().ToLong(&spacing);
+    gapText->GetValue().ToLong(&maxGap);
+
+    FontImporter::Options options;
+    options.trim = trimCheck->GetValue();
+    options.spacing = static_cast<int>(std::clamp(spacing, 0L, 64L));
+    options.maxGapFill = static_cast<uint32_t>(std::clamp(maxGap, 0L, 0xFFFFL));
+    bool useMapping = mappingCheck->GetValue();
+    wxString fontName = nameText->GetValue().Trim().Trim(false);
+    if (fontName.IsEmpty()) {
+        fontName = "font";
+    }
+
+    FontImporter::Source sourceTemplate;
+    sourceTemplate.colorFormat = colorFormats[std::max(formatChoice->GetSelection(), 0)];
+    sourceTemplate.cellWidth = static_cast<int>(std::max(cellWidth, 0L));
+    sourceTemplate.cellHeight = static_cast<int>(std::max(cellHeight, 0L));
+    dialog->Destroy();
+
+    wxString mappingFile;
+    if (useMapping) {
+        wxFileDialog mappingDialog(this, "Select Code Mapping File", "", "",
+                                   "Mapping files (*.txt;*.map)|*.txt;*.map|All files (*.*)|*.*",
+                                   wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+        if (mappingDialog.ShowModal() == wxID_CANCEL) {
+            return;
+        }
+        mappingFile = mappingDialog.GetPath();
+    }
+
+    // BDF and GRX fonts carry their own codes, the first codes and the mapping are for sheets
+    std::vector<FontImporter::Source> sources(paths.size(), sourceTemplate);
+    size_t sheetIndex = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        sources[i].filepath = paths[i].ToStdString();
+        if (FontImporter::detectType(sources[i].filepath) != FontImporter::SourceType::GridSheet) {
+            continue;
+        }
+        sources[i].mappingFile = mappingFile.ToStdString();
+        uint32_t rangeStart = 0, rangeEnd = 0;
+        if (sheetIndex < firstCodes.size() && firstCodes[sheetIndex] >= 0) {
+            sources[i].firstCode = static_cast<uint32_t>(firstCodes[sheetIndex]);
+        } else if (FontData::ParseRangeFromFilename(paths[i], rangeStart, rangeEnd)) {
+            sources[i].firstCode = rangeStart;
+        } else {
+            sources[i].followPrevious = sheetIndex > 0;
+        }
+        sheetIndex++;
+    }
+    FontImporter::Result result;
+    {
+        wxBusyCursor busy;
+        if (!FontImporter::import(sources, options, result)) {
+            wxMessageBox("Failed to import the font, see the log for details.", "Import Unicode Font", wxOK | wxICON_ERROR);
+            return;
+        }
+    }
+
+    auto fontObj = std::make_shared<DataParser::DataObject>();
+    fontObj->typeID = ObjectType::DAT_FONT;
+    fontObj->setProperty('NAME', fontName.ToStdString());
+    fontObj->updateDateProperty();
+    size_t rangeCount = result.font.ranges.size();
+    fontObj->data = std::move(result.font);
+    addObjectToCurrentOrRoot(fontObj, "Import Unicode Font");
+    SetModified(true);
+    RefreshTreeDisplay();
+    SetStatusText(wxString::Format("Imported %d glyphs in %zu ranges, %d duplicates dropped",
+                                   result.glyphs, rangeCount, result.duplicates));
+
+    wxString report = wxString::Format("%d glyphs in %zu ranges.\n\nBlock coverage:\n", result.glyphs, rangeCount);
+    report += wxString::FromUTF8(FontImporter::formatCoverage(result.coverage));
+    wxMessageBox(report, "Import Unicode Font", wxOK | wxICON_INFORMATION);
+}
+
+void MyFrame::OnBuildAtlas(wxCommandEvent& event)
+{
+    // Bitmaps of the selection, selected datafiles contribute all bitmaps inside them
+    std::vector<std::shared_ptr<DataParser::DataObject>> sprites;
+    std::unordered_set<uint32_t> seen;
+    ObjectTraversalUtils::ForEachObjectRecursive(GetSelectedObjects(), [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isBitmap() && !obj->getBitmap().isPalette() && seen.insert(obj->ui_id).second) {
+            sprites.push_back(obj);
+        }
+        return false;
+    });
+    if (sprites.empty()) {
+        wxMessageBox("Select bitmaps or a datafile to build an atlas from.", "Build Atlas", wxOK | wxICON_INFORMATION);
+        return;
+    }
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Build Atlas",
+                                  wxDefaultPosition, wxDefaultSize,
+                                  wxDEFAULT_DIALOG_STYLE);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    wxBoxSizer* nameSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* nameLabel = new wxStaticText(dialog, wxID_ANY, "Name:");
+    wxTextCtrl* nameText = new wxTextCtrl(dialog, wxID_ANY, "atlas", wxDefaultPosition, wxSize(200, -1));
+    nameSizer->Add(nameLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    nameSizer->Add(nameText, 1, wxEXPAND);
+    mainSizer->Add(nameSizer, 0, wxALL | wxEXPAND, 5);
+
+    wxBoxSizer* sizeSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* paddingLabel = new wxStaticText(dialog, wxID_ANY, "Padding:");
+    wxTextCtrl* paddingText = new wxTextCtrl(dialog, wxID_ANY, "1", wxDefaultPosition, wxSize(40, -1));
+    wxStaticText* maxSizeLabel = new wxStaticText(dialog, wxID_ANY, "Max size:");
+    wxTextCtrl* maxSizeText = new wxTextCtrl(dialog, wxID_ANY, "4096", wxDefaultPosition, wxSize(60, -1));
+    sizeSizer->Add(paddingLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    sizeSizer->Add(paddingText, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    sizeSizer->Add(maxSizeLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    sizeSizer->Add(maxSizeText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(sizeSizer, 0, wxALL, 5);
+
+    wxCheckBox* trimCheck = new wxCheckBox(dialog, wxID_ANY, "Trim transparent borders");
+    trimCheck->SetValue(true);
+    mainSizer->Add(trimCheck, 0, wxALL, 5);
+    wxCheckBox* powerOfTwoCheck = new wxCheckBox(dialog, wxID_ANY, "Power of two size");
+    mainSizer->Add(powerOfTwoCheck, 0, wxALL, 5);
+    wxCheckBox* rotationCheck = new wxCheckBox(dialog, wxID_ANY, "Allow rotation");
+    mainSizer->Add(rotationCheck, 0, wxALL, 5);
+
+    wxRadioBox* outputBox = new wxRadioBox(dialog, wxID_ANY, "Coordinates",
+                                           wxDefaultPosition, wxDefaultSize,
+                                           wxArrayString{
+                                               "C header file",
+                                               "Datafile object"
+                                           },
+                                           1, wxRA_SPECIFY_COLS);
+    mainSizer->Add(outputBox, 0, wxEXPAND | wxALL, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* okButton = new wxButton(dialog, wxID_OK, "OK");
+    wxButton* cancelButton = new wxButton(dialog, wxID_CANCEL, "Cancel");
+    buttonSizer->Add(okButton, 0, wxALL, 5);
+    buttonSizer->Add(cancelButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    mainSizer->Fit(dialog);
+    dialog->Center();
+
+    if (dialog->ShowModal() != wxID_OK) {
+        dialog->Destroy();
+        return;
+    }
+
+    AtlasPacker::Options options;
+    long padding = 1, maxSize = 4096;
+    paddingText->GetValue().ToLong(&padding);
+    maxSizeText->GetValue().ToLong(&maxSize);
+    options.padding = std::max(0L, padding);
+    options.maxSize = static_cast<int>(std::max(1L, maxSize));
+    options.trim = trimCheck->GetValue();
+    options.powerOfTwo = powerOfTwoCheck->GetValue();
+    options.allowRotation = rotationCheck->GetValue();
+    wxString atlasName = nameText->GetValue().Trim().Trim(false);
+    if (atlasName.IsEmpty()) {
+        atlasName = "atlas";
+    }
+    bool headerOutput = outputBox->GetSelection() == 0;
+    dialog->Destroy();
+
+    std::vector<AtlasPacker::Input> inputs;
+    inputs.reserve(sprites.size());
+    for (const auto& obj : sprites) {
+        inputs.push_back(AtlasPacker::Input{obj->name, &obj->getBitmap()});
+    }
+    AtlasPacker::Result result;
+    {
+        wxBusyCursor busy;
+        if (!AtlasPacker::pack(inputs, options, result)) {
+            wxMessageBox("Failed to build the atlas, see the log for details.", "Build Atlas", wxOK | wxICON_ERROR);
+            return;
+        }
+    }
+
+    if (headerOutput) {
+        // Next to the datafile's own header by default
+        wxString defaultDir = m_currentFilePath.empty() ? wxString() : wxFileName(wxString::FromUTF8(m_currentFilePath)).GetPath();
+        wxFileDialog saveDialog(this, "Save Atlas Header", defaultDir, atlasName + ".h",
+                                "C header files (*.h)|*.h|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+        if (saveDialog.ShowModal() == wxID_CANCEL) {
+            return;
+        }
+        std::ofstream headerFile(saveDialog.GetPath().ToStdString());
+        if (!headerFile.is_open()) {
+            logError("Failed to create header file: " + saveDialog.GetPath().ToStdString());
+            wxMessageBox("Failed to write the atlas header.", "Build Atlas", wxOK | wxICON_ERROR);
+            return;
+        }
+        headerFile << AtlasPacker::generateHeader(result, atlasName.ToStdString());
+    }
+
+    m_history.record("Build Atlas", m_objects);
+    auto atlasObj = std::make_shared<DataParser::DataObject>();
+    atlasObj->typeID = ObjectType::DAT_BITMAP;
+    atlasObj->setProperty('NAME', atlasName.ToStdString());
+    atlasObj->updateDateProperty();
+    atlasObj->data = std::move(result.atlas);
+    m_objects.push_back(atlasObj);
+
+    if (!headerOutput) {
+        auto tableObj = std::make_shared<DataParser::DataObject>();
+        tableObj->typeID = ObjectType::DAT_DATA;
+        tableObj->setProperty('NAME', atlasName.ToStdString() + "_RECTS");
+        tableObj->updateDateProperty();
+        tableObj->data = AtlasPacker::serializeTable(result);
+        m_objects.push_back(tableObj);
+    }
+
+    SetModified(true);
+    m_tree->Freeze();
+    RefreshTreeDisplay();
+    m_tree->Thaw();
+    const BitmapData& atlas = atlasObj->getBitmap();
+    SetStatusText(wxString::Format("Packed %zu sprites into a %dx%d atlas", sprites.size(), atlas.width, atlas.height));
+}
+
+void MyFrame::OnFindDuplicates(wxCommandEvent& event)
+{
+    // Search the selection, or the whole datafile when nothing is selected
+    auto selectedObjs = GetSelectedObjects();
+    const auto& roots = selectedObjs.empty() ? m_objects : selectedObjs;
+    std::vector<std::shared_ptr<DataParser::DataObject>> images;
+    std::unordered_set<uint32_t> seen;
+    ObjectTraversalUtils::ForEachObjectRecursive(roots, [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isBitmap() && seen.insert(obj->ui_id).second) {
+            images.push_back(obj);
+        }
+        return false;
+    });
+
+    std::vector<DuplicateFinder::Group> groups;
+    {
+        wxBusyCursor busy;
+        groups = DuplicateFinder::find(images, m_currentPalette, DuplicateFinder::Options());
+    }
+    if (groups.empty()) {
+        wxMessageBox(wxString::Format("No duplicates found among %zu images.", images.size()), "Find Duplicates", wxOK | wxICON_INFORMATION);
+        return;
+    }
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Duplicate Images",
+                                  wxDefaultPosition, wxSize(560, 400),
+                                  wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    wxListCtrl* list = new wxListCtrl(dialog, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT);
+    list->InsertColumn(0, "Group", wxLIST_FORMAT_LEFT, 50);
+    list->InsertColumn(1, "Object", wxLIST_FORMAT_LEFT, 220);
+    list->InsertColumn(2, "Size", wxLIST_FORMAT_LEFT, 110);
+    list->InsertColumn(3, "Match", wxLIST_FORMAT_LEFT, 110);
+    size_t duplicateCount = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        const auto& group = groups[g];
+        for (size_t i = 0; i < group.objects.size(); i++) {
+            const BitmapData& bitmap = group.objects[i]->getBitmap();
+            long row = list->InsertItem(list->GetItemCount(), wxString::Format("%zu", g + 1));
+            list->SetItem(row, 1, wxString::FromUTF8(group.objects[i]->name));
+            list->SetItem(row, 2, wxString::Format("%dx%d, %d bpp", bitmap.width, bitmap.height, std::abs(bitmap.bits)));
+            if (i == 0) {
+                list->SetItem(row, 3, "kept");
+            } else if (bitmap == group.objects[0]->getBitmap()) {
+                list->SetItem(row, 3, "exact");
+            } else {
+                list->SetItem(row, 3, wxString::Format("similar (%d)",
+                    DuplicateFinder::hammingDistance(DuplicateFinder::perceptualHash(bitmap, m_currentPalette),
+                                                     DuplicateFinder::perceptualHash(group.objects[0]->getBitmap(), m_currentPalette))));
+            }
+            list->SetItemData(row, static_cast<long>(g));
+        }
+        duplicateCount += group.objects.size() - 1;
+    }
+    mainSizer->Add(list, 1, wxEXPAND | wxALL, 5);
+
+    wxStaticText* hint = new wxStaticText(dialog, wxID_ANY,
+        wxString::Format("%zu duplicate(s) in %zu group(s). Actions apply to the selected groups, or to all when none is selected.",
+                         duplicateCount, groups.size()));
+    hint->Wrap(540);
+    mainSizer->Add(hint, 0, wxLEFT | wxRIGHT | wxEXPAND, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* mergeButton = new wxButton(dialog, ID_DUPLICATES_MERGE, "Merge into One");
+    wxButton* replaceButton = new wxButton(dialog, ID_DUPLICATES_REPLACE, "Replace References");
+    wxButton* closeButton = new wxButton(dialog, wxID_CANCEL, "Close");
+    mergeButton->Bind(wxEVT_BUTTON, [dialog](wxCommandEvent&) { dialog->EndModal(ID_DUPLICATES_MERGE); });
+    replaceButton->Bind(wxEVT_BUTTON, [dialog](wxCommandEvent&) { dialog->EndModal(ID_DUPLICATES_REPLACE); });
+    buttonSizer->Add(mergeButton, 0, wxALL, 5);
+    buttonSizer->Add(replaceButton, 0, wxALL, 5);
+    buttonSizer->Add(closeButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    dialog->Center();
+
+    int action = dialog->ShowModal();
+    std::vector<bool> chosen(groups.size(), list->GetSelectedItemCount() == 0);
+    for (long row = list->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED); row != -1;
+         row = list->GetNextItem(row, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) {
+        chosen[static_cast<size_t>(list->GetItemData(row))] = true;
+    }
+    dialog->Destroy();
+    if (action != ID_DUPLICATES_MERGE && action != ID_DUPLICATES_REPLACE) {
+        return;
+    }
+
+    UndoHistory::SavedContents previousContents;
+    if (action == ID_DUPLICATES_MERGE) {
+        m_history.record("Merge Duplicates", m_objects);
+    }
+    int changed = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (!chosen[g]) {
+            continue;
+        }
+        const auto& kept = groups[g].objects[0];
+        for (size_t i = 1; i < groups[g].objects.size(); i++) {
+            auto obj = groups[g].objects[i];
+            if (action == ID_DUPLICATES_MERGE) {
+                // The first object of the group stands in for all of them
+                auto* parentVector = ObjectTraversalUtils::FindParentVector(m_objects, obj);
+                if (parentVector && ObjectTraversalUtils::FindAndRemoveObject(*parentVector, obj)) {
+                    ++changed;
+                }
+            } else {
+                // Datafile objects are addressed by name and index, so keep both and share the kept pixels
+                ObjectType typeID = obj->getBitmap().typeID;
+                previousContents.emplace_back(obj, UndoHistory::withData(*obj, std::move(obj->data)));
+                obj->data = kept->getBitmap();
+                obj->getBitmap().typeID = typeID;
+                obj->updateDateProperty();
+                ++changed;
+            }
+        }
+    }
+    if (action == ID_DUPLICATES_MERGE) {
+        m_currentObject = nullptr;
+        if (changed == 0) {
+            m_history.discardLast();
+        }
+    } else if (changed > 0) {
+        m_history.recordPrevious("Replace Duplicates", m_objects, std::move(previousContents));
+    }
+    if (changed > 0) {
+        SetModified(true);
+        m_tree->Freeze();
+        RefreshTreeDisplay();
+        m_tree->Thaw();
+        SetStatusText(wxString::Format(action == ID_DUPLICATES_MERGE ? "%d duplicate object(s) removed" : "%d duplicate object(s) replaced", changed));
+    }
+}
+
+void MyFrame::OnBatchTransform(wxCommandEvent& event)
+{
+    // Bitmaps of the selection, selected datafiles contribute all bitmaps inside them
+    std::vector<std::shared_ptr<DataParser::DataObject>> targets;
+    std::unordered_set<uint32_t> seen;
+    ObjectTraversalUtils::ForEachObjectRecursive(GetSelectedObjects(), [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isBitmap() && !obj->getBitmap().isPalette() && seen.insert(obj->ui_id).second) {
+            targets.push_back(obj);
+        }
+        return false;
+    });
+    if (targets.empty()) {
+        wxMessageBox("Select bitmaps or a datafile to transform.", "Batch Transform", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    std::vector<std::shared_ptr<DataParser::DataObject>> palettes;
+    ObjectTraversalUtils::ForEachObjectRecursive(m_objects, [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isBitmap() && obj->getBitmap().isPalette()) {
+            palettes.push_back(obj);
+        }
+        return false;
+    });
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Batch Transform",
+                                  wxDefaultPosition, wxDefaultSize,
+                                  wxDEFAULT_DIALOG_STYLE);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+
+    wxRadioBox* operationBox = new wxRadioBox(dialog, wxID_ANY, "Operation",
+                                              wxDefaultPosition, wxDefaultSize,
+                                              wxArrayString{
+                                                  "Remap to palette",
+                                                  "Flip horizontally",
+                                                  "Flip vertically",
+                                                  "Rotate right",
+                                                  "Rotate 180 degrees",
+                                                  "Rotate left",
+                                                  "Scale",
+                                                  "Replace color"
+                                              },
+                                              2, wxRA_SPECIFY_COLS);
+    operationBox->SetSelection(1);
+    mainSizer->Add(operationBox, 0, wxEXPAND | wxALL, 5);
+
+    wxBoxSizer* paletteSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* paletteLabel = new wxStaticText(dialog, wxID_ANY, "Target palette:");
+    wxChoice* paletteChoice = new wxChoice(dialog, wxID_ANY);
+    for (const auto& palette : palettes) {
+        paletteChoice->Append(wxString::FromUTF8(palette->name));
+    }
+    if (!palettes.empty()) {
+        paletteChoice->SetSelection(0);
+    }
+    paletteSizer->Add(paletteLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    paletteSizer->Add(paletteChoice, 1, wxEXPAND);
+    mainSizer->Add(paletteSizer, 0, wxALL | wxEXPAND, 5);
+
+    wxBoxSizer* scaleSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* scaleLabel = new wxStaticText(dialog, wxID_ANY, "Scale (%):");
+    wxTextCtrl* scaleText = new wxTextCtrl(dialog, wxID_ANY, "200", wxDefaultPosition, wxSize(60, -1));
+    scaleSizer->Add(scaleLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    scaleSizer->Add(scaleText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(scaleSizer, 0, wxALL, 5);
+
+    wxBoxSizer* colorSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* fromLabel = new wxStaticText(dialog, wxID_ANY, "Replace:");
+    wxColourPickerCtrl* fromPicker = new wxColourPickerCtrl(dialog, wxID_ANY, wxColour(0, 0, 0));
+    wxStaticText* toLabel = new wxStaticText(dialog, wxID_ANY, "with:");
+    wxColourPickerCtrl* toPicker = new wxColourPickerCtrl(dialog, wxID_ANY, wxColour(255, 255, 255));
+    colorSizer->Add(fromLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    colorSizer->Add(fromPicker, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    colorSizer->Add(toLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    colorSizer->Add(toPicker, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(colorSizer, 0, wxALL, 5);
+    wxCheckBox* maskCheck = new wxCheckBox(dialog, wxID_ANY, "Replace with the transparent color");
+    mainSizer->Add(maskCheck, 0, wxALL, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* okButton = new wxButton(dialog, wxID_OK, "OK");
+    wxButton* cancelButton = new wxButton(dialog, wxID_CANCEL, "Cancel");
+    buttonSizer->Add(okButton, 0, wxALL, 5);
+    buttonSizer->Add(cancelButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    mainSizer->Fit(dialog);
+    dialog->Center();
+
+    if (dialog->ShowModal() != wxID_OK) {
+        dialog->Destroy();
+        return;
+    }
+
+    BatchTransform::Params params;
+    params.operation = static_cast<BatchTransform::Operation>(operationBox->GetSelection());
+    params.palette = m_currentPalette;
+    long scalePercent = 200;
+    scaleText->GetValue().ToLong(&scalePercent);
+    params.scalePercent = static_cast<int>(scalePercent);
+    wxColour fromColor = fromPicker->GetColour();
+    wxColour toColor = toPicker->GetColour();
+    params.fromColor = (fromColor.Red() << 16) | (fromColor.Green() << 8) | fromColor.Blue();
+    params.toColor = (toColor.Red() << 16) | (toColor.Green() << 8) | toColor.Blue();
+    params.toMask = maskCheck->GetValue();
+    int paletteIndex = paletteChoice->GetSelection();
+    dialog->Destroy();
+
+    if (params.operation == BatchTransform::Operation::RemapPalette) {
+        if (paletteIndex == wxNOT_FOUND) {
+            wxMessageBox("The datafile has no palette object to remap to.", "Batch Transform", wxOK | wxICON_INFORMATION);
+            return;
+        }
+        params.targetPalette = palettes[paletteIndex]->getBitmap().data;
+    }
+    if (params.operation == BatchTransform::Operation::Scale && (params.scalePercent <= 0 || params.scalePercent > 10000)) {
+        wxMessageBox("Scale must be between 1% and 10000%.", "Batch Transform", wxOK | wxICON_ERROR);
+        return;
+    }
+    if (params.operation == BatchTransform::Operation::Scale) {
+        for (const auto& target : targets) {
+            int width = 0, height = 0;
+            if (!BatchTransform::scaledSize(target->getBitmap(), params.scalePercent, width, height)) {
+                wxMessageBox(wxString::Format("%s would be larger than %d pixels on a side or %lld pixels in total at %d%%.",
+                                              wxString::FromUTF8(target->name), BatchTransform::MaxSide,
+                                              static_cast<long long>(BatchTransform::MaxPixels), params.scalePercent),
+                             "Batch Transform", wxOK | wxICON_ERROR);
+                return;
+            }
+        }
+    }
+
+    std::vector<BatchTransform::Job> jobs(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        jobs[i].source = &targets[i]->getBitmap();
+    }
+    {
+        wxBusyCursor busy;
+        BatchTransform::run(jobs, params);
+    }
+
+    // The replaced bitmaps move into the undo history, so nothing is copied
+    UndoHistory::SavedContents previousContents;
+    int changed = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        if (!jobs[i].done) {
+            continue;
+        }
+        previousContents.emplace_back(targets[i], UndoHistory::withData(*targets[i], std::move(targets[i]->data)));
+        targets[i]->data = std::move(jobs[i].result);
+        targets[i]->updateDateProperty();
+        ++changed;
+    }
+    if (changed > 0) {
+        m_history.recordPrevious("Batch Transform", m_objects, std::move(previousContents));
+        SetModified(true);
+        m_tree->Freeze();
+        RefreshTreeDisplay();
+        m_tree->Thaw();
+        SetStatusText(wxString::Format("%d bitmap(s) transformed", changed));
+    }
+    if (changed < static_cast<int>(targets.size())) {
+        wxMessageBox(wxString::Format("%zu bitmap(s) could not be transformed, see the log for details.", targets.size() - changed),
+                     "Batch Transform", wxOK | wxICON_WARNING);
+    }
+}
+
+void MyFrame::OnBatchAudio(wxCommandEvent& event)
+{
+    // OGG and SAMP objects of the selection, selected datafiles contribute all sounds inside them
+    std::vector<std::shared_ptr<DataParser::DataObject>> targets;
+    std::unordered_set<uint32_t> seen;
+    ObjectTraversalUtils::ForEachObjectRecursive(GetSelectedObjects(), [&](const std::shared_ptr<DataParser::DataObject>& obj) {
+        if (obj->isAudio() && obj->getAudio().typeID != ObjectType::DAT_MIDI && seen.insert(obj->ui_id).second) {
+            targets.push_back(obj);
+        }
+        return false;
+    });
+
+    // Without sounds in the selection, the OGG and WAV files of a directory are imported
+    // as new objects, which are added once converted
+    bool imported = targets.empty();
+    int unreadable = 0;
+    if (imported) {
+        wxDirDialog dirDialog(this, "Select a Directory of OGG or WAV Files to Convert", "",
+                              wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST);
+        if (dirDialog.ShowModal() == wxID_CANCEL) {
+            return;
+        }
+        wxArrayString files;
+        wxDir::GetAllFiles(dirDialog.GetPath(), &files, wxEmptyString, wxDIR_FILES);
+        files.Sort();
+        for (const wxString& path : files) {
+            wxFileName fileName(path);
+            wxString extension = fileName.GetExt().Lower();
+            if (extension != "ogg" && extension != "wav") {
+                continue;
+            }
+            AudioData audioData;
+            audioData.typeID = extension == "ogg" ? ObjectType::DAT_OGG : ObjectType::DAT_SAMP;
+            if (!audioData.importFromFile(path.ToStdString())) {
+                logError("Batch Convert Audio: cannot read " + path.ToStdString());
+                ++unreadable;
+                continue;
+            }
+            auto obj = std::make_shared<DataParser::DataObject>();
+            obj->typeID = audioData.typeID;
+            obj->setProperty('NAME', fileName.GetName().ToStdString());
+            SetOrigPropertyWithFormat(obj, path.ToStdString());
+            obj->updateDateProperty();
+            obj->data = std::move(audioData);
+            targets.push_back(obj);
+        }
+        if (targets.empty()) {
+            wxMessageBox(unreadable > 0 ? "None of the OGG or WAV files in the directory could be read."
+                                        : "The directory has no OGG or WAV files.",
+                         "Batch Convert Audio", wxOK | wxICON_INFORMATION);
+            return;
+        }
+    }
+
+    wxDialog* dialog = new wxDialog(this, wxID_ANY, "Batch Convert Audio",
+                                  wxDefaultPosition, wxDefaultSize,
+                                  wxDEFAULT_DIALOG_STYLE);
+    wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+    wxStaticText* info = new wxStaticText(dialog, wxID_ANY,
+        wxString::Format(imported ? "%zu sound(s) will be added as samples." : "%zu sound(s) will be stored as samples.", targets.size()));
+    mainSizer->Add(info, 0, wxALL, 5);
+
+    const int rates[] = {0, 8000, 11025, 16000, 22050, 32000, 44100};
+    wxBoxSizer* rateSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* rateLabel = new wxStaticText(dialog, wxID_ANY, "Sample rate:");
+    wxChoice* rateChoice = new wxChoice(dialog, wxID_ANY);
+    for (int rate : rates) {
+        rateChoice->Append(rate == 0 ? wxString("Keep") : wxString::Format("%d Hz", rate));
+    }
+    rateChoice->SetSelection(0);
+    rateSizer->Add(rateLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    rateSizer->Add(rateChoice, 1, wxEXPAND);
+    mainSizer->Add(rateSizer, 0, wxALL | wxEXPAND, 5);
+
+    wxRadioBox* channelBox = new wxRadioBox(dialog, wxID_ANY, "Channels",
+                                            wxDefaultPosition, wxDefaultSize,
+                                            wxArrayString{"Keep", "Mono", "Stereo"},
+                                            3, wxRA_SPECIFY_COLS);
+    mainSizer->Add(channelBox, 0, wxEXPAND | wxALL, 5);
+    wxRadioBox* bitsBox = new wxRadioBox(dialog, wxID_ANY, "Sample depth",
+                                         wxDefaultPosition, wxDefaultSize,
+                                         wxArrayString{"8 bit", "16 bit"},
+                                         2, wxRA_SPECIFY_COLS);
+    bitsBox->SetSelection(1);
+    mainSizer->Add(bitsBox, 0, wxEXPAND | wxALL, 5);
+
+    wxBoxSizer* normalizeSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxCheckBox* normalizeCheck = new wxCheckBox(dialog, wxID_ANY, "Normalize peak to (dB):");
+    wxTextCtrl* peakText = new wxTextCtrl(dialog, wxID_ANY, "-1.0", wxDefaultPosition, wxSize(60, -1));
+    normalizeSizer->Add(normalizeCheck, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    normalizeSizer->Add(peakText, 0, wxALIGN_CENTER_VERTICAL);
+    mainSizer->Add(normalizeSizer, 0, wxALL, 5);
+
+    wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* okButton = new wxButton(dialog, wxID_OK, "OK");
+    wxButton* cancelButton = new wxButton(dialog, wxID_CANCEL, "Cancel");
+    buttonSizer->Add(okButton, 0, wxALL, 5);
+    buttonSizer->Add(cancelButton, 0, wxALL, 5);
+    mainSizer->Add(buttonSizer, 0, wxALIGN_CENTER | wxALL, 5);
+
+    dialog->SetSizer(mainSizer);
+    mainSizer->Fit(dialog);
+    dialog->Center();
+
+    if (dialog->ShowModal() != wxID_OK) {
+        dialog->Destroy();
+        return;
+    }
+
+    BatchAudioConvert::Params params;
+    params.sampleRate = rates[std::max(rateChoice->GetSelection(), 0)];
+    params.channels = channelBox->GetSelection();
+    params.bitsPerSample = bitsBox->GetSelection() == 0 ? 8 : 16;
+    params.normalize = normalizeCheck->GetValue();
+    double peakDb = -1.0;
+    peakText->GetValue().ToDouble(&peakDb);
+    params.normalizePeakDb = static_cast<float>(peakDb);
+    dialog->Destroy();
+
+    if (params.normalize && (peakDb > 0.0 || peakDb < -60.0)) {
+        wxMessageBox("Normalize level must be between -60 and 0 dB.", "Batch Convert Audio", wxOK | wxICON_ERROR);
+        return;
+    }
+
+    std::vector<BatchAudioConvert::Job> jobs(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        jobs[i].source = &targets[i]->getAudio();
+    }
+    {
+        wxBusyCursor busy;
+        BatchAudioConvert::run(jobs, params);
+    }
+
+    wxDialog* report = new wxDialog(this, wxID_ANY, "Batch Convert Audio",
+                                  wxDefaultPosition, wxSize(520, 360),
+                                  wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER);
+    wxBoxSizer* reportSizer = new wxBoxSizer(wxVERTICAL);
+    wxListCtrl* list = new wxListCtrl(report, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT);
+    list->InsertColumn(0, "Object", wxLIST_FORMAT_LEFT, 200);
+    list->InsertColumn(1, "Before", wxLIST_FORMAT_RIGHT, 90);
+    list->InsertColumn(2, "After", wxLIST_FORMAT_RIGHT, 90);
+    list->InsertColumn(3, "Ratio", wxLIST_FORMAT_RIGHT, 80);
+
+    // The replaced sounds move into the undo history, so nothing is copied
+    UndoHistory::SavedContents previousContents;
+    int changed = 0;
+    size_t totalBefore = 0, totalAfter = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        long row = list->InsertItem(list->GetItemCount(), wxString::FromUTF8(targets[i]->name));
+        if (!jobs[i].done) {
+            list->SetItem(row, 1, "failed");
+            continue;
+        }
+        list->SetItem(row, 1, wxString::Format("%zu", jobs[i].sourceBytes));
+        list->SetItem(row, 2, wxString::Format("%zu", jobs[i].resultBytes));
+        list->SetItem(row, 3, wxString::Format("%.1f%%", 100.0 * jobs[i].resultBytes / std::max<size_t>(jobs[i].sourceBytes, 1)));
+        totalBefore += jobs[i].sourceBytes;
+        totalAfter += jobs[i].resultBytes;
+
+        if (imported) {
+            targets[i]->typeID = ObjectType::DAT_SAMP;
+            targets[i]->data = std::move(jobs[i].result);
+            ++changed;
+            continue;
+        }
+        DataParser::DataObject previous = UndoHistory::withData(*targets[i], std::move(targets[i]->data));
+        targets[i]->typeID = ObjectType::DAT_SAMP;
+        targets[i]->data = std::move(jobs[i].result);
+        targets[i]->updateDateProperty();
+        previousContents.emplace_back(targets[i], std::move(previous));
+        ++changed;
+    }
+    if (changed > 0 && imported) {
+        // Converted files go where new objects go, as one undo step
+        m_history.record("Batch Convert Audio", m_objects);
+        auto& destination = m_currentObject && m_currentObject->isNested() ? m_currentObject->getNestedObjects() : m_objects;
+        for (size_t i = 0; i < targets.size(); i++) {
+            if (jobs[i].done) {
+                destination.push_back(targets[i]);
+            }
+        }
+    } else if (changed > 0) {
+        m_history.recordPrevious("Batch Convert Audio", m_objects, std::move(previousContents));
+    }
+    if (changed > 0) {
+        SetModified(true);
+        m_tree->Freeze();
+        RefreshTreeDisplay();
+        m_tree->Thaw();
+        if (m_currentObject && seen.count(m_currentObject->ui_id)) {
+            UpdatePreviewControls(m_currentObject);
+        }
+        SetStatusText(wxString::Format("%d sound(s) converted", changed));
+    }
+    reportSizer->Add(list, 1, wxEXPAND | wxALL, 5);
+    wxString summary = wxString::Format("%d of %zu sound(s) converted", changed, targets.size());
+    if (totalBefore > 0) {
+        summary += wxString::Format(", %zu bytes before, %zu after (%.1f%%).", totalBefore, totalAfter, 100.0 * totalAfter / totalBefore);
+    }
+    if (unreadable > 0) {
+        summary += wxString::Format(" %d file(s) could not be read.", unreadable);
+    }
+    if (changed < static_cast<int>(targets.size()) || unreadable > 0) {
+        summary += " See the log for the failures.";
+    }
+    wxStaticText* summaryText = new wxStaticText(report, wxID_ANY, summary);
+    summaryText->Wrap(500);
+    reportSizer->Add(summaryText, 0, wxLEFT | wxRIGHT | wxEXPAND, 5);
+    wxButton* closeButton = new wxButton(report, wxID_OK, "Close");
+    reportSizer->Add(closeButton, 0, wxALIGN_CENTER | wxALL, 5);
+    report->SetSizer(reportSizer);
+    report->Center();
+    report->ShowModal();
+    report->Destroy();
+}
+
+// Update OnDepth* to support multiple selection
+#define MULTI_DEPTH_HANDLER(FUNC, bits, label) \
+void MyFrame::FUNC(wxCommandEvent& event) { \
+    auto selectedObjs = GetSelectedObjects(); \
+    if (selectedObjs.empty()) { \
+        wxMessageBox("No objects selected for depth change.", "Change Depth", wxOK | wxICON_INFORMATION); \
+        return; \
+    } \
+    m_history.record("Change Depth", m_objects, selectedObjs); \
+    int changed = 0, ignored = 0; \
+    for (auto& obj : selectedObjs) { \
+        if (!obj->isBitmap()) { ++ignored; continue; } \
+        BitmapData& bmpData = const_cast<BitmapData&>(obj->getBitmap()); \
+        if (bmpData.setColorDepth(bits, m_currentPalette, m_grabberInfo.GetDither(), m_grabberInfo.GetTransparency())) { \
+            obj->updateDateProperty(); \
+            ++changed; \
+        } \
+    } \
+    if (changed == 0) { m_history.discardLast(); } \
+    if (changed > 0) { SetModified(true); RefreshTreeDisplay(); SetStatusText(wxString::Format("%d object(s) converted to %s", changed, label)); } \
+    if (ignored > 0) { wxMessageBox(wxString::Format("%d non-bitmap object(s) were ignored", ignored), "Change Depth", wxOK | wxICON_INFORMATION); } \
+}
+MULTI_DEPTH_HANDLER(OnDepth256, 8, "256 color palette")
+MULTI_DEPTH_HANDLER(OnDepth15, 15, "15-bit hicolor")
+MULTI_DEPTH_HANDLER(OnDepth16, 16, "16-bit hicolor")
+MULTI_DEPTH_HANDLER(OnDepth24, 24, "24-bit truecolor")
+MULTI_DEPTH_HANDLER(OnDepth32, 32, "32-bit truecolor")
+#undef MULTI_DEPTH_HANDLER
+
+// Update OnChangeFilenameToRelative/Absolute to support multiple selection
+void MyFrame::OnChangeFilenameToRelative(wxCommandEvent& event) {
+    auto selectedObjs = GetSelectedObjects();
+    if (selectedObjs.empty()) {
+        wxMessageBox("No objects selected for filename change.", "Change Filename", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    m_history.recordProperties("Change Filename", m_objects, selectedObjs);
+    int changed = 0, ignored = 0;
+    wxString cwd = wxGetCwd();
+    for (auto& obj : selectedObjs) {
+        std::string orig = obj->getProperty('ORIG');
+        if (orig.empty()) { ++ignored; continue; }
+        wxFileName fileName(wxString::FromUTF8(orig));
+        if (!fileName.IsAbsolute()) { ++ignored; continue; }
+        fileName.MakeRelativeTo(cwd);
+        std::string newOrig = fileName.GetFullPath().ToStdString();
+        if (newOrig == orig) { ++ignored; continue; }
+        obj->setProperty('ORIG', newOrig);
+        obj->updateDateProperty();
+        ++changed;
+    }
+    if (changed == 0) { m_history.discardLast(); }
+    if (changed > 0) { SetModified(true); SetStatusText(wxString::Format("%d object(s) changed to relative filename", changed)); }
+    if (ignored > 0) { wxMessageBox(wxString::Format("%d object(s) were ignored", ignored), "Change Filename", wxOK | wxICON_INFORMATION); }
+}
+void MyFrame::OnChangeFilenameToAbsolute(wxCommandEvent& event) {
     auto selectedObjs = GetSelectedObjects();
     if (selectedObjs.empty()) {
         wxMessageBox("No objects selected for filename change.", "Change Filename", wxOK | wxICON_INFORMATION);
         return;
     }
+    m_history.recordProperties("Change Filename", m_objects, selectedObjs);
     int changed = 0, ignored = 0;
     wxString cwd = wxGetCwd();
     for (auto& obj : selectedObjs) {
@@ -4402,7 +5683,8 @@ void MyFrame::OnChangeFilenameToAbsolute(wxCommandEvent& event) {
         obj->updateDateProperty();
         ++changed;
     }
-    if (changed > 0) { SetModified(true); RefreshTreeDisplay(); SetStatusText(wxString::Format("%d object(s) changed to absolute filename", changed)); }
+    if (changed == 0) { m_history.discardLast(); }
+    if (changed > 0) { SetModified(true); SetStatusText(wxString::Format("%d object(s) changed to absolute filename", changed)); }
     if (ignored > 0) { wxMessageBox(wxString::Format("%d object(s) were ignored", ignored), "Change Filename", wxOK | wxICON_INFORMATION); }
 }
 
@@ -4414,6 +5696,7 @@ void MyFrame::FUNC(wxCommandEvent& event) { \
         wxMessageBox("No objects selected for type change.", "Change Type", wxOK | wxICON_INFORMATION); \
         return; \
     } \
+    m_history.record("Change Type", m_objects, selectedObjs); \
     int changed = 0, failed = 0; \
     for (auto& obj : selectedObjs) { \
         if (!obj->isBitmap()) { ++failed; continue; } \
@@ -4422,6 +5705,7 @@ void MyFrame::FUNC(wxCommandEvent& event) { \
         obj->typeID = TYPE; \
         ++changed; \
     } \
+    if (changed == 0) { m_history.discardLast(); } \
     if (changed > 0) { SetModified(true); RefreshTreeDisplay(); SetStatusText(wxString::Format("%d object(s) converted to %s", changed, LABEL)); } \
     if (failed > 0) { wxMessageBox(wxString::Format("%d object(s) failed to convert or were not bitmaps", failed), "Change Type", wxOK | wxICON_INFORMATION); } \
 }
@@ -4552,6 +5836,13 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
     }
     int answer = wxMessageBox("The file was modified. Do you want to import the changes back into the datafile?", "Shell Edit", wxYES_NO | wxICON_QUESTION);
     if (answer == wxYES) {
+        // The replaced payload moves into the undo history
+        auto replaceData = [this](DataParser::DataVariant newData) {
+            UndoHistory::SavedContents previous;
+            previous.emplace_back(m_currentObject, UndoHistory::withData(*m_currentObject, std::move(m_currentObject->data)));
+            m_currentObject->data = std::move(newData);
+            m_history.recordPrevious("Shell Edit", m_objects, std::move(previous));
+        };
         // Import logic (reuse Grab/Replace logic)
         wxString dummyPath = tempPath;
         if (m_currentObject->isBitmap()) {
@@ -4559,7 +5850,7 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
             if (BitmapData::readFileToWxImage(dummyPath, image)) {
                 BitmapData newBmp;
                 if (newBmp.loadFromWxImage(image, m_currentObject->getBitmap().bits, &m_currentPalette, m_grabberInfo.GetDither(), m_grabberInfo.GetTransparency())) {
-                    m_currentObject->data = newBmp;
+                    replaceData(std::move(newBmp));
                     SetModified(true);
                     UpdateObjectPreview();
                     SetStatusText("Bitmap updated from shell edit.");
@@ -4568,7 +5859,7 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
         } else if (m_currentObject->isFont()) {
             FontData fontData;
             if (FontEditDialog::GrabFontFromFile(this, fontData, dummyPath)) {
-                m_currentObject->data = fontData;
+                replaceData(std::move(fontData));
                 SetModified(true);
                 UpdateObjectPreview();
                 SetStatusText("Font updated from shell edit.");
@@ -4576,7 +5867,7 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
         } else if (m_currentObject->isAudio()) {
             AudioData audioData = m_currentObject->getAudio();
             if (audioData.importFromFile(dummyPath.ToStdString())) {
-                m_currentObject->data = audioData;
+                replaceData(std::move(audioData));
                 SetModified(true);
                 UpdateObjectPreview();
                 SetStatusText("Audio updated from shell edit.");
@@ -4584,7 +5875,7 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
         } else if (m_currentObject->isVideo()) {
             VideoData videoData;
             if (videoData.importFromFile(dummyPath.ToStdString())) {
-                m_currentObject->data = videoData;
+                replaceData(std::move(videoData));
                 SetModified(true);
                 UpdateObjectPreview();
                 SetStatusText("Video updated from shell edit.");
@@ -4593,7 +5884,7 @@ void MyFrame::OnShellEdit(wxCommandEvent& event)
             std::ifstream file(dummyPath.ToStdString(), std::ios::binary);
             if (file) {
                 std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                m_currentObject->data = data;
+                replaceData(std::move(data));
                 SetModified(true);
                 UpdateObjectPreview();
                 SetStatusText("Raw data updated from shell edit.");
@@ -4614,10 +5905,68 @@ void MyFrame::OnSortObjects(wxCommandEvent& event)
             m_grabberInfo.SetSort(optionsMenu->IsChecked(ID_SORT_OBJECTS));
         }
     }
+    if (m_grabberInfo.GetSort()) {
+        // Sorting reorders the objects themselves, keep the old order for undo
+        m_history.record("Sort Objects", m_objects);
+        SetModified(true);
+    }
     // Refresh the tree display (will sort if enabled)
     RefreshTreeDisplay();
 }
 
+void MyFrame::OnUndo(wxCommandEvent& event)
+{
+    if (!m_history.canUndo()) {
+        SetStatusText("Nothing to undo");
+        return;
+    }
+    std::string description = m_history.undoDescription();
+    m_history.undo(m_objects);
+    if (description == "Sort Objects") {
+        // The tree sorts itself while the option is on, so undoing the sort turns it off
+        SetSortOption(false);
+    }
+    m_currentObject = nullptr;
+    SetModified(true);
+    m_tree->Freeze();
+    RefreshTreeDisplay();
+    m_tree->Thaw();
+    UpdateObjectPreview();
+    SetStatusText("Undo: " + description);
+}
+
+void MyFrame::OnRedo(wxCommandEvent& event)
+{
+    if (!m_history.canRedo()) {
+        SetStatusText("Nothing to redo");
+        return;
+    }
+    std::string description = m_history.redoDescription();
+    m_history.redo(m_objects);
+    if (description == "Sort Objects") {
+        SetSortOption(true);
+    }
+    m_currentObject = nullptr;
+    SetModified(true);
+    m_tree->Freeze();
+    RefreshTreeDisplay();
+    m_tree->Thaw();
+    UpdateObjectPreview();
+    SetStatusText("Redo: " + description);
+}
+
+void MyFrame::SetSortOption(bool sort)
+{
+    m_grabberInfo.SetSort(sort);
+    wxMenuBar* menuBar = GetMenuBar();
+    if (menuBar) {
+        wxMenu* optionsMenu = menuBar->GetMenu(menuBar->FindMenu("O&ptions"));
+        if (optionsMenu) {
+            optionsMenu->Check(ID_SORT_OBJECTS, sort);
+        }
+    }
+}
+
 void MyFrame::SortObjectsByName(std::vector<std::shared_ptr<DataParser::DataObject>>& objects) {
     std::sort(objects.begin(), objects.end(), [](const std::shared_ptr<DataParser::DataObject>& a, const std::shared_ptr<DataParser::DataObject>& b) {
         return a->getProperty('NAME') < b->getProperty('NAME');
@@ -4700,6 +6049,38 @@ void MyFrame::OnPreserveTransparency(wxCommandEvent& event)
     SetModified(true);
 }
 
+void MyFrame::OnProfileMode(wxCommandEvent& event)
+{
+    if (event.IsChecked()) {
+        Logger::getInstance().setProfiling(true);
+        SetStatusText("Profile mode on");
+        return;
+    }
+
+    Logger::getInstance().setProfiling(false);
+    SetStatusText("Profile mode off");
+    logInfo("Profile summary:\n" + Logger::getInstance().getProfileSummary());
+
+    wxFileDialog saveFileDialog(this, "Save profile trace", "", "profile.json",
+                               "Chrome trace files (*.json)|*.json|All files (*.*)|*.*",
+                               wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+        return;
+    }
+    if (!Logger::getInstance().writeChromeTrace(saveFileDialog.GetPath().ToStdString())) {
+        wxMessageBox("Failed to write profile trace", "Error", wxOK | wxICON_ERROR);
+    }
+}
+
+void MyFrame::OnThumbnailView(wxCommandEvent& event)
+{
+    bool showThumbnails = event.IsChecked();
+    m_thumbnailView->Show(showThumbnails);
+    m_tree->Show(!showThumbnails);
+    RefreshThumbnailView();
+    Layout();
+}
+
 // Handler stub for tree item context menu
 void MyFrame::OnTreeItemMenu(wxTreeEvent& event) {
     wxTreeItemId item = event.GetItem();
@@ -4734,6 +6115,7 @@ void MyFrame::OnTreeItemMenu(wxTreeEvent& event) {
         // ... existing multi-selection menu ...
         menu.Append(ID_DELETE, "Delete");
         menu.Append(ID_AUTOCROP, "Autocrop");
+        menu.Append(ID_SPRITE_BENCHMARK, "Sprite Blit Benchmark");
         wxMenu* depthMenu = new wxMenu();
         depthMenu->Append(ID_DEPTH_256, "8-bit (256)");
         depthMenu->Append(ID_DEPTH_15, "15-bit");
@@ -4789,6 +6171,7 @@ void MyFrame::OnTreeItemMenu(wxTreeEvent& event) {
         menu.AppendSubMenu(replaceMenu, "Replace");
         menu.Append(ID_RENAME, "Rename");
         menu.Append(ID_AUTOCROP, "Autocrop");
+        menu.Append(ID_SPRITE_BENCHMARK, "Sprite Blit Benchmark");
         menu.Append(ID_UNGRAB, "Ungrab");
         wxMenu* alphaMenu = new wxMenu();
         alphaMenu->Append(ID_VIEW_ALPHA, "View Alpha");
@@ -4859,6 +6242,7 @@ void MyFrame::OnBoxGrab(wxCommandEvent& event)
             wxMessageBox("Failed to convert image to bitmap format.", "Error", wxOK | wxICON_ERROR);
             return;
         }
+        m_history.record("Box Grab", m_objects, {m_currentObject});
         if (m_currentObject->isBitmap()) {
             m_currentObject->getBitmap() = newBitmapData;
         } else {
@@ -4917,6 +6301,7 @@ void MyFrame::OnDeleteAlpha(wxCommandEvent& event)
 {
     if (!IsBitmapOrRLESpriteSelected("delete"))
         return;
+    m_history.record("Delete Alpha", m_objects, {m_currentObject});
     BitmapData& bmpData = const_cast<BitmapData&>(m_currentObject->getBitmap());
     bmpData.deleteAlphaData();
     UpdateObjectPreview();
@@ -4946,7 +6331,9 @@ void MyFrame::OnImportAlpha(wxCommandEvent& event)
         wxMessageBox("Failed to load image file: " + path, "Error", wxOK | wxICON_ERROR, this);
         return;
     }
+    m_history.record("Import Alpha", m_objects, {m_currentObject});
     if (!bmpData.importAlphaDataFromImage(image)) {
+        m_history.discardLast();
         wxMessageBox("Failed to import alpha channel from image.", "Error", wxOK | wxICON_ERROR, this);
         return;
     }
@@ -5331,6 +6718,7 @@ bool MyFrame::GrabNested(wxString& path) {
 // Add after other event handlers:
 void MyFrame::OnNewOggAudio(wxCommandEvent& event) {
     auto obj = std::make_shared<DataParser::DataObject>(DataParser::createSampleObject(ObjectType::DAT_OGG));
+    m_history.record("New Object", m_objects);
     m_objects.push_back(obj);
     RefreshTreeDisplay();
     SetModified(true);
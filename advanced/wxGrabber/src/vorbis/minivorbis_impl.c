@@ -209,3 +209,70 @@ int create_wav_in_memory(const char* pcm_data, int pcm_size, int sample_rate, in
 
     return 0;
 }
+
+struct VorbisStream {
+    MemoryBuffer buffer;
+    OggVorbis_File vorbis;
+};
+
+VorbisStream* vorbis_stream_open(const unsigned char* data, size_t size, VorbisInfo* res_info) {
+    VorbisStream* stream = (VorbisStream*)malloc(sizeof(VorbisStream));
+    if (!stream) {
+        return NULL;
+    }
+    stream->buffer.data = data;
+    stream->buffer.size = size;
+    stream->buffer.position = 0;
+
+    /* The callbacks keep a pointer to the buffer, so it lives in the stream */
+    if(ov_open_callbacks(&stream->buffer, &stream->vorbis, NULL, 0, memory_callbacks) != 0) {
+        free(stream);
+        return NULL;
+    }
+
+    vorbis_info* info = ov_info(&stream->vorbis, -1);
+    ogg_int64_t total_samples = ov_pcm_total(&stream->vorbis, -1);
+    if(!info || total_samples < 0) {
+        vorbis_stream_close(stream);
+        return NULL;
+    }
+    if (res_info) {
+        res_info->pcm_data_size = (int)(total_samples * info->channels * 2);
+        res_info->sample_rate = info->rate;
+        res_info->channels = info->channels;
+        res_info->bitrate = (int)info->bitrate_nominal;
+        res_info->duration_ms = (int)(total_samples * 1000 / info->rate);
+    }
+    return stream;
+}
+
+int vorbis_stream_seek(VorbisStream* stream, long long frame) {
+    /* Bisects over the pages, only the packets around the target are decoded */
+    return ov_pcm_seek(&stream->vorbis, (ogg_int64_t)frame) == 0 ? 0 : -1;
+}
+
+int vorbis_stream_read(VorbisStream* stream, char* pcm_data, int max_bytes) {
+    int section = 0;
+    int total = 0;
+    while (total < max_bytes) {
+        long bytes = ov_read(&stream->vorbis, pcm_data + total, max_bytes - total, 0, 2, 1, &section);
+        if (bytes == OV_HOLE) {
+            continue;  /* Skipped a damaged page, keep going */
+        }
+        if (bytes < 0) {
+            return total > 0 ? total : -1;
+        }
+        if (bytes == 0) {
+            break;
+        }
+        total += (int)bytes;
+    }
+    return total;
+}
+
+void vorbis_stream_close(VorbisStream* stream) {
+    if (stream) {
+        ov_clear(&stream->vorbis);
+        free(stream);
+    }
+}
@@ -1,5 +1,9 @@
 #include "../../include/vorbis/vorbis_wrapper.h"
 #include "../../include/vorbis/minivorbis_impl.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 
 bool VorbisWrapper::ConvertOggToWav(const std::vector<uint8_t>& oggBuffer, std::vector<uint8_t>& wavBuffer) {
     if (oggBuffer.empty()) {
@@ -71,4 +75,49 @@ bool VorbisWrapper::ConvertOggToPCM(const std::vector<uint8_t>& oggBuffer, std::
     pcmBuffer.resize(info.pcm_data_size);
 
     return true;
-} 
\ No newline at end of file
+}
+
+VorbisDecoder::~VorbisDecoder() {
+    close();
+}
+
+bool VorbisDecoder::open(const std::vector<uint8_t>& oggBuffer) {
+    close();
+    if (oggBuffer.empty()) {
+        return false;
+    }
+    m_data = oggBuffer;
+    m_stream = vorbis_stream_open(m_data.data(), m_data.size(), &m_info);
+    if (!m_stream || m_info.channels <= 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void VorbisDecoder::close() {
+    vorbis_stream_close(m_stream);
+    m_stream = nullptr;
+    m_info = VorbisInfo();
+    m_data.clear();
+    m_data.shrink_to_fit();
+}
+
+int64_t VorbisDecoder::getTotalFrames() const {
+    return m_info.channels > 0 ? static_cast<int64_t>(m_info.pcm_data_size) / (m_info.channels * 2) : 0;
+}
+
+bool VorbisDecoder::seek(int64_t frame) {
+    return m_stream && vorbis_stream_seek(m_stream, frame) == 0;
+}
+
+size_t VorbisDecoder::read(int16_t* samples, size_t frameCount) {
+    if (!m_stream || frameCount == 0) {
+        return 0;
+    }
+    // ov_read stops at packet boundaries, vorbis_stream_read keeps going until the buffer is full
+    size_t frameBytes = static_cast<size_t>(m_info.channels) * 2;
+    size_t maxBytes = std::min(frameCount * frameBytes, static_cast<size_t>(INT32_MAX) / frameBytes * frameBytes);
+    int bytes = vorbis_stream_read(m_stream, reinterpret_cast<char*>(samples), static_cast<int>(maxBytes));
+    return bytes > 0 ? static_cast<size_t>(bytes) / frameBytes : 0;
+}